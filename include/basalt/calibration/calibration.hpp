@@ -38,11 +38,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <basalt/spline/rd_spline.h>
 #include <basalt/calibration/calib_bias.hpp>
 #include <basalt/camera/generic_camera.hpp>
+#include <basalt/utils/parallel.h>
 
 namespace basalt {
 
@@ -160,6 +164,121 @@ struct Calibration {
     return accel_noise_std * std::sqrt(imu_update_rate);
   }
 
+  /// @brief Number of points projected into all cameras before moving on to
+  /// the next points in \ref projectBatch. Small enough that the coordinates
+  /// of a block stay in cache while they are projected into every camera.
+  static constexpr Eigen::Index PROJECT_BATCH_BLOCK_SIZE = 1024;
+
+  /// @brief Project a batch of points in the IMU frame into all cameras
+  ///
+  /// Applies the inverse of \ref T_i_c and projects with the vectorized
+  /// kernel of every camera (see \ref GenericCamera::projectBatch). Points
+  /// are processed in blocks of PROJECT_BATCH_BLOCK_SIZE, each of which is
+  /// projected into all cameras in turn, so the input is streamed from memory
+  /// once.
+  ///
+  /// Outputs are resized to the number of cameras and points, which does not
+  /// allocate if they already have the right size.
+  ///
+  /// @param[in] p3d_i 3xN or 4xN matrix of points in the IMU frame
+  /// @param[out] proj per camera 2xN matrix of projections
+  /// @param[out] valid per camera 1 if the projection is valid and 0
+  /// otherwise
+  /// @param[out] in_image per camera 1 if the projection is valid and inside
+  /// \ref resolution shrunk by border on every side, i.e. border <= u <
+  /// width - border and border <= v < height - border
+  /// @param[in] border distance to the image boundary in pixels
+  template <class DerivedPoints3D>
+  void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d_i,
+                    std::vector<CameraBatchPoints2<Scalar>>& proj,
+                    std::vector<CameraBatchValid>& valid,
+                    std::vector<CameraBatchValid>& in_image,
+                    Scalar border = Scalar(0)) const {
+    // without workers all blocks are projected on the calling thread
+    const auto executor = [](std::function<void()> task) { task(); };
+    projectBatch(p3d_i, proj, valid, in_image, executor, 0, border);
+  }
+
+  /// @brief Project a batch of points in the IMU frame into all cameras
+  /// using a caller-supplied executor for parallelization.
+  ///
+  /// The blocks of \ref projectBatch are processed with \ref parallelFor by
+  /// the calling thread and \p num_workers worker tasks passed to
+  /// \p executor (see there for the requirements on the executor). The
+  /// result is identical to \ref projectBatch without executor.
+  ///
+  /// @param executor callable taking a std::function<void()> to run, e.g.
+  /// submitting it to a thread pool
+  /// @param num_workers number of tasks passed to the executor
+  ///
+  /// See the overload without executor for the other parameters.
+  template <class DerivedPoints3D, class Executor>
+  void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d_i,
+                    std::vector<CameraBatchPoints2<Scalar>>& proj,
+                    std::vector<CameraBatchValid>& valid,
+                    std::vector<CameraBatchValid>& in_image,
+                    Executor&& executor, size_t num_workers,
+                    Scalar border = Scalar(0)) const {
+    BASALT_INSTRUMENT_SCOPE("basalt::Calibration::projectBatch");
+
+    using Mat4 = Eigen::Matrix<Scalar, 4, 4>;
+
+    const size_t num_cams = intrinsics.size();
+    BASALT_ASSERT_STREAM(
+        T_i_c.size() == num_cams && resolution.size() == num_cams,
+        "T_i_c.size() " << T_i_c.size() << " intrinsics.size() " << num_cams
+                        << " resolution.size() " << resolution.size());
+    const Eigen::Index num_points = p3d_i.cols();
+
+    proj.resize(num_cams);
+    valid.resize(num_cams);
+    in_image.resize(num_cams);
+
+    Eigen::aligned_vector<Mat4> T_c_i(num_cams);
+    for (size_t c = 0; c < num_cams; c++) {
+      T_c_i[c] = T_i_c[c].inverse().matrix();
+      proj[c].resize(2, num_points);
+      valid[c].resize(num_points);
+      in_image[c].resize(num_points);
+    }
+
+    auto process_block = [&](Eigen::Index begin, Eigen::Index n) {
+      const auto p3d_block = p3d_i.middleCols(begin, n);
+
+      for (size_t c = 0; c < num_cams; c++) {
+        auto proj_block = proj[c].middleCols(begin, n);
+        auto valid_block = valid[c].segment(begin, n);
+
+        intrinsics[c].visitBatch([&](const auto& cam) {
+          projectBatchChunks(cam, p3d_block, &T_c_i[c], proj_block,
+                             valid_block);
+        });
+
+        const auto u = proj_block.row(0).transpose().array();
+        const auto v = proj_block.row(1).transpose().array();
+        const Scalar width = Scalar(resolution[c][0]);
+        const Scalar height = Scalar(resolution[c][1]);
+
+        in_image[c].segment(begin, n) =
+            (valid_block.array() != 0 && u >= border && u < width - border &&
+             v >= border && v < height - border)
+                .template cast<uint8_t>()
+                .matrix();
+      }
+    };
+
+    const Eigen::Index num_blocks =
+        (num_points + PROJECT_BATCH_BLOCK_SIZE - 1) / PROJECT_BATCH_BLOCK_SIZE;
+
+    parallelFor(num_blocks, std::forward<Executor>(executor), num_workers,
+                [&](size_t b) {
+                  const Eigen::Index begin =
+                      Eigen::Index(b) * PROJECT_BATCH_BLOCK_SIZE;
+                  process_block(begin, std::min(PROJECT_BATCH_BLOCK_SIZE,
+                                                num_points - begin));
+                });
+  }
+
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
@@ -38,6 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <basalt/camera/camera_batch.hpp>
 #include <basalt/camera/camera_static_assert.hpp>
 
 #include <basalt/utils/sophus_utils.hpp>
@@ -87,6 +88,10 @@ class BalCamera {
   using Mat42 = Eigen::Matrix<Scalar, 4, 2>;
   using Mat4N = Eigen::Matrix<Scalar, 4, N>;
 
+  using BatchArray = CameraBatchArray<Scalar>;
+  using BatchJ3D = CameraBatchJ3D<Scalar>;
+  using BatchJparam = CameraBatchJparam<Scalar, N>;
+
   /// @brief Default constructor with zero intrinsics
   BalCamera() { param_.setZero(); }
 
@@ -184,6 +189,93 @@ class BalCamera {
     return is_valid;
   }
 
+  /// @brief Project a batch of points and optionally compute Jacobians
+  ///
+  /// Batch counterpart of @ref project that evaluates CAMERA_BATCH_SIZE points
+  /// at once with @ref projectChunk, see @ref projectBatchChunks.
+  ///
+  /// @param[in] p3d 3xN or 4xN matrix of points to project
+  /// @param[out] proj 2xN matrix of projections
+  /// @param[out] valid vector of N flags, 1 if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr contiguous storage for one 2x3 or
+  /// 2x4 Jacobian with respect to the point per projection
+  /// @param[out] d_proj_d_param if not nullptr contiguous storage for one
+  /// Mat2N Jacobian with respect to the intrinsics per projection
+  template <class DerivedPoints3D, class DerivedPoints2D, class DerivedValid,
+            class DerivedJ3DPtr = std::nullptr_t,
+            class DerivedJparamPtr = std::nullptr_t>
+  inline void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+                           const Eigen::MatrixBase<DerivedPoints2D>& proj,
+                           const Eigen::MatrixBase<DerivedValid>& valid,
+                           DerivedJ3DPtr d_proj_d_p3d = nullptr,
+                           DerivedJparamPtr d_proj_d_param = nullptr) const {
+    projectBatchChunks(*this, p3d, nullptr, proj, valid, d_proj_d_p3d,
+                       d_proj_d_param);
+  }
+
+  /// @brief Project a chunk of points given as coordinate arrays
+  ///
+  /// Same arithmetic as @ref project evaluated for all lanes at once.
+  ///
+  /// @param[in] x, y, z coordinates of the points
+  /// @param[out] u, v coordinates of the projections
+  /// @param[out] is_valid if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr Jacobians with respect to the
+  /// point, see @ref CameraBatchJ3D
+  /// @param[out] d_proj_d_param if not nullptr Jacobians with respect to the
+  /// intrinsics, see @ref CameraBatchJparam
+  inline void projectChunk(const BatchArray& x, const BatchArray& y,
+                           const BatchArray& z, BatchArray& u, BatchArray& v,
+                           CameraBatchMask& is_valid,
+                           BatchJ3D* d_proj_d_p3d = nullptr,
+                           BatchJparam* d_proj_d_param = nullptr) const {
+    const Scalar& f = param_[0];
+    const Scalar& k1 = param_[1];
+    const Scalar& k2 = param_[2];
+
+    const BatchArray mx = x / z;
+    const BatchArray my = y / z;
+
+    const BatchArray mx2 = mx * mx;
+    const BatchArray my2 = my * my;
+
+    const BatchArray r2 = mx2 + my2;
+    const BatchArray r4 = r2 * r2;
+
+    const BatchArray rp = Scalar(1) + k1 * r2 + k2 * r4;
+
+    u = f * mx * rp;
+    v = f * my * rp;
+
+    is_valid = z >= Sophus::Constants<Scalar>::epsilonSqrt();
+
+    if (d_proj_d_p3d) {
+      BatchJ3D& J = *d_proj_d_p3d;
+
+      const BatchArray tmp = k1 + k2 * Scalar(2) * r2;
+
+      J.col(0) = f * (rp + Scalar(2) * mx2 * tmp) / z;
+      J.col(3) = f * (rp + Scalar(2) * my2 * tmp) / z;
+
+      J.col(1) = f * my * mx * Scalar(2) * tmp / z;
+      J.col(2) = J.col(1);
+
+      J.col(4) = -f * mx * (rp + Scalar(2) * tmp * r2) / z;
+      J.col(5) = -f * my * (rp + Scalar(2) * tmp * r2) / z;
+    }
+
+    if (d_proj_d_param) {
+      BatchJparam& J = *d_proj_d_param;
+
+      J.col(0) = mx * rp;
+      J.col(1) = my * rp;
+      J.col(2) = f * mx * r2;
+      J.col(3) = f * my * r2;
+      J.col(4) = f * mx * r4;
+      J.col(5) = f * my * r4;
+    }
+  }
+
   /// @brief Unproject the point and optionally compute Jacobians
   ///
   ///
@@ -0,0 +1,390 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Helpers for projecting batches of points stored in
+structure-of-arrays layout
+*/
+
+#pragma once
+
+#include <basalt/utils/assert.h>
+#include <basalt/utils/instrumentation.h>
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace basalt {
+
+/// @brief Number of points processed together by the batch projection
+/// kernels. Chosen so that one chunk of coordinates fits in a few SIMD
+/// registers per coordinate for both float and double.
+constexpr int CAMERA_BATCH_SIZE = 16;
+
+/// @brief Fixed size array holding one coordinate of a chunk of points
+template <typename Scalar>
+using CameraBatchArray = Eigen::Array<Scalar, CAMERA_BATCH_SIZE, 1>;
+
+/// @brief Per-point validity of a chunk of points
+using CameraBatchMask = Eigen::Array<bool, CAMERA_BATCH_SIZE, 1>;
+
+/// @brief Jacobians of a chunk of projections with respect to the 3D points.
+///
+/// Column 2 * c + r holds entry (r, c) of the 2x3 Jacobian for every lane,
+/// i.e. the columns follow the column-major storage of a 2x3 matrix.
+template <typename Scalar>
+using CameraBatchJ3D = Eigen::Array<Scalar, CAMERA_BATCH_SIZE, 6>;
+
+/// @brief Jacobians of a chunk of projections with respect to the N intrinsic
+/// parameters. Column 2 * c + r holds entry (r, c) of the 2xN Jacobian.
+template <typename Scalar, int N>
+using CameraBatchJparam = Eigen::Array<Scalar, CAMERA_BATCH_SIZE, 2 * N>;
+
+/// @brief 3D points stored as rows of x, y and z coordinates
+template <typename Scalar>
+using CameraBatchPoints3 =
+    Eigen::Matrix<Scalar, 3, Eigen::Dynamic, Eigen::RowMajor>;
+
+/// @brief 2D points stored as rows of u and v coordinates
+template <typename Scalar>
+using CameraBatchPoints2 =
+    Eigen::Matrix<Scalar, 2, Eigen::Dynamic, Eigen::RowMajor>;
+
+/// @brief Byte mask with one entry per point (1 if valid, 0 otherwise)
+using CameraBatchValid = Eigen::Matrix<uint8_t, Eigen::Dynamic, 1>;
+
+/// @brief Element-wise atan2 for a chunk of values
+///
+/// Reduces the argument to [0, 1] so that only a single call to the (possibly
+/// vectorized) array atan is required, then restores the octant with selects.
+/// Returns 0 for atan2(0, 0) like std::atan2.
+template <typename Scalar>
+inline CameraBatchArray<Scalar> batchAtan2(const CameraBatchArray<Scalar>& y,
+                                           const CameraBatchArray<Scalar>& x) {
+  using Array = CameraBatchArray<Scalar>;
+
+  const Scalar pi = Scalar(M_PI);
+  const Scalar pi_2 = Scalar(M_PI_2);
+
+  const Array ax = x.abs();
+  const Array ay = y.abs();
+
+  const CameraBatchMask swap = ay > ax;
+  const Array num = swap.select(ax, ay);
+  const Array den = swap.select(ay, ax);
+
+  const Array t = (den > Scalar(0)).select(num / den, Scalar(0));
+
+  Array res = t.atan();
+  res = swap.select(pi_2 - res, res);
+  res = (x < Scalar(0)).select(pi - res, res);
+  res = (y < Scalar(0)).select(-res, res);
+
+  return res;
+}
+
+/// @brief Store Jacobians of a chunk into an array of fixed size matrices
+///
+/// @param[in] chunk Jacobians of the chunk, see @ref CameraBatchJ3D
+/// @param[in] n number of lanes to store
+/// @param[out] dst first of n consecutive 2xCOLS matrices
+template <int COLS, class ChunkJ, class DerivedJ>
+inline void storeBatchJacobians(const ChunkJ& chunk, Eigen::Index n,
+                                DerivedJ* dst) {
+  for (Eigen::Index k = 0; k < n; k++) {
+    for (int c = 0; c < COLS; c++) {
+      dst[k](0, c) = chunk(k, 2 * c);
+      dst[k](1, c) = chunk(k, 2 * c + 1);
+    }
+  }
+}
+
+/// @brief Project a batch of points chunk by chunk
+///
+/// Loads CAMERA_BATCH_SIZE points at a time into coordinate arrays, optionally
+/// transforms them with T_c_w and calls `cam.projectChunk(x, y, z, u, v,
+/// is_valid, d_proj_d_p3d, d_proj_d_param)`. Lanes past the end of the batch
+/// are padded with the point (0, 0, 1), which every model projects without
+/// producing NaNs, and are not written back.
+///
+/// Jacobians are written to caller-provided contiguous storage with one block
+/// per point. d_proj_d_p3d points to 2x3 or 2x4 matrices, matching the number
+/// of rows of p3d, and is computed with respect to the point after applying
+/// T_c_w. d_proj_d_param points either to 2xN matrices or, if it is a plain
+/// scalar pointer, to raw storage of column-major 2xN blocks.
+///
+/// @param[in] cam camera model providing projectChunk
+/// @param[in] p3d 3xN or 4xN matrix of points. Row-major storage makes loading
+/// the coordinate arrays contiguous.
+/// @param[in] T_c_w if not nullptr transformation applied to points before
+/// projection
+/// @param[out] proj 2xN matrix of projections
+/// @param[out] valid vector of N flags, 1 if projection is valid
+/// @param[out] d_proj_d_p3d if not nullptr storage for Jacobians of
+/// projections with respect to the points
+/// @param[out] d_proj_d_param if not nullptr storage for Jacobians of
+/// projections with respect to intrinsic parameters
+template <class CamT, class DerivedPoints3D, class DerivedPoints2D,
+          class DerivedValid, class DerivedJ3DPtr = std::nullptr_t,
+          class DerivedJparamPtr = std::nullptr_t>
+inline void projectBatchChunks(
+    const CamT& cam, const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+    const Eigen::Matrix<typename CamT::Scalar, 4, 4>* T_c_w,
+    const Eigen::MatrixBase<DerivedPoints2D>& proj_const,
+    const Eigen::MatrixBase<DerivedValid>& valid_const,
+    DerivedJ3DPtr d_proj_d_p3d = nullptr,
+    DerivedJparamPtr d_proj_d_param = nullptr) {
+  BASALT_INSTRUMENT_SCOPE("basalt::projectBatch");
+  BASALT_INSTRUMENT_COUNT("basalt::projectBatch points", p3d.cols());
+
+  using Scalar = typename CamT::Scalar;
+  using Array = CameraBatchArray<Scalar>;
+  using ValidScalar = typename DerivedValid::Scalar;
+
+  constexpr int N = CamT::N;
+  constexpr int ROWS = DerivedPoints3D::RowsAtCompileTime;
+  static_assert(ROWS == 3 || ROWS == 4, "points must be 3xN or 4xN");
+  EIGEN_STATIC_ASSERT(DerivedPoints2D::RowsAtCompileTime == 2,
+                      YOU_MIXED_MATRICES_OF_DIFFERENT_SIZES);
+  EIGEN_STATIC_ASSERT_VECTOR_ONLY(DerivedValid);
+
+  constexpr bool WITH_J3D = !std::is_same_v<DerivedJ3DPtr, std::nullptr_t>;
+  constexpr bool WITH_JPARAM =
+      !std::is_same_v<DerivedJparamPtr, std::nullptr_t>;
+
+  if constexpr (WITH_J3D) {
+    static_assert(std::is_pointer_v<DerivedJ3DPtr>);
+    using DerivedJ3D = typename std::remove_pointer<DerivedJ3DPtr>::type;
+    EIGEN_STATIC_ASSERT_MATRIX_SPECIFIC_SIZE(DerivedJ3D, 2, ROWS);
+    BASALT_ASSERT(d_proj_d_p3d);
+  }
+
+  if constexpr (WITH_JPARAM) {
+    static_assert(std::is_pointer_v<DerivedJparamPtr>);
+    using DerivedJparam = typename std::remove_pointer<DerivedJparamPtr>::type;
+    if constexpr (!std::is_same_v<DerivedJparam, Scalar>) {
+      EIGEN_STATIC_ASSERT_MATRIX_SPECIFIC_SIZE(DerivedJparam, 2, N);
+    }
+    BASALT_ASSERT(d_proj_d_param);
+  }
+
+  Eigen::MatrixBase<DerivedPoints2D>& proj =
+      const_cast<Eigen::MatrixBase<DerivedPoints2D>&>(proj_const);
+  Eigen::MatrixBase<DerivedValid>& valid =
+      const_cast<Eigen::MatrixBase<DerivedValid>&>(valid_const);
+
+  const Eigen::Index num_points = p3d.cols();
+  BASALT_ASSERT(proj.cols() == num_points);
+  BASALT_ASSERT(valid.size() == num_points);
+
+  Array x, y, z, w, u, v;
+  CameraBatchMask is_valid;
+
+  CameraBatchJ3D<Scalar> j3d;
+  CameraBatchJparam<Scalar, N> jparam;
+  CameraBatchJ3D<Scalar>* j3d_ptr = WITH_J3D ? &j3d : nullptr;
+  CameraBatchJparam<Scalar, N>* jparam_ptr = WITH_JPARAM ? &jparam : nullptr;
+
+  for (Eigen::Index i = 0; i < num_points; i += CAMERA_BATCH_SIZE) {
+    const Eigen::Index n =
+        std::min<Eigen::Index>(CAMERA_BATCH_SIZE, num_points - i);
+
+    if (n < CAMERA_BATCH_SIZE) {
+      x.setZero();
+      y.setZero();
+      z.setOnes();
+      w.setOnes();
+    }
+
+    x.head(n) = p3d.row(0).segment(i, n).transpose().array();
+    y.head(n) = p3d.row(1).segment(i, n).transpose().array();
+    z.head(n) = p3d.row(2).segment(i, n).transpose().array();
+
+    if (T_c_w) {
+      const Eigen::Matrix<Scalar, 4, 4>& T = *T_c_w;
+
+      if constexpr (ROWS == 4) {
+        w.head(n) = p3d.row(3).segment(i, n).transpose().array();
+      } else {
+        w.setOnes();
+      }
+
+      const Array xt = T(0, 0) * x + T(0, 1) * y + T(0, 2) * z + T(0, 3) * w;
+      const Array yt = T(1, 0) * x + T(1, 1) * y + T(1, 2) * z + T(1, 3) * w;
+      const Array zt = T(2, 0) * x + T(2, 1) * y + T(2, 2) * z + T(2, 3) * w;
+
+      cam.projectChunk(xt, yt, zt, u, v, is_valid, j3d_ptr, jparam_ptr);
+    } else {
+      cam.projectChunk(x, y, z, u, v, is_valid, j3d_ptr, jparam_ptr);
+    }
+
+    proj.row(0).segment(i, n) = u.head(n).matrix().transpose();
+    proj.row(1).segment(i, n) = v.head(n).matrix().transpose();
+    valid.segment(i, n) =
+        is_valid.head(n).template cast<ValidScalar>().matrix();
+
+    if constexpr (WITH_J3D) {
+      storeBatchJacobians<3>(j3d, n, d_proj_d_p3d + i);
+      if constexpr (ROWS == 4) {
+        for (Eigen::Index k = 0; k < n; k++) {
+          d_proj_d_p3d[i + k].col(3).setZero();
+        }
+      }
+    }
+
+    if constexpr (WITH_JPARAM) {
+      using DerivedJparam =
+          typename std::remove_pointer<DerivedJparamPtr>::type;
+      if constexpr (std::is_same_v<DerivedJparam, Scalar>) {
+        // Column-major 2xN blocks are rows of the chunk Jacobian.
+        Eigen::Map<Eigen::Matrix<Scalar, 2 * N, Eigen::Dynamic>>(
+            d_proj_d_param + i * 2 * N, 2 * N, n) =
+            jparam.topRows(n).transpose().matrix();
+      } else {
+        storeBatchJacobians<N>(jparam, n, d_proj_d_param + i);
+      }
+    }
+  }
+}
+
+/// @brief Unproject a batch of points chunk by chunk
+///
+/// Loads CAMERA_BATCH_SIZE points at a time into coordinate arrays and calls
+/// `cam.unprojectChunk(u, v, x, y, z, is_valid)`. Lanes past the end of the
+/// batch are padded with zeros and are not written back. Iterative models use
+/// the same number of iterations in all lanes, so the kernels have no
+/// per-lane branches.
+///
+/// All outputs are written to caller-provided storage that has to have the
+/// right size, nothing is allocated. Eigen::Map of aligned_vector data can be
+/// used to write directly into arrays of Vec3 or Vec4.
+///
+/// @param[in] cam camera model providing unprojectChunk
+/// @param[in] proj 2xN matrix of points to unproject
+/// @param[out] p3d 3xN or 4xN matrix of unprojected bearing vectors. The
+/// fourth row is set to zero like in the per-point unproject.
+/// @param[out] valid vector of N flags, 1 if unprojection is valid
+template <class CamT, class DerivedPoints2D, class DerivedPoints3D,
+          class DerivedValid>
+inline void unprojectBatchChunks(
+    const CamT& cam, const Eigen::MatrixBase<DerivedPoints2D>& proj,
+    const Eigen::MatrixBase<DerivedPoints3D>& p3d_const,
+    const Eigen::MatrixBase<DerivedValid>& valid_const) {
+  BASALT_INSTRUMENT_SCOPE("basalt::unprojectBatch");
+  BASALT_INSTRUMENT_COUNT("basalt::unprojectBatch points", proj.cols());
+
+  using Scalar = typename CamT::Scalar;
+  using Array = CameraBatchArray<Scalar>;
+  using ValidScalar = typename DerivedValid::Scalar;
+
+  constexpr int ROWS = DerivedPoints3D::RowsAtCompileTime;
+  static_assert(ROWS == 3 || ROWS == 4, "points must be 3xN or 4xN");
+  EIGEN_STATIC_ASSERT(DerivedPoints2D::RowsAtCompileTime == 2,
+                      YOU_MIXED_MATRICES_OF_DIFFERENT_SIZES);
+  EIGEN_STATIC_ASSERT_VECTOR_ONLY(DerivedValid);
+
+  Eigen::MatrixBase<DerivedPoints3D>& p3d =
+      const_cast<Eigen::MatrixBase<DerivedPoints3D>&>(p3d_const);
+  Eigen::MatrixBase<DerivedValid>& valid =
+      const_cast<Eigen::MatrixBase<DerivedValid>&>(valid_const);
+
+  const Eigen::Index num_points = proj.cols();
+  BASALT_ASSERT(p3d.cols() == num_points);
+  BASALT_ASSERT(valid.size() == num_points);
+
+  Array u, v, x, y, z;
+  CameraBatchMask is_valid;
+
+  for (Eigen::Index i = 0; i < num_points; i += CAMERA_BATCH_SIZE) {
+    const Eigen::Index n =
+        std::min<Eigen::Index>(CAMERA_BATCH_SIZE, num_points - i);
+
+    if (n < CAMERA_BATCH_SIZE) {
+      u.setZero();
+      v.setZero();
+    }
+
+    u.head(n) = proj.row(0).segment(i, n).transpose().array();
+    v.head(n) = proj.row(1).segment(i, n).transpose().array();
+
+    cam.unprojectChunk(u, v, x, y, z, is_valid);
+
+    p3d.row(0).segment(i, n) = x.head(n).matrix().transpose();
+    p3d.row(1).segment(i, n) = y.head(n).matrix().transpose();
+    p3d.row(2).segment(i, n) = z.head(n).matrix().transpose();
+    if constexpr (ROWS == 4) {
+      p3d.row(3).segment(i, n).setZero();
+    }
+    valid.segment(i, n) =
+        is_valid.head(n).template cast<ValidScalar>().matrix();
+  }
+}
+
+/// @brief Detects camera containers with a visitBatch(f) function, see
+/// GenericCamera::visitBatch.
+template <class CamT, class F, class = void>
+struct HasVisitBatch : std::false_type {};
+
+template <class CamT, class F>
+struct HasVisitBatch<CamT, F,
+                     std::void_t<decltype(std::declval<const CamT&>()
+                                              .visitBatch(std::declval<F>()))>>
+    : std::true_type {};
+
+/// @brief Call f with the concrete camera model
+///
+/// For containers like GenericCamera the dispatch on the stored model happens
+/// once and f runs on the concrete type, so loops over points in f are
+/// inlined and vectorized for that model. Concrete models are passed to f
+/// directly. Range-based functions that accept any camera type use this to
+/// hoist the dispatch out of their per-point loop.
+///
+/// @param[in] cam concrete camera model or container with visitBatch
+/// @param[in] f callable taking the concrete camera model
+/// @return result of f
+template <class CamT, class F>
+inline decltype(auto) visitCameraModel(const CamT& cam, F&& f) {
+  if constexpr (HasVisitBatch<CamT, F>::value) {
+    return cam.visitBatch(std::forward<F>(f));
+  } else {
+    return std::forward<F>(f)(cam);
+  }
+}
+
+}  // namespace basalt
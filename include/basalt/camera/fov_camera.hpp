@@ -38,6 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <basalt/camera/camera_batch.hpp>
 #include <basalt/camera/camera_static_assert.hpp>
 
 #include <basalt/utils/sophus_utils.hpp>
@@ -71,6 +72,10 @@ class FovCamera {
 
   using Mat44 = Eigen::Matrix<Scalar, 4, 4>;
 
+  using BatchArray = CameraBatchArray<Scalar>;
+  using BatchJ3D = CameraBatchJ3D<Scalar>;
+  using BatchJparam = CameraBatchJparam<Scalar, N>;
+
   /// @brief Default constructor with zero intrinsics
   FovCamera() { param_.setZero(); }
 
@@ -224,6 +229,146 @@ class FovCamera {
     return is_valid;
   }
 
+  /// @brief Project a batch of points and optionally compute Jacobians
+  ///
+  /// Batch counterpart of @ref project that evaluates CAMERA_BATCH_SIZE points
+  /// at once with @ref projectChunk, see @ref projectBatchChunks.
+  ///
+  /// @param[in] p3d 3xN or 4xN matrix of points to project
+  /// @param[out] proj 2xN matrix of projections
+  /// @param[out] valid vector of N flags, 1 if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr contiguous storage for one 2x3 or
+  /// 2x4 Jacobian with respect to the point per projection
+  /// @param[out] d_proj_d_param if not nullptr contiguous storage for one
+  /// Mat2N Jacobian with respect to the intrinsics per projection
+  template <class DerivedPoints3D, class DerivedPoints2D, class DerivedValid,
+            class DerivedJ3DPtr = std::nullptr_t,
+            class DerivedJparamPtr = std::nullptr_t>
+  inline void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+                           const Eigen::MatrixBase<DerivedPoints2D>& proj,
+                           const Eigen::MatrixBase<DerivedValid>& valid,
+                           DerivedJ3DPtr d_proj_d_p3d = nullptr,
+                           DerivedJparamPtr d_proj_d_param = nullptr) const {
+    projectBatchChunks(*this, p3d, nullptr, proj, valid, d_proj_d_p3d,
+                       d_proj_d_param);
+  }
+
+  /// @brief Project a chunk of points given as coordinate arrays
+  ///
+  /// Same arithmetic as @ref project evaluated for all lanes at once.
+  ///
+  /// @param[in] x, y, z coordinates of the points
+  /// @param[out] u, v coordinates of the projections
+  /// @param[out] is_valid if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr Jacobians with respect to the
+  /// point, see @ref CameraBatchJ3D
+  /// @param[out] d_proj_d_param if not nullptr Jacobians with respect to the
+  /// intrinsics, see @ref CameraBatchJparam
+  inline void projectChunk(const BatchArray& x, const BatchArray& y,
+                           const BatchArray& z, BatchArray& u, BatchArray& v,
+                           CameraBatchMask& is_valid,
+                           BatchJ3D* d_proj_d_p3d = nullptr,
+                           BatchJparam* d_proj_d_param = nullptr) const {
+    const Scalar& fx = param_[0];
+    const Scalar& fy = param_[1];
+    const Scalar& cx = param_[2];
+    const Scalar& cy = param_[3];
+    const Scalar& w = param_[4];
+
+    const bool compute_jacobians = d_proj_d_p3d || d_proj_d_param;
+
+    BatchArray rd, d_rd_d_w, d_rd_d_x, d_rd_d_y, d_rd_d_z;
+
+    if (w > Sophus::Constants<Scalar>::epsilonSqrt()) {
+      const BatchArray r2 = x * x + y * y;
+      const BatchArray r = r2.sqrt();
+
+      const Scalar tanwhalf = std::tan(w / 2);
+      const BatchArray atan_wrd = batchAtan2<Scalar>(2 * tanwhalf * r, z);
+
+      const CameraBatchMask near_center =
+          r2 < Sophus::Constants<Scalar>::epsilonSqrt();
+      const BatchArray r_safe = near_center.select(Scalar(1), r);
+
+      rd = near_center.select(Scalar(2) * tanwhalf / w,
+                              atan_wrd / (r_safe * w));
+
+      is_valid =
+          !(near_center && (z < Sophus::Constants<Scalar>::epsilonSqrt()));
+
+      if (compute_jacobians) {
+        const Scalar tmp1 = Scalar(1) / std::cos(w / 2);
+        const Scalar d_tanwhalf_d_w = Scalar(0.5) * tmp1 * tmp1;
+        const BatchArray tmp =
+            (z * z + Scalar(4) * tanwhalf * tanwhalf * r2);
+        const BatchArray d_atan_wrd_d_w =
+            Scalar(2) * r * d_tanwhalf_d_w * z / tmp;
+
+        d_rd_d_w = near_center.select(
+            Scalar(2) * (d_tanwhalf_d_w * w - tanwhalf) / (w * w),
+            (d_atan_wrd_d_w * w - atan_wrd) / (r_safe * w * w));
+
+        const BatchArray d_r_d_x = x / r_safe;
+        const BatchArray d_r_d_y = y / r_safe;
+
+        const BatchArray d_atan_wrd_d_x =
+            Scalar(2) * tanwhalf * d_r_d_x * z / tmp;
+        const BatchArray d_atan_wrd_d_y =
+            Scalar(2) * tanwhalf * d_r_d_y * z / tmp;
+        const BatchArray d_atan_wrd_d_z = -Scalar(2) * tanwhalf * r / tmp;
+
+        d_rd_d_x = near_center.select(
+            Scalar(0), (d_atan_wrd_d_x * r - d_r_d_x * atan_wrd) /
+                           (r_safe * r_safe * w));
+        d_rd_d_y = near_center.select(
+            Scalar(0), (d_atan_wrd_d_y * r - d_r_d_y * atan_wrd) /
+                           (r_safe * r_safe * w));
+        d_rd_d_z = near_center.select(Scalar(0), d_atan_wrd_d_z / (r_safe * w));
+      }
+    } else {
+      rd.setOnes();
+      is_valid.setConstant(true);
+
+      if (compute_jacobians) {
+        d_rd_d_w.setZero();
+        d_rd_d_x.setZero();
+        d_rd_d_y.setZero();
+        d_rd_d_z.setZero();
+      }
+    }
+
+    const BatchArray mx = x * rd;
+    const BatchArray my = y * rd;
+
+    u = fx * mx + cx;
+    v = fy * my + cy;
+
+    if (d_proj_d_p3d) {
+      BatchJ3D& J = *d_proj_d_p3d;
+
+      J.col(0) = fx * (d_rd_d_x * x + rd);
+      J.col(2) = fx * d_rd_d_y * x;
+      J.col(4) = fx * d_rd_d_z * x;
+
+      J.col(1) = fy * d_rd_d_x * y;
+      J.col(3) = fy * (d_rd_d_y * y + rd);
+      J.col(5) = fy * d_rd_d_z * y;
+    }
+
+    if (d_proj_d_param) {
+      BatchJparam& J = *d_proj_d_param;
+
+      J.setZero();
+      J.col(0) = mx;
+      J.col(4).setOnes();
+      J.col(3) = my;
+      J.col(7).setOnes();
+
+      J.col(8) = fx * x * d_rd_d_w;
+      J.col(9) = fy * y * d_rd_d_w;
+    }
+  }
+
   /// @brief Unproject the point and optionally compute Jacobians
   ///
   /// The unprojection function is computed as follows: \f{align}{
@@ -46,6 +46,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <basalt/camera/pinhole_camera.hpp>
 #include <basalt/camera/pinhole_radtan8_camera.hpp>
 #include <basalt/camera/unified_camera.hpp>
+#include <basalt/camera/unproject_lut.hpp>
 
 #include <variant>
 
@@ -70,6 +71,8 @@ class GenericCamera {
   using Mat42 = Eigen::Matrix<Scalar, 4, 2>;
   using Mat4 = Eigen::Matrix<Scalar, 4, 4>;
 
+  using BatchPoints2 = CameraBatchPoints2<Scalar>;
+
   /// Possible variants of camera models.
   using VariantT =
       std::variant<ExtendedUnifiedCamera<Scalar>, DoubleSphereCamera<Scalar>,
@@ -315,6 +318,48 @@ class GenericCamera {
         variant);
   }
 
+  /// @brief Project a batch of points stored in structure-of-arrays layout
+  ///
+  /// Requires a single std::visit for the whole batch and projects
+  /// CAMERA_BATCH_SIZE points at a time with the vectorized kernel of the
+  /// stored model. Jacobians are computed with respect to the point in the
+  /// camera frame, i.e. after applying T_c_w.
+  ///
+  /// @param[in] p3d 3xN or 4xN matrix of points to project
+  /// @param[in] T_c_w transformation from world to camera frame that should be
+  /// applied to points before projection
+  /// @param[out] proj results of projection, resized to 2xN
+  /// @param[out] valid 1 if projection is valid and 0 otherwise, resized to N
+  /// @param[out] d_proj_d_p3d if not nullptr contiguous storage for N 2x3 or
+  /// 2x4 Jacobians with respect to the points
+  /// @param[out] d_proj_d_param if not nullptr contiguous storage for N
+  /// column-major 2 x getN() Jacobians with respect to the intrinsics
+  template <class DerivedPoints3D, class DerivedJ3DPtr = std::nullptr_t>
+  inline void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+                           const Mat4& T_c_w, BatchPoints2& proj,
+                           CameraBatchValid& valid,
+                           DerivedJ3DPtr d_proj_d_p3d = nullptr,
+                           Scalar* d_proj_d_param = nullptr) const {
+    projectBatchImpl(p3d, &T_c_w, proj, valid, d_proj_d_p3d, d_proj_d_param);
+  }
+
+  /// @brief Project a batch of points stored in structure-of-arrays layout
+  ///
+  /// @param[in] p3d 3xN or 4xN matrix of points to project
+  /// @param[out] proj results of projection, resized to 2xN
+  /// @param[out] valid 1 if projection is valid and 0 otherwise, resized to N
+  /// @param[out] d_proj_d_p3d if not nullptr contiguous storage for N 2x3 or
+  /// 2x4 Jacobians with respect to the points
+  /// @param[out] d_proj_d_param if not nullptr contiguous storage for N
+  /// column-major 2 x getN() Jacobians with respect to the intrinsics
+  template <class DerivedPoints3D, class DerivedJ3DPtr = std::nullptr_t>
+  inline void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+                           BatchPoints2& proj, CameraBatchValid& valid,
+                           DerivedJ3DPtr d_proj_d_p3d = nullptr,
+                           Scalar* d_proj_d_param = nullptr) const {
+    projectBatchImpl(p3d, nullptr, proj, valid, d_proj_d_p3d, d_proj_d_param);
+  }
+
   /// @brief Unproject a vector of points
   ///
   /// @param[in] proj points to unproject
@@ -334,6 +379,99 @@ class GenericCamera {
         variant);
   }
 
+  /// @brief Unproject a batch of points stored in structure-of-arrays layout
+  ///
+  /// Requires a single std::visit for the whole batch and unprojects
+  /// CAMERA_BATCH_SIZE points at a time with the vectorized kernel of the
+  /// stored model. Unlike the overload with std::vector<bool> nothing is
+  /// resized or allocated: the outputs can be caller-owned matrices or
+  /// Eigen::Map of existing buffers and must have N columns / entries.
+  ///
+  /// @param[in] proj 2xN matrix of points to unproject
+  /// @param[out] p3d 3xN or 4xN matrix of unprojected points
+  /// @param[out] valid vector of N flags, 1 if unprojection is valid
+  template <class DerivedPoints2D, class DerivedPoints3D, class DerivedValid>
+  inline void unprojectBatch(
+      const Eigen::MatrixBase<DerivedPoints2D>& proj,
+      const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+      const Eigen::MatrixBase<DerivedValid>& valid) const {
+    std::visit(
+        [&](const auto& cam) { unprojectBatchChunks(cam, proj, p3d, valid); },
+        variant);
+  }
+
+  /// @brief Unproject an array of points into caller-provided storage
+  ///
+  /// Same as @ref unprojectBatch for points stored as consecutive Vec2 and
+  /// Vec4, e.g. the data of an aligned_vector or of an image-sized buffer
+  /// that is reused across frames.
+  ///
+  /// @param[in] proj num_points points to unproject
+  /// @param[in] num_points number of points
+  /// @param[out] p3d storage for num_points results of unprojection
+  /// @param[out] valid storage for num_points flags, 1 if unprojection is
+  /// valid and 0 otherwise
+  inline void unproject(const Vec2* proj, size_t num_points, Vec4* p3d,
+                        uint8_t* valid) const {
+    if (num_points == 0) return;
+
+    const Eigen::Map<const Eigen::Matrix<Scalar, 2, Eigen::Dynamic>> proj_mat(
+        proj->data(), 2, num_points);
+    Eigen::Map<Eigen::Matrix<Scalar, 4, Eigen::Dynamic>> p3d_mat(p3d->data(),
+                                                                 4, num_points);
+    Eigen::Map<CameraBatchValid> valid_vec(valid, num_points);
+
+    unprojectBatch(proj_mat, p3d_mat, valid_vec);
+  }
+
+  /// @brief Build a lookup table for fast unprojection
+  ///
+  /// The table is built with the unproject function of the stored model and
+  /// has to be rebuilt if the intrinsics change. See @ref UnprojectLut for the
+  /// error characteristics.
+  ///
+  /// @param[in] width image width in pixels
+  /// @param[in] height image height in pixels
+  /// @param[in] step distance between grid nodes in pixels
+  /// @return table of bearing vectors
+  inline UnprojectLut<Scalar> makeUnprojectLut(int width, int height,
+                                               int step = 1) const {
+    UnprojectLut<Scalar> res;
+    std::visit([&](const auto& cam) { res.build(cam, width, height, step); },
+               variant);
+    return res;
+  }
+
+  /// @brief Call f with the stored camera model
+  ///
+  /// Per-point calls like @ref project or @ref getParam dispatch on the
+  /// variant every time, which prevents inlining and vectorization across
+  /// points. visitBatch dispatches once and runs f on the concrete model, so a
+  /// loop over points inside f is compiled for each model separately:
+  ///
+  /// ```
+  /// cam.visitBatch([&](const auto& c) {
+  ///   for (size_t i = 0; i < p3d.size(); i++) c.project(p3d[i], proj[i]);
+  /// });
+  /// ```
+  ///
+  /// f has to return the same type for all models. See also
+  /// @ref visitCameraModel for code that accepts any camera type.
+  ///
+  /// @param[in] f callable taking the concrete camera model
+  /// @return result of f
+  template <class F>
+  inline decltype(auto) visitBatch(F&& f) const {
+    return std::visit(std::forward<F>(f), variant);
+  }
+
+  /// @brief Call f with the stored camera model, which f may modify. See
+  /// overload above.
+  template <class F>
+  inline decltype(auto) visitBatch(F&& f) {
+    return std::visit(std::forward<F>(f), variant);
+  }
+
   /// @brief Construct a particular type of camera model from name
   static GenericCamera<Scalar> fromString(const std::string& name) {
     GenericCamera<Scalar> res;
@@ -347,6 +485,27 @@ class GenericCamera {
   VariantT variant;
 
  private:
+  /// @brief Shared implementation of the projectBatch overloads
+  template <class DerivedPoints3D, class DerivedJ3DPtr>
+  inline void projectBatchImpl(const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+                               const Mat4* T_c_w, BatchPoints2& proj,
+                               CameraBatchValid& valid,
+                               DerivedJ3DPtr d_proj_d_p3d,
+                               Scalar* d_proj_d_param) const {
+    proj.resize(2, p3d.cols());
+    valid.resize(p3d.cols());
+    std::visit(
+        [&](const auto& cam) {
+          if (d_proj_d_param) {
+            projectBatchChunks(cam, p3d, T_c_w, proj, valid, d_proj_d_p3d,
+                               d_proj_d_param);
+          } else {
+            projectBatchChunks(cam, p3d, T_c_w, proj, valid, d_proj_d_p3d);
+          }
+        },
+        variant);
+  }
+
   /// @brief Iterate over all possible types of the variant and construct that
   /// type that has a matching name
   template <int I>
@@ -39,6 +39,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <basalt/camera/camera_batch.hpp>
 #include <basalt/camera/camera_static_assert.hpp>
 
 #include <basalt/utils/sophus_utils.hpp>
@@ -76,6 +77,10 @@ class KannalaBrandtCamera4 {
   using Mat42 = Eigen::Matrix<Scalar, 4, 2>;
   using Mat4N = Eigen::Matrix<Scalar, 4, N>;
 
+  using BatchArray = CameraBatchArray<Scalar>;
+  using BatchJ3D = CameraBatchJ3D<Scalar>;
+  using BatchJparam = CameraBatchJparam<Scalar, N>;
+
   /// @brief Default constructor with zero intrinsics
   KannalaBrandtCamera4() { param_.setZero(); }
 
@@ -326,6 +331,158 @@ class KannalaBrandtCamera4 {
     return theta;
   }
 
+  /// @brief Project a batch of points and optionally compute Jacobians
+  ///
+  /// Batch counterpart of @ref project that evaluates CAMERA_BATCH_SIZE points
+  /// at once with @ref projectChunk, see @ref projectBatchChunks.
+  ///
+  /// @param[in] p3d 3xN or 4xN matrix of points to project
+  /// @param[out] proj 2xN matrix of projections
+  /// @param[out] valid vector of N flags, 1 if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr contiguous storage for one 2x3 or
+  /// 2x4 Jacobian with respect to the point per projection
+  /// @param[out] d_proj_d_param if not nullptr contiguous storage for one
+  /// Mat2N Jacobian with respect to the intrinsics per projection
+  template <class DerivedPoints3D, class DerivedPoints2D, class DerivedValid,
+            class DerivedJ3DPtr = std::nullptr_t,
+            class DerivedJparamPtr = std::nullptr_t>
+  inline void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+                           const Eigen::MatrixBase<DerivedPoints2D>& proj,
+                           const Eigen::MatrixBase<DerivedValid>& valid,
+                           DerivedJ3DPtr d_proj_d_p3d = nullptr,
+                           DerivedJparamPtr d_proj_d_param = nullptr) const {
+    projectBatchChunks(*this, p3d, nullptr, proj, valid, d_proj_d_p3d,
+                       d_proj_d_param);
+  }
+
+  /// @brief Project a chunk of points given as coordinate arrays
+  ///
+  /// Same arithmetic as @ref project evaluated for all lanes at once.
+  ///
+  /// @param[in] x, y, z coordinates of the points
+  /// @param[out] u, v coordinates of the projections
+  /// @param[out] is_valid if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr Jacobians with respect to the
+  /// point, see @ref CameraBatchJ3D
+  /// @param[out] d_proj_d_param if not nullptr Jacobians with respect to the
+  /// intrinsics, see @ref CameraBatchJparam
+  inline void projectChunk(const BatchArray& x, const BatchArray& y,
+                           const BatchArray& z, BatchArray& u, BatchArray& v,
+                           CameraBatchMask& is_valid,
+                           BatchJ3D* d_proj_d_p3d = nullptr,
+                           BatchJparam* d_proj_d_param = nullptr) const {
+    const Scalar& fx = param_[0];
+    const Scalar& fy = param_[1];
+    const Scalar& cx = param_[2];
+    const Scalar& cy = param_[3];
+    const Scalar& k1 = param_[4];
+    const Scalar& k2 = param_[5];
+    const Scalar& k3 = param_[6];
+    const Scalar& k4 = param_[7];
+
+    const BatchArray r2 = x * x + y * y;
+    const BatchArray r = r2.sqrt();
+
+    // Both branches of project are evaluated and the result is selected per
+    // lane. The pinhole branch is used close to the optical axis.
+    const CameraBatchMask use_theta =
+        r > Sophus::Constants<Scalar>::epsilonSqrt();
+    const BatchArray r_safe = use_theta.select(r, Scalar(1));
+    const BatchArray r2_safe = use_theta.select(r2, Scalar(1));
+
+    const BatchArray theta = batchAtan2<Scalar>(r, z);
+    const BatchArray theta2 = theta * theta;
+
+    BatchArray r_theta = k4 * theta2;
+    r_theta += k3;
+    r_theta *= theta2;
+    r_theta += k2;
+    r_theta *= theta2;
+    r_theta += k1;
+    r_theta *= theta2;
+    r_theta += 1;
+    r_theta *= theta;
+
+    const BatchArray mx = use_theta.select(x * r_theta / r_safe, x / z);
+    const BatchArray my = use_theta.select(y * r_theta / r_safe, y / z);
+
+    u = fx * mx + cx;
+    v = fy * my + cy;
+
+    is_valid = use_theta || (z >= Sophus::Constants<Scalar>::epsilonSqrt());
+
+    if (d_proj_d_p3d) {
+      BatchJ3D& J = *d_proj_d_p3d;
+
+      const BatchArray d_r_d_x = x / r_safe;
+      const BatchArray d_r_d_y = y / r_safe;
+
+      const BatchArray tmp = (z * z + r2);
+      const BatchArray d_theta_d_x = d_r_d_x * z / tmp;
+      const BatchArray d_theta_d_y = d_r_d_y * z / tmp;
+      const BatchArray d_theta_d_z = -r / tmp;
+
+      BatchArray d_r_theta_d_theta = Scalar(9) * k4 * theta2;
+      d_r_theta_d_theta += Scalar(7) * k3;
+      d_r_theta_d_theta *= theta2;
+      d_r_theta_d_theta += Scalar(5) * k2;
+      d_r_theta_d_theta *= theta2;
+      d_r_theta_d_theta += Scalar(3) * k1;
+      d_r_theta_d_theta *= theta2;
+      d_r_theta_d_theta += Scalar(1);
+
+      const BatchArray z2 = z * z;
+
+      J.col(0) = use_theta.select(
+          fx *
+              (r_theta * r + x * r * d_r_theta_d_theta * d_theta_d_x -
+               x * x * r_theta / r_safe) /
+              r2_safe,
+          fx / z);
+      J.col(1) = use_theta.select(
+          fy * y *
+              (d_r_theta_d_theta * d_theta_d_x * r - x * r_theta / r_safe) /
+              r2_safe,
+          Scalar(0));
+
+      J.col(2) = use_theta.select(
+          fx * x *
+              (d_r_theta_d_theta * d_theta_d_y * r - y * r_theta / r_safe) /
+              r2_safe,
+          Scalar(0));
+      J.col(3) = use_theta.select(
+          fy *
+              (r_theta * r + y * r * d_r_theta_d_theta * d_theta_d_y -
+               y * y * r_theta / r_safe) /
+              r2_safe,
+          fy / z);
+
+      J.col(4) = use_theta.select(
+          fx * x * d_r_theta_d_theta * d_theta_d_z / r_safe, -fx * x / z2);
+      J.col(5) = use_theta.select(
+          fy * y * d_r_theta_d_theta * d_theta_d_z / r_safe, -fy * y / z2);
+    }
+
+    if (d_proj_d_param) {
+      BatchJparam& J = *d_proj_d_param;
+
+      J.setZero();
+      J.col(0) = mx;
+      J.col(4).setOnes();
+      J.col(3) = my;
+      J.col(7).setOnes();
+
+      J.col(8) =
+          use_theta.select(fx * x * theta * theta2 / r_safe, Scalar(0));
+      J.col(9) =
+          use_theta.select(fy * y * theta * theta2 / r_safe, Scalar(0));
+
+      for (int i = 10; i < 2 * N; i++) {
+        J.col(i) = J.col(i - 2) * theta2;
+      }
+    }
+  }
+
   /// @brief Unproject the point and optionally compute Jacobians
   ///
   /// The unprojection function is computed as follows: \f{align}{
@@ -482,6 +639,90 @@ class KannalaBrandtCamera4 {
     return true;
   }
 
+  /// @brief Unproject a batch of points
+  ///
+  /// Batch counterpart of @ref unproject that evaluates CAMERA_BATCH_SIZE
+  /// points at once with @ref unprojectChunk, see @ref unprojectBatchChunks.
+  /// Outputs are written to caller-provided storage without allocation.
+  ///
+  /// @param[in] proj 2xN matrix of points to unproject
+  /// @param[out] p3d 3xN or 4xN matrix of unprojected points
+  /// @param[out] valid vector of N flags, 1 if unprojection is valid
+  template <class DerivedPoints2D, class DerivedPoints3D, class DerivedValid>
+  inline void unprojectBatch(
+      const Eigen::MatrixBase<DerivedPoints2D>& proj,
+      const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+      const Eigen::MatrixBase<DerivedValid>& valid) const {
+    unprojectBatchChunks(*this, proj, p3d, valid);
+  }
+
+  /// @brief Unproject a chunk of points given as coordinate arrays
+  ///
+  /// Same arithmetic as @ref unproject evaluated for all lanes at once. All
+  /// lanes run the same number of Newton iterations as @ref solveTheta.
+  ///
+  /// @param[in] u, v coordinates of the points to unproject
+  /// @param[out] x, y, z coordinates of the unprojected points
+  /// @param[out] is_valid if unprojection is valid
+  inline void unprojectChunk(const BatchArray& u, const BatchArray& v,
+                             BatchArray& x, BatchArray& y, BatchArray& z,
+                             CameraBatchMask& is_valid) const {
+    const Scalar& fx = param_[0];
+    const Scalar& fy = param_[1];
+    const Scalar& cx = param_[2];
+    const Scalar& cy = param_[3];
+    const Scalar& k1 = param_[4];
+    const Scalar& k2 = param_[5];
+    const Scalar& k3 = param_[6];
+    const Scalar& k4 = param_[7];
+
+    const BatchArray mx = (u - cx) / fx;
+    const BatchArray my = (v - cy) / fy;
+
+    const BatchArray thetad = (mx * mx + my * my).sqrt();
+
+    BatchArray theta = thetad;
+    for (int i = 0; i < 3; i++) {
+      const BatchArray theta2 = theta * theta;
+
+      BatchArray func = k4 * theta2;
+      func += k3;
+      func *= theta2;
+      func += k2;
+      func *= theta2;
+      func += k1;
+      func *= theta2;
+      func += Scalar(1);
+      func *= theta;
+
+      BatchArray d_func_d_theta = Scalar(9) * k4 * theta2;
+      d_func_d_theta += Scalar(7) * k3;
+      d_func_d_theta *= theta2;
+      d_func_d_theta += Scalar(5) * k2;
+      d_func_d_theta *= theta2;
+      d_func_d_theta += Scalar(3) * k1;
+      d_func_d_theta *= theta2;
+      d_func_d_theta += Scalar(1);
+
+      theta += (thetad - func) / d_func_d_theta;
+    }
+
+    // Close to the optical axis the point is unprojected without distortion
+    // like in unproject.
+    const CameraBatchMask use_theta =
+        thetad > Sophus::Constants<Scalar>::epsilonSqrt();
+    const BatchArray thetad_safe = use_theta.select(thetad, Scalar(1));
+
+    const BatchArray scaling =
+        use_theta.select(theta.sin() / thetad_safe, Scalar(1));
+
+    x = mx * scaling;
+    y = my * scaling;
+    z = use_theta.select(theta.cos(), Scalar(1));
+
+    is_valid.setConstant(true);
+  }
+
   /// @brief Increment intrinsic parameters by inc
   ///
   /// @param[in] inc increment vector
@@ -38,6 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <basalt/camera/camera_batch.hpp>
 #include <basalt/camera/camera_static_assert.hpp>
 
 #include <basalt/utils/sophus_utils.hpp>
@@ -69,6 +70,10 @@ class UnifiedCamera {
   using Mat42 = Eigen::Matrix<Scalar, 4, 2>;
   using Mat4N = Eigen::Matrix<Scalar, 4, N>;
 
+  using BatchArray = CameraBatchArray<Scalar>;
+  using BatchJ3D = CameraBatchJ3D<Scalar>;
+  using BatchJparam = CameraBatchJparam<Scalar, N>;
+
   /// @brief Default constructor with zero intrinsics
   UnifiedCamera() { param_.setZero(); }
 
@@ -197,6 +202,104 @@ class UnifiedCamera {
     return is_valid;
   }
 
+  /// @brief Project a batch of points and optionally compute Jacobians
+  ///
+  /// Batch counterpart of @ref project that evaluates CAMERA_BATCH_SIZE points
+  /// at once with @ref projectChunk, see @ref projectBatchChunks.
+  ///
+  /// @param[in] p3d 3xN or 4xN matrix of points to project
+  /// @param[out] proj 2xN matrix of projections
+  /// @param[out] valid vector of N flags, 1 if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr contiguous storage for one 2x3 or
+  /// 2x4 Jacobian with respect to the point per projection
+  /// @param[out] d_proj_d_param if not nullptr contiguous storage for one
+  /// Mat2N Jacobian with respect to the intrinsics per projection
+  template <class DerivedPoints3D, class DerivedPoints2D, class DerivedValid,
+            class DerivedJ3DPtr = std::nullptr_t,
+            class DerivedJparamPtr = std::nullptr_t>
+  inline void projectBatch(const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+                           const Eigen::MatrixBase<DerivedPoints2D>& proj,
+                           const Eigen::MatrixBase<DerivedValid>& valid,
+                           DerivedJ3DPtr d_proj_d_p3d = nullptr,
+                           DerivedJparamPtr d_proj_d_param = nullptr) const {
+    projectBatchChunks(*this, p3d, nullptr, proj, valid, d_proj_d_p3d,
+                       d_proj_d_param);
+  }
+
+  /// @brief Project a chunk of points given as coordinate arrays
+  ///
+  /// Same arithmetic as @ref project evaluated for all lanes at once.
+  ///
+  /// @param[in] x, y, z coordinates of the points
+  /// @param[out] u, v coordinates of the projections
+  /// @param[out] is_valid if projection is valid
+  /// @param[out] d_proj_d_p3d if not nullptr Jacobians with respect to the
+  /// point, see @ref CameraBatchJ3D
+  /// @param[out] d_proj_d_param if not nullptr Jacobians with respect to the
+  /// intrinsics, see @ref CameraBatchJparam
+  inline void projectChunk(const BatchArray& x, const BatchArray& y,
+                           const BatchArray& z, BatchArray& u, BatchArray& v,
+                           CameraBatchMask& is_valid,
+                           BatchJ3D* d_proj_d_p3d = nullptr,
+                           BatchJparam* d_proj_d_param = nullptr) const {
+    const Scalar& fx = param_[0];
+    const Scalar& fy = param_[1];
+    const Scalar& cx = param_[2];
+    const Scalar& cy = param_[3];
+    const Scalar& alpha = param_[4];
+
+    const BatchArray r2 = x * x + y * y;
+    const BatchArray rho = (r2 + z * z).sqrt();
+
+    const BatchArray norm = alpha * rho + (Scalar(1) - alpha) * z;
+
+    const BatchArray mx = x / norm;
+    const BatchArray my = y / norm;
+
+    u = fx * mx + cx;
+    v = fy * my + cy;
+
+    const Scalar w = alpha > Scalar(0.5) ? (Scalar(1) - alpha) / alpha
+                                         : alpha / (Scalar(1) - alpha);
+    is_valid = z > -w * rho;
+
+    if (d_proj_d_p3d) {
+      BatchJ3D& J = *d_proj_d_p3d;
+      const BatchArray denom = norm * norm * rho;
+      const BatchArray mid = -(alpha * x * y);
+      const BatchArray add = norm * rho;
+      const BatchArray addz = (alpha * z + (Scalar(1) - alpha) * rho);
+
+      J.col(0) = fx * (add - x * x * alpha);
+      J.col(1) = fy * mid;
+      J.col(2) = fx * mid;
+      J.col(3) = fy * (add - y * y * alpha);
+      J.col(4) = -fx * x * addz;
+      J.col(5) = -fy * y * addz;
+
+      J.colwise() /= denom;
+    }
+
+    if (d_proj_d_param) {
+      BatchJparam& J = *d_proj_d_param;
+      const BatchArray norm2 = norm * norm;
+
+      J.setZero();
+      J.col(0) = mx;
+      J.col(4).setOnes();
+      J.col(3) = my;
+      J.col(7).setOnes();
+
+      const BatchArray tmp_x = -fx * x / norm2;
+      const BatchArray tmp_y = -fy * y / norm2;
+
+      const BatchArray tmp4 = (rho - z);
+
+      J.col(8) = tmp_x * tmp4;
+      J.col(9) = tmp_y * tmp4;
+    }
+  }
+
   /// @brief Unproject the point and optionally compute Jacobians
   ///
   /// The unprojection function is computed as follows: \f{align}{
@@ -340,6 +443,64 @@ class UnifiedCamera {
     return is_valid;
   }
 
+  /// @brief Unproject a batch of points
+  ///
+  /// Batch counterpart of @ref unproject that evaluates CAMERA_BATCH_SIZE
+  /// points at once with @ref unprojectChunk, see @ref unprojectBatchChunks.
+  /// Outputs are written to caller-provided storage without allocation.
+  ///
+  /// @param[in] proj 2xN matrix of points to unproject
+  /// @param[out] p3d 3xN or 4xN matrix of unprojected points
+  /// @param[out] valid vector of N flags, 1 if unprojection is valid
+  template <class DerivedPoints2D, class DerivedPoints3D, class DerivedValid>
+  inline void unprojectBatch(
+      const Eigen::MatrixBase<DerivedPoints2D>& proj,
+      const Eigen::MatrixBase<DerivedPoints3D>& p3d,
+      const Eigen::MatrixBase<DerivedValid>& valid) const {
+    unprojectBatchChunks(*this, proj, p3d, valid);
+  }
+
+  /// @brief Unproject a chunk of points given as coordinate arrays
+  ///
+  /// Same arithmetic as @ref unproject evaluated for all lanes at once.
+  ///
+  /// @param[in] u, v coordinates of the points to unproject
+  /// @param[out] x, y, z coordinates of the unprojected points
+  /// @param[out] is_valid if unprojection is valid
+  inline void unprojectChunk(const BatchArray& u, const BatchArray& v,
+                             BatchArray& x, BatchArray& y, BatchArray& z,
+                             CameraBatchMask& is_valid) const {
+    const Scalar& fx = param_[0];
+    const Scalar& fy = param_[1];
+    const Scalar& cx = param_[2];
+    const Scalar& cy = param_[3];
+    const Scalar& alpha = param_[4];
+
+    const Scalar xi = alpha / (Scalar(1) - alpha);
+
+    const BatchArray mx = (Scalar(1) - alpha) * ((u - cx) / fx);
+    const BatchArray my = (Scalar(1) - alpha) * ((v - cy) / fy);
+
+    const BatchArray r2 = mx * mx + my * my;
+
+    if (alpha > Scalar(0.5)) {
+      is_valid = !(r2 >= Scalar(1) / (Scalar(2) * alpha - Scalar(1)));
+    } else {
+      is_valid.setConstant(true);
+    }
+
+    const Scalar xi2 = xi * xi;
+
+    const BatchArray n = (Scalar(1) + (Scalar(1) - xi2) * r2).sqrt();
+    const BatchArray m = Scalar(1) + r2;
+
+    const BatchArray k = (xi + n) / m;
+
+    x = k * mx;
+    y = k * my;
+    z = k - xi;
+  }
+
   /// @brief Set parameters from initialization
   ///
   /// Initializes the camera model to  \f$ \left[f_x, f_y, c_x, c_y, 0.5,
@@ -0,0 +1,301 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Lookup table of bearing vectors for fast unprojection
+*/
+
+#pragma once
+
+#include <basalt/camera/camera_batch.hpp>
+#include <basalt/utils/assert.h>
+#include <basalt/utils/eigen_utils.hpp>
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace basalt {
+
+/// @brief Precomputed table of bearing vectors for O(1) unprojection
+///
+/// Models like KannalaBrandtCamera4 or PinholeRadtan8Camera unproject with an
+/// iterative solve, which dominates when whole images or dense keypoints are
+/// unprojected. This table stores the result of the camera's own unproject on
+/// a regular grid of pixels every `step` pixels and answers queries by
+/// bilinear interpolation of the four surrounding bearing vectors followed by
+/// normalization.
+///
+/// Grid nodes whose unprojection does not project back to the same pixel are
+/// marked invalid, as are queries that touch them.
+///
+/// With step = 1 the result at integer pixel positions is exact up to
+/// rounding. In between grid nodes the error of bilinear interpolation is
+/// bounded by (step^2 / 8) * (sup |d^2 b / du^2| + sup |d^2 b / dv^2|) with b
+/// the unit bearing vector as a function of the pixel position (u, v) and the
+/// supremum taken over the cell. Normalization does not increase the angular
+/// error beyond asin of that bound. For pinhole-like models the second
+/// derivatives are of the order 1 / f^2 with f the focal length in pixels, so
+/// the error is roughly step^2 / (4 f^2) radians; it grows quadratically with
+/// the step and is largest close to the border of the valid area of wide angle
+/// models. @ref build does not measure the error; use @ref estimateMaxError
+/// to check a table against the camera model.
+template <typename Scalar_>
+class UnprojectLut {
+ public:
+  using Scalar = Scalar_;
+
+  using Vec2 = Eigen::Matrix<Scalar, 2, 1>;
+  using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+  using Vec4 = Eigen::Matrix<Scalar, 4, 1>;
+
+  /// @brief Default constructor creates an empty table that fails every query
+  UnprojectLut() = default;
+
+  /// @brief Build the table from a camera model
+  ///
+  /// @param[in] cam camera model with unproject(Vec2, Vec4), e.g. any of the
+  /// concrete models or GenericCamera. A GenericCamera is dispatched once for
+  /// the whole table.
+  /// @param[in] width image width in pixels
+  /// @param[in] height image height in pixels
+  /// @param[in] step distance between grid nodes in pixels. 1 gives a table at
+  /// full resolution, larger values sub-sample it.
+  template <class CamT>
+  void build(const CamT& cam, int width, int height, int step = 1) {
+    visitCameraModel(cam, [&](const auto& c) {
+      buildImpl(c, width, height, step);
+    });
+  }
+
+  /// @brief Unproject a point using the table
+  ///
+  /// @param[in] proj point to unproject in pixels
+  /// @param[out] p3d unit bearing vector, last component is 0
+  /// @return false if proj is outside the table or any of the four surrounding
+  /// grid nodes could not be unprojected
+  inline bool unproject(const Vec2& proj, Vec4& p3d) const {
+    const Scalar x = proj[0] * inv_step_;
+    const Scalar y = proj[1] * inv_step_;
+
+    if (!(x >= 0 && y >= 0 && x <= Scalar(cols_ - 1) &&
+          y <= Scalar(rows_ - 1))) {
+      p3d.setZero();
+      return false;
+    }
+
+    const int ix = std::min(int(x), cols_ - 2);
+    const int iy = std::min(int(y), rows_ - 2);
+
+    const Scalar dx = x - ix;
+    const Scalar dy = y - iy;
+
+    const int idx = iy * cols_ + ix;
+
+    if (!(valid_[idx] && valid_[idx + 1] && valid_[idx + cols_] &&
+          valid_[idx + cols_ + 1])) {
+      p3d.setZero();
+      return false;
+    }
+
+    const Scalar ddx = Scalar(1) - dx;
+    const Scalar ddy = Scalar(1) - dy;
+
+    const Vec3 b =
+        ddy * (ddx * bearings_.col(idx) + dx * bearings_.col(idx + 1)) +
+        dy * (ddx * bearings_.col(idx + cols_) +
+              dx * bearings_.col(idx + cols_ + 1));
+
+    p3d.template head<3>() = b.normalized();
+    p3d[3] = Scalar(0);
+    return true;
+  }
+
+  /// @brief Unproject a vector of points using the table
+  ///
+  /// @param[in] proj points to unproject
+  /// @param[out] p3d results of unprojection
+  /// @param[out] unproj_success if unprojection is valid
+  inline void unproject(const Eigen::aligned_vector<Vec2>& proj,
+                        Eigen::aligned_vector<Vec4>& p3d,
+                        std::vector<bool>& unproj_success) const {
+    p3d.resize(proj.size());
+    unproj_success.resize(proj.size());
+    for (size_t i = 0; i < proj.size(); i++) {
+      unproj_success[i] = unproject(proj[i], p3d[i]);
+    }
+  }
+
+  /// @brief Estimate the maximum angular error of the table in radians
+  ///
+  /// Compares the table against the camera model at the edge midpoints and the
+  /// center of a subset of the cells, where the interpolation error of a cell
+  /// is largest. If the table has more than max_cells cells, every k-th row and
+  /// column of cells is sampled such that at most about max_cells cells are
+  /// checked; the last row and column of cells, which are closest to the image
+  /// border, are always included. This is an estimate: between the samples and
+  /// in cells that are skipped the error can be larger.
+  ///
+  /// @param[in] cam camera model the table was built from
+  /// @param[in] max_cells approximate number of cells to check
+  /// @return maximum angular error found, 0 for an empty table
+  template <class CamT>
+  Scalar estimateMaxError(const CamT& cam, int max_cells = 4096) const {
+    Scalar res = 0;
+    visitCameraModel(cam, [&](const auto& c) {
+      res = estimateMaxErrorImpl(c, max_cells);
+    });
+    return res;
+  }
+
+  /// @brief Distance between grid nodes in pixels
+  inline int getStep() const { return step_; }
+
+  /// @brief Returns true if the table was not built yet
+  inline bool empty() const { return valid_.empty(); }
+
+ private:
+  /// @brief Build the table from a concrete camera model, see @ref build
+  template <class CamT>
+  void buildImpl(const CamT& cam, int width, int height, int step) {
+    BASALT_ASSERT(width > 0 && height > 0);
+    BASALT_ASSERT(step > 0);
+
+    step_ = step;
+    inv_step_ = Scalar(1) / Scalar(step);
+
+    // Nodes cover the pixel range [0, width - 1] x [0, height - 1].
+    cols_ = (width - 1 + step - 1) / step + 1;
+    rows_ = (height - 1 + step - 1) / step + 1;
+    cols_ = std::max(cols_, 2);
+    rows_ = std::max(rows_, 2);
+
+    bearings_.resize(3, cols_ * rows_);
+    valid_.resize(cols_ * rows_);
+
+    for (int r = 0; r < rows_; r++) {
+      for (int c = 0; c < cols_; c++) {
+        const int idx = r * cols_ + c;
+
+        const Vec2 proj(Scalar(c * step), Scalar(r * step));
+
+        Vec4 p3d;
+        valid_[idx] = unprojectChecked(cam, proj, p3d);
+        if (valid_[idx]) {
+          bearings_.col(idx) = p3d.template head<3>().normalized();
+        } else {
+          bearings_.col(idx).setZero();
+        }
+      }
+    }
+  }
+
+  /// @brief Estimate the error for a concrete camera model, see
+  /// @ref estimateMaxError
+  template <class CamT>
+  Scalar estimateMaxErrorImpl(const CamT& cam, int max_cells) const {
+    if (empty()) return 0;
+
+    const int num_cells = (cols_ - 1) * (rows_ - 1);
+    const int stride =
+        std::max(1, int(std::ceil(std::sqrt(Scalar(num_cells) /
+                                            Scalar(std::max(max_cells, 1))))));
+
+    // Edge midpoints and center of a cell relative to its top left node
+    const Scalar half = Scalar(step_) / Scalar(2);
+    const Vec2 offsets[5] = {Vec2(half, 0), Vec2(0, half), Vec2(half, half),
+                             Vec2(Scalar(step_), half),
+                             Vec2(half, Scalar(step_))};
+
+    Scalar max_error = 0;
+    for (int r = 0; r < rows_ - 1; r++) {
+      if (r % stride != 0 && r != rows_ - 2) continue;
+
+      for (int c = 0; c < cols_ - 1; c++) {
+        if (c % stride != 0 && c != cols_ - 2) continue;
+
+        const Vec2 corner(Scalar(c * step_), Scalar(r * step_));
+        for (const Vec2& offset : offsets) {
+          const Vec2 p = corner + offset;
+
+          Vec4 p3d_exact, p3d_lut;
+          if (unprojectChecked(cam, p, p3d_exact) && unproject(p, p3d_lut)) {
+            const Scalar chord = (p3d_exact.template head<3>().normalized() -
+                                  p3d_lut.template head<3>())
+                                     .norm();
+            const Scalar angle =
+                Scalar(2) * std::asin(std::min(Scalar(1), chord / Scalar(2)));
+            max_error = std::max(max_error, angle);
+          }
+        }
+      }
+    }
+
+    return max_error;
+  }
+
+  /// @brief Unproject with the camera model and check that the result
+  /// projects back to the same pixel
+  ///
+  /// Iterative models can converge to a wrong solution far from the valid
+  /// area, which would otherwise end up in the table.
+  template <class CamT>
+  static bool unprojectChecked(const CamT& cam, const Vec2& proj, Vec4& p3d) {
+    if (!cam.unproject(proj, p3d) || !p3d.allFinite()) return false;
+
+    Vec2 reproj;
+    if (!cam.project(p3d, reproj)) return false;
+
+    return (reproj - proj).norm() < REPROJECTION_THRESHOLD;
+  }
+
+  /// Maximum reprojection error of a grid node in pixels
+  static constexpr Scalar REPROJECTION_THRESHOLD = Scalar(1e-2);
+
+  int step_ = 1;
+  Scalar inv_step_ = 1;
+  int cols_ = 0;
+  int rows_ = 0;
+
+  /// Unit bearing vectors of the grid nodes, row by row
+  Eigen::Matrix<Scalar, 3, Eigen::Dynamic> bearings_;
+
+  /// 1 if the grid node could be unprojected
+  std::vector<uint8_t> valid_;
+};
+
+}  // namespace basalt
@@ -0,0 +1,246 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Image with precomputed cubic spline coefficients
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include <Eigen/Dense>
+
+#include <basalt/image/image.h>
+#include <basalt/image/texel_image.h>
+
+namespace basalt {
+
+/// @brief Image of horizontal cubic spline coefficients, for fast evaluation
+/// of \ref Image::interpCubicSplines and \ref Image::interpGradCubicSplines.
+///
+/// The Image methods evaluate \ref CubHermiteSpline for the 4 rows of the
+/// 4x4 neighbourhood and once more vertically, computing the spline
+/// coefficients from the 16 pixels for every point. Here the coefficients
+/// [a, b, c, d] of the horizontal spline starting at every pixel are
+/// computed once per image, with the same border clamping as the Image
+/// methods. Since the splines are linear in the coefficients, a point then
+/// reads 4 texels of one column, blends them with the vertical spline
+/// weights and evaluates the blended polynomial (and its derivatives) with
+/// Horner's scheme. The result is the same as the Image methods up to
+/// rounding of the floating point type.
+///
+/// The coefficients are half-integers for 8 and 16 bit images and stored
+/// exactly as float. Like \ref GradientImage texels take 16 bytes per pixel,
+/// so this pays off if many points are interpolated per image.
+template <typename T, class Allocator = DefaultImageAllocator<T>>
+class CubicSplineImage : public TexelImage<T, Texel4f, Allocator> {
+ public:
+  using Base = TexelImage<T, Texel4f, Allocator>;
+  using CoeffType = float;
+
+  /// @brief Coefficients [a, b, c, d] of f(t) = a t^3 + b t^2 + c t + d.
+  using Texel = typename Base::Texel;
+
+  using Base::InBounds;
+
+  /// @brief Default constructor, the image is empty.
+  inline CubicSplineImage() {}
+
+  /// @brief Construct from image, see \ref setFromImage.
+  inline explicit CubicSplineImage(const Image<const T>& img) {
+    setFromImage(img);
+  }
+
+  /// @brief Compute spline coefficients for image. Memory is kept if the
+  /// size of the image does not change.
+  ///
+  /// @param[in] img image, e.g. a level of \ref ManagedImagePyr
+  inline void setFromImage(const Image<const T>& img) {
+    texels_.Reinitialise(img.w, img.h);
+
+    const int w = img.w;
+
+    for (size_t y = 0; y < img.h; y++) {
+      const T* row = img.RowPtr(y);
+      Texel* dst = texels_.RowPtr(y);
+
+      for (int x = 0; x < w; x++) {
+        // same clamping as Image::clamp
+        const int p0 = row[std::max(x - 1, 0)];
+        const int p1 = row[x];
+        const int p2 = row[std::min(x + 1, w - 1)];
+        const int p3 = row[std::min(x + 2, w - 1)];
+
+        // see CubHermiteSpline
+        dst[x].data[0] = CoeffType(0.5) * (-p0 + 3 * p1 - 3 * p2 + p3);
+        dst[x].data[1] = CoeffType(0.5) * (2 * p0 - 5 * p1 + 4 * p2 - p3);
+        dst[x].data[2] = CoeffType(0.5) * (-p0 + p2);
+        dst[x].data[3] = CoeffType(p1);
+      }
+    }
+  }
+
+  /// @brief Interpolated image value, same as \ref
+  /// Image::interpCubicSplines.
+  ///
+  /// There is no bounds check (unless BASALT_ENABLE_BOUNDS_CHECKS is defined).
+  /// We assume that the pixel coordinates satisfy InBounds(x, y, 0).
+  template <typename S>
+  inline S interpCubicSplines(const Eigen::Matrix<S, 2, 1>& p) const {
+    return interpCubicSplines<S>(p[0], p[1]);
+  }
+
+  /// @brief Interpolated image value, see overload above.
+  template <typename S>
+  inline S interpCubicSplines(S x, S y) const {
+    static_assert(std::is_floating_point_v<S>,
+                  "interpolation / gradient only makes sense "
+                  "for floating point result type");
+
+    BASALT_BOUNDS_ASSERT(InBounds(x, y, 0));
+
+    const int ix = x;
+    const int iy = y;
+    const S dx = x - ix;
+    const S dy = y - iy;
+
+    const Eigen::Matrix<S, 4, 1> c = loadColumn<S>(ix, iy) * weights(dy);
+    return horner(c, dx);
+  }
+
+  /// @brief Image value and gradient, same as \ref
+  /// Image::interpGradCubicSplines.
+  ///
+  /// There is no bounds check (unless BASALT_ENABLE_BOUNDS_CHECKS is defined).
+  /// We assume that the pixel coordinates satisfy InBounds(x, y, 0).
+  template <typename S>
+  inline Eigen::Matrix<S, 3, 1> interpGradCubicSplines(
+      const Eigen::Matrix<S, 2, 1>& p) const {
+    return interpGradCubicSplines<S>(p[0], p[1]);
+  }
+
+  /// @brief Image value and gradient, see overload above.
+  template <typename S>
+  inline Eigen::Matrix<S, 3, 1> interpGradCubicSplines(S x, S y) const {
+    static_assert(std::is_floating_point_v<S>,
+                  "interpolation / gradient only makes sense "
+                  "for floating point result type");
+
+    BASALT_BOUNDS_ASSERT(InBounds(x, y, 0));
+
+    const int ix = x;
+    const int iy = y;
+    const S dx = x - ix;
+    const S dy = y - iy;
+
+    const Eigen::Matrix<S, 4, 4> coeffs = loadColumn<S>(ix, iy);
+
+    // The splines are linear in the coefficients, so blend the coefficients
+    // of the 4 rows vertically first and evaluate the blended splines.
+    const Eigen::Matrix<S, 4, 1> c = coeffs * weights(dy);
+    const Eigen::Matrix<S, 4, 1> dc = coeffs * weightsDerivative(dy);
+
+    return Eigen::Matrix<S, 3, 1>(horner(c, dx), hornerDerivative(c, dx),
+                                  horner(dc, dx));
+  }
+
+  /// @brief Batched version of \ref interpGradCubicSplines with the same
+  /// interface as \ref GradientImage::interpGradBatch.
+  ///
+  /// @param[in] points 2xN pixel coordinates
+  /// @param[out] res 3xN value and gradient for every point
+  template <typename DerivedP, typename DerivedRes>
+  inline void interpGradCubicSplinesBatch(
+      const Eigen::MatrixBase<DerivedP>& points,
+      const Eigen::MatrixBase<DerivedRes>& res) const {
+    using S = typename DerivedP::Scalar;
+    Base::evalBatch(points, res, [this](S x, S y) {
+      return interpGradCubicSplines<S>(x, y);
+    });
+  }
+
+ protected:
+  using Base::texels_;
+
+  /// Coefficients of the rows iy - 1, ..., iy + 2 at column ix as 4x4 matrix
+  /// with one row per column. Rows are clamped as in Image::clamp.
+  template <typename S>
+  inline Eigen::Matrix<S, 4, 4> loadColumn(int ix, int iy) const {
+    const int h = texels_.h;
+
+    Eigen::Matrix<S, 4, 4> coeffs;
+    coeffs.col(0) = loadTexel<S>(texels_.RowPtr(std::max(iy - 1, 0))[ix]);
+    coeffs.col(1) = loadTexel<S>(texels_.RowPtr(iy)[ix]);
+    coeffs.col(2) = loadTexel<S>(texels_.RowPtr(std::min(iy + 1, h - 1))[ix]);
+    coeffs.col(3) = loadTexel<S>(texels_.RowPtr(std::min(iy + 2, h - 1))[ix]);
+    return coeffs;
+  }
+
+  /// Evaluate a t^3 + b t^2 + c t + d for coefficients [a, b, c, d].
+  template <typename S>
+  static inline S horner(const Eigen::Matrix<S, 4, 1>& c, S t) {
+    return c[3] + t * (c[2] + t * (c[1] + t * c[0]));
+  }
+
+  /// Derivative of \ref horner with respect to t.
+  template <typename S>
+  static inline S hornerDerivative(const Eigen::Matrix<S, 4, 1>& c, S t) {
+    return c[2] + t * (S(2) * c[1] + S(3) * c[0] * t);
+  }
+
+  /// Weights of f(-1), f(0), f(1), f(2) in CubHermiteSpline at t.
+  template <typename S>
+  static inline Eigen::Matrix<S, 4, 1> weights(S t) {
+    const S t2 = t * t;
+    const S t3 = t2 * t;
+    return S(0.5) * Eigen::Matrix<S, 4, 1>(-t3 + S(2) * t2 - t,
+                                           S(3) * t3 - S(5) * t2 + S(2),
+                                           S(-3) * t3 + S(4) * t2 + t, t3 - t2);
+  }
+
+  /// Derivative of \ref weights with respect to t.
+  template <typename S>
+  static inline Eigen::Matrix<S, 4, 1> weightsDerivative(S t) {
+    const S t2 = t * t;
+    return S(0.5) * Eigen::Matrix<S, 4, 1>(S(-3) * t2 + S(4) * t - S(1),
+                                           S(9) * t2 - S(10) * t,
+                                           S(-9) * t2 + S(8) * t + S(1),
+                                           S(3) * t2 - S(2) * t);
+  }
+};
+
+}  // namespace basalt
@@ -0,0 +1,179 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Image with precomputed central-difference gradients
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include <Eigen/Dense>
+
+#include <basalt/image/image.h>
+#include <basalt/image/texel_image.h>
+
+namespace basalt {
+
+/// @brief Image of texels holding the pixel value and its central
+/// differences, for fast evaluation of \ref Image::interpGrad.
+///
+/// Image::interpGrad interpolates the central differences of the image
+/// bilinearly and reads 12 pixels per point. Here the differences are
+/// computed once per image with integer arithmetic, and every texel stores
+/// [value, I(x+1, y) - I(x-1, y), I(x, y+1) - I(x, y-1), 0]. Interpolation
+/// then reads the 4 neighbouring texels and blends them as one 4-vector, so
+/// the result is the same as Image::interpGrad up to rounding of the
+/// floating point type.
+///
+/// Texels are stored as float, which represents the integer values and
+/// differences of 8 and 16 bit images exactly and converts to the result
+/// type without integer to float conversions per point. The price is 16
+/// bytes per pixel, so computing the texels only pays off if many points are
+/// interpolated per image, e.g. for patch tracking on the pyramid levels.
+///
+/// Gradients of the border pixels (which interpGrad never uses, see
+/// \ref Image::InBounds) are set to zero.
+template <typename T, class Allocator = DefaultImageAllocator<T>>
+class GradientImage : public TexelImage<T, Texel4f, Allocator> {
+ public:
+  using Base = TexelImage<T, Texel4f, Allocator>;
+  using GradType = float;
+
+  /// @brief Texel with value, horizontal and vertical difference and padding.
+  using Texel = typename Base::Texel;
+
+  using Base::InBounds;
+
+  /// @brief Default constructor, the image is empty.
+  inline GradientImage() {}
+
+  /// @brief Construct from image, see \ref setFromImage.
+  inline explicit GradientImage(const Image<const T>& img) {
+    setFromImage(img);
+  }
+
+  /// @brief Compute texels for image. Memory is kept if the size of the
+  /// image does not change.
+  ///
+  /// @param[in] img image, e.g. a level of \ref ManagedImagePyr
+  inline void setFromImage(const Image<const T>& img) {
+    texels_.Reinitialise(img.w, img.h);
+
+    const int w = img.w;
+    const int h = img.h;
+
+    for (int y = 0; y < h; y++) {
+      const T* row = img.RowPtr(y);
+      Texel* dst = texels_.RowPtr(y);
+
+      if (y == 0 || y == h - 1 || w < 3) {
+        for (int x = 0; x < w; x++) {
+          dst[x] = Texel{{GradType(row[x]), 0, 0, 0}};
+        }
+        continue;
+      }
+
+      const T* row_m1 = img.RowPtr(y - 1);
+      const T* row_p1 = img.RowPtr(y + 1);
+
+      dst[0] = Texel{{GradType(row[0]), 0, 0, 0}};
+      for (int x = 1; x < w - 1; x++) {
+        dst[x].data[0] = GradType(row[x]);
+        dst[x].data[1] = GradType(int(row[x + 1]) - int(row[x - 1]));
+        dst[x].data[2] = GradType(int(row_p1[x]) - int(row_m1[x]));
+        dst[x].data[3] = 0;
+      }
+      dst[w - 1] = Texel{{GradType(row[w - 1]), 0, 0, 0}};
+    }
+  }
+
+  /// @brief Image value and gradient, same as \ref Image::interpGrad.
+  ///
+  /// There is no bounds check (unless BASALT_ENABLE_BOUNDS_CHECKS is defined).
+  /// We assume that the pixel coordinates satisfy InBounds(x, y, 1).
+  template <typename S>
+  inline Eigen::Matrix<S, 3, 1> interpGrad(
+      const Eigen::Matrix<S, 2, 1>& p) const {
+    return interpGrad<S>(p[0], p[1]);
+  }
+
+  /// @brief Image value and gradient, see overload above.
+  template <typename S>
+  inline Eigen::Matrix<S, 3, 1> interpGrad(S x, S y) const {
+    static_assert(std::is_floating_point_v<S>,
+                  "interpolation / gradient only makes sense "
+                  "for floating point result type");
+
+    BASALT_BOUNDS_ASSERT(InBounds(x, y, 1));
+
+    const int ix = x;
+    const int iy = y;
+
+    const S dx = x - ix;
+    const S dy = y - iy;
+
+    const S ddx = S(1.0) - dx;
+    const S ddy = S(1.0) - dy;
+
+    const Texel* row0 = texels_.RowPtr(iy) + ix;
+    const Texel* row1 = texels_.RowPtr(iy + 1) + ix;
+
+    const Eigen::Matrix<S, 4, 1> res =
+        ddx * ddy * loadTexel<S>(row0[0]) + ddx * dy * loadTexel<S>(row1[0]) +
+        dx * ddy * loadTexel<S>(row0[1]) + dx * dy * loadTexel<S>(row1[1]);
+
+    return Eigen::Matrix<S, 3, 1>(res[0], S(0.5) * res[1], S(0.5) * res[2]);
+  }
+
+  /// @brief Batched version of \ref interpGrad with the same interface as
+  /// \ref Image::interpGradBatch.
+  ///
+  /// @param[in] points 2xN pixel coordinates
+  /// @param[out] res 3xN value and gradient for every point
+  template <typename DerivedP, typename DerivedRes>
+  inline void interpGradBatch(const Eigen::MatrixBase<DerivedP>& points,
+                              const Eigen::MatrixBase<DerivedRes>& res) const {
+    using S = typename DerivedP::Scalar;
+    Base::evalBatch(points, res,
+                    [this](S x, S y) { return interpGrad<S>(x, y); });
+  }
+
+ protected:
+  using Base::texels_;
+};
+
+}  // namespace basalt
@@ -68,6 +68,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <memory>
+#include <type_traits>
 
 #include <Eigen/Dense>
 
@@ -196,7 +197,7 @@ struct Image {
       std::memset((char*)ptr, v, pitch * h);
     } else {
       for (size_t y = 0; y < h; ++y) {
-        std::memset((char*)RowPtr(y), v, pitch);
+        std::memset((char*)RowPtr(y), v, w * sizeof(T));
       }
     }
   }
@@ -681,6 +682,243 @@ struct Image {
     return res;
   }
 
+  //////////////////////////////////////////////////////
+  // Batched Interpolated Pixel Access
+  //////////////////////////////////////////////////////
+  //
+  // Evaluate interp, interpGrad or interpGradBilinearExact for every column of
+  // the 2xN matrix of points and write the results to the corresponding
+  // columns of res (1xN for interpBatch, 3xN otherwise), e.g. for all points
+  // of a patch pattern at once.
+  //
+  // Points are processed in chunks: pixel values and interpolation weights of
+  // a chunk are first gathered into small arrays, so the arithmetic is done in
+  // a loop over points that the compiler can vectorize. The arithmetic is the
+  // same as in the corresponding function for a single point, so results only
+  // differ if the compiler contracts it to FMA differently. The same bounds
+  // requirements apply to every point.
+  //
+  //////////////////////////////////////////////////////
+
+  // number of points processed together in the batched interpolation
+  static constexpr int INTERP_BATCH_SIZE = 16;
+
+  // batched version of interp
+  template <typename DerivedP, typename DerivedRes>
+  inline void interpBatch(const Eigen::MatrixBase<DerivedP>& points,
+                          const Eigen::MatrixBase<DerivedRes>& res) const {
+    using S = typename DerivedP::Scalar;
+    static_assert(std::is_floating_point_v<S>,
+                  "interpolation / gradient only makes sense "
+                  "for floating point result type");
+    static_assert(DerivedP::RowsAtCompileTime == 2);
+    static_assert(DerivedRes::RowsAtCompileTime == 1);
+
+    BASALT_ASSERT(points.cols() == res.cols());
+
+    auto& res_ref = const_cast<Eigen::MatrixBase<DerivedRes>&>(res);
+
+    S dx[INTERP_BATCH_SIZE], dy[INTERP_BATCH_SIZE];
+    S px0y0[INTERP_BATCH_SIZE], px1y0[INTERP_BATCH_SIZE];
+    S px0y1[INTERP_BATCH_SIZE], px1y1[INTERP_BATCH_SIZE];
+    S val[INTERP_BATCH_SIZE];
+
+    const int num_points = points.cols();
+    for (int i0 = 0; i0 < num_points; i0 += INTERP_BATCH_SIZE) {
+      const int n = std::min(INTERP_BATCH_SIZE, num_points - i0);
+
+      for (int k = 0; k < n; k++) {
+        const S x = points(0, i0 + k);
+        const S y = points(1, i0 + k);
+        BASALT_BOUNDS_ASSERT(InBounds(x, y, 0));
+
+        const int ix = x;
+        const int iy = y;
+        dx[k] = x - ix;
+        dy[k] = y - iy;
+
+        const T* row0 = RowPtr(iy) + ix;
+        const T* row1 = RowPtr(iy + 1) + ix;
+        px0y0[k] = row0[0];
+        px1y0[k] = row0[1];
+        px0y1[k] = row1[0];
+        px1y1[k] = row1[1];
+      }
+
+      for (int k = 0; k < n; k++) {
+        const S ddx = S(1.0) - dx[k];
+        const S ddy = S(1.0) - dy[k];
+
+        val[k] = ddx * ddy * px0y0[k] + ddx * dy[k] * px0y1[k] +
+                 dx[k] * ddy * px1y0[k] + dx[k] * dy[k] * px1y1[k];
+      }
+
+      for (int k = 0; k < n; k++) {
+        res_ref(0, i0 + k) = val[k];
+      }
+    }
+  }
+
+  // batched version of interpGrad
+  template <typename DerivedP, typename DerivedRes>
+  inline void interpGradBatch(const Eigen::MatrixBase<DerivedP>& points,
+                              const Eigen::MatrixBase<DerivedRes>& res) const {
+    using S = typename DerivedP::Scalar;
+    static_assert(std::is_floating_point_v<S>,
+                  "interpolation / gradient only makes sense "
+                  "for floating point result type");
+    static_assert(DerivedP::RowsAtCompileTime == 2);
+    static_assert(DerivedRes::RowsAtCompileTime == 3);
+
+    BASALT_ASSERT(points.cols() == res.cols());
+
+    auto& res_ref = const_cast<Eigen::MatrixBase<DerivedRes>&>(res);
+
+    S dx[INTERP_BATCH_SIZE], dy[INTERP_BATCH_SIZE];
+    S pxm1y0[INTERP_BATCH_SIZE], px0y0[INTERP_BATCH_SIZE];
+    S px1y0[INTERP_BATCH_SIZE], px2y0[INTERP_BATCH_SIZE];
+    S pxm1y1[INTERP_BATCH_SIZE], px0y1[INTERP_BATCH_SIZE];
+    S px1y1[INTERP_BATCH_SIZE], px2y1[INTERP_BATCH_SIZE];
+    S px0ym1[INTERP_BATCH_SIZE], px1ym1[INTERP_BATCH_SIZE];
+    S px0y2[INTERP_BATCH_SIZE], px1y2[INTERP_BATCH_SIZE];
+    S val[INTERP_BATCH_SIZE], grad_x[INTERP_BATCH_SIZE];
+    S grad_y[INTERP_BATCH_SIZE];
+
+    const int num_points = points.cols();
+    for (int i0 = 0; i0 < num_points; i0 += INTERP_BATCH_SIZE) {
+      const int n = std::min(INTERP_BATCH_SIZE, num_points - i0);
+
+      for (int k = 0; k < n; k++) {
+        const S x = points(0, i0 + k);
+        const S y = points(1, i0 + k);
+        BASALT_BOUNDS_ASSERT(InBounds(x, y, 1));
+
+        const int ix = x;
+        const int iy = y;
+        dx[k] = x - ix;
+        dy[k] = y - iy;
+
+        const T* rowm1 = RowPtr(iy - 1) + ix;
+        const T* row0 = RowPtr(iy) + ix;
+        const T* row1 = RowPtr(iy + 1) + ix;
+        const T* row2 = RowPtr(iy + 2) + ix;
+
+        px0ym1[k] = rowm1[0];
+        px1ym1[k] = rowm1[1];
+        pxm1y0[k] = row0[-1];
+        px0y0[k] = row0[0];
+        px1y0[k] = row0[1];
+        px2y0[k] = row0[2];
+        pxm1y1[k] = row1[-1];
+        px0y1[k] = row1[0];
+        px1y1[k] = row1[1];
+        px2y1[k] = row1[2];
+        px0y2[k] = row2[0];
+        px1y2[k] = row2[1];
+      }
+
+      for (int k = 0; k < n; k++) {
+        const S ddx = S(1.0) - dx[k];
+        const S ddy = S(1.0) - dy[k];
+
+        val[k] = ddx * ddy * px0y0[k] + ddx * dy[k] * px0y1[k] +
+                 dx[k] * ddy * px1y0[k] + dx[k] * dy[k] * px1y1[k];
+
+        const S res_mx = ddx * ddy * pxm1y0[k] + ddx * dy[k] * pxm1y1[k] +
+                         dx[k] * ddy * px0y0[k] + dx[k] * dy[k] * px0y1[k];
+        const S res_px = ddx * ddy * px1y0[k] + ddx * dy[k] * px1y1[k] +
+                         dx[k] * ddy * px2y0[k] + dx[k] * dy[k] * px2y1[k];
+
+        grad_x[k] = S(0.5) * (res_px - res_mx);
+
+        const S res_my = ddx * ddy * px0ym1[k] + ddx * dy[k] * px0y0[k] +
+                         dx[k] * ddy * px1ym1[k] + dx[k] * dy[k] * px1y0[k];
+        const S res_py = ddx * ddy * px0y1[k] + ddx * dy[k] * px0y2[k] +
+                         dx[k] * ddy * px1y1[k] + dx[k] * dy[k] * px1y2[k];
+
+        grad_y[k] = S(0.5) * (res_py - res_my);
+      }
+
+      for (int k = 0; k < n; k++) {
+        res_ref(0, i0 + k) = val[k];
+        res_ref(1, i0 + k) = grad_x[k];
+        res_ref(2, i0 + k) = grad_y[k];
+      }
+    }
+  }
+
+  // batched version of interpGradBilinearExact
+  template <typename DerivedP, typename DerivedRes>
+  inline void interpGradBilinearExactBatch(
+      const Eigen::MatrixBase<DerivedP>& points,
+      const Eigen::MatrixBase<DerivedRes>& res) const {
+    using S = typename DerivedP::Scalar;
+    static_assert(std::is_floating_point_v<S>,
+                  "interpolation / gradient only makes sense "
+                  "for floating point result type");
+    static_assert(DerivedP::RowsAtCompileTime == 2);
+    static_assert(DerivedRes::RowsAtCompileTime == 3);
+
+    BASALT_ASSERT(points.cols() == res.cols());
+
+    auto& res_ref = const_cast<Eigen::MatrixBase<DerivedRes>&>(res);
+
+    S dx[INTERP_BATCH_SIZE], dy[INTERP_BATCH_SIZE];
+    S px0y0[INTERP_BATCH_SIZE], px1y0[INTERP_BATCH_SIZE];
+    S px0y1[INTERP_BATCH_SIZE], px1y1[INTERP_BATCH_SIZE];
+    S val[INTERP_BATCH_SIZE], grad_x[INTERP_BATCH_SIZE];
+    S grad_y[INTERP_BATCH_SIZE];
+
+    const int num_points = points.cols();
+    for (int i0 = 0; i0 < num_points; i0 += INTERP_BATCH_SIZE) {
+      const int n = std::min(INTERP_BATCH_SIZE, num_points - i0);
+
+      for (int k = 0; k < n; k++) {
+        const S x = points(0, i0 + k);
+        const S y = points(1, i0 + k);
+        BASALT_BOUNDS_ASSERT(InBounds(x, y, 0));
+
+        const int ix = x;
+        const int iy = y;
+        dx[k] = x - ix;
+        dy[k] = y - iy;
+
+        // clamping pixel values
+        int ixp1 = ix + 1;
+        int iyp1 = iy + 1;
+        if (ixp1 > (int)w - 1) ixp1 = w - 1;
+        if (iyp1 > (int)h - 1) iyp1 = h - 1;
+
+        px0y0[k] = RowPtr(iy)[ix];
+        px1y0[k] = RowPtr(iy)[ixp1];
+        px0y1[k] = RowPtr(iyp1)[ix];
+        px1y1[k] = RowPtr(iyp1)[ixp1];
+      }
+
+      for (int k = 0; k < n; k++) {
+        const S ddx = 1.0f - dx[k];
+        const S ddy = 1.0f - dy[k];
+
+        const double fxy0 = ddx * px0y0[k] + dx[k] * px1y0[k];
+        const double fxy1 = ddx * px0y1[k] + dx[k] * px1y1[k];
+
+        val[k] = fxy0 * ddy + fxy1 * dy[k];
+        grad_y[k] = fxy1 - fxy0;
+
+        const double fx0y = ddy * px0y0[k] + dy[k] * px0y1[k];
+        const double fx1y = ddy * px1y0[k] + dy[k] * px1y1[k];
+
+        grad_x[k] = fx1y - fx0y;
+      }
+
+      for (int k = 0; k < n; k++) {
+        res_ref(0, i0 + k) = val[k];
+        res_ref(1, i0 + k) = grad_x[k];
+        res_ref(2, i0 + k) = grad_y[k];
+      }
+    }
+  }
+
   //////////////////////////////////////////////////////
   // Bounds Checking
   //////////////////////////////////////////////////////
@@ -830,6 +1068,19 @@ struct Image {
 template <class T>
 using DefaultImageAllocator = std::allocator<T>;
 
+/// @brief Row alignment in bytes requested by the allocator.
+///
+/// Allocators can define a static member \c alignment (e.g.
+/// AlignedImageAllocator). ManagedImage then pads the pitch to a multiple of
+/// it. 0 means no padding.
+template <class Allocator, class = void>
+struct ImageAllocatorAlignment : std::integral_constant<size_t, 0> {};
+
+template <class Allocator>
+struct ImageAllocatorAlignment<Allocator,
+                               std::void_t<decltype(Allocator::alignment)>>
+    : std::integral_constant<size_t, Allocator::alignment> {};
+
 /// @brief Image that manages it's own memory, storing a strong pointer to it's
 /// memory
 template <typename T, class Allocator = DefaultImageAllocator<T>>
@@ -845,18 +1096,18 @@ class ManagedImage : public Image<T> {
   inline ManagedImage() {}
 
   // Row image
-  inline ManagedImage(size_t w)
-      : Image<T>(Allocator().allocate(w), w, 1, w * sizeof(T)) {}
+  inline ManagedImage(size_t w) : ManagedImage(w, 1) {}
 
+  // Image with default pitch (see DefaultPitch)
   inline ManagedImage(size_t w, size_t h)
-      : Image<T>(Allocator().allocate(w * h), w, h, w * sizeof(T)) {}
+      : ManagedImage(w, h, DefaultPitch(w)) {}
 
   inline ManagedImage(size_t w, size_t h, size_t pitch_bytes)
-      : Image<T>(Allocator().allocate((h * pitch_bytes) / sizeof(T) + 1), w, h,
+      : Image<T>(Allocator().allocate(AllocationSize(h, pitch_bytes)), w, h,
                  pitch_bytes) {}
 
   // Not copy constructable
-  inline ManagedImage(const ManagedImage<T>& other) = delete;
+  inline ManagedImage(const ManagedImage<T, Allocator>& other) = delete;
 
   // Move constructor
   inline ManagedImage(ManagedImage<T, Allocator>&& img) {
@@ -885,7 +1136,7 @@ class ManagedImage : public Image<T> {
     CopyFrom(other.obj);
   }
 
-  inline void Swap(ManagedImage<T>& img) {
+  inline void Swap(ManagedImage<T, Allocator>& img) {
     std::swap(img.pitch, Image<T>::pitch);
     std::swap(img.ptr, Image<T>::ptr);
     std::swap(img.w, Image<T>::w);
@@ -915,14 +1166,41 @@ class ManagedImage : public Image<T> {
   inline void Deallocate() {
     if (Image<T>::ptr) {
       Allocator().deallocate(Image<T>::ptr,
-                             (Image<T>::h * Image<T>::pitch) / sizeof(T));
+                             AllocationSize(Image<T>::h, Image<T>::pitch));
       Image<T>::ptr = nullptr;
     }
   }
 
+  /// @brief Pitch in bytes used for images of the given width.
+  ///
+  /// The row size padded to \ref ImageAllocatorAlignment of the allocator, so
+  /// for allocators that align memory every row is aligned as well.
+  static inline size_t DefaultPitch(size_t w) {
+    constexpr size_t alignment = ImageAllocatorAlignment<Allocator>::value;
+    const size_t row_bytes = w * sizeof(T);
+    if constexpr (alignment > 1) {
+      return (row_bytes + alignment - 1) / alignment * alignment;
+    } else {
+      return row_bytes;
+    }
+  }
+
+  /// @brief Number of elements allocated for an image with the given height
+  /// and pitch. Allocation and deallocation have to agree on it for sized
+  /// allocators, e.g. \ref PooledImageAllocator.
+  static inline size_t AllocationSize(size_t h, size_t pitch_bytes) {
+    return (h * pitch_bytes + sizeof(T) - 1) / sizeof(T);
+  }
+
   // Move asignment
   template <typename TOther, typename AllocOther>
   inline void OwnAndReinterpret(ManagedImage<TOther, AllocOther>&& img) {
+    // the memory is returned through Allocator, which has to be able to free
+    // memory of AllocOther
+    static_assert(
+        std::is_same_v<Allocator, typename std::allocator_traits<AllocOther>::
+                                      template rebind_alloc<T>>,
+        "OwnAndReinterpret needs the same allocator for both pixel types");
     Deallocate();
     Image<T>::pitch = img.pitch;
     Image<T>::ptr = (T*)img.ptr;
@@ -0,0 +1,312 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Allocators for images with aligned rows and recycled memory blocks
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <basalt/utils/assert.h>
+
+namespace basalt {
+
+/// @brief Allocate memory with the given alignment (0 for default alignment).
+inline void* allocateAligned(size_t bytes, size_t alignment) {
+  if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    return ::operator new(bytes, std::align_val_t(alignment));
+  }
+  return ::operator new(bytes);
+}
+
+/// @brief Free memory allocated with \ref allocateAligned.
+inline void deallocateAligned(void* p, size_t alignment) {
+  if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    ::operator delete(p, std::align_val_t(alignment));
+  } else {
+    ::operator delete(p);
+  }
+}
+
+/// @brief Allocator that aligns the memory to the given number of bytes.
+///
+/// \ref ManagedImage also pads the pitch of images created with this
+/// allocator to a multiple of \c Alignment, so every row starts at an aligned
+/// address.
+template <class T, size_t Alignment = 64>
+struct AlignedImageAllocator {
+  static_assert((Alignment & (Alignment - 1)) == 0,
+                "Alignment should be a power of 2");
+
+  using value_type = T;
+  static constexpr size_t alignment = Alignment;
+
+  template <class U>
+  struct rebind {
+    using other = AlignedImageAllocator<U, Alignment>;
+  };
+
+  AlignedImageAllocator() = default;
+
+  template <class U>
+  AlignedImageAllocator(const AlignedImageAllocator<U, Alignment>&) {}
+
+  inline T* allocate(size_t n) {
+    return static_cast<T*>(allocateAligned(n * sizeof(T), Alignment));
+  }
+
+  inline void deallocate(T* p, size_t) { deallocateAligned(p, Alignment); }
+
+  template <class U>
+  bool operator==(const AlignedImageAllocator<U, Alignment>&) const {
+    return true;
+  }
+
+  template <class U>
+  bool operator!=(const AlignedImageAllocator<U, Alignment>&) const {
+    return false;
+  }
+};
+
+/// @brief Thread-safe pool of memory blocks bucketed by their size.
+///
+/// Blocks returned with \ref deallocate are not freed, but cached and handed
+/// out again by the next \ref allocate of the same size. When images of the
+/// same resolution are created and destroyed every frame, memory is taken
+/// from the heap only during the first frames.
+///
+/// The size and alignment of every block are stored in a small header in
+/// front of the returned memory, so a block always goes back to the bucket it
+/// was allocated from, even if the owner computes a different size (e.g.
+/// after ManagedImage::OwnAndReinterpret), and handing out a cached block
+/// does not allocate any bookkeeping. The cache is limited to
+/// \ref cacheLimit bytes, blocks that do not fit are freed.
+class ImageMemoryPool {
+ public:
+  /// @brief Default value of \ref cacheLimit.
+  static constexpr size_t DEFAULT_CACHE_LIMIT = size_t(256) << 20;
+
+  /// @brief Process-wide pool used by \ref PooledImageAllocator.
+  ///
+  /// Never destroyed, so images with static storage duration can still return
+  /// their memory at exit.
+  static ImageMemoryPool& instance() {
+    static ImageMemoryPool* pool = new ImageMemoryPool;
+    return *pool;
+  }
+
+  ImageMemoryPool() = default;
+  ImageMemoryPool(const ImageMemoryPool&) = delete;
+  ImageMemoryPool& operator=(const ImageMemoryPool&) = delete;
+
+  inline ~ImageMemoryPool() { release(); }
+
+  /// @brief Get block of the given size and alignment, reusing a cached
+  /// block if there is one.
+  inline void* allocate(size_t bytes, size_t alignment = 0) {
+    const BlockKey key(bytes, alignment);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = free_blocks_.find(key);
+    if (it != free_blocks_.end() && !it->second.empty()) {
+      void* p = it->second.back();
+      it->second.pop_back();
+      cached_bytes_ -= bytes;
+      return p;
+    }
+
+    const size_t offset = headerOffset(alignment);
+    char* p = static_cast<char*>(allocateAligned(bytes + offset, alignment));
+    p += offset;
+    *header(p) = BlockHeader{key, HEADER_MAGIC};
+    return p;
+  }
+
+  /// @brief Return block to the pool. The block is put back into the bucket
+  /// it was allocated from, so \p bytes may differ from the allocated size.
+  /// Only \p alignment is checked against it.
+  inline void deallocate(void* p, size_t bytes, size_t alignment = 0) {
+    if (!p) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const BlockHeader& h = *header(p);
+    BASALT_ASSERT_MSG(h.magic == HEADER_MAGIC,
+                      "block was not allocated from an ImageMemoryPool");
+    const BlockKey key = h.key;
+
+    BASALT_ASSERT(key.second == alignment);
+    UNUSED(bytes);
+    UNUSED(alignment);
+
+    if (cached_bytes_ + key.first > cache_limit_) {
+      freeBlock(p, key.second);
+      return;
+    }
+    free_blocks_[key].push_back(p);
+    cached_bytes_ += key.first;
+  }
+
+  /// @brief Free all cached blocks. Blocks that are currently in use are
+  /// not affected.
+  inline void release() { trim(0); }
+
+  /// @brief Free cached blocks, largest first, until at most \p max_bytes
+  /// are cached. Blocks that are currently in use are not affected.
+  inline void trim(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = free_blocks_.rbegin();
+         it != free_blocks_.rend() && cached_bytes_ > max_bytes; ++it) {
+      std::vector<void*>& blocks = it->second;
+      while (!blocks.empty() && cached_bytes_ > max_bytes) {
+        freeBlock(blocks.back(), it->first.second);
+        blocks.pop_back();
+        cached_bytes_ -= it->first.first;
+      }
+    }
+  }
+
+  /// @brief Total size of the cached blocks in bytes.
+  inline size_t cachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cached_bytes_;
+  }
+
+  /// @brief Maximum total size of the cached blocks in bytes.
+  inline size_t cacheLimit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_limit_;
+  }
+
+  /// @brief Set maximum total size of the cached blocks in bytes and free
+  /// cached blocks above it.
+  inline void setCacheLimit(size_t max_bytes) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cache_limit_ = max_bytes;
+    }
+    trim(max_bytes);
+  }
+
+ private:
+  using BlockKey = std::pair<size_t, size_t>;  // (size, alignment)
+
+  // Stored directly in front of every block handed out by the pool.
+  struct BlockHeader {
+    BlockKey key;
+    uint64_t magic;
+  };
+
+  static constexpr uint64_t HEADER_MAGIC = 0xba5a17b10c4ULL;
+
+  // Distance of the block from the start of the allocation. Keeps the block
+  // aligned and leaves room for the header.
+  static inline size_t headerOffset(size_t alignment) {
+    constexpr size_t min_offset =
+        (sizeof(BlockHeader) + __STDCPP_DEFAULT_NEW_ALIGNMENT__ - 1) /
+        __STDCPP_DEFAULT_NEW_ALIGNMENT__ * __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    if (alignment <= min_offset) return min_offset;
+    return alignment;
+  }
+
+  static inline BlockHeader* header(void* p) {
+    return reinterpret_cast<BlockHeader*>(static_cast<char*>(p) -
+                                          sizeof(BlockHeader));
+  }
+
+  static inline void freeBlock(void* p, size_t alignment) {
+    deallocateAligned(static_cast<char*>(p) - headerOffset(alignment),
+                      alignment);
+  }
+
+  mutable std::mutex mutex_;
+  // free blocks for each (size, alignment)
+  std::map<BlockKey, std::vector<void*>> free_blocks_;
+  size_t cached_bytes_ = 0;
+  size_t cache_limit_ = DEFAULT_CACHE_LIMIT;
+};
+
+/// @brief Stateless allocator that takes memory from \ref ImageMemoryPool.
+///
+/// Can be used as \c Allocator template parameter of \ref ManagedImage and
+/// \ref ManagedImagePyr, e.g. ManagedImagePyr<uint16_t,
+/// PooledImageAllocator<uint16_t>>, to avoid heap allocations for images that
+/// are recreated with the same size. With non-zero \c Alignment memory and
+/// rows are aligned like with \ref AlignedImageAllocator.
+template <class T, size_t Alignment = 0>
+struct PooledImageAllocator {
+  static_assert((Alignment & (Alignment - 1)) == 0,
+                "Alignment should be 0 or a power of 2");
+
+  using value_type = T;
+  static constexpr size_t alignment = Alignment;
+
+  template <class U>
+  struct rebind {
+    using other = PooledImageAllocator<U, Alignment>;
+  };
+
+  PooledImageAllocator() = default;
+
+  template <class U>
+  PooledImageAllocator(const PooledImageAllocator<U, Alignment>&) {}
+
+  inline T* allocate(size_t n) {
+    return static_cast<T*>(
+        ImageMemoryPool::instance().allocate(n * sizeof(T), Alignment));
+  }
+
+  inline void deallocate(T* p, size_t n) {
+    ImageMemoryPool::instance().deallocate(p, n * sizeof(T), Alignment);
+  }
+
+  template <class U>
+  bool operator==(const PooledImageAllocator<U, Alignment>&) const {
+    return true;
+  }
+
+  template <class U>
+  bool operator!=(const PooledImageAllocator<U, Alignment>&) const {
+    return false;
+  }
+};
+
+}  // namespace basalt
@@ -38,7 +38,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <basalt/image/image.h>
+#include <basalt/utils/instrumentation.h>
+#include <basalt/utils/parallel.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace basalt {
 
@@ -60,27 +73,150 @@ class ManagedImagePyr {
   ///
   /// @param other image to use for the pyramid level 0
   /// @param num_level number of levels for the pyramid
-  inline ManagedImagePyr(const ManagedImage<T>& other, size_t num_levels) {
+  template <class OtherAllocator>
+  inline ManagedImagePyr(const ManagedImage<T, OtherAllocator>& other,
+                         size_t num_levels) {
     setFromImage(other, num_levels);
   }
 
+  /// @brief Set image pyramid from other image.
+  ///
+  /// Memory of the mipmap and the subsampling buffer is kept if the size of
+  /// the image does not change, so an existing pyramid can be reused for the
+  /// next frame without allocations (see also \ref PooledImageAllocator).
+  ///
+  /// @param other image to use for the pyramid level 0
+  /// @param num_level number of levels for the pyramid
+  template <class OtherAllocator>
+  inline void setFromImage(const ManagedImage<T, OtherAllocator>& other,
+                           size_t num_levels) {
+    setFromImage(other.SubImage(0, 0, other.w, other.h), num_levels);
+  }
+
   /// @brief Set image pyramid from other image.
   ///
   /// @param other image to use for the pyramid level 0
   /// @param num_level number of levels for the pyramid
-  inline void setFromImage(const ManagedImage<T>& other, size_t num_levels) {
-    orig_w = other.w;
-    image.Reinitialise(other.w + other.w / 2, other.h);
-    image.Fill(0);
-    lvl_internal(0).CopyFrom(other);
+  inline void setFromImage(const Image<const T>& other, size_t num_levels) {
+    BASALT_INSTRUMENT_SCOPE("basalt::ManagedImagePyr::setFromImage");
+
+    reinitialiseMipmap(other.w, other.h);
+
+    Image<T> l0 = lvl_internal(0);
+    PitchedCopy((char*)l0.ptr, l0.pitch, (const char*)other.ptr, other.pitch,
+                other.w * sizeof(T), other.h);
+
+    computeLevels(num_levels);
+  }
+
+  /// @brief Set image pyramid from other image without copying it.
+  ///
+  /// Level 0 is a view of \p other, which has to stay valid as long as the
+  /// pyramid is used (or until it is set again). Only levels 1 and higher are
+  /// stored in the mipmap, the level 0 region of \ref mipmap is not updated.
+  ///
+  /// @param other image to use for the pyramid level 0
+  /// @param num_level number of levels for the pyramid
+  inline void setFromExternalImage(const Image<const T>& other,
+                                   size_t num_levels) {
+    BASALT_INSTRUMENT_SCOPE("basalt::ManagedImagePyr::setFromExternalImage");
+
+    if (reinitialiseMipmap(other.w, other.h)) {
+      lvl_internal(0).Fill(0);
+    }
+    external_lvl0 = other;
+
+    computeLevels(num_levels);
+  }
+
+  /// @brief Prepare the mipmap for an image of the given size and return its
+  /// level 0 region.
+  ///
+  /// The caller (e.g. a camera driver) writes the image directly into the
+  /// returned image and then calls \ref computeLevels, which avoids copying
+  /// level 0. Memory is kept if the size does not change.
+  ///
+  /// @param w width of level 0
+  /// @param h height of level 0
+  /// @return writable image of level 0
+  inline Image<T> prepareLevel0(size_t w, size_t h) {
+    reinitialiseMipmap(w, h);
+    return lvl_internal(0);
+  }
+
+  /// @brief Compute levels 1 to num_levels from level 0.
+  ///
+  /// Parts of the mipmap that are not covered by any level are set to zero,
+  /// everything else is overwritten, so the mipmap is never filled as a
+  /// whole.
+  ///
+  /// @param num_level number of levels for the pyramid
+  inline void computeLevels(size_t num_levels) {
+    clearUnusedMipmap(num_levels);
 
     for (size_t i = 0; i < num_levels; i++) {
       const Image<const T> l = lvl(i);
       Image<T> lp1 = lvl_internal(i + 1);
-      subsample(l, lp1);
+      subsample(l, lp1, subsample_tmp);
     }
   }
 
+  /// @brief Set image pyramid from other image using a caller-supplied
+  /// executor for parallelization.
+  ///
+  /// Every level is split into bands of rows. A band is computed as soon as
+  /// the rows of the previous level it depends on are done, so levels overlap
+  /// and there is no barrier between them. Besides the calling thread, which
+  /// also computes bands, \p num_workers worker tasks are passed to
+  /// \p executor. No threads are created here. The function returns when the
+  /// pyramid is complete. Workers that start later return immediately, so
+  /// the executor may run tasks at any time, including immediately in the
+  /// calling thread. The result is identical to \ref setFromImage without
+  /// executor.
+  ///
+  /// The band bookkeeping and the accumulator rows of the workers are kept in
+  /// the pyramid, so in steady state the only allocation per call is the
+  /// small state shared with the workers (see \ref runParallelWork), which
+  /// keeps late workers valid. If the executor throws, no further bands are
+  /// started and the exception is rethrown once the started bands are done.
+  ///
+  /// @param other image to use for the pyramid level 0
+  /// @param num_level number of levels for the pyramid
+  /// @param executor callable taking a std::function<void()> to run, e.g.
+  /// submitting it to a thread pool
+  /// @param num_workers number of tasks passed to the executor
+  /// @param band_rows number of rows in a band
+  template <class OtherAllocator, class Executor>
+  inline void setFromImage(const ManagedImage<T, OtherAllocator>& other,
+                           size_t num_levels, Executor&& executor,
+                           size_t num_workers, size_t band_rows = 32) {
+    setFromImage(other.SubImage(0, 0, other.w, other.h), num_levels,
+                 std::forward<Executor>(executor), num_workers, band_rows);
+  }
+
+  /// @brief Set image pyramid from other image using a caller-supplied
+  /// executor for parallelization. See overload above.
+  template <class Executor>
+  inline void setFromImage(const Image<const T>& other, size_t num_levels,
+                           Executor&& executor, size_t num_workers,
+                           size_t band_rows = 32) {
+    BASALT_INSTRUMENT_SCOPE("basalt::ManagedImagePyr::setFromImage");
+    BASALT_ASSERT(band_rows > 0);
+
+    reinitialiseMipmap(other.w, other.h);
+    clearUnusedMipmap(num_levels);
+
+    const size_t num_tasks =
+        build_bands.reset(*this, num_levels, band_rows, num_workers);
+
+    auto state = std::make_unique<ParallelBuildState>();
+    state->num_tasks = num_tasks;
+    state->pyr = this;
+    state->src = other;
+    runParallelWork(std::move(state), std::forward<Executor>(executor),
+                    num_workers);
+  }
+
   /// @brief Extrapolate image after border with reflection.
   static inline int border101(int x, int h) {
     return h - 1 - std::abs(h - 1 - x);
@@ -101,6 +237,85 @@ class ManagedImagePyr {
   /// \f]
   /// and removing every even-numbered row and column.
   static void subsample(const Image<const T>& img, Image<T>& img_sub) {
+    std::vector<int> tmp;
+    subsample(img, img_sub, tmp);
+  }
+
+  /// @brief Subsample the image twice in each direction.
+  ///
+  /// Same result as \ref subsampleReference, but the image is processed row
+  /// by row: the vertical pass for one output row is written to a single
+  /// accumulator row, which is then convolved horizontally. Both passes are
+  /// vectorized with SSE2 or NEON when available.
+  ///
+  /// @param[in] img image to subsample
+  /// @param[out] img_sub subsampled image
+  /// @param[in,out] tmp scratch accumulator row, resized if required. Pass
+  /// the same vector to consecutive calls to avoid reallocation.
+  static void subsample(const Image<const T>& img, Image<T>& img_sub,
+                        std::vector<int>& tmp) {
+    static_assert(std::is_same<T, uint16_t>::value ||
+                  std::is_same<T, uint8_t>::value);
+
+    BASALT_ASSERT(2 * img_sub.w <= img.w + 1);
+    BASALT_ASSERT(2 * img_sub.h <= img.h + 1);
+
+    // The reflected border of the accumulator row needs at least 4 elements.
+    if (img.w < 4) {
+      subsampleReference(img, img_sub);
+      return;
+    }
+
+    subsampleRows(img, img_sub, 0, img_sub.h, tmp);
+  }
+
+  /// @brief Compute rows [row_begin, row_end) of \ref subsample.
+  ///
+  /// Output rows only depend on the input image, so disjoint row ranges can
+  /// be computed in parallel (with separate scratch rows). Requires images
+  /// at least 4 pixels wide.
+  static void subsampleRows(const Image<const T>& img, Image<T>& img_sub,
+                            size_t row_begin, size_t row_end,
+                            std::vector<int>& tmp) {
+    static_assert(std::is_same<T, uint16_t>::value ||
+                  std::is_same<T, uint8_t>::value);
+
+    BASALT_ASSERT(img.w >= 4);
+    BASALT_ASSERT(2 * img_sub.w <= img.w + 1);
+    BASALT_ASSERT(2 * img_sub.h <= img.h + 1);
+    BASALT_ASSERT(row_begin <= row_end && row_end <= img_sub.h);
+
+    const int w = img.w;
+
+    // accumulator row with two reflected elements on each side
+    tmp.resize(w + 4);
+    int* acc = tmp.data() + 2;
+
+    for (int r = int(row_begin); r < int(row_end); r++) {
+      const T* row_m2 = img.RowPtr(std::abs(2 * r - 2));
+      const T* row_m1 = img.RowPtr(std::abs(2 * r - 1));
+      const T* row = img.RowPtr(2 * r);
+      const T* row_p1 = img.RowPtr(border101(2 * r + 1, img.h));
+      const T* row_p2 = img.RowPtr(border101(2 * r + 2, img.h));
+
+      convolveRowVertical(row_m2, row_m1, row, row_p1, row_p2, w, acc);
+
+      acc[-2] = acc[2];
+      acc[-1] = acc[1];
+      acc[w] = acc[w - 2];
+      acc[w + 1] = acc[w - 3];
+
+      convolveRowHorizontal(tmp.data(), int(tmp.size()), img_sub.w,
+                            img_sub.RowPtr(r));
+    }
+  }
+
+  /// @brief Reference implementation of \ref subsample.
+  ///
+  /// Straightforward scalar implementation with a transposed accumulator
+  /// image. Used as a fallback for very narrow images and for testing.
+  static void subsampleReference(const Image<const T>& img,
+                                 Image<T>& img_sub) {
     static_assert(std::is_same<T, uint16_t>::value ||
                   std::is_same<T, uint8_t>::value);
 
@@ -151,6 +366,8 @@ class ManagedImagePyr {
   /// @param lvl level to return
   /// @return const image of with the pyramid level
   inline const Image<const T> lvl(size_t lvl) const {
+    if (lvl == 0 && external_lvl0.IsValid()) return external_lvl0;
+
     size_t x = (lvl == 0) ? 0 : orig_w;
     size_t y = (lvl <= 1) ? 0 : (image.h - (image.h >> (lvl - 1)));
     size_t width = (orig_w >> lvl);
@@ -193,8 +410,393 @@ class ManagedImagePyr {
     return image.SubImage(x, y, width, height);
   }
 
-  size_t orig_w;          ///< Width of the original image (level 0)
-  ManagedImage<T> image;  ///< Pyramid image stored as a mipmap
+  /// @brief Resize the mipmap for level 0 of the given size.
+  ///
+  /// @return true if the memory was reallocated
+  inline bool reinitialiseMipmap(size_t w, size_t h) {
+    const bool realloc = !image.IsValid() || image.w != w + w / 2 ||
+                         image.h != h || orig_w != w;
+    orig_w = w;
+    external_lvl0 = Image<const T>();
+    image.Reinitialise(w + w / 2, h);
+    return realloc;
+  }
+
+  /// @brief Set parts of the mipmap right of level 0 that are not covered by
+  /// levels 1 to num_levels to zero.
+  inline void clearUnusedMipmap(size_t num_levels) {
+    for (size_t y = 0; y < image.h; y++) {
+      size_t used_w = 0;
+      for (size_t l = 1; l <= num_levels; l++) {
+        const size_t y0 = (l == 1) ? 0 : (image.h - (image.h >> (l - 1)));
+        if (y >= y0 && y < y0 + (image.h >> l)) {
+          used_w = orig_w >> l;
+          break;
+        }
+      }
+
+      T* row = image.RowPtr(y);
+      std::fill(row + orig_w + used_w, row + image.w, T(0));
+    }
+  }
+
+  /// @brief Vertical 5-tap convolution of one row (1 4 6 4 1).
+  static inline void convolveRowVertical(const T* row_m2, const T* row_m1,
+                                         const T* row, const T* row_p1,
+                                         const T* row_p2, int w, int* acc) {
+    int c = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    if constexpr (std::is_same<T, uint8_t>::value) {
+      // 16 * 255 fits into 16 bit, so accumulate 8 pixels in 16 bit lanes
+      for (; c + 8 <= w; c += 8) {
+        const __m128i a = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(row_m2 + c)), zero);
+        const __m128i b = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(row_m1 + c)), zero);
+        const __m128i m =
+            _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + c)), zero);
+        const __m128i d = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(row_p1 + c)), zero);
+        const __m128i e = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(row_p2 + c)), zero);
+
+        __m128i s = _mm_add_epi16(_mm_add_epi16(a, e),
+                                  _mm_slli_epi16(_mm_add_epi16(b, d), 2));
+        s = _mm_add_epi16(
+            s, _mm_add_epi16(_mm_slli_epi16(m, 2), _mm_slli_epi16(m, 1)));
+
+        _mm_storeu_si128((__m128i*)(acc + c), _mm_unpacklo_epi16(s, zero));
+        _mm_storeu_si128((__m128i*)(acc + c + 4), _mm_unpackhi_epi16(s, zero));
+      }
+    } else {
+      const auto conv = [](__m128i a, __m128i b, __m128i m, __m128i d,
+                           __m128i e) {
+        __m128i s = _mm_add_epi32(_mm_add_epi32(a, e),
+                                  _mm_slli_epi32(_mm_add_epi32(b, d), 2));
+        return _mm_add_epi32(
+            s, _mm_add_epi32(_mm_slli_epi32(m, 2), _mm_slli_epi32(m, 1)));
+      };
+
+      for (; c + 8 <= w; c += 8) {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(row_m2 + c));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(row_m1 + c));
+        const __m128i m = _mm_loadu_si128((const __m128i*)(row + c));
+        const __m128i d = _mm_loadu_si128((const __m128i*)(row_p1 + c));
+        const __m128i e = _mm_loadu_si128((const __m128i*)(row_p2 + c));
+
+        _mm_storeu_si128(
+            (__m128i*)(acc + c),
+            conv(_mm_unpacklo_epi16(a, zero), _mm_unpacklo_epi16(b, zero),
+                 _mm_unpacklo_epi16(m, zero), _mm_unpacklo_epi16(d, zero),
+                 _mm_unpacklo_epi16(e, zero)));
+        _mm_storeu_si128(
+            (__m128i*)(acc + c + 4),
+            conv(_mm_unpackhi_epi16(a, zero), _mm_unpackhi_epi16(b, zero),
+                 _mm_unpackhi_epi16(m, zero), _mm_unpackhi_epi16(d, zero),
+                 _mm_unpackhi_epi16(e, zero)));
+      }
+    }
+#elif defined(__ARM_NEON)
+    if constexpr (std::is_same<T, uint8_t>::value) {
+      // 16 * 255 fits into 16 bit, so accumulate 8 pixels in 16 bit lanes
+      for (; c + 8 <= w; c += 8) {
+        const uint16x8_t a = vmovl_u8(vld1_u8(row_m2 + c));
+        const uint16x8_t b = vmovl_u8(vld1_u8(row_m1 + c));
+        const uint16x8_t m = vmovl_u8(vld1_u8(row + c));
+        const uint16x8_t d = vmovl_u8(vld1_u8(row_p1 + c));
+        const uint16x8_t e = vmovl_u8(vld1_u8(row_p2 + c));
+
+        uint16x8_t s =
+            vaddq_u16(vaddq_u16(a, e), vshlq_n_u16(vaddq_u16(b, d), 2));
+        s = vaddq_u16(s, vaddq_u16(vshlq_n_u16(m, 2), vshlq_n_u16(m, 1)));
+
+        vst1q_s32(acc + c, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(s))));
+        vst1q_s32(acc + c + 4,
+                  vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(s))));
+      }
+    } else {
+      const auto conv = [](uint32x4_t a, uint32x4_t b, uint32x4_t m,
+                           uint32x4_t d, uint32x4_t e) {
+        uint32x4_t s =
+            vaddq_u32(vaddq_u32(a, e), vshlq_n_u32(vaddq_u32(b, d), 2));
+        return vreinterpretq_s32_u32(
+            vaddq_u32(s, vaddq_u32(vshlq_n_u32(m, 2), vshlq_n_u32(m, 1))));
+      };
+
+      for (; c + 8 <= w; c += 8) {
+        const uint16x8_t a = vld1q_u16(row_m2 + c);
+        const uint16x8_t b = vld1q_u16(row_m1 + c);
+        const uint16x8_t m = vld1q_u16(row + c);
+        const uint16x8_t d = vld1q_u16(row_p1 + c);
+        const uint16x8_t e = vld1q_u16(row_p2 + c);
+
+        vst1q_s32(acc + c, conv(vmovl_u16(vget_low_u16(a)),
+                                vmovl_u16(vget_low_u16(b)),
+                                vmovl_u16(vget_low_u16(m)),
+                                vmovl_u16(vget_low_u16(d)),
+                                vmovl_u16(vget_low_u16(e))));
+        vst1q_s32(acc + c + 4, conv(vmovl_u16(vget_high_u16(a)),
+                                    vmovl_u16(vget_high_u16(b)),
+                                    vmovl_u16(vget_high_u16(m)),
+                                    vmovl_u16(vget_high_u16(d)),
+                                    vmovl_u16(vget_high_u16(e))));
+      }
+    }
+#endif
+
+    for (; c < w; c++) {
+      acc[c] = int(row_m2[c]) + 4 * int(row_m1[c]) + 6 * int(row[c]) +
+               4 * int(row_p1[c]) + int(row_p2[c]);
+    }
+  }
+
+  /// @brief Horizontal 5-tap convolution (1 4 6 4 1) of the accumulator row
+  /// followed by normalization, keeping every second column.
+  ///
+  /// @param[in] buf accumulator row including the two border elements on
+  /// each side, so output column c depends on buf[2c] ... buf[2c + 4]
+  /// @param[in] buf_size number of elements in buf
+  /// @param[in] w_sub number of output columns
+  /// @param[out] dst output row
+  static inline void convolveRowHorizontal(const int* buf, int buf_size,
+                                           int w_sub, T* dst) {
+    int c = 0;
+
+#if defined(__SSE2__)
+    // Elements p[0], p[2], p[4], p[6]
+    const auto even = [](const int* p) {
+      const __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)p));
+      const __m128 b =
+          _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(p + 4)));
+      return _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    };
+    // Elements p[1], p[3], p[5], p[7]
+    const auto odd = [](const int* p) {
+      const __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)p));
+      const __m128 b =
+          _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(p + 4)));
+      return _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    };
+    const __m128i round = _mm_set1_epi32(1 << 7);
+    const auto conv = [&](const int* p) {
+      const __m128i e1 = even(p + 2);
+      __m128i s = _mm_add_epi32(even(p), even(p + 4));
+      s = _mm_add_epi32(s,
+                        _mm_slli_epi32(_mm_add_epi32(odd(p), odd(p + 2)), 2));
+      s = _mm_add_epi32(
+          s, _mm_add_epi32(_mm_slli_epi32(e1, 2), _mm_slli_epi32(e1, 1)));
+      return _mm_srai_epi32(_mm_add_epi32(s, round), 8);
+    };
+
+    // 8 output pixels read buf[2c] ... buf[2c + 19]
+    for (; c + 8 <= w_sub && 2 * c + 20 <= buf_size; c += 8) {
+      const __m128i lo = conv(buf + 2 * c);
+      const __m128i hi = conv(buf + 2 * c + 8);
+
+      if constexpr (std::is_same<T, uint8_t>::value) {
+        const __m128i v16 = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64((__m128i*)(dst + c), _mm_packus_epi16(v16, v16));
+      } else {
+        // SSE2 has no unsigned 32 to 16 bit pack, so shift to signed range
+        const __m128i offset32 = _mm_set1_epi32(1 << 15);
+        const __m128i offset16 = _mm_set1_epi16(short(0x8000));
+        const __m128i v16 = _mm_packs_epi32(_mm_sub_epi32(lo, offset32),
+                                            _mm_sub_epi32(hi, offset32));
+        _mm_storeu_si128((__m128i*)(dst + c), _mm_xor_si128(v16, offset16));
+      }
+    }
+#elif defined(__ARM_NEON)
+    const int32x4_t round = vdupq_n_s32(1 << 7);
+    const auto conv = [&](const int* p) {
+      // vld2q deinterleaves even and odd elements
+      const int32x4x2_t q0 = vld2q_s32(p);
+      const int32x4x2_t q1 = vld2q_s32(p + 2);
+      const int32x4x2_t q2 = vld2q_s32(p + 4);
+
+      int32x4_t s = vaddq_s32(q0.val[0], q2.val[0]);
+      s = vaddq_s32(s, vshlq_n_s32(vaddq_s32(q0.val[1], q1.val[1]), 2));
+      s = vaddq_s32(s, vaddq_s32(vshlq_n_s32(q1.val[0], 2),
+                                 vshlq_n_s32(q1.val[0], 1)));
+      return vreinterpretq_u32_s32(vshrq_n_s32(vaddq_s32(s, round), 8));
+    };
+
+    // 8 output pixels read buf[2c] ... buf[2c + 19]
+    for (; c + 8 <= w_sub && 2 * c + 20 <= buf_size; c += 8) {
+      const uint16x8_t v16 = vcombine_u16(vmovn_u32(conv(buf + 2 * c)),
+                                          vmovn_u32(conv(buf + 2 * c + 8)));
+
+      if constexpr (std::is_same<T, uint8_t>::value) {
+        vst1_u8(dst + c, vmovn_u16(v16));
+      } else {
+        vst1q_u16(dst + c, v16);
+      }
+    }
+#else
+    UNUSED(buf_size);
+#endif
+
+    for (; c < w_sub; c++) {
+      const int* p = buf + 2 * c;
+      const int val_int = p[0] + 4 * p[1] + 6 * p[2] + 4 * p[3] + p[4];
+      dst[c] = T((val_int + (1 << 7)) >> 8);
+    }
+  }
+
+  /// @brief Compute rows [row_begin, row_end) of a level in parallel
+  /// \ref setFromImage. Level 0 is copied from \p other.
+  inline void computeBand(const Image<const T>& other, size_t level,
+                          size_t row_begin, size_t row_end,
+                          std::vector<int>& tmp) {
+    if (level == 0) {
+      Image<T> l = lvl_internal(0);
+      PitchedCopy((char*)l.RowPtr(row_begin), l.pitch,
+                  (const char*)other.RowPtr(row_begin), other.pitch,
+                  other.w * sizeof(T), row_end - row_begin);
+      return;
+    }
+
+    const Image<const T> l = lvl(level - 1);
+    Image<T> lp1 = lvl_internal(level);
+    if (l.w < 4) {
+      subsample(l, lp1, tmp);
+    } else {
+      subsampleRows(l, lp1, row_begin, row_end, tmp);
+    }
+  }
+
+  /// @brief Bands of the levels in parallel \ref setFromImage.
+  ///
+  /// Kept in the pyramid and only reset per call, so the vectors keep their
+  /// memory across frames. Only accessed by the workers while bands are left
+  /// to start, with the mutex of \ref ParallelBuildState locked.
+  struct ParallelBuildBands {
+    size_t band_rows = 0;
+
+    std::vector<size_t> rows;                  ///< Height of each level
+    std::vector<std::vector<bool>> band_done;  ///< Finished bands per level
+    std::vector<size_t> next_band;             ///< First band not started
+    std::vector<size_t> done_bands;            ///< Finished leading bands
+
+    /// Accumulator rows for \ref subsample, one per worker and one for the
+    /// calling thread
+    std::vector<std::vector<int>> worker_tmp;
+
+    /// Set up the bands of a pyramid and return their number.
+    inline size_t reset(const ManagedImagePyr& pyr, size_t num_levels,
+                        size_t band_rows_, size_t num_workers) {
+      band_rows = band_rows_;
+      rows.resize(num_levels + 1);
+      band_done.resize(num_levels + 1);
+      next_band.assign(num_levels + 1, 0);
+      done_bands.assign(num_levels + 1, 0);
+      if (worker_tmp.size() < num_workers + 1) {
+        worker_tmp.resize(num_workers + 1);
+      }
+
+      size_t num_bands = 0;
+      for (size_t i = 0; i <= num_levels; i++) {
+        const Image<const T> l = pyr.lvl(i);
+        // narrow levels are computed in one task with subsample
+        const size_t h = (i > 0 && pyr.lvl(i - 1).w < 4) ? 1 : l.h;
+        rows[i] = l.h;
+        band_done[i].assign((h + band_rows - 1) / band_rows, false);
+        num_bands += band_done[i].size();
+      }
+      return num_bands;
+    }
+
+    /// Number of rows of a level that are finished.
+    inline size_t doneRows(size_t level) const {
+      if (done_bands[level] == band_done[level].size()) return rows[level];
+      return std::min(done_bands[level] * band_rows, rows[level]);
+    }
+
+    /// Find band whose dependencies are done, starting with the deepest
+    /// level to keep the data of the previous level in cache.
+    inline bool nextBand(size_t& level, size_t& band) const {
+      for (size_t l = rows.size(); l-- > 0;) {
+        const size_t b = next_band[l];
+        if (b == band_done[l].size()) continue;
+
+        if (l > 0) {
+          // the last row of a band needs rows up to 2 * row_end of level - 1
+          const size_t row_end = std::min((b + 1) * band_rows, rows[l]);
+          const bool whole_level = band_done[l].size() == 1;
+          const size_t needed =
+              whole_level ? rows[l - 1]
+                          : std::min(2 * row_end + 1, rows[l - 1]);
+          if (doneRows(l - 1) < needed) continue;
+        }
+
+        level = l;
+        band = b;
+        return true;
+      }
+      return false;
+    }
+
+    /// Mark a band as finished.
+    inline void finishBand(size_t level, size_t band) {
+      band_done[level][band] = true;
+      while (done_bands[level] < band_done[level].size() &&
+             band_done[level][done_bands[level]]) {
+        done_bands[level]++;
+      }
+    }
+  };
+
+  /// @brief State shared with the workers of parallel \ref setFromImage.
+  struct ParallelBuildState : ParallelWorkState {
+    ManagedImagePyr* pyr = nullptr;
+    Image<const T> src;
+
+    /// Compute ready bands until all bands are started.
+    inline void work(size_t worker) override {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (num_started < num_tasks) {
+        ParallelBuildBands& bands = pyr->build_bands;
+
+        size_t level, band;
+        if (!bands.nextBand(level, band)) {
+          // some band in progress will make new bands ready
+          cv.wait(lock);
+          continue;
+        }
+
+        bands.next_band[level]++;
+        num_started++;
+
+        const bool whole_level = bands.band_done[level].size() == 1;
+        const size_t row_begin = band * bands.band_rows;
+        const size_t row_end =
+            whole_level ? bands.rows[level]
+                        : std::min(row_begin + bands.band_rows,
+                                   bands.rows[level]);
+
+        std::exception_ptr e = runUnlocked(lock, [&]() {
+          pyr->computeBand(src, level, row_begin, row_end,
+                           bands.worker_tmp[worker]);
+        });
+        bands.finishBand(level, band);
+        completeTask(std::move(e));
+      }
+    }
+  };
+
+  size_t orig_w = 0;                 ///< Width of the original image (level 0)
+  ManagedImage<T, Allocator> image;  ///< Pyramid image stored as a mipmap
+
+  /// External level 0 set with \ref setFromExternalImage
+  Image<const T> external_lvl0;
+
+  /// Accumulator row reused by \ref subsample for all levels and images
+  std::vector<int> subsample_tmp;
+
+  /// Bands of parallel \ref setFromImage, reused for all images
+  ParallelBuildBands build_bands;
 };
 
 }  // namespace basalt
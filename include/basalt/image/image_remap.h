@@ -0,0 +1,322 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Fixed-point remapping of images between camera models
+*/
+
+#pragma once
+
+#include <basalt/camera/camera_batch.hpp>
+#include <basalt/image/image.h>
+#include <basalt/utils/parallel.h>
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace basalt {
+
+/// @brief Entry of a fixed-point remap table
+///
+/// Integer source position of the top-left pixel of the 2x2 neighborhood and
+/// fractional offsets in units of 1 / ImageRemap::FRAC_SCALE. An entry with
+/// x < 0 marks a destination pixel without valid source.
+struct RemapEntry {
+  int16_t x;
+  int16_t y;
+  uint8_t fx;
+  uint8_t fy;
+};
+
+/// @brief Precomputed pixel mapping between two camera models
+///
+/// For every pixel of the destination camera the table stores where to sample
+/// the source image in a compact fixed-point format (see @ref RemapEntry).
+/// This covers undistortion (any model to a pinhole camera), stereo
+/// rectification (rotation R_src_dst between the cameras) and fisheye to
+/// pinhole virtual cameras. Applying the table uses bilinear interpolation in
+/// integer arithmetic for Image<uint8_t> and Image<uint16_t>, optionally split
+/// into bands of rows that are processed in parallel.
+///
+/// Source positions are quantized to 1 / FRAC_SCALE of a pixel, so compared to
+/// floating point bilinear interpolation the result differs by at most the
+/// image gradient times 1 / (2 * FRAC_SCALE) pixels plus rounding of the
+/// intensity.
+class ImageRemap {
+ public:
+  /// Number of bits of the fractional source position
+  static constexpr int FRAC_BITS = 5;
+  /// Number of fractional steps per pixel
+  static constexpr int FRAC_SCALE = 1 << FRAC_BITS;
+
+  /// @brief Build the table from two camera models
+  ///
+  /// Every destination pixel is unprojected with dst_cam, rotated to the frame
+  /// of the source camera and projected with src_cam. Pixels that do not
+  /// unproject, do not project or fall outside the source image are marked
+  /// invalid.
+  ///
+  /// @param[in] src_cam camera model of the images that will be remapped, e.g.
+  /// GenericCamera or any of the concrete models
+  /// @param[in] src_w width of the source images
+  /// @param[in] src_h height of the source images
+  /// @param[in] dst_cam camera model of the remapped images
+  /// @param[in] dst_w width of the remapped images
+  /// @param[in] dst_h height of the remapped images
+  /// @param[in] R_src_dst rotation from destination to source camera frame,
+  /// identity for undistortion and the rectifying rotation for stereo
+  /// rectification
+  template <class SrcCamT, class DstCamT, class DerivedR>
+  void build(const SrcCamT& src_cam, size_t src_w, size_t src_h,
+             const DstCamT& dst_cam, size_t dst_w, size_t dst_h,
+             const Eigen::MatrixBase<DerivedR>& R_src_dst) {
+    // Destination pixels are unprojected one by one, so a GenericCamera is
+    // dispatched once here. The source camera projects whole rows with
+    // projectBatch, which dispatches once per row.
+    visitCameraModel(dst_cam, [&](const auto& dst) {
+      buildImpl(src_cam, src_w, src_h, dst, dst_w, dst_h, R_src_dst);
+    });
+  }
+
+  /// @brief Build the table without rotation between the cameras, e.g. for
+  /// undistortion. See overload above, Scalar has to match the scalar type of
+  /// the camera models.
+  template <typename Scalar = double, class SrcCamT, class DstCamT>
+  void build(const SrcCamT& src_cam, size_t src_w, size_t src_h,
+             const DstCamT& dst_cam, size_t dst_w, size_t dst_h) {
+    build(src_cam, src_w, src_h, dst_cam, dst_w, dst_h,
+          Eigen::Matrix<Scalar, 3, 3>::Identity());
+  }
+
+  /// @brief Remap an image
+  ///
+  /// @param[in] src source image, must have the size given to @ref build
+  /// @param[out] dst remapped image, must have the destination size
+  /// @param[in] border value of pixels without valid source
+  template <typename T>
+  void apply(const Image<T>& src, Image<T>& dst, T border = 0) const {
+    checkSizes(src, dst);
+    remapRows(src, dst, 0, dst.h, border);
+  }
+
+  /// @brief Remap an image using a caller-supplied executor for
+  /// parallelization.
+  ///
+  /// The destination is split into bands of rows, which are processed with
+  /// \ref parallelFor by the calling thread and \p num_workers worker tasks
+  /// passed to \p executor (see there for the requirements on the executor).
+  /// The result is identical to @ref apply without executor.
+  ///
+  /// @param[in] src source image, must have the size given to @ref build
+  /// @param[out] dst remapped image, must have the destination size
+  /// @param executor callable taking a std::function<void()> to run, e.g.
+  /// submitting it to a thread pool
+  /// @param num_workers number of tasks passed to the executor
+  /// @param band_rows number of rows in a band
+  /// @param[in] border value of pixels without valid source
+  template <typename T, class Executor>
+  void apply(const Image<T>& src, Image<T>& dst, Executor&& executor,
+             size_t num_workers, size_t band_rows = 32, T border = 0) const {
+    BASALT_ASSERT(band_rows > 0);
+    checkSizes(src, dst);
+
+    const size_t num_bands = (dst.h + band_rows - 1) / band_rows;
+    parallelFor(num_bands, std::forward<Executor>(executor), num_workers,
+                [&](size_t band) {
+                  const size_t row_begin = band * band_rows;
+                  remapRows(src, dst, row_begin,
+                            std::min(row_begin + band_rows, size_t(dst.h)),
+                            border);
+                });
+  }
+
+  /// @brief Table with one entry per destination pixel
+  inline const ManagedImage<RemapEntry>& getMap() const { return map_; }
+
+  /// @brief Width of the source images
+  inline size_t getSrcWidth() const { return src_w_; }
+
+  /// @brief Height of the source images
+  inline size_t getSrcHeight() const { return src_h_; }
+
+ private:
+  /// @brief Build the table for a concrete destination camera model, see
+  /// @ref build
+  template <class SrcCamT, class DstCamT, class DerivedR>
+  void buildImpl(const SrcCamT& src_cam, size_t src_w, size_t src_h,
+                 const DstCamT& dst_cam, size_t dst_w, size_t dst_h,
+                 const Eigen::MatrixBase<DerivedR>& R_src_dst) {
+    using Scalar = typename DerivedR::Scalar;
+    using Vec2 = Eigen::Matrix<Scalar, 2, 1>;
+    using Vec4 = Eigen::Matrix<Scalar, 4, 1>;
+
+    EIGEN_STATIC_ASSERT_MATRIX_SPECIFIC_SIZE(DerivedR, 3, 3);
+    BASALT_ASSERT(src_w >= 2 && src_h >= 2);
+    BASALT_ASSERT(src_w <= size_t(INT16_MAX) && src_h <= size_t(INT16_MAX));
+
+    src_w_ = src_w;
+    src_h_ = src_h;
+    map_.Reinitialise(dst_w, dst_h);
+
+    const int max_x = int(src_w) - 2;
+    const int max_y = int(src_h) - 2;
+
+    // Rows are projected as a batch, see projectBatch of the camera models.
+    Eigen::Matrix<Scalar, 3, Eigen::Dynamic, Eigen::RowMajor> p3d(3, dst_w);
+    Eigen::Matrix<Scalar, 2, Eigen::Dynamic, Eigen::RowMajor> proj(2, dst_w);
+    Eigen::Matrix<uint8_t, Eigen::Dynamic, 1> proj_valid(dst_w);
+    std::vector<uint8_t> unproj_valid(dst_w);
+
+    for (size_t y = 0; y < dst_h; y++) {
+      for (size_t x = 0; x < dst_w; x++) {
+        Vec4 p;
+        unproj_valid[x] = dst_cam.unproject(Vec2(Scalar(x), Scalar(y)), p);
+        if (unproj_valid[x]) {
+          p3d.col(x) = R_src_dst * p.template head<3>();
+        } else {
+          p3d.col(x) << 0, 0, 1;
+        }
+      }
+
+      src_cam.projectBatch(p3d, proj, proj_valid);
+
+      RemapEntry* row = map_.RowPtr(y);
+      for (size_t x = 0; x < dst_w; x++) {
+        const Scalar sx = proj(0, x);
+        const Scalar sy = proj(1, x);
+
+        // Range is checked on the quantized position, so that round-off of
+        // the projection does not reject pixels on the border of the image.
+        RemapEntry& e = row[x];
+        if (!(unproj_valid[x] && proj_valid[x] && sx > -1 && sy > -1 &&
+              sx < Scalar(src_w) && sy < Scalar(src_h))) {
+          e = RemapEntry{-1, -1, 0, 0};
+          continue;
+        }
+
+        const int qx = int(std::lround(sx * FRAC_SCALE));
+        const int qy = int(std::lround(sy * FRAC_SCALE));
+        if (qx < 0 || qy < 0 || qx > (max_x + 1) * FRAC_SCALE ||
+            qy > (max_y + 1) * FRAC_SCALE) {
+          e = RemapEntry{-1, -1, 0, 0};
+          continue;
+        }
+
+        // The last row and column are reached with the full fractional
+        // weight, so the 2x2 neighborhood never leaves the image.
+        const int ix = std::min(qx >> FRAC_BITS, max_x);
+        const int iy = std::min(qy >> FRAC_BITS, max_y);
+
+        e.x = int16_t(ix);
+        e.y = int16_t(iy);
+        e.fx = uint8_t(qx - ix * FRAC_SCALE);
+        e.fy = uint8_t(qy - iy * FRAC_SCALE);
+      }
+    }
+  }
+
+  template <typename T>
+  void checkSizes(const Image<T>& src, const Image<T>& dst) const {
+    static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>,
+                  "only uint8_t and uint16_t images are supported");
+    BASALT_ASSERT(src.w == src_w_ && src.h == src_h_);
+    BASALT_ASSERT(dst.w == map_.w && dst.h == map_.h);
+  }
+
+  /// @brief Remap rows [row_begin, row_end) of the destination
+  ///
+  /// Source pixels are gathered chunk by chunk into small arrays, the blending
+  /// loop over a chunk is free of branches and memory indirection so that it
+  /// vectorizes.
+  template <typename T>
+  void remapRows(const Image<T>& src, Image<T>& dst, size_t row_begin,
+                 size_t row_end, T border) const {
+    constexpr int CHUNK = 16;
+    constexpr int32_t HALF = 1 << (2 * FRAC_BITS - 1);
+
+    int32_t p00[CHUNK], p01[CHUNK], p10[CHUNK], p11[CHUNK];
+    int32_t wx[CHUNK], wy[CHUNK], res[CHUNK];
+    bool valid[CHUNK];
+
+    for (size_t y = row_begin; y < row_end; y++) {
+      const RemapEntry* map_row = map_.RowPtr(y);
+      T* dst_row = dst.RowPtr(y);
+
+      for (size_t x0 = 0; x0 < dst.w; x0 += CHUNK) {
+        const int n = int(std::min<size_t>(CHUNK, dst.w - x0));
+
+        for (int k = 0; k < n; k++) {
+          const RemapEntry& e = map_row[x0 + k];
+          valid[k] = e.x >= 0;
+          if (valid[k]) {
+            const T* r0 = src.RowPtr(e.y) + e.x;
+            const T* r1 = src.RowPtr(e.y + 1) + e.x;
+            p00[k] = r0[0];
+            p01[k] = r0[1];
+            p10[k] = r1[0];
+            p11[k] = r1[1];
+            wx[k] = e.fx;
+            wy[k] = e.fy;
+          } else {
+            p00[k] = p01[k] = p10[k] = p11[k] = 0;
+            wx[k] = wy[k] = 0;
+          }
+        }
+
+        for (int k = 0; k < n; k++) {
+          const int32_t top = p00[k] * FRAC_SCALE + (p01[k] - p00[k]) * wx[k];
+          const int32_t bot = p10[k] * FRAC_SCALE + (p11[k] - p10[k]) * wx[k];
+          res[k] = (top * FRAC_SCALE + (bot - top) * wy[k] + HALF) >>
+                   (2 * FRAC_BITS);
+        }
+
+        for (int k = 0; k < n; k++) {
+          dst_row[x0 + k] = valid[k] ? T(res[k]) : border;
+        }
+      }
+    }
+  }
+
+  size_t src_w_ = 0;
+  size_t src_h_ = 0;
+
+  ManagedImage<RemapEntry> map_;
+};
+
+}  // namespace basalt
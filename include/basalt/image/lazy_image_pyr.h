@@ -0,0 +1,235 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Image pyramid with levels computed on demand
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <basalt/image/image.h>
+#include <basalt/image/image_pyr.h>
+#include <basalt/utils/instrumentation.h>
+
+namespace basalt {
+
+/// @brief Storage of the levels of a \ref LazyImagePyr.
+enum class PyrLayout {
+  /// All levels in one mipmap image as in \ref ManagedImagePyr
+  Mipmap,
+  /// A separate image per level, so rows of deep levels are contiguous
+  PerLevel
+};
+
+/// @brief Image pyramid that computes levels when they are first accessed.
+///
+/// Setting a new image for level 0 only invalidates levels 1 and higher, they
+/// are computed by \ref lvl when requested, together with all lower levels
+/// that are not computed yet. A tracker that only uses the first levels for
+/// most frames skips subsampling the rest. The levels are identical to the
+/// ones of \ref ManagedImagePyr and memory is kept between frames of the same
+/// size.
+///
+/// Accessing a level that is not computed yet modifies the pyramid, so
+/// concurrent calls to \ref lvl need external synchronization. Use
+/// \ref computeLevels before sharing the pyramid between threads.
+template <typename T, class Allocator = DefaultImageAllocator<T>>
+class LazyImagePyr {
+ public:
+  using PixelType = T;
+  using Ptr = std::shared_ptr<LazyImagePyr<T, Allocator>>;
+
+  /// @brief Construct empty pyramid.
+  ///
+  /// @param layout storage of the levels
+  inline explicit LazyImagePyr(PyrLayout layout = PyrLayout::Mipmap)
+      : layout_(layout) {}
+
+  /// @brief Set level 0 from other image and invalidate all other levels.
+  ///
+  /// @param other image to use for the pyramid level 0
+  /// @param num_level number of levels for the pyramid
+  template <class OtherAllocator>
+  inline void setFromImage(const ManagedImage<T, OtherAllocator>& other,
+                           size_t num_levels) {
+    setFromImage(other.SubImage(0, 0, other.w, other.h), num_levels);
+  }
+
+  /// @brief Set level 0 from other image and invalidate all other levels.
+  ///
+  /// @param other image to use for the pyramid level 0
+  /// @param num_level number of levels for the pyramid
+  inline void setFromImage(const Image<const T>& other, size_t num_levels) {
+    reinitialise(other.w, other.h, num_levels, false);
+
+    Image<T> l0 = lvl_internal(0);
+    PitchedCopy((char*)l0.ptr, l0.pitch, (const char*)other.ptr, other.pitch,
+                other.w * sizeof(T), other.h);
+  }
+
+  /// @brief Use other image as level 0 without copying it and invalidate all
+  /// other levels.
+  ///
+  /// \p other has to stay valid as long as the pyramid is used (or until it
+  /// is set again).
+  ///
+  /// @param other image to use for the pyramid level 0
+  /// @param num_level number of levels for the pyramid
+  inline void setFromExternalImage(const Image<const T>& other,
+                                   size_t num_levels) {
+    reinitialise(other.w, other.h, num_levels, true);
+    external_lvl0_ = other;
+  }
+
+  /// @brief Return image of the certain level, computing it if required.
+  ///
+  /// @param lvl level to return, at most the number of levels
+  /// @return const image of the pyramid level
+  inline const Image<const T> lvl(size_t lvl) {
+    BASALT_ASSERT_STREAM(lvl <= num_levels_,
+                         "lvl " << lvl << " num_levels " << num_levels_);
+
+    if (lvl > num_computed_) computeLevels(lvl);
+    return lvl_view(lvl);
+  }
+
+  /// @brief Compute all levels up to \p lvl that are not computed yet.
+  ///
+  /// @param lvl highest level to compute, at most the number of levels
+  inline void computeLevels(size_t lvl) {
+    BASALT_ASSERT_STREAM(lvl <= num_levels_,
+                         "lvl " << lvl << " num_levels " << num_levels_);
+    if (lvl <= num_computed_) return;
+
+    BASALT_INSTRUMENT_SCOPE("basalt::LazyImagePyr::computeLevels");
+
+    for (size_t i = num_computed_; i < lvl; i++) {
+      const Image<const T> l = lvl_view(i);
+      Image<T> lp1 = lvl_internal(i + 1);
+      ManagedImagePyr<T, Allocator>::subsample(l, lp1, subsample_tmp_);
+    }
+    num_computed_ = lvl;
+  }
+
+  /// @brief Compute all levels.
+  inline void computeLevels() { computeLevels(num_levels_); }
+
+  /// @brief Check if a level is computed. Level 0 always is.
+  inline bool isComputed(size_t lvl) const { return lvl <= num_computed_; }
+
+  /// @brief Number of levels above level 0.
+  inline size_t numLevels() const { return num_levels_; }
+
+  /// @brief Storage of the levels.
+  inline PyrLayout layout() const { return layout_; }
+
+ protected:
+  /// @brief Resize the storage for level 0 of the given size and invalidate
+  /// all levels.
+  ///
+  /// @param external if true, no separate image is needed for level 0
+  inline void reinitialise(size_t w, size_t h, size_t num_levels,
+                           bool external) {
+    orig_w_ = w;
+    orig_h_ = h;
+    num_levels_ = num_levels;
+    num_computed_ = 0;
+    external_lvl0_ = Image<const T>();
+
+    if (layout_ == PyrLayout::Mipmap) {
+      mipmap_.Reinitialise(w + w / 2, h);
+    } else {
+      levels_.resize(num_levels + 1);
+      if (!external) levels_[0].Reinitialise(w, h);
+      for (size_t l = 1; l <= num_levels; l++) {
+        levels_[l].Reinitialise(w >> l, h >> l);
+      }
+    }
+  }
+
+  /// @brief Return image of the certain level without computing it.
+  inline const Image<const T> lvl_view(size_t lvl) const {
+    if (lvl == 0 && external_lvl0_.IsValid()) return external_lvl0_;
+
+    if (layout_ == PyrLayout::PerLevel) {
+      const ManagedImage<T, Allocator>& l = levels_[lvl];
+      return l.SubImage(0, 0, l.w, l.h);
+    }
+
+    return mipmap_.SubImage(mipmapX(lvl), mipmapY(lvl), orig_w_ >> lvl,
+                            orig_h_ >> lvl);
+  }
+
+  /// @brief Return writable image of the certain level.
+  inline Image<T> lvl_internal(size_t lvl) {
+    if (layout_ == PyrLayout::PerLevel) {
+      ManagedImage<T, Allocator>& l = levels_[lvl];
+      return l.SubImage(0, 0, l.w, l.h);
+    }
+
+    return mipmap_.SubImage(mipmapX(lvl), mipmapY(lvl), orig_w_ >> lvl,
+                            orig_h_ >> lvl);
+  }
+
+  /// @brief Column of the level in the mipmap, see \ref ManagedImagePyr.
+  inline size_t mipmapX(size_t lvl) const { return (lvl == 0) ? 0 : orig_w_; }
+
+  /// @brief Row of the level in the mipmap, see \ref ManagedImagePyr.
+  inline size_t mipmapY(size_t lvl) const {
+    return (lvl <= 1) ? 0 : (orig_h_ - (orig_h_ >> (lvl - 1)));
+  }
+
+  PyrLayout layout_;
+
+  size_t orig_w_ = 0;        ///< Width of level 0
+  size_t orig_h_ = 0;        ///< Height of level 0
+  size_t num_levels_ = 0;    ///< Number of levels above level 0
+  size_t num_computed_ = 0;  ///< Levels up to this one are valid
+
+  ManagedImage<T, Allocator> mipmap_;  ///< Storage for PyrLayout::Mipmap
+
+  /// Storage for PyrLayout::PerLevel
+  std::vector<ManagedImage<T, Allocator>> levels_;
+
+  /// External level 0 set with \ref setFromExternalImage
+  Image<const T> external_lvl0_;
+
+  /// Accumulator row reused by \ref ManagedImagePyr::subsample
+  std::vector<int> subsample_tmp_;
+};
+
+}  // namespace basalt
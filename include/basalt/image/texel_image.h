@@ -0,0 +1,116 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Base of images with precomputed per-pixel texels
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include <Eigen/Dense>
+
+#include <basalt/image/image.h>
+
+namespace basalt {
+
+/// @brief Texel of 4 floats, 16 bytes per pixel.
+struct Texel4f {
+  float data[4];
+};
+
+/// @brief Texel as 4-vector of the result type.
+template <typename S>
+inline Eigen::Matrix<S, 4, 1> loadTexel(const Texel4f& t) {
+  return Eigen::Map<const Eigen::Matrix<float, 4, 1>>(t.data)
+      .template cast<S>();
+}
+
+/// @brief Common part of images that store per-pixel data precomputed from
+/// an 8 or 16 bit image, see \ref GradientImage and \ref CubicSplineImage.
+///
+/// Derived classes fill \ref texels_ in setFromImage and implement the
+/// interpolation on top of it.
+template <typename T, typename TexelT, class Allocator>
+class TexelImage {
+ public:
+  static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>);
+
+  using PixelType = T;
+  using Texel = TexelT;
+
+  using TexelAllocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Texel>;
+
+  /// @brief In bounds check, same as \ref Image::InBounds.
+  inline bool InBounds(float x, float y, float border) const {
+    return texels_.InBounds(x, y, border);
+  }
+
+  /// @brief Width of the image.
+  inline size_t width() const { return texels_.w; }
+
+  /// @brief Height of the image.
+  inline size_t height() const { return texels_.h; }
+
+  /// @brief Precomputed texels, e.g. for visualization.
+  inline const Image<const Texel> texels() const {
+    return texels_.SubImage(0, 0, texels_.w, texels_.h);
+  }
+
+ protected:
+  /// Evaluate res.col(i) = func(points(0, i), points(1, i)) for all points;
+  /// the loop behind the batched interfaces of the derived classes.
+  template <typename DerivedP, typename DerivedRes, typename Func>
+  static inline void evalBatch(const Eigen::MatrixBase<DerivedP>& points,
+                               const Eigen::MatrixBase<DerivedRes>& res,
+                               Func&& func) {
+    static_assert(DerivedP::RowsAtCompileTime == 2);
+    static_assert(DerivedRes::RowsAtCompileTime == 3);
+
+    BASALT_ASSERT(points.cols() == res.cols());
+
+    auto& res_ref = const_cast<Eigen::MatrixBase<DerivedRes>&>(res);
+    for (int i = 0; i < points.cols(); i++) {
+      res_ref.col(i) = func(points(0, i), points(1, i));
+    }
+  }
+
+  ManagedImage<Texel, TexelAllocator> texels_;
+};
+
+}  // namespace basalt
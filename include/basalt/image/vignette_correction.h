@@ -0,0 +1,252 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+@file
+@brief Photometric vignette correction with precomputed fixed-point gains
+*/
+
+#pragma once
+
+#include <basalt/image/image.h>
+#include <basalt/image/image_pyr.h>
+#include <basalt/spline/rd_spline.h>
+#include <basalt/utils/instrumentation.h>
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace basalt {
+
+/// @brief Vignette correction for images of one camera
+///
+/// The vignette of a camera is stored in \ref Calibration::vignette as a
+/// spline over the distance from the optical center (in pixels multiplied by
+/// 1e9). Evaluating it per pixel is expensive, so the inverse of the
+/// attenuation is sampled once into a radial lookup table and expanded to a
+/// per-pixel gain image in fixed point. Correcting an image is then a
+/// multiplication with the gain, a shift and saturation per pixel, which the
+/// compiler vectorizes.
+///
+/// Compared to dividing by the spline value in floating point, the result
+/// differs by at most one intensity level plus the intensity times the error
+/// of the gain. The gain has two sources of error:
+/// - it is quantized to 1 / GAIN_SCALE, which adds at most
+///   1 / (2 * GAIN_SCALE),
+/// - it is taken from the lookup table entry with the nearest radius, which
+///   is up to 1 / (2 * RADIUS_STEPS) pixels away from the radius of the
+///   pixel. This adds at most the change of 1 / attenuation over that
+///   distance, e.g. 1.3e-3 at the image corners of a 640x480 camera whose
+///   attenuation falls to 0.5 as 1 - 0.5 * (r / 400)^2.
+class VignetteCorrection {
+ public:
+  /// Number of fractional bits of the gains
+  static constexpr int GAIN_BITS = 12;
+  /// Fixed-point representation of gain 1
+  static constexpr int GAIN_SCALE = 1 << GAIN_BITS;
+  /// Number of entries of the radial lookup table per pixel of radius
+  static constexpr int RADIUS_STEPS = 4;
+
+  /// @brief Build the gain tables from a vignette spline
+  ///
+  /// @param[in] vignette spline of the attenuation over the distance from
+  /// \p center in pixels multiplied by 1e9, e.g. from \ref
+  /// Calibration::vignette. Radii outside of the spline are clamped to its
+  /// time range.
+  /// @param[in] w width of the images
+  /// @param[in] h height of the images
+  /// @param[in] center optical center in pixels
+  /// @param[in] max_gain upper bound for the gain, limits the amplification
+  /// of noise where the attenuation is close to zero. Has to be below 16.
+  template <int _N, typename Scalar, template <class> class _KnotStorage>
+  void build(const RdSpline<1, _N, Scalar, _KnotStorage>& vignette, size_t w,
+             size_t h, const Eigen::Vector2d& center, double max_gain = 8) {
+    BASALT_ASSERT(max_gain >= 1);
+    BASALT_ASSERT(max_gain * GAIN_SCALE <=
+                  double(std::numeric_limits<uint16_t>::max()));
+
+    center_ = center;
+
+    // Largest distance of a pixel from the center, reached at a corner.
+    const double max_x = std::max(center[0], double(w) - 1 - center[0]);
+    const double max_y = std::max(center[1], double(h) - 1 - center[1]);
+    const double max_r = std::sqrt(max_x * max_x + max_y * max_y);
+
+    const size_t lut_size = size_t(std::ceil(max_r * RADIUS_STEPS)) + 1;
+    radius_lut_.resize(lut_size);
+
+    const double min_t = double(vignette.minTimeNs());
+    const double max_t = double(vignette.maxTimeNs());
+    const double min_v = 1.0 / max_gain;
+
+    for (size_t i = 0; i < lut_size; i++) {
+      const double r = double(i) / RADIUS_STEPS;
+      const double t = std::clamp(r * 1e9, min_t, max_t);
+      const double v =
+          std::max(double(vignette.evaluate(int64_t(t))[0]), min_v);
+      radius_lut_[i] = uint16_t(std::lround(GAIN_SCALE / v));
+    }
+
+    gain_.Reinitialise(w, h);
+    for (size_t y = 0; y < h; y++) {
+      uint16_t* row = gain_.RowPtr(y);
+      const double dy = double(y) - center[1];
+      for (size_t x = 0; x < w; x++) {
+        const double dx = double(x) - center[0];
+        const double r = std::sqrt(dx * dx + dy * dy);
+        row[x] = radius_lut_[size_t(std::lround(r * RADIUS_STEPS))];
+      }
+    }
+  }
+
+  /// @brief Build the gain tables with the optical center in the middle of
+  /// the image (half the resolution), the convention of the vignette
+  /// calibration. See overload above.
+  template <int _N, typename Scalar, template <class> class _KnotStorage>
+  void build(const RdSpline<1, _N, Scalar, _KnotStorage>& vignette,
+             const Eigen::Vector2i& resolution, double max_gain = 8) {
+    build(vignette, size_t(resolution[0]), size_t(resolution[1]),
+          resolution.cast<double>() / 2, max_gain);
+  }
+
+  /// @brief Correct an image
+  ///
+  /// @param[in] src image to correct, must have the size given to @ref build
+  /// @param[out] dst corrected image of the same size, may be \p src
+  template <typename T>
+  void apply(const Image<const T>& src, Image<T>& dst) const {
+    BASALT_ASSERT(dst.w == src.w && dst.h == src.h);
+    applyRows(src, dst, 0, src.h);
+  }
+
+  /// @brief Correct an image. See overload above.
+  template <typename T>
+  void apply(const Image<T>& src, Image<T>& dst) const {
+    apply(Image<const T>(src.ptr, src.w, src.h, src.pitch), dst);
+  }
+
+  /// @brief Correct an image in place
+  template <typename T>
+  void apply(Image<T>& img) const {
+    apply(img, img);
+  }
+
+  /// @brief Correct rows [row_begin, row_end) of an image, e.g. to process
+  /// bands of rows in parallel.
+  ///
+  /// @param[in] src image to correct, must have the size given to @ref build
+  /// @param[out] dst corrected image of the same size, may be \p src
+  /// @param[in] row_begin first row to correct
+  /// @param[in] row_end end of the rows to correct
+  template <typename T>
+  void applyRows(const Image<const T>& src, Image<T>& dst, size_t row_begin,
+                 size_t row_end) const {
+    static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>,
+                  "only uint8_t and uint16_t images are supported");
+    BASALT_ASSERT(src.w == gain_.w && src.h == gain_.h);
+    BASALT_ASSERT(row_end <= src.h);
+
+    // 65535 * 65535 + HALF still fits into 32 bits.
+    constexpr uint32_t HALF = 1 << (GAIN_BITS - 1);
+    constexpr uint32_t MAX_VAL = std::numeric_limits<T>::max();
+
+    for (size_t y = row_begin; y < row_end; y++) {
+      const T* src_row = src.RowPtr(y);
+      const uint16_t* gain_row = gain_.RowPtr(y);
+      T* dst_row = dst.RowPtr(y);
+
+      for (size_t x = 0; x < src.w; x++) {
+        const uint32_t v = (uint32_t(src_row[x]) * gain_row[x] + HALF) >>
+                           GAIN_BITS;
+        dst_row[x] = T(std::min(v, MAX_VAL));
+      }
+    }
+  }
+
+  /// @brief Gain of every pixel in units of 1 / GAIN_SCALE
+  inline const ManagedImage<uint16_t>& getGain() const { return gain_; }
+
+  /// @brief Gain over the distance from the optical center in units of
+  /// 1 / GAIN_SCALE, entry i is the gain at radius i / RADIUS_STEPS.
+  inline const std::vector<uint16_t>& getRadiusLut() const {
+    return radius_lut_;
+  }
+
+  /// @brief Optical center used to build the tables
+  inline const Eigen::Vector2d& getCenter() const { return center_; }
+
+ private:
+  Eigen::Vector2d center_ = Eigen::Vector2d::Zero();
+  std::vector<uint16_t> radius_lut_;
+  ManagedImage<uint16_t> gain_;
+};
+
+/// @brief Set image pyramid from an image and correct its vignette.
+///
+/// The correction is applied while level 0 is written, so the image is
+/// traversed only once. All levels are computed from the corrected image.
+///
+/// @param[out] pyr pyramid to set
+/// @param[in] img image to use for the pyramid level 0
+/// @param[in] num_levels number of levels for the pyramid
+/// @param[in] vignette correction built for the size of \p img
+template <typename T, class Allocator>
+inline void setFromImage(ManagedImagePyr<T, Allocator>& pyr,
+                         const Image<const T>& img, size_t num_levels,
+                         const VignetteCorrection& vignette) {
+  BASALT_INSTRUMENT_SCOPE("basalt::ManagedImagePyr::setFromImage");
+
+  Image<T> l0 = pyr.prepareLevel0(img.w, img.h);
+  vignette.apply(img, l0);
+
+  pyr.computeLevels(num_levels);
+}
+
+/// @brief Set image pyramid from an image and correct its vignette. See
+/// overload above.
+template <typename T, class Allocator, class OtherAllocator>
+inline void setFromImage(ManagedImagePyr<T, Allocator>& pyr,
+                         const ManagedImage<T, OtherAllocator>& img,
+                         size_t num_levels,
+                         const VignetteCorrection& vignette) {
+  setFromImage(pyr, img.SubImage(0, 0, img.w, img.h), num_levels, vignette);
+}
+
+}  // namespace basalt
@@ -0,0 +1,319 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Structure-of-arrays container for PoseVelBiasState
+*/
+
+#pragma once
+
+#include <basalt/imu/imu_types.h>
+#include <basalt/utils/assert.h>
+#include <basalt/utils/instrumentation.h>
+
+#include <vector>
+
+namespace basalt {
+
+/// @brief Array of \ref PoseVelBiasState stored as one matrix per member.
+///
+/// Optimizers hold many states and update all of them with one solver
+/// increment. Storing each member of all states in one matrix turns
+/// \ref applyInc and \ref diff for the whole array into a few streaming
+/// array operations, including the exponential and logarithm maps of the
+/// rotations, instead of many small per-state operations.
+///
+/// Poses are stored as columns of SE3 parameters (see SE3::data(), unit
+/// quaternion coefficients followed by the translation), so single states can
+/// still be accessed without copies as Eigen::Map<SE3> and Eigen::Map<Vec3>.
+/// The increments and differences use the layout of a dense solver vector:
+/// state i occupies the 15 entries starting at POSE_VEL_BIAS_SIZE * i,
+/// ordered like in PoseVelBiasState::applyInc.
+template <class Scalar_>
+class PoseVelBiasStateArray {
+ public:
+  using Scalar = Scalar_;
+  using State = PoseVelBiasState<Scalar>;
+  using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+  using VecX = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+  using SO3 = Sophus::SO3<Scalar>;
+  using SE3 = Sophus::SE3<Scalar>;
+
+  static constexpr int POSE_PARAMS = SE3::num_parameters;
+
+  using PoseMat = Eigen::Matrix<Scalar, POSE_PARAMS, Eigen::Dynamic>;
+  using Vec3Mat = Eigen::Matrix<Scalar, 3, Eigen::Dynamic>;
+  using IncMat = Eigen::Matrix<Scalar, POSE_VEL_BIAS_SIZE, Eigen::Dynamic>;
+
+  /// @brief Default constructor with no states.
+  PoseVelBiasStateArray() = default;
+
+  /// @brief Constructor with num_states default initialized states.
+  explicit PoseVelBiasStateArray(size_t num_states) { resize(num_states); }
+
+  /// @brief Constructor copying the given states.
+  explicit PoseVelBiasStateArray(const Eigen::aligned_vector<State>& states) {
+    resize(states.size());
+    for (size_t i = 0; i < states.size(); i++) setState(i, states[i]);
+  }
+
+  /// @brief Resize the array, keeping existing states. New states have
+  /// identity pose and zero other values like the default
+  /// PoseVelBiasState.
+  void resize(size_t num_states) {
+    const size_t old_size = size();
+
+    t_ns_.resize(num_states, 0);
+    poses_.conservativeResize(POSE_PARAMS, num_states);
+    vel_w_i_.conservativeResize(3, num_states);
+    bias_gyro_.conservativeResize(3, num_states);
+    bias_accel_.conservativeResize(3, num_states);
+
+    for (size_t i = old_size; i < num_states; i++) setState(i, State());
+  }
+
+  /// @brief Number of states.
+  inline size_t size() const { return t_ns_.size(); }
+
+  /// @brief Copy state i into a PoseVelBiasState.
+  State getState(size_t i) const {
+    return State(t_ns_[i], T_w_i(i), vel_w_i(i), bias_gyro(i), bias_accel(i));
+  }
+
+  /// @brief Overwrite state i.
+  void setState(size_t i, const State& state) {
+    t_ns_[i] = state.t_ns;
+    T_w_i(i) = state.T_w_i;
+    vel_w_i(i) = state.vel_w_i;
+    bias_gyro(i) = state.bias_gyro;
+    bias_accel(i) = state.bias_accel;
+  }
+
+  /// @brief Copy all states into a vector of PoseVelBiasState.
+  Eigen::aligned_vector<State> getStates() const {
+    Eigen::aligned_vector<State> res(size());
+    for (size_t i = 0; i < size(); i++) res[i] = getState(i);
+    return res;
+  }
+
+  /// @brief Timestamp of state i in nanoseconds.
+  inline int64_t& t_ns(size_t i) { return t_ns_[i]; }
+
+  /// @brief Timestamp of state i in nanoseconds.
+  inline int64_t t_ns(size_t i) const { return t_ns_[i]; }
+
+  /// @brief Pose of state i mapped to the array storage.
+  inline Eigen::Map<SE3> T_w_i(size_t i) {
+    return Eigen::Map<SE3>(poses_.col(i).data());
+  }
+
+  /// @brief Pose of state i mapped to the array storage.
+  inline Eigen::Map<const SE3> T_w_i(size_t i) const {
+    return Eigen::Map<const SE3>(poses_.col(i).data());
+  }
+
+  /// @brief Linear velocity of state i mapped to the array storage.
+  inline Eigen::Map<Vec3> vel_w_i(size_t i) {
+    return Eigen::Map<Vec3>(vel_w_i_.col(i).data());
+  }
+
+  /// @brief Linear velocity of state i mapped to the array storage.
+  inline Eigen::Map<const Vec3> vel_w_i(size_t i) const {
+    return Eigen::Map<const Vec3>(vel_w_i_.col(i).data());
+  }
+
+  /// @brief Gyroscope bias of state i mapped to the array storage.
+  inline Eigen::Map<Vec3> bias_gyro(size_t i) {
+    return Eigen::Map<Vec3>(bias_gyro_.col(i).data());
+  }
+
+  /// @brief Gyroscope bias of state i mapped to the array storage.
+  inline Eigen::Map<const Vec3> bias_gyro(size_t i) const {
+    return Eigen::Map<const Vec3>(bias_gyro_.col(i).data());
+  }
+
+  /// @brief Accelerometer bias of state i mapped to the array storage.
+  inline Eigen::Map<Vec3> bias_accel(size_t i) {
+    return Eigen::Map<Vec3>(bias_accel_.col(i).data());
+  }
+
+  /// @brief Accelerometer bias of state i mapped to the array storage.
+  inline Eigen::Map<const Vec3> bias_accel(size_t i) const {
+    return Eigen::Map<const Vec3>(bias_accel_.col(i).data());
+  }
+
+  /// @brief Poses of all states, one column of SE3 parameters per state.
+  inline const PoseMat& poses() const { return poses_; }
+
+  /// @brief Apply an increment to all states.
+  ///
+  /// Same as calling PoseVelBiasState::applyInc with the segment of inc of
+  /// every state.
+  /// @param[in] inc increment of size POSE_VEL_BIAS_SIZE * size()
+  void applyInc(const Eigen::Ref<const VecX>& inc) {
+    BASALT_INSTRUMENT_SCOPE("basalt::PoseVelBiasStateArray::applyInc");
+
+    BASALT_ASSERT_STREAM(size_t(inc.size()) == POSE_VEL_BIAS_SIZE * size(),
+                         "inc.size() " << inc.size() << " size() " << size());
+
+    const Eigen::Map<const IncMat> inc_mat(inc.data(), POSE_VEL_BIAS_SIZE,
+                                           size());
+
+    poses_.template bottomRows<3>() += inc_mat.template topRows<3>();
+    vel_w_i_ += inc_mat.template middleRows<3>(6);
+    bias_gyro_ += inc_mat.template middleRows<3>(9);
+    bias_accel_ += inc_mat.template middleRows<3>(12);
+
+    // R' = exp(omega) * R for all states, with SO3::exp evaluated on the
+    // whole row of rotation angles.
+    const Vec3Array omega = inc_mat.template middleRows<3>(3).array();
+    const RowArray theta_sq = omega.square().colwise().sum();
+    const RowArray theta = theta_sq.sqrt();
+    const RowArray half_theta = Scalar(0.5) * theta;
+
+    const Scalar eps = Sophus::Constants<Scalar>::epsilon();
+    const auto small = theta_sq < eps * eps;
+    const RowArray theta_po4 = theta_sq.square();
+    const RowArray real =
+        small.select(Scalar(1) - Scalar(1.0 / 8.0) * theta_sq +
+                         Scalar(1.0 / 384.0) * theta_po4,
+                     half_theta.cos());
+    const RowArray imag =
+        small.select(Scalar(0.5) - Scalar(1.0 / 48.0) * theta_sq +
+                         Scalar(1.0 / 3840.0) * theta_po4,
+                     half_theta.sin() / theta);
+
+    const Vec3Array v = omega.rowwise() * imag;
+    auto q = poses_.template topRows<4>().array();
+    quatMultiply(real, v, q, q);
+  }
+
+  /// @brief Compute the difference to another array of the same size.
+  ///
+  /// Same as calling PoseVelBiasState::diff for every state, so
+  /// ```
+  ///      b = a;
+  ///      b.applyInc(inc);
+  ///      a.diff(b) == inc; // Should be true.
+  /// ```
+  /// @param[in] other states to compute the difference to
+  /// @return differences of size POSE_VEL_BIAS_SIZE * size()
+  VecX diff(const PoseVelBiasStateArray& other) const {
+    BASALT_INSTRUMENT_SCOPE("basalt::PoseVelBiasStateArray::diff");
+
+    BASALT_ASSERT_STREAM(other.size() == size(), "other.size() "
+                                                     << other.size()
+                                                     << " size() " << size());
+
+    VecX res(POSE_VEL_BIAS_SIZE * size());
+    Eigen::Map<IncMat> res_mat(res.data(), POSE_VEL_BIAS_SIZE, size());
+
+    res_mat.template topRows<3>() =
+        other.poses_.template bottomRows<3>() - poses_.template bottomRows<3>();
+    res_mat.template middleRows<3>(6) = other.vel_w_i_ - vel_w_i_;
+    res_mat.template middleRows<3>(9) = other.bias_gyro_ - bias_gyro_;
+    res_mat.template middleRows<3>(12) = other.bias_accel_ - bias_accel_;
+
+    // log(R_other * R^-1) for all states, with SO3::log evaluated on the
+    // whole rows of quaternion coefficients.
+    const Scalar eps = Sophus::Constants<Scalar>::epsilon();
+    const Scalar pi = Sophus::Constants<Scalar>::pi();
+
+    const auto q_other = other.poses_.template topRows<4>().array();
+    QuatArray q_inv = poses_.template topRows<4>().array();
+    q_inv.template topRows<3>() *= Scalar(-1);
+
+    QuatArray q_rel(4, size());
+    quatMultiply(q_other.row(3), q_other.template topRows<3>(), q_inv, q_rel);
+
+    const RowArray w = q_rel.row(3);
+    const RowArray n_sq = q_rel.template topRows<3>().square().colwise().sum();
+    const RowArray n = n_sq.sqrt();
+
+    const RowArray two_atan_nbyw_by_n =
+        (n_sq < eps * eps)
+            .select(Scalar(2) / w - Scalar(2.0 / 3.0) * n_sq / w.cube(),
+                    (w.abs() < eps).select(
+                        (w > Scalar(0)).select(RowArray::Constant(size(), pi),
+                                               -pi) /
+                            n,
+                        Scalar(2) * (n / w).atan() / n));
+
+    res_mat.template middleRows<3>(3) =
+        (q_rel.template topRows<3>().rowwise() * two_atan_nbyw_by_n).matrix();
+
+    return res;
+  }
+
+ private:
+  using RowArray = Eigen::Array<Scalar, 1, Eigen::Dynamic>;
+  using Vec3Array = Eigen::Array<Scalar, 3, Eigen::Dynamic>;
+  using QuatArray = Eigen::Array<Scalar, 4, Eigen::Dynamic>;
+
+  /// @brief Column-wise quaternion product res = q1 * q2, where q1 is given
+  /// by its real and imaginary parts and q2 and res by rows of coefficients
+  /// (x, y, z, w). The result is normalized and may alias q2.
+  template <class Real, class Imag, class Quat, class Res>
+  static void quatMultiply(const Real& w1, const Imag& v1, const Quat& q2,
+                           Res&& res) {
+    const RowArray x2 = q2.row(0), y2 = q2.row(1), z2 = q2.row(2),
+                   w2 = q2.row(3);
+
+    const RowArray x = w1 * x2 + w2 * v1.row(0) + v1.row(1) * z2 -
+                       v1.row(2) * y2;
+    const RowArray y = w1 * y2 + w2 * v1.row(1) + v1.row(2) * x2 -
+                       v1.row(0) * z2;
+    const RowArray z = w1 * z2 + w2 * v1.row(2) + v1.row(0) * y2 -
+                       v1.row(1) * x2;
+    const RowArray w = w1 * w2 - v1.row(0) * x2 - v1.row(1) * y2 -
+                       v1.row(2) * z2;
+
+    const RowArray inv_norm = (x.square() + y.square() + z.square() +
+                               w.square())
+                                  .rsqrt();
+
+    res.row(0) = x * inv_norm;
+    res.row(1) = y * inv_norm;
+    res.row(2) = z * inv_norm;
+    res.row(3) = w * inv_norm;
+  }
+
+  std::vector<int64_t> t_ns_;
+  PoseMat poses_;
+  Vec3Mat vel_w_i_;
+  Vec3Mat bias_gyro_;
+  Vec3Mat bias_accel_;
+};
+
+}  // namespace basalt
@@ -40,18 +40,29 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <basalt/imu/imu_types.h>
 #include <basalt/utils/assert.h>
+#include <basalt/utils/instrumentation.h>
 #include <basalt/utils/sophus_utils.hpp>
 
+#include <type_traits>
+#include <vector>
+
 namespace basalt {
 
 /// @brief Integrated pseudo-measurement that combines several consecutive IMU
 /// measurements.
-template <class Scalar_>
+///
+/// IMU data, propagation of single samples and residuals use Scalar. The
+/// accumulated quantities (delta state, covariance and bias Jacobians) are
+/// stored in AccumScalar. With Scalar = float and AccumScalar = double the
+/// expensive per-sample computations run in single precision, while rounding
+/// errors do not build up over long integration intervals.
+template <class Scalar_, class AccumScalar_ = Scalar_>
 class IntegratedImuMeasurement {
  public:
   using Scalar = Scalar_;
+  using AccumScalar = AccumScalar_;
 
-  using Ptr = std::shared_ptr<IntegratedImuMeasurement<Scalar>>;
+  using Ptr = std::shared_ptr<IntegratedImuMeasurement>;
 
   using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
   using VecN = Eigen::Matrix<Scalar, POSE_VEL_SIZE, 1>;
@@ -61,6 +72,13 @@ class IntegratedImuMeasurement {
   using MatN6 = Eigen::Matrix<Scalar, POSE_VEL_SIZE, 6>;
   using SO3 = Sophus::SO3<Scalar>;
 
+  using AccumVec3 = Eigen::Matrix<AccumScalar, 3, 1>;
+  using AccumVecN = Eigen::Matrix<AccumScalar, POSE_VEL_SIZE, 1>;
+  using AccumMat3 = Eigen::Matrix<AccumScalar, 3, 3>;
+  using AccumMatNN = Eigen::Matrix<AccumScalar, POSE_VEL_SIZE, POSE_VEL_SIZE>;
+  using AccumMatN3 = Eigen::Matrix<AccumScalar, POSE_VEL_SIZE, 3>;
+  using AccumSO3 = Sophus::SO3<AccumScalar>;
+
   /// @brief Propagate current state given ImuData and optionally compute
   /// Jacobians.
   ///
@@ -86,18 +104,30 @@ class IntegratedImuMeasurement {
     int64_t dt_ns = data.t_ns - curr_state.t_ns;
     Scalar dt = dt_ns * Scalar(1e-9);
 
-    SO3 R_w_i_new_2 =
-        curr_state.T_w_i.so3() * SO3::exp(Scalar(0.5) * dt * data.gyro);
+    // The right Jacobians are only needed for d_next_d_gyro. In this case
+    // compute them together with the expmap.
+    SO3 exp_gyro_2, exp_gyro;
+    Mat3 Jr2 = Mat3::Zero(), Jr = Mat3::Zero();
+    if (d_next_d_gyro) {
+      exp_gyro_2 =
+          Sophus::expAndRightJacobianSO3(Scalar(0.5) * dt * data.gyro, Jr2);
+      exp_gyro = Sophus::expAndRightJacobianSO3(dt * data.gyro, Jr);
+    } else {
+      exp_gyro_2 = SO3::exp(Scalar(0.5) * dt * data.gyro);
+      exp_gyro = SO3::exp(dt * data.gyro);
+    }
+
+    SO3 R_w_i_new_2 = curr_state.T_w_i.so3() * exp_gyro_2;
     Mat3 RR_w_i_new_2 = R_w_i_new_2.matrix();
 
     Vec3 accel_world = RR_w_i_new_2 * data.accel;
 
     next_state.t_ns = data.t_ns;
-    next_state.T_w_i.so3() = curr_state.T_w_i.so3() * SO3::exp(dt * data.gyro);
+    next_state.T_w_i.so3() = curr_state.T_w_i.so3() * exp_gyro;
     next_state.vel_w_i = curr_state.vel_w_i + accel_world * dt;
     next_state.T_w_i.translation() = curr_state.T_w_i.translation() +
                                      curr_state.vel_w_i * dt +
-                                     0.5 * accel_world * dt * dt;
+                                     Scalar(0.5) * accel_world * dt * dt;
 
     if (d_next_d_curr) {
       d_next_d_curr->setIdentity();
@@ -117,12 +147,6 @@ class IntegratedImuMeasurement {
     if (d_next_d_gyro) {
       d_next_d_gyro->setZero();
 
-      Mat3 Jr;
-      Sophus::rightJacobianSO3(dt * data.gyro, Jr);
-
-      Mat3 Jr2;
-      Sophus::rightJacobianSO3(Scalar(0.5) * dt * data.gyro, Jr2);
-
       d_next_d_gyro->template block<3, 3>(3, 0) =
           next_state.T_w_i.so3().matrix() * Jr * dt;
       d_next_d_gyro->template block<3, 3>(6, 0) =
@@ -140,6 +164,8 @@ class IntegratedImuMeasurement {
     d_state_d_bg_.setZero();
     bias_gyro_lin_.setZero();
     bias_accel_lin_.setZero();
+    data_accel_cov_.setZero();
+    data_gyro_cov_.setZero();
   }
 
   /// @brief Constructor with start time and bias estimates.
@@ -151,6 +177,8 @@ class IntegratedImuMeasurement {
     cov_.setZero();
     d_state_d_ba_.setZero();
     d_state_d_bg_.setZero();
+    data_accel_cov_.setZero();
+    data_gyro_cov_.setZero();
   }
 
   /// @brief Integrate IMU data
@@ -160,27 +188,210 @@ class IntegratedImuMeasurement {
   /// @param[in] gyro_cov diagonal of gyroscope noise covariance matrix
   void integrate(const ImuData<Scalar>& data, const Vec3& accel_cov,
                  const Vec3& gyro_cov) {
-    ImuData<Scalar> data_corrected = data;
-    data_corrected.t_ns -= start_t_ns_;
-    data_corrected.accel -= bias_accel_lin_;
-    data_corrected.gyro -= bias_gyro_lin_;
+    BASALT_INSTRUMENT_SCOPE("basalt::IntegratedImuMeasurement::integrate");
+
+    if (keep_data_) storeData(&data, 1, accel_cov, gyro_cov);
+
+    if constexpr (!std::is_same_v<Scalar, AccumScalar>) {
+      // Mixed precision is only implemented in the block-sparse path.
+      integrateSamples(&data, 1, accel_cov, gyro_cov);
+    } else {
+      ImuData<Scalar> data_corrected = data;
+      data_corrected.t_ns -= start_t_ns_;
+      data_corrected.accel -= bias_accel_lin_;
+      data_corrected.gyro -= bias_gyro_lin_;
 
-    PoseVelState<Scalar> new_state;
+      PoseVelState<Scalar> new_state;
 
-    MatNN F;
-    MatN3 A;
-    MatN3 G;
+      MatNN F;
+      MatN3 A;
+      MatN3 G;
 
-    propagateState(delta_state_, data_corrected, new_state, &F, &A, &G);
+      propagateState(delta_state_, data_corrected, new_state, &F, &A, &G);
+
+      delta_state_ = new_state;
+      cov_ = F * cov_ * F.transpose() +
+             A * accel_cov.asDiagonal() * A.transpose() +
+             G * gyro_cov.asDiagonal() * G.transpose();
+      sqrt_cov_inv_computed_ = false;
+
+      d_state_d_ba_ = -A + F * d_state_d_ba_;
+      d_state_d_bg_ = -G + F * d_state_d_bg_;
+    }
+  }
+
+  /// @brief Integrate a contiguous sequence of IMU data
+  ///
+  /// Equivalent to calling @ref integrate for every sample (up to floating
+  /// point rounding), but exploits the block structure of the propagation
+  /// Jacobians F, A and G of @ref propagateState: most blocks are identity
+  /// or zero, so covariance and bias Jacobians are updated in place with 3x3
+  /// and 9x3 block products instead of dense 9x9 products.
+  ///
+  /// @param[in] data pointer to the first IMU sample
+  /// @param[in] num_data number of IMU samples
+  /// @param[in] accel_cov diagonal of accelerometer noise covariance matrix
+  /// @param[in] gyro_cov diagonal of gyroscope noise covariance matrix
+  void integrateBatch(const ImuData<Scalar>* data, size_t num_data,
+                      const Vec3& accel_cov, const Vec3& gyro_cov) {
+    BASALT_INSTRUMENT_SCOPE(
+        "basalt::IntegratedImuMeasurement::integrateBatch");
+    BASALT_INSTRUMENT_COUNT(
+        "basalt::IntegratedImuMeasurement::integrateBatch samples", num_data);
+
+    if (keep_data_) storeData(data, num_data, accel_cov, gyro_cov);
+    integrateSamples(data, num_data, accel_cov, gyro_cov);
+  }
 
-    delta_state_ = new_state;
-    cov_ = F * cov_ * F.transpose() +
-           A * accel_cov.asDiagonal() * A.transpose() +
-           G * gyro_cov.asDiagonal() * G.transpose();
+  /// @brief Integrate a sequence of IMU data. See overload above.
+  template <class Allocator>
+  void integrateBatch(const std::vector<ImuData<Scalar>, Allocator>& data,
+                      const Vec3& accel_cov, const Vec3& gyro_cov) {
+    integrateBatch(data.data(), data.size(), accel_cov, gyro_cov);
+  }
+
+  /// @brief Keep the integrated IMU data to allow re-integration when the
+  /// bias estimate changes, see @ref updateBiasLin.
+  ///
+  /// Has to be enabled before the first sample is integrated. All samples
+  /// have to be integrated with the same noise covariances.
+  ///
+  /// @param[in] keep_data if the IMU data should be stored, disabling it
+  /// releases stored data
+  void setKeepData(bool keep_data) {
+    BASALT_ASSERT_STREAM(!keep_data || delta_state_.t_ns == 0,
+                         "setKeepData has to be called before integration");
+    keep_data_ = keep_data;
+    if (!keep_data_) {
+      data_.clear();
+      data_.shrink_to_fit();
+    }
+  }
+
+  /// @brief Move the bias linearization point to a new estimate
+  ///
+  /// For small bias changes the first order correction through the bias
+  /// Jacobians in @ref residual is accurate and nothing is done. If the change
+  /// of one of the biases exceeds its threshold, the measurement is
+  /// re-integrated from the stored IMU data at the new biases (see
+  /// @ref setKeepData). Without stored data the first order correction is
+  /// instead folded into the delta state, which moves the linearization point
+  /// without changing the residual at the new biases.
+  ///
+  /// @param[in] bias_gyro_lin new estimate of the gyroscope bias
+  /// @param[in] bias_accel_lin new estimate of the accelerometer bias
+  /// @param[in] gyro_threshold maximal norm of the gyroscope bias change that
+  /// is handled by the first order correction
+  /// @param[in] accel_threshold maximal norm of the accelerometer bias change
+  /// that is handled by the first order correction
+  /// @return true if the measurement was re-integrated
+  bool updateBiasLin(const Vec3& bias_gyro_lin, const Vec3& bias_accel_lin,
+                     Scalar gyro_threshold, Scalar accel_threshold) {
+    const Vec3 bg_diff = bias_gyro_lin - bias_gyro_lin_;
+    const Vec3 ba_diff = bias_accel_lin - bias_accel_lin_;
+
+    if (bg_diff.norm() <= gyro_threshold && ba_diff.norm() <= accel_threshold) {
+      return false;
+    }
+
+    if (keep_data_) {
+      reintegrate(bias_gyro_lin, bias_accel_lin);
+      return true;
+    }
+
+    const AccumVecN state_diff =
+        d_state_d_bg_ * bg_diff.template cast<AccumScalar>() +
+        d_state_d_ba_ * ba_diff.template cast<AccumScalar>();
+
+    delta_state_.T_w_i.translation() += state_diff.template segment<3>(0);
+    delta_state_.T_w_i.so3() =
+        AccumSO3::exp(state_diff.template segment<3>(3)) *
+        delta_state_.T_w_i.so3();
+    delta_state_.vel_w_i += state_diff.template segment<3>(6);
+
+    bias_gyro_lin_ = bias_gyro_lin;
+    bias_accel_lin_ = bias_accel_lin;
+
+    return false;
+  }
+
+  /// @brief Re-integrate the stored IMU data with new bias estimates
+  ///
+  /// Requires @ref setKeepData to be enabled before integration.
+  ///
+  /// @param[in] bias_gyro_lin new estimate of the gyroscope bias
+  /// @param[in] bias_accel_lin new estimate of the accelerometer bias
+  void reintegrate(const Vec3& bias_gyro_lin, const Vec3& bias_accel_lin) {
+    BASALT_ASSERT(keep_data_);
+
+    bias_gyro_lin_ = bias_gyro_lin;
+    bias_accel_lin_ = bias_accel_lin;
+
+    delta_state_ = PoseVelState<AccumScalar>();
+    cov_.setZero();
+    d_state_d_ba_.setZero();
+    d_state_d_bg_.setZero();
+    sqrt_cov_inv_computed_ = false;
+
+    integrateSamples(data_.data(), data_.size(), data_accel_cov_,
+                     data_gyro_cov_);
+  }
+
+  /// @brief Append a measurement that starts where this one ends
+  ///
+  /// Combines delta states, covariances and bias Jacobians as if the IMU data
+  /// of both measurements had been integrated sequentially. The noise of both
+  /// measurements is independent, so segments can be integrated in parallel
+  /// and merged afterwards, e.g. as parallel prefix or when marginalizing
+  /// keyframes. Both measurements need the same bias linearization point.
+  ///
+  /// @param[in] other measurement that starts at get_start_t_ns() +
+  /// get_dt_ns()
+  void append(const IntegratedImuMeasurement& other) {
+    BASALT_ASSERT_STREAM(
+        other.start_t_ns_ == start_t_ns_ + delta_state_.t_ns,
+        "other.start_t_ns_ " << other.start_t_ns_ << " end of measurement "
+                             << start_t_ns_ + delta_state_.t_ns);
+    BASALT_ASSERT(other.bias_gyro_lin_ == bias_gyro_lin_ &&
+                  other.bias_accel_lin_ == bias_accel_lin_);
+
+    const PoseVelState<AccumScalar>& d2 = other.delta_state_;
+    const AccumScalar dt2 = d2.t_ns * AccumScalar(1e-9);
+
+    const AccumMat3 R1 = delta_state_.T_w_i.so3().matrix();
+    const AccumVec3 R1_p2 = R1 * d2.T_w_i.translation();
+    const AccumVec3 R1_v2 = R1 * d2.vel_w_i;
+
+    // Jacobian with respect to this delta state has the same structure as
+    // the one of a single propagation step.
+    applyStateJacobian(AccumSO3::hat(-R1_p2), AccumSO3::hat(-R1_v2), dt2);
+
+    // Jacobian with respect to the other delta state is diag(R1, R1, R1).
+    for (size_t i = 0; i < POSE_VEL_SIZE; i += 3) {
+      for (size_t j = 0; j < POSE_VEL_SIZE; j += 3) {
+        cov_.template block<3, 3>(i, j) +=
+            R1 * other.cov_.template block<3, 3>(i, j) * R1.transpose();
+      }
+      d_state_d_ba_.template block<3, 3>(i, 0) +=
+          R1 * other.d_state_d_ba_.template block<3, 3>(i, 0);
+      d_state_d_bg_.template block<3, 3>(i, 0) +=
+          R1 * other.d_state_d_bg_.template block<3, 3>(i, 0);
+    }
     sqrt_cov_inv_computed_ = false;
 
-    d_state_d_ba_ = -A + F * d_state_d_ba_;
-    d_state_d_bg_ = -G + F * d_state_d_bg_;
+    delta_state_.t_ns += d2.t_ns;
+    delta_state_.T_w_i.translation() = delta_state_.T_w_i.translation() +
+                                       delta_state_.vel_w_i * dt2 + R1_p2;
+    delta_state_.T_w_i.so3() = delta_state_.T_w_i.so3() * d2.T_w_i.so3();
+    delta_state_.vel_w_i = delta_state_.vel_w_i + R1_v2;
+
+    // Stored data is only complete if both measurements kept it.
+    if (keep_data_ && other.keep_data_ && !other.data_.empty()) {
+      storeData(other.data_.data(), other.data_.size(), other.data_accel_cov_,
+                other.data_gyro_cov_);
+    } else if (keep_data_ && !other.keep_data_) {
+      setKeepData(false);
+    }
   }
 
   /// @brief Predict state given this pseudo-measurement
@@ -190,15 +401,16 @@ class IntegratedImuMeasurement {
   /// @param[out] state1 predicted state
   void predictState(const PoseVelState<Scalar>& state0, const Vec3& g,
                     PoseVelState<Scalar>& state1) const {
-    Scalar dt = delta_state_.t_ns * Scalar(1e-9);
+    const auto& delta_state = deltaStateScalar();
+    Scalar dt = delta_state.t_ns * Scalar(1e-9);
 
-    state1.T_w_i.so3() = state0.T_w_i.so3() * delta_state_.T_w_i.so3();
+    state1.T_w_i.so3() = state0.T_w_i.so3() * delta_state.T_w_i.so3();
     state1.vel_w_i =
-        state0.vel_w_i + g * dt + state0.T_w_i.so3() * delta_state_.vel_w_i;
+        state0.vel_w_i + g * dt + state0.T_w_i.so3() * delta_state.vel_w_i;
     state1.T_w_i.translation() =
         state0.T_w_i.translation() + state0.vel_w_i * dt +
         Scalar(0.5) * g * dt * dt +
-        state0.T_w_i.so3() * delta_state_.T_w_i.translation();
+        state0.T_w_i.so3() * delta_state.T_w_i.translation();
   }
 
   /// @brief Compute residual between two states given this pseudo-measurement
@@ -223,13 +435,17 @@ class IntegratedImuMeasurement {
                 const Vec3& curr_ba, MatNN* d_res_d_state0 = nullptr,
                 MatNN* d_res_d_state1 = nullptr, MatN3* d_res_d_bg = nullptr,
                 MatN3* d_res_d_ba = nullptr) const {
-    Scalar dt = delta_state_.t_ns * Scalar(1e-9);
+    const auto& delta_state = deltaStateScalar();
+    const auto& d_state_d_ba = d_state_d_ba_.template cast<Scalar>();
+    const auto& d_state_d_bg = d_state_d_bg_.template cast<Scalar>();
+
+    Scalar dt = delta_state.t_ns * Scalar(1e-9);
     VecN res;
 
     VecN bg_diff;
     VecN ba_diff;
-    bg_diff = d_state_d_bg_ * (curr_bg - bias_gyro_lin_);
-    ba_diff = d_state_d_ba_ * (curr_ba - bias_accel_lin_);
+    bg_diff = d_state_d_bg * (curr_bg - bias_gyro_lin_);
+    ba_diff = d_state_d_ba * (curr_ba - bias_accel_lin_);
 
     BASALT_ASSERT(ba_diff.template segment<3>(3).isApproxToConstant(0));
 
@@ -239,22 +455,27 @@ class IntegratedImuMeasurement {
                   state0.vel_w_i * dt - Scalar(0.5) * g * dt * dt);
 
     res.template segment<3>(0) =
-        tmp - (delta_state_.T_w_i.translation() +
+        tmp - (delta_state.T_w_i.translation() +
                bg_diff.template segment<3>(0) + ba_diff.template segment<3>(0));
-    res.template segment<3>(3) =
-        (SO3::exp(bg_diff.template segment<3>(3)) * delta_state_.T_w_i.so3() *
-         state1.T_w_i.so3().inverse() * state0.T_w_i.so3())
-            .log();
+    const SO3 R_res =
+        SO3::exp(bg_diff.template segment<3>(3)) * delta_state.T_w_i.so3() *
+        state1.T_w_i.so3().inverse() * state0.T_w_i.so3();
+
+    // The right inverse Jacobian is only needed for the state Jacobians. In
+    // this case compute it together with the logmap.
+    Mat3 J = Mat3::Zero();
+    if (d_res_d_state0 || d_res_d_state1) {
+      Sophus::logAndRightJacobianInvSO3(R_res, res.template segment<3>(3), J);
+    } else {
+      res.template segment<3>(3) = R_res.log();
+    }
 
     Vec3 tmp2 = R0_inv * (state1.vel_w_i - state0.vel_w_i - g * dt);
     res.template segment<3>(6) =
-        tmp2 - (delta_state_.vel_w_i + bg_diff.template segment<3>(6) +
+        tmp2 - (delta_state.vel_w_i + bg_diff.template segment<3>(6) +
                 ba_diff.template segment<3>(6));
 
     if (d_res_d_state0 || d_res_d_state1) {
-      Mat3 J;
-      Sophus::rightJacobianInvSO3(res.template segment<3>(3), J);
-
       if (d_res_d_state0) {
         d_res_d_state0->setZero();
         d_res_d_state0->template block<3, 3>(0, 0) = -R0_inv;
@@ -276,17 +497,17 @@ class IntegratedImuMeasurement {
     }
 
     if (d_res_d_ba) {
-      *d_res_d_ba = -d_state_d_ba_;
+      *d_res_d_ba = -d_state_d_ba;
     }
 
     if (d_res_d_bg) {
       d_res_d_bg->setZero();
-      *d_res_d_bg = -d_state_d_bg_;
+      *d_res_d_bg = -d_state_d_bg;
 
       Mat3 J;
       Sophus::leftJacobianInvSO3(res.template segment<3>(3), J);
       d_res_d_bg->template block<3, 3>(3, 0) =
-          J * d_state_d_bg_.template block<3, 3>(3, 0);
+          J * d_state_d_bg.template block<3, 3>(3, 0);
     }
 
     return res;
@@ -319,53 +540,234 @@ class IntegratedImuMeasurement {
   }
 
   /// @brief Measurement covariance matrix
-  const MatNN& get_cov() const { return cov_; }
+  const AccumMatNN& get_cov() const { return cov_; }
 
   // Just for testing...
   /// @brief Delta state
-  const PoseVelState<Scalar>& getDeltaState() const { return delta_state_; }
+  const PoseVelState<AccumScalar>& getDeltaState() const {
+    return delta_state_;
+  }
 
   /// @brief Jacobian of delta state with respect to accelerometer bias
-  const MatN3& get_d_state_d_ba() const { return d_state_d_ba_; }
+  const AccumMatN3& get_d_state_d_ba() const { return d_state_d_ba_; }
 
   /// @brief Jacobian of delta state with respect to gyroscope bias
-  const MatN3& get_d_state_d_bg() const { return d_state_d_bg_; }
+  const AccumMatN3& get_d_state_d_bg() const { return d_state_d_bg_; }
+
+  /// @brief Gyroscope bias used as linearization point
+  const Vec3& get_bias_gyro_lin() const { return bias_gyro_lin_; }
+
+  /// @brief Accelerometer bias used as linearization point
+  const Vec3& get_bias_accel_lin() const { return bias_accel_lin_; }
 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
  private:
+  /// @brief Delta state in Scalar precision, reference to the stored state if
+  /// no conversion is needed.
+  decltype(auto) deltaStateScalar() const {
+    if constexpr (std::is_same_v<Scalar, AccumScalar>) {
+      return (delta_state_);
+    } else {
+      return delta_state_.template cast<Scalar>();
+    }
+  }
+
+  /// @brief Block-sparse integration of IMU data, see @ref integrateBatch
+  void integrateSamples(const ImuData<Scalar>* data, size_t num_data,
+                        const Vec3& accel_cov, const Vec3& gyro_cov) {
+    for (size_t i = 0; i < num_data; i++) {
+      const int64_t t_ns = data[i].t_ns - start_t_ns_;
+      const Vec3 accel = data[i].accel - bias_accel_lin_;
+      const Vec3 gyro = data[i].gyro - bias_gyro_lin_;
+
+      BASALT_ASSERT_STREAM(t_ns > delta_state_.t_ns,
+                           "t_ns " << t_ns << " delta_state_.t_ns "
+                                   << delta_state_.t_ns);
+
+      const int64_t dt_ns = t_ns - delta_state_.t_ns;
+      const Scalar dt = dt_ns * Scalar(1e-9);
+      const AccumScalar dt_accum = dt_ns * AccumScalar(1e-9);
+
+      // State propagation, same as in propagateState. The increments are
+      // computed in Scalar and accumulated in AccumScalar.
+      // The right Jacobians of G = d_next_d_gyro are computed together with
+      // the expmap.
+      Mat3 Jr2;
+      const SO3 exp_gyro_2 =
+          Sophus::expAndRightJacobianSO3(Scalar(0.5) * dt * gyro, Jr2);
+      Mat3 Jr;
+      const SO3 exp_gyro = Sophus::expAndRightJacobianSO3(dt * gyro, Jr);
+
+      const SO3 R_w_i_new_2 =
+          delta_state_.T_w_i.so3().template cast<Scalar>() * exp_gyro_2;
+      const Mat3 RR_w_i_new_2 = R_w_i_new_2.matrix();
+
+      const Vec3 accel_world = RR_w_i_new_2 * accel;
+      const AccumVec3 accel_world_accum =
+          accel_world.template cast<AccumScalar>();
+
+      delta_state_.t_ns = t_ns;
+      delta_state_.T_w_i.translation() =
+          delta_state_.T_w_i.translation() + delta_state_.vel_w_i * dt_accum +
+          AccumScalar(0.5) * accel_world_accum * dt_accum * dt_accum;
+      delta_state_.T_w_i.so3() =
+          delta_state_.T_w_i.so3() * exp_gyro.template cast<AccumScalar>();
+      delta_state_.vel_w_i =
+          delta_state_.vel_w_i + accel_world_accum * dt_accum;
+
+      // Non-trivial blocks of F = d_next_d_curr. The remaining blocks are
+      // identity, dt * identity (position / velocity) and zero.
+      const Mat3 F_vr = SO3::hat(-accel_world * dt);
+      const Mat3 F_pr = F_vr * dt * Scalar(0.5);
+
+      // Non-zero blocks of A = d_next_d_accel.
+      const Mat3 A_p = Scalar(0.5) * RR_w_i_new_2 * dt * dt;
+      const Mat3 A_v = RR_w_i_new_2 * dt;
+
+      // Non-zero blocks of G = d_next_d_gyro.
+      const Mat3 G_r =
+          delta_state_.T_w_i.so3().matrix().template cast<Scalar>() * Jr * dt;
+      const Mat3 G_v = F_vr * RR_w_i_new_2 * Jr2 * Scalar(0.5) * dt;
+      const Mat3 G_p = Scalar(0.5) * dt * G_v;
+
+      applyStateJacobian(F_pr.template cast<AccumScalar>(),
+                         F_vr.template cast<AccumScalar>(), dt_accum);
+
+      // cov_ += A * accel_cov * A^T + G * gyro_cov * G^T
+      const Mat3 A_p_cov = A_p * accel_cov.asDiagonal();
+      const Mat3 A_v_cov = A_v * accel_cov.asDiagonal();
+      const Mat3 G_p_cov = G_p * gyro_cov.asDiagonal();
+      const Mat3 G_r_cov = G_r * gyro_cov.asDiagonal();
+      const Mat3 G_v_cov = G_v * gyro_cov.asDiagonal();
+
+      const Mat3 cov_pp =
+          A_p_cov * A_p.transpose() + G_p_cov * G_p.transpose();
+      const Mat3 cov_pr = G_p_cov * G_r.transpose();
+      const Mat3 cov_pv =
+          A_p_cov * A_v.transpose() + G_p_cov * G_v.transpose();
+      const Mat3 cov_rr = G_r_cov * G_r.transpose();
+      const Mat3 cov_rv = G_r_cov * G_v.transpose();
+      const Mat3 cov_vv =
+          A_v_cov * A_v.transpose() + G_v_cov * G_v.transpose();
+
+      cov_.template block<3, 3>(0, 0) += cov_pp.template cast<AccumScalar>();
+      cov_.template block<3, 3>(0, 3) += cov_pr.template cast<AccumScalar>();
+      cov_.template block<3, 3>(0, 6) += cov_pv.template cast<AccumScalar>();
+      cov_.template block<3, 3>(3, 0) +=
+          cov_pr.transpose().template cast<AccumScalar>();
+      cov_.template block<3, 3>(3, 3) += cov_rr.template cast<AccumScalar>();
+      cov_.template block<3, 3>(3, 6) += cov_rv.template cast<AccumScalar>();
+      cov_.template block<3, 3>(6, 0) +=
+          cov_pv.transpose().template cast<AccumScalar>();
+      cov_.template block<3, 3>(6, 3) +=
+          cov_rv.transpose().template cast<AccumScalar>();
+      cov_.template block<3, 3>(6, 6) += cov_vv.template cast<AccumScalar>();
+
+      // d_state_d_ba_ -= A, d_state_d_bg_ -= G
+      d_state_d_ba_.template block<3, 3>(0, 0) -=
+          A_p.template cast<AccumScalar>();
+      d_state_d_ba_.template block<3, 3>(6, 0) -=
+          A_v.template cast<AccumScalar>();
+
+      d_state_d_bg_.template block<3, 3>(0, 0) -=
+          G_p.template cast<AccumScalar>();
+      d_state_d_bg_.template block<3, 3>(3, 0) -=
+          G_r.template cast<AccumScalar>();
+      d_state_d_bg_.template block<3, 3>(6, 0) -=
+          G_v.template cast<AccumScalar>();
+    }
+
+    if (num_data > 0) sqrt_cov_inv_computed_ = false;
+  }
+
+  /// @brief In-place update of covariance and bias Jacobians with the
+  /// Jacobian of a propagation step
+  ///
+  /// Computes cov_ = F * cov_ * F^T, d_state_d_ba_ = F * d_state_d_ba_ and
+  /// d_state_d_bg_ = F * d_state_d_bg_ for
+  /// F = [I, F_pr, dt * I; 0, I, 0; 0, F_vr, I] without forming F.
+  void applyStateJacobian(const AccumMat3& F_pr, const AccumMat3& F_vr,
+                          AccumScalar dt) {
+    // Update rows (F * cov_) and then columns (* F^T). Position has to be
+    // updated before velocity, since it depends on the old velocity block.
+    cov_.template block<3, POSE_VEL_SIZE>(0, 0) +=
+        F_pr * cov_.template block<3, POSE_VEL_SIZE>(3, 0) +
+        dt * cov_.template block<3, POSE_VEL_SIZE>(6, 0);
+    cov_.template block<3, POSE_VEL_SIZE>(6, 0) +=
+        F_vr * cov_.template block<3, POSE_VEL_SIZE>(3, 0);
+
+    cov_.template block<POSE_VEL_SIZE, 3>(0, 0) +=
+        cov_.template block<POSE_VEL_SIZE, 3>(0, 3) * F_pr.transpose() +
+        dt * cov_.template block<POSE_VEL_SIZE, 3>(0, 6);
+    cov_.template block<POSE_VEL_SIZE, 3>(0, 6) +=
+        cov_.template block<POSE_VEL_SIZE, 3>(0, 3) * F_vr.transpose();
+
+    d_state_d_ba_.template block<3, 3>(0, 0) +=
+        F_pr * d_state_d_ba_.template block<3, 3>(3, 0) +
+        dt * d_state_d_ba_.template block<3, 3>(6, 0);
+    d_state_d_ba_.template block<3, 3>(6, 0) +=
+        F_vr * d_state_d_ba_.template block<3, 3>(3, 0);
+
+    d_state_d_bg_.template block<3, 3>(0, 0) +=
+        F_pr * d_state_d_bg_.template block<3, 3>(3, 0) +
+        dt * d_state_d_bg_.template block<3, 3>(6, 0);
+    d_state_d_bg_.template block<3, 3>(6, 0) +=
+        F_vr * d_state_d_bg_.template block<3, 3>(3, 0);
+  }
+
+  /// @brief Append IMU data for later re-integration
+  void storeData(const ImuData<Scalar>* data, size_t num_data,
+                 const Vec3& accel_cov, const Vec3& gyro_cov) {
+    if (data_.empty()) {
+      data_accel_cov_ = accel_cov;
+      data_gyro_cov_ = gyro_cov;
+    } else {
+      BASALT_ASSERT_STREAM(
+          accel_cov == data_accel_cov_ && gyro_cov == data_gyro_cov_,
+          "stored IMU data has to be integrated with the same covariances");
+    }
+    data_.insert(data_.end(), data, data + num_data);
+  }
+
   /// @brief Helper function to compute square root of the inverse covariance
   void compute_sqrt_cov_inv() const {
-    sqrt_cov_inv_.setIdentity();
+    AccumMatNN sqrt_cov_inv;
+    sqrt_cov_inv.setIdentity();
     auto ldlt = cov_.ldlt();
 
-    sqrt_cov_inv_ = ldlt.transpositionsP() * sqrt_cov_inv_;
-    ldlt.matrixL().solveInPlace(sqrt_cov_inv_);
+    sqrt_cov_inv = ldlt.transpositionsP() * sqrt_cov_inv;
+    ldlt.matrixL().solveInPlace(sqrt_cov_inv);
 
-    VecN D_inv_sqrt;
+    AccumVecN D_inv_sqrt;
     for (size_t i = 0; i < POSE_VEL_SIZE; i++) {
-      if (ldlt.vectorD()[i] < std::numeric_limits<Scalar>::min()) {
+      if (ldlt.vectorD()[i] < std::numeric_limits<AccumScalar>::min()) {
         D_inv_sqrt[i] = 0;
       } else {
-        D_inv_sqrt[i] = Scalar(1.0) / sqrt(ldlt.vectorD()[i]);
+        D_inv_sqrt[i] = AccumScalar(1.0) / sqrt(ldlt.vectorD()[i]);
       }
     }
-    sqrt_cov_inv_ = D_inv_sqrt.asDiagonal() * sqrt_cov_inv_;
+    sqrt_cov_inv_ =
+        (D_inv_sqrt.asDiagonal() * sqrt_cov_inv).template cast<Scalar>();
   }
 
   int64_t start_t_ns_{0};  ///< Integration start time in nanoseconds
 
-  PoseVelState<Scalar> delta_state_;  ///< Delta state
+  PoseVelState<AccumScalar> delta_state_;  ///< Delta state
 
-  MatNN cov_;  ///< Measurement covariance
+  AccumMatNN cov_;  ///< Measurement covariance
   mutable MatNN
       sqrt_cov_inv_;  ///< Cached square root inverse of measurement covariance
   mutable bool sqrt_cov_inv_computed_{
       false};  ///< If the cached square root inverse
                ///< covariance is computed
 
-  MatN3 d_state_d_ba_, d_state_d_bg_;
+  AccumMatN3 d_state_d_ba_, d_state_d_bg_;
 
   Vec3 bias_gyro_lin_, bias_accel_lin_;
+
+  bool keep_data_{false};  ///< If integrated IMU data is stored
+  std::vector<ImuData<Scalar>> data_;  ///< Stored IMU data
+  Vec3 data_accel_cov_, data_gyro_cov_;  ///< Noise of the stored IMU data
 };
 
 }  // namespace basalt
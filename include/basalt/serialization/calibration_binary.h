@@ -0,0 +1,612 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+@file
+@brief Flat binary calibration format that can be used without parsing
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <basalt/calibration/calibration.hpp>
+
+namespace basalt {
+
+/// @brief Header of the flat binary calibration format
+///
+/// The binary calibration consists of fixed-size records that are stored back
+/// to back: CalibBinaryHeader, CalibBinaryImu, num_cameras times
+/// CalibBinaryCamera, num_vignettes times CalibBinaryVignette and finally
+/// num_vignette_knots doubles with the knots of all vignette splines. Values
+/// are stored as double (int64_t for times) in native byte order, independent
+/// of the Scalar type of the \ref Calibration. All records have a size that is
+/// a multiple of 8 bytes, so an 8-byte aligned buffer (e.g. a memory-mapped
+/// file) can be used in place with \ref CalibBinaryView.
+struct CalibBinaryHeader {
+  static constexpr char MAGIC[8] = {'B', 'S', 'L', 'T', 'C', 'A', 'L', 'B'};
+  static constexpr uint32_t VERSION = 2;
+  static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  char magic[8];                ///< MAGIC
+  uint32_t version;             ///< VERSION
+  uint32_t byte_order;          ///< BYTE_ORDER_MARK in native byte order
+  uint32_t num_cameras;         ///< number of CalibBinaryCamera records
+  uint32_t num_vignettes;       ///< number of CalibBinaryVignette records
+  uint64_t num_vignette_knots;  ///< total number of vignette knots
+  uint64_t size;                ///< total size in bytes
+};
+
+/// @brief IMU part of the binary calibration
+struct CalibBinaryImu {
+  double calib_accel_bias[9];  ///< CalibAccelBias::getParam()
+  double calib_gyro_bias[12];  ///< CalibGyroBias::getParam()
+  double imu_update_rate;
+  double gyro_noise_std[3];
+  double accel_noise_std[3];
+  double gyro_bias_std[3];
+  double accel_bias_std[3];
+  int64_t cam_time_offset_ns;
+};
+
+/// @brief Per-camera part of the binary calibration
+struct CalibBinaryCamera {
+  static constexpr int MAX_INTRINSICS = 16;
+
+  /// T_i_c as unit quaternion [x, y, z, w] followed by the translation
+  double T_i_c[7];
+
+  /// camera model parameters (GenericCamera::getParam()); for
+  /// PinholeRadtan8Camera followed by rpmax
+  double intrinsics[MAX_INTRINSICS];
+
+  uint32_t camera_type;     ///< CalibBinaryCameraType of the model
+  uint32_t num_intrinsics;  ///< number of used entries of intrinsics
+  int32_t resolution[2];
+};
+
+/// @brief Per-camera vignette spline of the binary calibration
+struct CalibBinaryVignette {
+  int64_t start_t_ns;
+  int64_t dt_ns;
+  uint64_t knot_offset;  ///< index of the first knot in the knot array
+  uint64_t num_knots;
+};
+
+static_assert(std::is_trivially_copyable_v<CalibBinaryHeader> &&
+              std::is_trivially_copyable_v<CalibBinaryImu> &&
+              std::is_trivially_copyable_v<CalibBinaryCamera> &&
+              std::is_trivially_copyable_v<CalibBinaryVignette>);
+static_assert(sizeof(CalibBinaryHeader) == 40);
+static_assert(sizeof(CalibBinaryImu) == 280);
+static_assert(sizeof(CalibBinaryCamera) == 200);
+static_assert(sizeof(CalibBinaryVignette) == 32);
+
+/// @brief Size in bytes of a binary calibration with the given number of
+/// records
+inline size_t calibBinarySize(size_t num_cameras, size_t num_vignettes,
+                              size_t num_vignette_knots) {
+  return sizeof(CalibBinaryHeader) + sizeof(CalibBinaryImu) +
+         num_cameras * sizeof(CalibBinaryCamera) +
+         num_vignettes * sizeof(CalibBinaryVignette) +
+         num_vignette_knots * sizeof(double);
+}
+
+/// @brief Camera model ids of the binary calibration
+///
+/// The ids are part of the file format and do not depend on the order of the
+/// models in GenericCamera::variant. Existing values must never change or be
+/// reused; a new model gets a new id and a specialization of
+/// \ref CalibBinaryCameraTypeOf.
+enum class CalibBinaryCameraType : uint32_t {
+  EUCM = 1,             ///< ExtendedUnifiedCamera
+  DS = 2,               ///< DoubleSphereCamera
+  KB4 = 3,              ///< KannalaBrandtCamera4
+  UCM = 4,              ///< UnifiedCamera
+  PINHOLE = 5,          ///< PinholeCamera
+  PINHOLE_RADTAN8 = 6,  ///< PinholeRadtan8Camera
+};
+
+/// @brief Id of a camera model in the binary calibration
+///
+/// Only defined for the models of GenericCamera::variant, so adding a model
+/// without an id fails to compile.
+template <class CamT>
+struct CalibBinaryCameraTypeOf;
+
+template <class Scalar>
+struct CalibBinaryCameraTypeOf<ExtendedUnifiedCamera<Scalar>> {
+  static constexpr CalibBinaryCameraType value = CalibBinaryCameraType::EUCM;
+};
+
+template <class Scalar>
+struct CalibBinaryCameraTypeOf<DoubleSphereCamera<Scalar>> {
+  static constexpr CalibBinaryCameraType value = CalibBinaryCameraType::DS;
+};
+
+template <class Scalar>
+struct CalibBinaryCameraTypeOf<KannalaBrandtCamera4<Scalar>> {
+  static constexpr CalibBinaryCameraType value = CalibBinaryCameraType::KB4;
+};
+
+template <class Scalar>
+struct CalibBinaryCameraTypeOf<UnifiedCamera<Scalar>> {
+  static constexpr CalibBinaryCameraType value = CalibBinaryCameraType::UCM;
+};
+
+template <class Scalar>
+struct CalibBinaryCameraTypeOf<PinholeCamera<Scalar>> {
+  static constexpr CalibBinaryCameraType value =
+      CalibBinaryCameraType::PINHOLE;
+};
+
+template <class Scalar>
+struct CalibBinaryCameraTypeOf<PinholeRadtan8Camera<Scalar>> {
+  static constexpr CalibBinaryCameraType value =
+      CalibBinaryCameraType::PINHOLE_RADTAN8;
+};
+
+/// @brief Id of the model of a camera in the binary calibration
+template <class Scalar>
+inline CalibBinaryCameraType calibBinaryCameraType(
+    const GenericCamera<Scalar>& cam) {
+  CalibBinaryCameraType res{};
+  std::visit(
+      [&](const auto& model) {
+        res = CalibBinaryCameraTypeOf<std::decay_t<decltype(model)>>::value;
+      },
+      cam.variant);
+  return res;
+}
+
+/// @brief Recursion of \ref calibBinaryCameraFromType over the models of
+/// GenericCamera::variant with index I and below
+template <int I, class Scalar>
+inline bool calibBinaryCameraFromTypeImpl(uint32_t camera_type,
+                                          GenericCamera<Scalar>& cam) {
+  if constexpr (I >= 0) {
+    using VariantT = decltype(GenericCamera<Scalar>::variant);
+    using CamT = std::variant_alternative_t<I, VariantT>;
+
+    if (uint32_t(CalibBinaryCameraTypeOf<CamT>::value) == camera_type) {
+      cam.variant.template emplace<I>();
+      return true;
+    }
+    return calibBinaryCameraFromTypeImpl<I - 1>(camera_type, cam);
+  } else {
+    UNUSED(camera_type);
+    UNUSED(cam);
+    return false;
+  }
+}
+
+/// @brief Set a camera to the default-constructed model with the given id
+///
+/// @param[in] camera_type id of the model, see \ref CalibBinaryCameraType
+/// @param[out] cam camera, unchanged if camera_type is not a valid id
+/// @return if camera_type is a valid id
+template <class Scalar>
+inline bool calibBinaryCameraFromType(uint32_t camera_type,
+                                      GenericCamera<Scalar>& cam) {
+  using VariantT = decltype(GenericCamera<Scalar>::variant);
+  constexpr int VARIANT_SIZE = std::variant_size_v<VariantT>;
+  return calibBinaryCameraFromTypeImpl<VARIANT_SIZE - 1>(camera_type, cam);
+}
+
+/// @brief Number of entries of CalibBinaryCamera::intrinsics used by a camera
+/// model, or -1 if camera_type is not a valid model id.
+inline int calibBinaryNumIntrinsics(uint32_t camera_type) {
+  GenericCamera<double> cam;
+  if (!calibBinaryCameraFromType(camera_type, cam)) return -1;
+
+  int res = -1;
+  std::visit(
+      [&](const auto& cam) {
+        using CamT = std::decay_t<decltype(cam)>;
+        res = CamT::N;
+        if constexpr (std::is_same_v<CamT, PinholeRadtan8Camera<double>>) {
+          res += 1;
+        }
+      },
+      cam.variant);
+  return res;
+}
+
+/// @brief Read-only view of a binary calibration stored in a buffer
+///
+/// The view does not copy the buffer, which has to outlive the view. Records
+/// are accessed in place, so a memory-mapped calibration file can be used
+/// directly without any parsing.
+class CalibBinaryView {
+ public:
+  /// @brief Point the view to a buffer and validate it
+  ///
+  /// Checks magic, version, byte order, alignment, sizes, camera model
+  /// ids and vignette knot ranges. Record counts are checked against the
+  /// buffer size before any size is computed from them. The view is only
+  /// valid if this returns true.
+  /// @param[in] data pointer to the start of the binary calibration, has to
+  /// be 8-byte aligned
+  /// @param[in] size size of the buffer in bytes
+  /// @return if the buffer holds a valid binary calibration
+  inline bool init(const void* data, size_t size) {
+    header_ = nullptr;
+
+    if (data == nullptr || reinterpret_cast<uintptr_t>(data) % 8 != 0 ||
+        size < calibBinarySize(0, 0, 0)) {
+      return false;
+    }
+
+    const uint8_t* ptr = static_cast<const uint8_t*>(data);
+    const auto* header = reinterpret_cast<const CalibBinaryHeader*>(ptr);
+
+    // Bound every count by the buffer size first, so the products in
+    // calibBinarySize cannot overflow for corrupted or hostile headers.
+    if (std::memcmp(header->magic, CalibBinaryHeader::MAGIC, 8) != 0 ||
+        header->version != CalibBinaryHeader::VERSION ||
+        header->byte_order != CalibBinaryHeader::BYTE_ORDER_MARK ||
+        header->size != size ||
+        header->num_cameras > size / sizeof(CalibBinaryCamera) ||
+        header->num_vignettes > size / sizeof(CalibBinaryVignette) ||
+        header->num_vignette_knots > size / sizeof(double) ||
+        calibBinarySize(header->num_cameras, header->num_vignettes,
+                        header->num_vignette_knots) != size) {
+      return false;
+    }
+
+    ptr += sizeof(CalibBinaryHeader);
+    imu_ = reinterpret_cast<const CalibBinaryImu*>(ptr);
+    ptr += sizeof(CalibBinaryImu);
+    cameras_ = reinterpret_cast<const CalibBinaryCamera*>(ptr);
+    ptr += header->num_cameras * sizeof(CalibBinaryCamera);
+    vignettes_ = reinterpret_cast<const CalibBinaryVignette*>(ptr);
+    ptr += header->num_vignettes * sizeof(CalibBinaryVignette);
+    knots_ = reinterpret_cast<const double*>(ptr);
+
+    for (size_t i = 0; i < header->num_cameras; i++) {
+      const CalibBinaryCamera& cam = cameras_[i];
+      if (calibBinaryNumIntrinsics(cam.camera_type) !=
+          int(cam.num_intrinsics)) {
+        return false;
+      }
+    }
+
+    for (size_t i = 0; i < header->num_vignettes; i++) {
+      const CalibBinaryVignette& v = vignettes_[i];
+      if (v.dt_ns <= 0 || v.knot_offset > header->num_vignette_knots ||
+          v.num_knots > header->num_vignette_knots - v.knot_offset) {
+        return false;
+      }
+    }
+
+    header_ = header;
+    return true;
+  }
+
+  /// @brief If the last call to @ref init succeeded
+  inline bool valid() const { return header_ != nullptr; }
+
+  /// @brief Header record
+  inline const CalibBinaryHeader& header() const {
+    BASALT_ASSERT(valid());
+    return *header_;
+  }
+
+  /// @brief IMU record
+  inline const CalibBinaryImu& imu() const {
+    BASALT_ASSERT(valid());
+    return *imu_;
+  }
+
+  /// @brief Number of cameras
+  inline size_t numCameras() const { return header().num_cameras; }
+
+  /// @brief Record of camera i
+  inline const CalibBinaryCamera& camera(size_t i) const {
+    BASALT_ASSERT(i < numCameras());
+    return cameras_[i];
+  }
+
+  /// @brief Number of vignette splines
+  inline size_t numVignettes() const { return header().num_vignettes; }
+
+  /// @brief Vignette record of camera i
+  inline const CalibBinaryVignette& vignette(size_t i) const {
+    BASALT_ASSERT(i < numVignettes());
+    return vignettes_[i];
+  }
+
+  /// @brief Pointer to the knots of the vignette spline of camera i
+  inline const double* vignetteKnots(size_t i) const {
+    return knots_ + vignette(i).knot_offset;
+  }
+
+  /// @brief Transformation from camera i to IMU
+  template <class Scalar>
+  inline Sophus::SE3<Scalar> T_i_c(size_t i) const {
+    const double* T = camera(i).T_i_c;
+    Eigen::Quaterniond q(T[3], T[0], T[1], T[2]);
+    Eigen::Vector3d t(T[4], T[5], T[6]);
+    return Sophus::SE3d(q, t).template cast<Scalar>();
+  }
+
+  /// @brief Camera model of camera i
+  ///
+  /// The model is selected by its id, so no name matching is needed.
+  template <class Scalar>
+  inline GenericCamera<Scalar> intrinsics(size_t i) const {
+    const CalibBinaryCamera& rec = camera(i);
+
+    GenericCamera<Scalar> res;
+    const bool valid_type = calibBinaryCameraFromType(rec.camera_type, res);
+    BASALT_ASSERT(valid_type);
+    UNUSED(valid_type);
+    std::visit(
+        [&](auto& cam) {
+          using CamT = std::decay_t<decltype(cam)>;
+          using VecN = typename CamT::VecN;
+
+          VecN p = Eigen::Map<const Eigen::Matrix<double, CamT::N, 1>>(
+                       rec.intrinsics)
+                       .template cast<Scalar>();
+
+          if constexpr (std::is_same_v<CamT, PinholeRadtan8Camera<Scalar>>) {
+            cam = CamT(p, Scalar(rec.intrinsics[CamT::N]));
+          } else {
+            cam = CamT(p);
+          }
+        },
+        res.variant);
+    return res;
+  }
+
+  /// @brief Vignette spline of camera i
+  template <class Scalar>
+  inline RdSpline<1, 4, Scalar> vignetteSpline(size_t i) const {
+    const CalibBinaryVignette& v = vignette(i);
+    const double* knots = vignetteKnots(i);
+
+    RdSpline<1, 4, Scalar> res(v.dt_ns, v.start_t_ns);
+    for (size_t j = 0; j < v.num_knots; j++) {
+      res.knotsPushBack(Eigen::Matrix<Scalar, 1, 1>(Scalar(knots[j])));
+    }
+    return res;
+  }
+
+  /// @brief Copy the binary calibration to a \ref Calibration
+  template <class Scalar>
+  inline void toCalibration(Calibration<Scalar>& calib) const {
+    using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+    using Vec3d = Eigen::Map<const Eigen::Vector3d>;
+
+    const CalibBinaryImu& imu_rec = imu();
+
+    calib = Calibration<Scalar>();
+
+    calib.T_i_c.resize(numCameras());
+    calib.intrinsics.resize(numCameras());
+    calib.resolution.resize(numCameras());
+    for (size_t i = 0; i < numCameras(); i++) {
+      calib.T_i_c[i] = T_i_c<Scalar>(i);
+      calib.intrinsics[i] = intrinsics<Scalar>(i);
+      calib.resolution[i] =
+          Eigen::Map<const Eigen::Vector2i>(camera(i).resolution);
+    }
+
+    calib.vignette.reserve(numVignettes());
+    for (size_t i = 0; i < numVignettes(); i++) {
+      calib.vignette.emplace_back(vignetteSpline<Scalar>(i));
+    }
+
+    calib.cam_time_offset_ns = imu_rec.cam_time_offset_ns;
+
+    calib.calib_accel_bias.getParam() =
+        Eigen::Map<const Eigen::Matrix<double, 9, 1>>(
+            imu_rec.calib_accel_bias)
+            .template cast<Scalar>();
+    calib.calib_gyro_bias.getParam() =
+        Eigen::Map<const Eigen::Matrix<double, 12, 1>>(
+            imu_rec.calib_gyro_bias)
+            .template cast<Scalar>();
+
+    calib.imu_update_rate = Scalar(imu_rec.imu_update_rate);
+
+    calib.gyro_noise_std =
+        Vec3(Vec3d(imu_rec.gyro_noise_std).template cast<Scalar>());
+    calib.accel_noise_std =
+        Vec3(Vec3d(imu_rec.accel_noise_std).template cast<Scalar>());
+    calib.gyro_bias_std =
+        Vec3(Vec3d(imu_rec.gyro_bias_std).template cast<Scalar>());
+    calib.accel_bias_std =
+        Vec3(Vec3d(imu_rec.accel_bias_std).template cast<Scalar>());
+  }
+
+ private:
+  const CalibBinaryHeader* header_ = nullptr;
+  const CalibBinaryImu* imu_ = nullptr;
+  const CalibBinaryCamera* cameras_ = nullptr;
+  const CalibBinaryVignette* vignettes_ = nullptr;
+  const double* knots_ = nullptr;
+};
+
+/// @brief Write a \ref Calibration to the flat binary format
+///
+/// @param[in] calib calibration with the same number of entries in T_i_c,
+/// intrinsics and resolution
+/// @param[out] buf resized to the size of the binary calibration
+template <class Scalar>
+inline void calibToBinary(const Calibration<Scalar>& calib,
+                          std::vector<uint8_t>& buf) {
+  const size_t num_cameras = calib.intrinsics.size();
+  BASALT_ASSERT_STREAM(calib.T_i_c.size() == num_cameras &&
+                           calib.resolution.size() == num_cameras,
+                       "T_i_c " << calib.T_i_c.size() << " intrinsics "
+                                << num_cameras << " resolution "
+                                << calib.resolution.size());
+
+  size_t num_knots = 0;
+  for (const auto& v : calib.vignette) num_knots += v.getKnots().size();
+
+  const size_t size =
+      calibBinarySize(num_cameras, calib.vignette.size(), num_knots);
+  buf.assign(size, 0);
+  uint8_t* ptr = buf.data();
+
+  CalibBinaryHeader header;
+  std::memcpy(header.magic, CalibBinaryHeader::MAGIC, 8);
+  header.version = CalibBinaryHeader::VERSION;
+  header.byte_order = CalibBinaryHeader::BYTE_ORDER_MARK;
+  header.num_cameras = num_cameras;
+  header.num_vignettes = calib.vignette.size();
+  header.num_vignette_knots = num_knots;
+  header.size = size;
+  std::memcpy(ptr, &header, sizeof(header));
+  ptr += sizeof(header);
+
+  CalibBinaryImu imu{};
+  auto copy = [](const auto& v, double* dst) {
+    for (int i = 0; i < v.size(); i++) dst[i] = double(v[i]);
+  };
+  copy(calib.calib_accel_bias.getParam(), imu.calib_accel_bias);
+  copy(calib.calib_gyro_bias.getParam(), imu.calib_gyro_bias);
+  imu.imu_update_rate = double(calib.imu_update_rate);
+  copy(calib.gyro_noise_std, imu.gyro_noise_std);
+  copy(calib.accel_noise_std, imu.accel_noise_std);
+  copy(calib.gyro_bias_std, imu.gyro_bias_std);
+  copy(calib.accel_bias_std, imu.accel_bias_std);
+  imu.cam_time_offset_ns = calib.cam_time_offset_ns;
+  std::memcpy(ptr, &imu, sizeof(imu));
+  ptr += sizeof(imu);
+
+  for (size_t i = 0; i < num_cameras; i++) {
+    CalibBinaryCamera cam{};
+
+    copy(calib.T_i_c[i].unit_quaternion().coeffs(), cam.T_i_c);
+    copy(calib.T_i_c[i].translation(), cam.T_i_c + 4);
+
+    cam.camera_type = uint32_t(calibBinaryCameraType(calib.intrinsics[i]));
+    std::visit(
+        [&](const auto& model) {
+          using CamT = std::decay_t<decltype(model)>;
+          static_assert(CamT::N < CalibBinaryCamera::MAX_INTRINSICS);
+
+          copy(model.getParam(), cam.intrinsics);
+          cam.num_intrinsics = CamT::N;
+          if constexpr (std::is_same_v<CamT, PinholeRadtan8Camera<Scalar>>) {
+            cam.intrinsics[CamT::N] = double(model.getRpmax());
+            cam.num_intrinsics += 1;
+          }
+        },
+        calib.intrinsics[i].variant);
+
+    cam.resolution[0] = calib.resolution[i][0];
+    cam.resolution[1] = calib.resolution[i][1];
+
+    std::memcpy(ptr, &cam, sizeof(cam));
+    ptr += sizeof(cam);
+  }
+
+  size_t knot_offset = 0;
+  for (const auto& v : calib.vignette) {
+    CalibBinaryVignette rec;
+    rec.start_t_ns = v.minTimeNs();
+    rec.dt_ns = v.getTimeIntervalNs();
+    rec.knot_offset = knot_offset;
+    rec.num_knots = v.getKnots().size();
+    knot_offset += rec.num_knots;
+
+    std::memcpy(ptr, &rec, sizeof(rec));
+    ptr += sizeof(rec);
+  }
+
+  for (const auto& v : calib.vignette) {
+    for (const auto& k : v.getKnots()) {
+      const double d = double(k[0]);
+      std::memcpy(ptr, &d, sizeof(d));
+      ptr += sizeof(d);
+    }
+  }
+
+  BASALT_ASSERT(ptr == buf.data() + size);
+}
+
+/// @brief Save a \ref Calibration to a file in the flat binary format
+///
+/// @return if the file was written successfully
+template <class Scalar>
+inline bool saveCalibBinary(const std::string& path,
+                            const Calibration<Scalar>& calib) {
+  std::vector<uint8_t> buf;
+  calibToBinary(calib, buf);
+
+  std::ofstream os(path, std::ios::binary);
+  os.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+  return bool(os);
+}
+
+/// @brief Load a \ref Calibration from a file in the flat binary format
+///
+/// The file is read with a single read into an aligned buffer. To avoid the
+/// copy, memory-map the file and use \ref CalibBinaryView directly.
+/// @return if the file could be read and holds a valid binary calibration
+template <class Scalar>
+inline bool loadCalibBinary(const std::string& path,
+                            Calibration<Scalar>& calib) {
+  std::ifstream is(path, std::ios::binary | std::ios::ate);
+  if (!is) return false;
+
+  const std::streamsize size = is.tellg();
+  if (size <= 0) return false;
+  is.seekg(0);
+
+  // uint64_t storage for 8-byte alignment
+  std::vector<uint64_t> buf((size + 7) / 8);
+  if (!is.read(reinterpret_cast<char*>(buf.data()), size)) return false;
+
+  CalibBinaryView view;
+  if (!view.init(buf.data(), size)) return false;
+
+  view.toCalibration(calib);
+  return true;
+}
+
+}  // namespace basalt
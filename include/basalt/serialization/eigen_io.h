@@ -38,6 +38,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
 #include <Eigen/Dense>
 #include <sophus/se3.hpp>
 #include <sophus/sim3.hpp>
@@ -45,6 +52,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cereal/archives/binary.hpp>
 #include <cereal/archives/json.hpp>
 
+#include <basalt/utils/eigen_utils.hpp>
+
 namespace cereal {
 
 // NOTE: Serialization functions for non-basalt types (for now Eigen and Sophus)
@@ -56,6 +65,78 @@ namespace cereal {
 // https://groups.google.com/d/topic/cerealcpp/WswQi_Sh-bw/discussion for a more
 // detailed discussion and possible workarounds.
 
+namespace basalt_detail {
+
+/// @brief If coefficients of type Scalar can be written to / read from the
+/// archive as a single blob with binary_data
+///
+/// Only the traits for the direction of the archive are evaluated, as cereal's
+/// input traits expect an input archive and its output traits an output
+/// archive.
+template <class Archive, class Scalar>
+constexpr bool supportsBinaryData() {
+  if constexpr (!std::is_arithmetic_v<Scalar>) {
+    return false;
+  } else if constexpr (Archive::is_saving::value) {
+    return traits::is_output_serializable<BinaryData<Scalar>, Archive>::value;
+  } else {
+    return traits::is_input_serializable<BinaryData<Scalar>, Archive>::value;
+  }
+}
+
+// Matrix coefficients are always stored in row-major order, which is the
+// order of the original coefficient-wise serialization. Blobs are thus byte
+// for byte compatible with archives written coefficient by coefficient.
+
+/// @brief Save all coefficients of a matrix in row-major order
+template <class Archive, class _Scalar, int _Rows, int _Cols, int _Options,
+          int _MaxRows, int _MaxCols>
+void saveCoeffs(
+    Archive& archive,
+    const Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>&
+        m) {
+  if constexpr (supportsBinaryData<Archive, _Scalar>()) {
+    if constexpr (_Rows == 1 || _Cols == 1 || (_Options & Eigen::RowMajor)) {
+      archive(binary_data(m.data(), m.size() * sizeof(_Scalar)));
+    } else {
+      const Eigen::Matrix<_Scalar, _Rows, _Cols, Eigen::RowMajor> tmp = m;
+      archive(binary_data(tmp.data(), tmp.size() * sizeof(_Scalar)));
+    }
+  } else {
+    for (int i = 0; i < m.rows(); i++) {
+      for (int j = 0; j < m.cols(); j++) {
+        archive(m(i, j));
+      }
+    }
+  }
+}
+
+/// @brief Load all coefficients of an already sized matrix in row-major order
+template <class Archive, class _Scalar, int _Rows, int _Cols, int _Options,
+          int _MaxRows, int _MaxCols>
+void loadCoeffs(
+    Archive& archive,
+    Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>& m) {
+  if constexpr (supportsBinaryData<Archive, _Scalar>()) {
+    if constexpr (_Rows == 1 || _Cols == 1 || (_Options & Eigen::RowMajor)) {
+      archive(binary_data(m.data(), m.size() * sizeof(_Scalar)));
+    } else {
+      Eigen::Matrix<_Scalar, _Rows, _Cols, Eigen::RowMajor> tmp;
+      tmp.resize(m.rows(), m.cols());
+      archive(binary_data(tmp.data(), tmp.size() * sizeof(_Scalar)));
+      m = tmp;
+    }
+  } else {
+    for (int i = 0; i < m.rows(); i++) {
+      for (int j = 0; j < m.cols(); j++) {
+        archive(m(i, j));
+      }
+    }
+  }
+}
+
+}  // namespace basalt_detail
+
 // For binary-archives, don't save a size tag for compact representation.
 template <class Archive, class _Scalar, int _Rows, int _Cols, int _Options,
           int _MaxRows, int _MaxCols>
@@ -64,15 +145,11 @@ std::enable_if_t<(_Rows > 0) && (_Cols > 0) &&
 serialize(
     Archive& archive,
     Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>& m) {
-  for (int i = 0; i < _Rows; i++) {
-    for (int j = 0; j < _Cols; j++) {
-      archive(m(i, j));
-    }
+  if constexpr (Archive::is_saving::value) {
+    basalt_detail::saveCoeffs(archive, m);
+  } else {
+    basalt_detail::loadCoeffs(archive, m);
   }
-  // Note: if we can break binary compatibility, we might want to consider the
-  // following. However, this would only work for compact Scalar types that can
-  // be serialized / deserialized by memcopy, such as double.
-  // archive(binary_data(m.data(), _Rows * _Cols * sizeof(_Scalar)));
 }
 
 // For text-archives, save size-tag even for constant size matrices, to ensure
@@ -103,11 +180,7 @@ std::enable_if_t<(_Cols > 0), void> save(
     Archive& archive, const Eigen::Matrix<_Scalar, Eigen::Dynamic, _Cols,
                                           _Options, _MaxRows, _MaxCols>& m) {
   archive(make_size_tag(static_cast<size_type>(m.size())));
-  for (int i = 0; i < m.rows(); i++) {
-    for (int j = 0; j < _Cols; j++) {
-      archive(m(i, j));
-    }
-  }
+  basalt_detail::saveCoeffs(archive, m);
 }
 
 template <class Archive, class _Scalar, int _Cols, int _Options, int _MaxRows,
@@ -119,11 +192,7 @@ std::enable_if_t<(_Cols > 0), void> load(
   size_type size;
   archive(make_size_tag(size));
   m.resize(Eigen::Index(size) / _Cols, _Cols);
-  for (int i = 0; i < m.rows(); i++) {
-    for (int j = 0; j < _Cols; j++) {
-      archive(m(i, j));
-    }
-  }
+  basalt_detail::loadCoeffs(archive, m);
 }
 
 template <class Archive, class _Scalar, int _Rows, int _Options, int _MaxRows,
@@ -132,11 +201,7 @@ std::enable_if_t<(_Rows > 0), void> save(
     Archive& archive, const Eigen::Matrix<_Scalar, _Rows, Eigen::Dynamic,
                                           _Options, _MaxRows, _MaxCols>& m) {
   archive(make_size_tag(static_cast<size_type>(m.size())));
-  for (int i = 0; i < _Rows; i++) {
-    for (int j = 0; j < m.cols(); j++) {
-      archive(m(i, j));
-    }
-  }
+  basalt_detail::saveCoeffs(archive, m);
 }
 
 template <class Archive, class _Scalar, int _Rows, int _Options, int _MaxRows,
@@ -148,24 +213,34 @@ std::enable_if_t<(_Rows > 0), void> load(
   size_type size;
   archive(make_size_tag(size));
   m.resize(_Rows, Eigen::Index(size) / _Rows);
-  for (int i = 0; i < _Rows; i++) {
-    for (int j = 0; j < m.cols(); j++) {
-      archive(m(i, j));
-    }
-  }
+  basalt_detail::loadCoeffs(archive, m);
 }
 
+// Text archives derive every size tag of a node from its number of children,
+// so they cannot store rows and columns as two size tags. Instead, they store
+// both as values next to the row-major coefficients. Archives written before
+// this layout, i.e. as a plain sequence of coefficients, are still loaded the
+// way they were loaded before (see load below).
 template <class Archive, class _Scalar, int _Options, int _MaxRows,
           int _MaxCols>
 void save(Archive& archive,
           const Eigen::Matrix<_Scalar, Eigen::Dynamic, Eigen::Dynamic, _Options,
                               _MaxRows, _MaxCols>& m) {
-  archive(make_size_tag(static_cast<size_type>(m.rows())));
-  archive(make_size_tag(static_cast<size_type>(m.cols())));
-  for (int i = 0; i < m.rows(); i++) {
-    for (int j = 0; j < m.cols(); j++) {
-      archive(m(i, j));
-    }
+  if constexpr (traits::is_text_archive<Archive>::value) {
+    using RowMajorMatrix = Eigen::Matrix<_Scalar, Eigen::Dynamic,
+                                         Eigen::Dynamic, Eigen::RowMajor>;
+    using Coeffs = Eigen::Matrix<_Scalar, Eigen::Dynamic, 1>;
+
+    const RowMajorMatrix tmp = m;
+    const Coeffs coeffs = Eigen::Map<const Coeffs>(tmp.data(), tmp.size());
+
+    archive(make_nvp("rows", static_cast<size_type>(m.rows())),
+            make_nvp("cols", static_cast<size_type>(m.cols())),
+            make_nvp("data", coeffs));
+  } else {
+    archive(make_size_tag(static_cast<size_type>(m.rows())));
+    archive(make_size_tag(static_cast<size_type>(m.cols())));
+    basalt_detail::saveCoeffs(archive, m);
   }
 }
 
@@ -176,18 +251,46 @@ void load(Archive& archive,
                         _MaxRows, _MaxCols>& m) {
   size_type rows;
   size_type cols;
-  archive(make_size_tag(rows));
-  archive(make_size_tag(cols));
-  m.resize(rows, cols);
-  for (int i = 0; i < m.rows(); i++) {
-    for (int j = 0; j < m.cols(); j++) {
-      archive(m(i, j));
+
+  if constexpr (traits::is_text_archive<Archive>::value) {
+    using RowMajorMatrix = Eigen::Matrix<_Scalar, Eigen::Dynamic,
+                                         Eigen::Dynamic, Eigen::RowMajor>;
+    Eigen::Matrix<_Scalar, Eigen::Dynamic, 1> coeffs;
+
+    const char* name = archive.getNodeName();
+    if (!name || std::strcmp(name, "rows") != 0) {
+      // Legacy layout: two size tags and the coefficients. Both size tags
+      // read back as the number of coefficients, so as before only empty and
+      // 1x1 matrices load and everything else fails with the archive's error.
+      archive(make_size_tag(rows));
+      archive(make_size_tag(cols));
+      m.resize(rows, cols);
+      basalt_detail::loadCoeffs(archive, m);
+      return;
     }
+
+    archive(make_nvp("rows", rows), make_nvp("cols", cols),
+            make_nvp("data", coeffs));
+    if (size_type(coeffs.size()) != rows * cols) {
+      throw std::runtime_error("matrix has incorrect length");
+    }
+    m = Eigen::Map<const RowMajorMatrix>(coeffs.data(), rows, cols);
+  } else {
+    archive(make_size_tag(rows));
+    archive(make_size_tag(cols));
+    m.resize(rows, cols);
+    basalt_detail::loadCoeffs(archive, m);
   }
 }
 
-template <class Archive>
-void serialize(Archive& ar, Sophus::SE3d& p) {
+template <class Archive, class Scalar>
+void serialize(Archive& ar, Sophus::SO3<Scalar>& p) {
+  ar(cereal::make_nvp("qx", p.data()[0]), cereal::make_nvp("qy", p.data()[1]),
+     cereal::make_nvp("qz", p.data()[2]), cereal::make_nvp("qw", p.data()[3]));
+}
+
+template <class Archive, class Scalar>
+void serialize(Archive& ar, Sophus::SE3<Scalar>& p) {
   ar(cereal::make_nvp("px", p.translation()[0]),
      cereal::make_nvp("py", p.translation()[1]),
      cereal::make_nvp("pz", p.translation()[2]),
@@ -197,8 +300,8 @@ void serialize(Archive& ar, Sophus::SE3d& p) {
      cereal::make_nvp("qw", p.so3().data()[3]));
 }
 
-template <class Archive>
-void serialize(Archive& ar, Sophus::Sim3d& p) {
+template <class Archive, class Scalar>
+void serialize(Archive& ar, Sophus::Sim3<Scalar>& p) {
   ar(cereal::make_nvp("px", p.translation()[0]),
      cereal::make_nvp("py", p.translation()[1]),
      cereal::make_nvp("pz", p.translation()[2]),
@@ -208,4 +311,235 @@ void serialize(Archive& ar, Sophus::Sim3d& p) {
      cereal::make_nvp("qw", p.rxso3().data()[3]));
 }
 
+namespace basalt_detail {
+
+/// @brief Describes how elements of a container are packed into a blob of
+/// scalars. The order of the scalars matches the element-wise serialization
+/// above, so blobs are byte for byte compatible with it.
+template <class T, class Enable = void>
+struct BlobTraits : std::false_type {};
+
+template <class _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows,
+          int _MaxCols>
+struct BlobTraits<
+    Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>,
+    std::enable_if_t<(_Rows > 0) && (_Cols > 0) &&
+                     std::is_arithmetic_v<_Scalar>>> : std::true_type {
+  using T = Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>;
+  using Scalar = _Scalar;
+  static constexpr size_t SIZE = _Rows * _Cols;
+
+  /// Contiguous arrays of T already have the blob layout (no padding,
+  /// row-major order).
+  static constexpr bool CONTIGUOUS =
+      (_Rows == 1 || _Cols == 1 || (_Options & Eigen::RowMajor)) &&
+      sizeof(T) == SIZE * sizeof(Scalar);
+
+  static void pack(const T& m, Scalar* dst) {
+    for (int i = 0; i < _Rows; i++) {
+      for (int j = 0; j < _Cols; j++) {
+        *dst++ = m(i, j);
+      }
+    }
+  }
+
+  static void unpack(const Scalar* src, T& m) {
+    for (int i = 0; i < _Rows; i++) {
+      for (int j = 0; j < _Cols; j++) {
+        m(i, j) = *src++;
+      }
+    }
+  }
+};
+
+template <class _Scalar>
+struct BlobTraits<Sophus::SO3<_Scalar>,
+                  std::enable_if_t<std::is_arithmetic_v<_Scalar>>>
+    : std::true_type {
+  using Scalar = _Scalar;
+  static constexpr size_t SIZE = 4;
+  static constexpr bool CONTIGUOUS = false;
+
+  static void pack(const Sophus::SO3<Scalar>& p, Scalar* dst) {
+    std::copy_n(p.data(), 4, dst);
+  }
+
+  static void unpack(const Scalar* src, Sophus::SO3<Scalar>& p) {
+    std::copy_n(src, 4, p.data());
+  }
+};
+
+template <class _Scalar>
+struct BlobTraits<Sophus::SE3<_Scalar>,
+                  std::enable_if_t<std::is_arithmetic_v<_Scalar>>>
+    : std::true_type {
+  using Scalar = _Scalar;
+  static constexpr size_t SIZE = 7;
+  static constexpr bool CONTIGUOUS = false;
+
+  static void pack(const Sophus::SE3<Scalar>& p, Scalar* dst) {
+    std::copy_n(p.translation().data(), 3, dst);
+    std::copy_n(p.so3().data(), 4, dst + 3);
+  }
+
+  static void unpack(const Scalar* src, Sophus::SE3<Scalar>& p) {
+    std::copy_n(src, 3, p.translation().data());
+    std::copy_n(src + 3, 4, p.so3().data());
+  }
+};
+
+template <class _Scalar>
+struct BlobTraits<Sophus::Sim3<_Scalar>,
+                  std::enable_if_t<std::is_arithmetic_v<_Scalar>>>
+    : std::true_type {
+  using Scalar = _Scalar;
+  static constexpr size_t SIZE = 7;
+  static constexpr bool CONTIGUOUS = false;
+
+  static void pack(const Sophus::Sim3<Scalar>& p, Scalar* dst) {
+    std::copy_n(p.translation().data(), 3, dst);
+    std::copy_n(p.rxso3().data(), 4, dst + 3);
+  }
+
+  static void unpack(const Scalar* src, Sophus::Sim3<Scalar>& p) {
+    std::copy_n(src, 3, p.translation().data());
+    std::copy_n(src + 3, 4, p.rxso3().data());
+  }
+};
+
+/// @brief If a container of T is written to / read from the archive as blob
+template <class Archive, class T, class Enable = void>
+struct UseBlob : std::false_type {};
+
+template <class Archive, class T>
+struct UseBlob<Archive, T, std::enable_if_t<BlobTraits<T>::value>>
+    : std::bool_constant<
+          supportsBinaryData<Archive, typename BlobTraits<T>::Scalar>()> {};
+
+/// Maximum number of elements that are packed into one binary_data call. This
+/// bounds the size of the temporary buffer for containers that are not
+/// stored in blob layout.
+constexpr size_t BLOB_CHUNK_SIZE = 4096;
+
+/// @brief Save a vector or deque as size tag followed by packed elements
+template <class Archive, class Container>
+void saveBlob(Archive& ar, const Container& c) {
+  using T = typename Container::value_type;
+  using Traits = BlobTraits<T>;
+  using Scalar = typename Traits::Scalar;
+
+  ar(make_size_tag(static_cast<size_type>(c.size())));
+
+  if constexpr (Traits::CONTIGUOUS &&
+                std::is_same_v<Container, Eigen::aligned_vector<T>>) {
+    // binary_data on Scalar, such that portable archives swap the byte order
+    // per scalar
+    ar(binary_data(reinterpret_cast<const Scalar*>(c.data()),
+                   c.size() * sizeof(T)));
+  } else {
+    std::vector<Scalar> buf(std::min(c.size(), BLOB_CHUNK_SIZE) *
+                            Traits::SIZE);
+
+    auto it = c.begin();
+    for (size_t i = 0; i < c.size(); i += BLOB_CHUNK_SIZE) {
+      const size_t n = std::min(c.size() - i, BLOB_CHUNK_SIZE);
+      for (size_t j = 0; j < n; j++, ++it) {
+        Traits::pack(*it, buf.data() + j * Traits::SIZE);
+      }
+      ar(binary_data(buf.data(), n * Traits::SIZE * sizeof(Scalar)));
+    }
+  }
+}
+
+/// @brief Load a vector or deque saved with @ref saveBlob
+template <class Archive, class Container>
+void loadBlob(Archive& ar, Container& c) {
+  using T = typename Container::value_type;
+  using Traits = BlobTraits<T>;
+  using Scalar = typename Traits::Scalar;
+
+  size_type size;
+  ar(make_size_tag(size));
+  c.resize(static_cast<size_t>(size));
+
+  if constexpr (Traits::CONTIGUOUS &&
+                std::is_same_v<Container, Eigen::aligned_vector<T>>) {
+    ar(binary_data(reinterpret_cast<Scalar*>(c.data()), c.size() * sizeof(T)));
+  } else {
+    std::vector<Scalar> buf(std::min(c.size(), BLOB_CHUNK_SIZE) *
+                            Traits::SIZE);
+
+    auto it = c.begin();
+    for (size_t i = 0; i < c.size(); i += BLOB_CHUNK_SIZE) {
+      const size_t n = std::min(c.size() - i, BLOB_CHUNK_SIZE);
+      ar(binary_data(buf.data(), n * Traits::SIZE * sizeof(Scalar)));
+      for (size_t j = 0; j < n; j++, ++it) {
+        Traits::unpack(buf.data() + j * Traits::SIZE, *it);
+      }
+    }
+  }
+}
+
+/// @brief Save a sequence container in the same format as std::vector and
+/// std::deque, e.g. for custom spline knot storages
+template <class Archive, class Container>
+void saveSequence(Archive& ar, const Container& c) {
+  if constexpr (UseBlob<Archive, typename Container::value_type>::value) {
+    saveBlob(ar, c);
+  } else {
+    ar(make_size_tag(static_cast<size_type>(c.size())));
+    for (const auto& v : c) {
+      ar(v);
+    }
+  }
+}
+
+/// @brief Load a sequence container saved with @ref saveSequence
+template <class Archive, class Container>
+void loadSequence(Archive& ar, Container& c) {
+  if constexpr (UseBlob<Archive, typename Container::value_type>::value) {
+    loadBlob(ar, c);
+  } else {
+    size_type size;
+    ar(make_size_tag(size));
+    c.resize(static_cast<size_t>(size));
+    for (auto& v : c) {
+      ar(v);
+    }
+  }
+}
+
+}  // namespace basalt_detail
+
+// Containers of fixed-size Eigen matrices and Sophus groups with Eigen
+// allocator are written as one contiguous blob (in chunks for deques) by
+// archives that support binary_data, e.g. cereal binary archives. The layout
+// is the same as the element-wise serialization. These overloads are more
+// specialized than the generic ones for std::vector and std::deque from
+// cereal, so they are picked up automatically.
+
+template <class Archive, class T>
+std::enable_if_t<basalt_detail::UseBlob<Archive, T>::value> save(
+    Archive& ar, const std::vector<T, Eigen::aligned_allocator<T>>& v) {
+  basalt_detail::saveBlob(ar, v);
+}
+
+template <class Archive, class T>
+std::enable_if_t<basalt_detail::UseBlob<Archive, T>::value> load(
+    Archive& ar, std::vector<T, Eigen::aligned_allocator<T>>& v) {
+  basalt_detail::loadBlob(ar, v);
+}
+
+template <class Archive, class T>
+std::enable_if_t<basalt_detail::UseBlob<Archive, T>::value> save(
+    Archive& ar, const std::deque<T, Eigen::aligned_allocator<T>>& d) {
+  basalt_detail::saveBlob(ar, d);
+}
+
+template <class Archive, class T>
+std::enable_if_t<basalt_detail::UseBlob<Archive, T>::value> load(
+    Archive& ar, std::deque<T, Eigen::aligned_allocator<T>>& d) {
+  basalt_detail::loadBlob(ar, d);
+}
+
 }  // namespace cereal
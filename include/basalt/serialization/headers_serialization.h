@@ -41,6 +41,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <basalt/serialization/eigen_io.h>
 #include <basalt/calibration/calibration.hpp>
 #include <basalt/camera/bal_camera.hpp>
+#include <basalt/serialization/calibration_binary.h>
+#include <basalt/spline/se3_spline.h>
+#include <basalt/utils/ring_buffer.h>
 
 #include <cereal/archives/binary.hpp>
 #include <cereal/archives/json.hpp>
@@ -247,31 +250,83 @@ inline void load(Archive& ar, basalt::BalCamera<Scalar>& cam) {
   cam = basalt::BalCamera<Scalar>(intr);
 }
 
-template <class Archive, class Scalar, int DIM, int ORDER>
-inline void save(Archive& ar,
-                 const basalt::RdSpline<DIM, ORDER, Scalar>& spline) {
+// Same format as std::vector and std::deque, so splines can be loaded with a
+// different knot storage than they were saved with.
+template <class Archive, class T>
+inline void save(Archive& ar, const basalt::RingBuffer<T>& buf) {
+  basalt_detail::saveSequence(ar, buf);
+}
+
+template <class Archive, class T>
+inline void load(Archive& ar, basalt::RingBuffer<T>& buf) {
+  basalt_detail::loadSequence(ar, buf);
+}
+
+template <class Archive, class Scalar, int DIM, int ORDER,
+          template <class> class KnotStorage>
+inline void save(
+    Archive& ar,
+    const basalt::RdSpline<DIM, ORDER, Scalar, KnotStorage>& spline) {
   ar(spline.minTimeNs());
   ar(spline.getTimeIntervalNs());
   ar(spline.getKnots());
 }
 
-template <class Archive, class Scalar, int DIM, int ORDER>
-inline void load(Archive& ar, basalt::RdSpline<DIM, ORDER, Scalar>& spline) {
+template <class Archive, class Scalar, int DIM, int ORDER,
+          template <class> class KnotStorage>
+inline void load(Archive& ar,
+                 basalt::RdSpline<DIM, ORDER, Scalar, KnotStorage>& spline) {
   int64_t start_t_ns;
   int64_t dt_ns;
-  Eigen::aligned_deque<Eigen::Matrix<Scalar, DIM, 1>> knots;
+  KnotStorage<Eigen::Matrix<Scalar, DIM, 1>> knots;
 
   ar(start_t_ns);
   ar(dt_ns);
   ar(knots);
 
-  basalt::RdSpline<DIM, ORDER, Scalar> new_spline(dt_ns, start_t_ns);
+  basalt::RdSpline<DIM, ORDER, Scalar, KnotStorage> new_spline(dt_ns,
+                                                               start_t_ns);
   for (const auto& k : knots) {
     new_spline.knotsPushBack(k);
   }
   spline = new_spline;
 }
 
+template <class Archive, class Scalar, int ORDER,
+          template <class> class KnotStorage>
+inline void save(Archive& ar,
+                 const basalt::Se3Spline<ORDER, Scalar, KnotStorage>& spline) {
+  ar(spline.minTimeNs());
+  ar(spline.getDtNs());
+  ar(spline.getPosSpline().getKnots());
+  ar(spline.getRotSpline().getKnots());
+}
+
+template <class Archive, class Scalar, int ORDER,
+          template <class> class KnotStorage>
+inline void load(Archive& ar,
+                 basalt::Se3Spline<ORDER, Scalar, KnotStorage>& spline) {
+  int64_t start_t_ns;
+  int64_t dt_ns;
+  KnotStorage<Eigen::Matrix<Scalar, 3, 1>> pos_knots;
+  KnotStorage<Sophus::SO3<Scalar>> so3_knots;
+
+  ar(start_t_ns);
+  ar(dt_ns);
+  ar(pos_knots);
+  ar(so3_knots);
+
+  if (pos_knots.size() != so3_knots.size()) {
+    throw std::runtime_error("Se3Spline has different number of knots");
+  }
+
+  basalt::Se3Spline<ORDER, Scalar, KnotStorage> new_spline(dt_ns, start_t_ns);
+  for (size_t i = 0; i < pos_knots.size(); i++) {
+    new_spline.knotsPushBack(Sophus::SE3<Scalar>(so3_knots[i], pos_knots[i]));
+  }
+  spline = new_spline;
+}
+
 template <class Archive, class Scalar>
 inline void serialize(Archive& ar, basalt::Calibration<Scalar>& cam) {
   ar(cereal::make_nvp("T_imu_cam", cam.T_i_c),
@@ -297,3 +352,40 @@ inline void serialize(Archive& ar, basalt::MocapCalibration<Scalar>& cam) {
 }
 
 }  // namespace cereal
+
+namespace basalt {
+
+/// @brief Convert a calibration stored as cereal archive to the flat binary
+/// format (see \ref CalibBinaryHeader)
+///
+/// @param[in] is stream with the cereal archive, e.g. a calibration json file
+/// @param[out] buf binary calibration
+template <class InputArchive = cereal::JSONInputArchive>
+inline void convertCalibToBinary(std::istream& is, std::vector<uint8_t>& buf) {
+  Calibration<double> calib;
+  {
+    InputArchive ar(is);
+    ar(calib);
+  }
+  calibToBinary(calib, buf);
+}
+
+/// @brief Convert a calibration file stored as cereal archive to a file in
+/// the flat binary format
+///
+/// @return if both files could be accessed
+template <class InputArchive = cereal::JSONInputArchive>
+inline bool convertCalibToBinary(const std::string& in_path,
+                                 const std::string& out_path) {
+  std::ifstream is(in_path, std::ios::binary);
+  if (!is) return false;
+
+  std::vector<uint8_t> buf;
+  convertCalibToBinary<InputArchive>(is, buf);
+
+  std::ofstream os(out_path, std::ios::binary);
+  os.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+  return bool(os);
+}
+
+}  // namespace basalt
@@ -0,0 +1,321 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+@file
+@brief Append-only on-disk log of Se3Spline knots with random access by time
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <basalt/spline/se3_spline.h>
+#include <basalt/utils/assert.h>
+
+namespace basalt {
+
+/// @brief Header of the Se3Spline log format
+///
+/// The header is followed by an append-only sequence of fixed-size knot
+/// records of 7 doubles each: the translation followed by the unit quaternion
+/// [x, y, z, w] (same order as the cereal serialization of SE3d). The time of
+/// knot i is start_t_ns + i * dt_ns, so the records of any knot window can be
+/// found without an index, and the number of knots follows from the file size.
+/// Knots are written and read in chunks of knots_per_chunk.
+struct SplineLogHeader {
+  static constexpr char MAGIC[8] = {'B', 'S', 'L', 'T', 'S', 'P', 'L', 'G'};
+  static constexpr uint32_t VERSION = 1;
+
+  /// Number of doubles per knot record
+  static constexpr size_t KNOT_SIZE = 7;
+
+  char magic[8];             ///< MAGIC
+  uint32_t version;          ///< VERSION
+  uint32_t order;            ///< order N of the spline
+  int64_t start_t_ns;        ///< time of the first knot
+  int64_t dt_ns;             ///< knot interval
+  uint64_t knots_per_chunk;  ///< number of knots per chunk
+};
+
+static_assert(sizeof(SplineLogHeader) == 40);
+
+/// @brief Writer for the Se3Spline log format (see \ref SplineLogHeader)
+///
+/// Knots are buffered and appended to the file one chunk at a time.
+template <int _N, typename _Scalar = double>
+class Se3SplineLogWriter {
+ public:
+  static constexpr int N = _N;  ///< Order of the spline.
+
+  using SE3 = Sophus::SE3<_Scalar>;
+
+  /// @brief Create a new log, overwriting an existing file
+  ///
+  /// @param[in] path file name
+  /// @param[in] dt_ns knot interval in nanoseconds
+  /// @param[in] start_t_ns time of the first knot in nanoseconds
+  /// @param[in] knots_per_chunk number of knots that are written at once
+  Se3SplineLogWriter(const std::string& path, int64_t dt_ns,
+                     int64_t start_t_ns = 0, size_t knots_per_chunk = 1024)
+      : os_(path, std::ios::binary | std::ios::trunc),
+        dt_ns_(dt_ns),
+        start_t_ns_(start_t_ns),
+        knots_per_chunk_(knots_per_chunk) {
+    BASALT_ASSERT(dt_ns > 0);
+    BASALT_ASSERT(knots_per_chunk > 0);
+
+    SplineLogHeader header;
+    std::memcpy(header.magic, SplineLogHeader::MAGIC, 8);
+    header.version = SplineLogHeader::VERSION;
+    header.order = N;
+    header.start_t_ns = start_t_ns;
+    header.dt_ns = dt_ns;
+    header.knots_per_chunk = knots_per_chunk;
+    os_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    buffer_.reserve(knots_per_chunk_ * SplineLogHeader::KNOT_SIZE);
+  }
+
+  /// @brief Writes the remaining buffered knots
+  ~Se3SplineLogWriter() { flush(); }
+
+  Se3SplineLogWriter(const Se3SplineLogWriter&) = delete;
+  Se3SplineLogWriter& operator=(const Se3SplineLogWriter&) = delete;
+
+  /// @brief If the file is open and all writes succeeded
+  bool good() const { return bool(os_); }
+
+  /// @brief Number of knots appended so far
+  size_t numKnots() const { return num_knots_; }
+
+  /// @brief Append a knot
+  void knotsPushBack(const SE3& knot) {
+    const auto& t = knot.translation();
+    const auto& q = knot.unit_quaternion().coeffs();
+    for (int i = 0; i < 3; i++) buffer_.push_back(double(t[i]));
+    for (int i = 0; i < 4; i++) buffer_.push_back(double(q[i]));
+    num_knots_++;
+
+    if (buffer_.size() == knots_per_chunk_ * SplineLogHeader::KNOT_SIZE) {
+      writeBuffer();
+    }
+  }
+
+  /// @brief Append all knots of a spline
+  ///
+  /// The knot interval and the start time of the spline have to match the
+  /// log, taking the knots already in the log into account.
+  template <template <class> class _KnotStorage>
+  void knotsPushBack(const Se3Spline<N, _Scalar, _KnotStorage>& spline) {
+    BASALT_ASSERT_STREAM(spline.getDtNs() == dt_ns_,
+                         "spline dt_ns " << spline.getDtNs() << " log dt_ns "
+                                         << dt_ns_);
+    BASALT_ASSERT_STREAM(
+        spline.minTimeNs() == start_t_ns_ + int64_t(num_knots_) * dt_ns_,
+        "spline start_t_ns " << spline.minTimeNs() << " log start_t_ns "
+                             << start_t_ns_ << " num_knots " << num_knots_);
+
+    for (size_t i = 0; i < spline.numKnots(); i++) {
+      knotsPushBack(spline.getKnot(i));
+    }
+  }
+
+  /// @brief Write buffered knots to the file and flush it
+  void flush() {
+    writeBuffer();
+    os_.flush();
+  }
+
+ private:
+  void writeBuffer() {
+    os_.write(reinterpret_cast<const char*>(buffer_.data()),
+              buffer_.size() * sizeof(double));
+    buffer_.clear();
+  }
+
+  std::ofstream os_;
+  int64_t dt_ns_;
+  int64_t start_t_ns_;
+  size_t knots_per_chunk_;
+  size_t num_knots_ = 0;
+  std::vector<double> buffer_;
+};
+
+/// @brief Reader for the Se3Spline log format with random access by time
+///
+/// Only the chunk of knots around the queried time (plus the N - 1 knots that
+/// the last segments of the chunk depend on) is kept in memory as a small
+/// Se3Spline. Memory use is thus independent of the length of the trajectory.
+/// Queries with increasing time only read each chunk once.
+template <int _N, typename _Scalar = double>
+class Se3SplineLogReader {
+ public:
+  static constexpr int N = _N;  ///< Order of the spline.
+
+  using SE3 = Sophus::SE3<_Scalar>;
+  using SO3 = Sophus::SO3<_Scalar>;
+  using Vec3 = Eigen::Matrix<_Scalar, 3, 1>;
+
+  using SplineT = Se3Spline<N, _Scalar>;
+
+  /// @brief Open a log and read its header
+  ///
+  /// @return if the file exists and holds a log of a spline of order N
+  bool open(const std::string& path) {
+    is_.close();
+    is_.clear();
+    is_.open(path, std::ios::binary);
+    valid_ = false;
+    window_begin_ = window_end_ = 0;
+    if (!is_) return false;
+
+    if (!is_.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+        std::memcmp(header_.magic, SplineLogHeader::MAGIC, 8) != 0 ||
+        header_.version != SplineLogHeader::VERSION ||
+        header_.order != uint32_t(N) || header_.dt_ns <= 0 ||
+        header_.knots_per_chunk == 0) {
+      return false;
+    }
+
+    buffer_.resize((header_.knots_per_chunk + N - 1) *
+                   SplineLogHeader::KNOT_SIZE);
+
+    valid_ = true;
+    refresh();
+    return true;
+  }
+
+  /// @brief If the last call to @ref open succeeded
+  bool valid() const { return valid_; }
+
+  /// @brief Update the number of knots from the current file size, e.g.
+  /// after more knots were appended by a writer
+  void refresh() {
+    BASALT_ASSERT(valid_);
+
+    is_.clear();
+    is_.seekg(0, std::ios::end);
+    const uint64_t size = uint64_t(is_.tellg());
+    const uint64_t knot_bytes = SplineLogHeader::KNOT_SIZE * sizeof(double);
+
+    // An incomplete last record (e.g. interrupted write) is ignored.
+    num_knots_ = (size - sizeof(SplineLogHeader)) / knot_bytes;
+
+    // The last chunk might have grown.
+    window_begin_ = window_end_ = 0;
+  }
+
+  /// @brief Number of knots in the log
+  size_t numKnots() const { return num_knots_; }
+
+  /// @brief Knot interval in nanoseconds
+  int64_t getDtNs() const { return header_.dt_ns; }
+
+  /// @brief Minimum time represented by the logged spline
+  int64_t minTimeNs() const { return header_.start_t_ns; }
+
+  /// @brief Maximum time represented by the logged spline
+  int64_t maxTimeNs() const {
+    return header_.start_t_ns +
+           (int64_t(num_knots_) - N + 1) * header_.dt_ns - 1;
+  }
+
+  /// @brief Spline that holds the chunk of knots for time_ns
+  ///
+  /// Reads the chunk from the file if it isn't loaded yet. The returned
+  /// spline can be used for any evaluation in the time range of the chunk and
+  /// stays valid until the next call that loads a different chunk.
+  /// @param[in] time_ns time in nanoseconds, in [minTimeNs(), maxTimeNs()]
+  const SplineT& window(int64_t time_ns) {
+    BASALT_ASSERT(valid_);
+    BASALT_ASSERT_STREAM(time_ns >= minTimeNs() && time_ns <= maxTimeNs(),
+                         "time_ns " << time_ns << " minTimeNs() "
+                                    << minTimeNs() << " maxTimeNs() "
+                                    << maxTimeNs());
+
+    const size_t s = (time_ns - header_.start_t_ns) / header_.dt_ns;
+    if (s < window_begin_ || s + N > window_end_) {
+      loadWindow(s);
+    }
+    return window_;
+  }
+
+  /// @brief Evaluate the pose at time_ns
+  SE3 pose(int64_t time_ns) { return window(time_ns).pose(time_ns); }
+
+ private:
+  /// @brief Load the chunk that contains segment s
+  void loadWindow(size_t s) {
+    const size_t chunk = header_.knots_per_chunk;
+
+    window_begin_ = (s / chunk) * chunk;
+    window_end_ = std::min(window_begin_ + chunk + N - 1, num_knots_);
+
+    const size_t num = window_end_ - window_begin_;
+    const size_t record = SplineLogHeader::KNOT_SIZE * sizeof(double);
+
+    is_.clear();
+    is_.seekg(sizeof(SplineLogHeader) + window_begin_ * record);
+    is_.read(reinterpret_cast<char*>(buffer_.data()), num * record);
+    BASALT_ASSERT(bool(is_));
+
+    window_ = SplineT(header_.dt_ns,
+                      header_.start_t_ns + window_begin_ * header_.dt_ns);
+    for (size_t i = 0; i < num; i++) {
+      const double* k = buffer_.data() + i * SplineLogHeader::KNOT_SIZE;
+      const Eigen::Quaterniond q(k[6], k[3], k[4], k[5]);
+      const Eigen::Vector3d t(k[0], k[1], k[2]);
+      window_.knotsPushBack(SE3(SO3(q.template cast<_Scalar>()),
+                                t.template cast<_Scalar>()));
+    }
+  }
+
+  std::ifstream is_;
+  SplineLogHeader header_;
+  bool valid_ = false;
+  size_t num_knots_ = 0;
+
+  size_t window_begin_ = 0;  ///< index of the first knot in window_
+  size_t window_end_ = 0;    ///< index after the last knot in window_
+  SplineT window_{1};
+  std::vector<double> buffer_;
+};
+
+}  // namespace basalt
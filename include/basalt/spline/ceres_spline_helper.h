@@ -39,10 +39,23 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <basalt/spline/spline_common.h>
+#include <basalt/utils/assert.h>
 #include <Eigen/Dense>
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 namespace basalt {
 
+/// @brief Residuals that depend on the same window of N spline knots. See
+/// \ref CeresSplineHelper::groupByKnotWindow.
+struct CeresSplineResidualGroup {
+  int64_t start_idx;            ///< Index of the first knot of the window
+  std::vector<size_t> indices;  ///< Indices of the residuals in the group
+  std::vector<double> u;        ///< Normalized times of the residuals
+};
+
 /// @brief Helper for implementing Lie group and Euclidean b-splines in ceres of
 /// order N
 ///
@@ -107,9 +120,7 @@ struct CeresSplineHelper {
       typename GroupT<T>::Tangent* vel_out = nullptr,
       typename GroupT<T>::Tangent* accel_out = nullptr,
       typename GroupT<T>::Tangent* jerk_out = nullptr) {
-    using Group = GroupT<T>;
     using Tangent = typename GroupT<T>::Tangent;
-    using Adjoint = typename GroupT<T>::Adjoint;
 
     VecN p, coeff, dcoeff, ddcoeff, dddcoeff;
 
@@ -133,8 +144,104 @@ struct CeresSplineHelper {
       }
     }
 
+    Tangent delta[DEG];
+    knotDeltas<T, GroupT>(sKnots, delta);
+
+    evaluateLieDeltas<T, GroupT>(sKnots[0], delta, coeff, dcoeff, ddcoeff,
+                                 dddcoeff, transform_out, vel_out, accel_out,
+                                 jerk_out);
+  }
+
+  /// @brief Evaluate Lie group cummulative B-spline and time derivatives at
+  /// several times within the same knot window.
+  ///
+  /// Equivalent to calling \ref evaluate_lie for every element of u, but the
+  /// logarithms between consecutive knots are computed only once. Use this in
+  /// cost functions that combine all residuals depending on the same N knots
+  /// (see \ref groupByKnotWindow).
+  ///
+  /// @param[in] sKnots array of pointers of the spline knots
+  /// @param[in] u normalized times to compute the value of the spline
+  /// @param[in] num number of elements in u
+  /// @param[in] inv_dt inverse of the time spacing in seconds between spline
+  /// knots
+  /// @param[out] transform_out if not nullptr return num values of the spline
+  /// @param[out] vel_out if not nullptr return num velocities in the body frame
+  /// @param[out] accel_out if not nullptr return num accelerations in the body
+  /// frame
+  /// @param[out] jerk_out if not nullptr return num jerks in the body frame
+  template <class T, template <class> class GroupT>
+  static inline void evaluate_lie_batch(
+      T const* const* sKnots, const double* u, size_t num, const double inv_dt,
+      GroupT<T>* transform_out = nullptr,
+      typename GroupT<T>::Tangent* vel_out = nullptr,
+      typename GroupT<T>::Tangent* accel_out = nullptr,
+      typename GroupT<T>::Tangent* jerk_out = nullptr) {
+    using Tangent = typename GroupT<T>::Tangent;
+
+    Tangent delta[DEG];
+    knotDeltas<T, GroupT>(sKnots, delta);
+
+    const bool need_vel = vel_out || accel_out || jerk_out;
+    const bool need_accel = accel_out || jerk_out;
+
+    VecN coeff, dcoeff, ddcoeff, dddcoeff;
+    for (size_t k = 0; k < num; k++) {
+      SplineBlending<N, double, true, 0>::evaluate(coeff, u[k], 1);
+      if (need_vel) {
+        SplineBlending<N, double, true, 1>::evaluate(dcoeff, u[k], inv_dt);
+      }
+      if (need_accel) {
+        SplineBlending<N, double, true, 2>::evaluate(ddcoeff, u[k],
+                                                     inv_dt * inv_dt);
+      }
+      if (jerk_out) {
+        SplineBlending<N, double, true, 3>::evaluate(
+            dddcoeff, u[k], inv_dt * inv_dt * inv_dt);
+      }
+
+      evaluateLieDeltas<T, GroupT>(
+          sKnots[0], delta, coeff, dcoeff, ddcoeff, dddcoeff,
+          transform_out ? transform_out + k : nullptr,
+          vel_out ? vel_out + k : nullptr, accel_out ? accel_out + k : nullptr,
+          jerk_out ? jerk_out + k : nullptr);
+    }
+  }
+
+  /// @brief Logarithms between consecutive knots of a Lie group spline.
+  ///
+  /// @param[in] sKnots array of pointers of the N spline knots
+  /// @param[out] deltas \f$ \log(T_{i}^{-1}T_{i+1}) \f$ for i = 0, ..., N-2
+  template <class T, template <class> class GroupT>
+  static inline void knotDeltas(T const* const* sKnots,
+                                typename GroupT<T>::Tangent* deltas) {
+    using Group = GroupT<T>;
+
+    for (int i = 0; i < DEG; i++) {
+      Eigen::Map<Group const> const p0(sKnots[i]);
+      Eigen::Map<Group const> const p1(sKnots[i + 1]);
+
+      Group r01 = p0.inverse() * p1;
+      deltas[i] = r01.log();
+    }
+  }
+
+  /// @brief Evaluate Lie group cummulative B-spline from precomputed knot
+  /// logarithms (see \ref knotDeltas) and blending coefficients.
+  template <class T, template <class> class GroupT>
+  static inline void evaluateLieDeltas(
+      T const* knot0, typename GroupT<T>::Tangent const* deltas,
+      const VecN& coeff, const VecN& dcoeff, const VecN& ddcoeff,
+      const VecN& dddcoeff, GroupT<T>* transform_out,
+      typename GroupT<T>::Tangent* vel_out,
+      typename GroupT<T>::Tangent* accel_out,
+      typename GroupT<T>::Tangent* jerk_out) {
+    using Group = GroupT<T>;
+    using Tangent = typename GroupT<T>::Tangent;
+    using Adjoint = typename GroupT<T>::Adjoint;
+
     if (transform_out) {
-      Eigen::Map<Group const> const p00(sKnots[0]);
+      Eigen::Map<Group const> const p00(knot0);
       *transform_out = p00;
     }
 
@@ -145,11 +252,7 @@ struct CeresSplineHelper {
     if (jerk_out) rot_jerk.setZero();
 
     for (int i = 0; i < DEG; i++) {
-      Eigen::Map<Group const> const p0(sKnots[i]);
-      Eigen::Map<Group const> const p1(sKnots[i + 1]);
-
-      Group r01 = p0.inverse() * p1;
-      Tangent delta = r01.log();
+      const Tangent& delta = deltas[i];
 
       Group exp_kdelta = Group::exp(delta * coeff[i + 1]);
 
@@ -216,6 +319,88 @@ struct CeresSplineHelper {
       (*vec_out) += coeff[i] * p;
     }
   }
+
+  /// @brief Evaluate Euclidean B-spline or time derivatives at several times
+  /// within the same knot window. See \ref evaluate.
+  ///
+  /// @param[in] sKnots array of pointers of the spline knots. The size of each
+  /// knot should be DIM.
+  /// @param[in] u normalized times to compute the value of the spline
+  /// @param[in] num number of elements in u
+  /// @param[in] inv_dt inverse of the time spacing in seconds between spline
+  /// knots
+  /// @param[out] vec_out num values of the spline (DERIV=0) or corresponding
+  /// derivatives.
+  template <class T, int DIM, int DERIV>
+  static inline void evaluate_batch(T const* const* sKnots, const double* u,
+                                    size_t num, const double inv_dt,
+                                    Eigen::Matrix<T, DIM, 1>* vec_out) {
+    if (!vec_out) return;
+
+    using VecD = Eigen::Matrix<T, DIM, 1>;
+
+    const double scale = std::pow(inv_dt, DERIV);
+
+    VecN coeff;
+    for (size_t k = 0; k < num; k++) {
+      SplineBlending<N, double, false, DERIV>::evaluate(coeff, u[k], scale);
+
+      vec_out[k].setZero();
+      for (int i = 0; i < N; i++) {
+        Eigen::Map<VecD const> const p(sKnots[i]);
+
+        vec_out[k] += coeff[i] * p;
+      }
+    }
+  }
+
+  /// @brief Group residuals by the window of N knots they depend on.
+  ///
+  /// Residuals in the same group share all parameter blocks and can be
+  /// evaluated together in one cost function with \ref evaluate_lie_batch and
+  /// \ref evaluate_batch, which computes the knot logarithms once per group
+  /// instead of once per residual. With one cost function per group the
+  /// multi-threaded evaluator of the solver parallelizes over the groups.
+  ///
+  /// @param[in] time_ns times of the residuals in nanoseconds, not
+  /// necessarily sorted
+  /// @param[in] start_t_ns start time of the spline in nanoseconds
+  /// @param[in] dt_ns knot interval in nanoseconds
+  /// @param[in] num_knots number of knots in the spline
+  /// @param[out] groups residual groups ordered by start_idx
+  static inline void groupByKnotWindow(
+      const std::vector<int64_t>& time_ns, int64_t start_t_ns, int64_t dt_ns,
+      size_t num_knots, std::vector<CeresSplineResidualGroup>& groups) {
+    std::vector<size_t> order(time_ns.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return time_ns[a] < time_ns[b];
+    });
+
+    groups.clear();
+    for (size_t idx : order) {
+      int64_t st_ns = time_ns[idx] - start_t_ns;
+
+      BASALT_ASSERT_STREAM(st_ns >= 0, "st_ns " << st_ns << " time_ns "
+                                                << time_ns[idx]
+                                                << " start_t_ns "
+                                                << start_t_ns);
+
+      int64_t s = st_ns / dt_ns;
+      double u = double(st_ns % dt_ns) / double(dt_ns);
+
+      BASALT_ASSERT_STREAM(
+          size_t(s + N) <= num_knots,
+          "s " << s << " N " << N << " knots.size() " << num_knots);
+
+      if (groups.empty() || groups.back().start_idx != s) {
+        groups.emplace_back();
+        groups.back().start_idx = s;
+      }
+      groups.back().indices.emplace_back(idx);
+      groups.back().u.emplace_back(u);
+    }
+  }
 };
 
 template <int _N>
@@ -40,11 +40,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <basalt/spline/spline_common.h>
 #include <basalt/utils/assert.h>
+#include <basalt/utils/instrumentation.h>
+#include <basalt/utils/ring_buffer.h>
 #include <basalt/utils/sophus_utils.hpp>
 
 #include <Eigen/Dense>
 
+#include <algorithm>
 #include <array>
+#include <vector>
 
 namespace basalt {
 
@@ -92,8 +96,14 @@ namespace basalt {
 /// vector values for knots \f$ p_{i} \f$. The corresponding derivative vector
 /// on the right is computed using \ref baseCoeffsWithTime.
 ///
+/// The knots are stored in an Eigen::aligned_deque by default. For
+/// sliding-window use \ref RingBuffer can be passed as _KnotStorage to keep
+/// all knots in one contiguous, cache line aligned allocation with O(1)
+/// \ref knotsPushBack and \ref knotsPopFront.
+///
 /// See [[arXiv:1911.08860]](https://arxiv.org/abs/1911.08860) for more details.
-template <int _DIM, int _N, typename _Scalar = double>
+template <int _DIM, int _N, typename _Scalar = double,
+          template <class> class _KnotStorage = Eigen::aligned_deque>
 class RdSpline {
  public:
   static constexpr int N = _N;        ///< Order of the spline.
@@ -121,6 +131,18 @@ class RdSpline {
     std::array<_Scalar, N> d_val_d_knot;  ///< Value of nonzero Jacobians.
   };
 
+  /// @brief Struct to store the Jacobians of a batch evaluation
+  ///
+  /// Instead of one \ref JacobianStruct per query the Jacobians are stored
+  /// grouped by segment: for the queries k in [begin, end) of a segment the
+  /// column k of d_val_d_knot holds the Jacobians with respect to the knots
+  /// start_idx, ..., start_idx + N - 1 of that segment.
+  struct BatchJacobianStruct {
+    std::vector<SplineSegmentRange> segments;  ///< Queries grouped by segment
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>
+        d_val_d_knot;  ///< Nonzero Jacobians, one column per query.
+  };
+
   /// @brief Default constructor
   RdSpline() = default;
 
@@ -140,8 +162,8 @@ class RdSpline {
 
   /// @brief Cast to different scalar type
   template <typename Scalar2>
-  inline RdSpline<_DIM, _N, Scalar2> cast() const {
-    RdSpline<_DIM, _N, Scalar2> res;
+  inline RdSpline<_DIM, _N, Scalar2, _KnotStorage> cast() const {
+    RdSpline<_DIM, _N, Scalar2, _KnotStorage> res;
 
     res.dt_ns_ = dt_ns_;
     res.start_t_ns_ = start_t_ns_;
@@ -234,10 +256,10 @@ class RdSpline {
   /// @return const reference to the knot
   inline const VecD& getKnot(int i) const { return knots_[i]; }
 
-  /// @brief Return const reference to deque with knots
+  /// @brief Return const reference to the container with knots
   ///
-  /// @return const reference to deque with knots
-  const Eigen::aligned_deque<VecD>& getKnots() const { return knots_; }
+  /// @return const reference to the container with knots
+  const _KnotStorage<VecD>& getKnots() const { return knots_; }
 
   /// @brief Return time interval in nanoseconds
   ///
@@ -267,10 +289,8 @@ class RdSpline {
         size_t(s + N) <= knots_.size(),
         "s " << s << " N " << N << " knots.size() " << knots_.size());
 
-    VecN p;
-    baseCoeffsWithTime<Derivative>(p, u);
-
-    VecN coeff = pow_inv_dt_[Derivative] * (BLENDING_MATRIX * p);
+    VecN coeff;
+    blendingCoeffs<Derivative>(coeff, u);
 
     // std::cerr << "p " << p.transpose() << std::endl;
     // std::cerr << "coeff " << coeff.transpose() << std::endl;
@@ -303,6 +323,170 @@ class RdSpline {
     return evaluate<2>(time_ns, J);
   }
 
+  /// @brief Evaluate value or derivative of the spline at many timestamps
+  ///
+  /// Groups the queries by segment, computes the blending coefficients of
+  /// every query with \ref splineBlendingCoeffsBatch and evaluates the queries
+  /// segment by segment, so the knots of a segment are looked up only once.
+  /// Results match \ref evaluate up to floating point rounding.
+  ///
+  /// @param Derivative derivative to evaluate (0 for value)
+  /// @param[in] time_ns timestamps in nanoseconds sorted in non-decreasing
+  /// order
+  /// @param[out] res values of the spline or derivative, one per timestamp
+  /// @param[out] J if not nullptr, return the Jacobians of the values with
+  /// respect to knots. The storage of J is reused between calls.
+  /// @param[in,out] ws if not nullptr, storage used when J is nullptr, see
+  /// \ref SplineBatchWorkspace. The Jacobians are the blending coefficients,
+  /// so with J the storage of J is used instead.
+  template <int Derivative = 0>
+  void evaluateBatch(const std::vector<int64_t>& time_ns,
+                     Eigen::aligned_vector<VecD>& res,
+                     BatchJacobianStruct* J = nullptr,
+                     SplineBatchWorkspace<_N, _Scalar>* ws = nullptr) const {
+    BASALT_INSTRUMENT_SCOPE("basalt::RdSpline::evaluateBatch");
+    BASALT_INSTRUMENT_COUNT("basalt::RdSpline::evaluateBatch queries",
+                            time_ns.size());
+
+    SplineBatchWorkspace<_N, _Scalar> tmp;
+    if (!ws) ws = &tmp;
+    std::vector<SplineSegmentRange>& segments =
+        J ? J->segments : ws->segments;
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& coeff =
+        J ? J->d_val_d_knot : ws->coeff;
+
+    splineSegmentsForTimes(time_ns, start_t_ns_, dt_ns_, knots_.size(), N,
+                           segments);
+    // the coefficients are zero for Derivative >= N
+    splineBlendingCoeffsBatch<_N, false, Derivative>(
+        time_ns, segments, start_t_ns_, dt_ns_,
+        pow_inv_dt_[std::min(Derivative, N - 1)], coeff);
+
+    res.resize(time_ns.size());
+
+    Eigen::Matrix<_Scalar, _DIM, _N> seg_knots;
+    for (const SplineSegmentRange& seg : segments) {
+      for (int i = 0; i < N; i++) {
+        seg_knots.col(i) = knots_[seg.start_idx + i];
+      }
+      for (size_t k = seg.begin; k < seg.end; k++) {
+        res[k].noalias() = seg_knots * coeff.col(k);
+      }
+    }
+  }
+
+  /// @brief Alias for first derivative of spline. See \ref evaluateBatch.
+  inline void velocityBatch(
+      const std::vector<int64_t>& time_ns, Eigen::aligned_vector<VecD>& res,
+      BatchJacobianStruct* J = nullptr,
+      SplineBatchWorkspace<_N, _Scalar>* ws = nullptr) const {
+    evaluateBatch<1>(time_ns, res, J, ws);
+  }
+
+  /// @brief Alias for second derivative of spline. See \ref evaluateBatch.
+  inline void accelerationBatch(
+      const std::vector<int64_t>& time_ns, Eigen::aligned_vector<VecD>& res,
+      BatchJacobianStruct* J = nullptr,
+      SplineBatchWorkspace<_N, _Scalar>* ws = nullptr) const {
+    evaluateBatch<2>(time_ns, res, J, ws);
+  }
+
+  /// @brief Cursor for repeated evaluation of the spline at increasing times
+  ///
+  /// Caches the current segment and pointers to its knots. Queries within the
+  /// same segment skip the segment lookup and moving to the next segment only
+  /// shifts the cached knots by one, so sampling the spline in time order
+  /// (e.g. at IMU rate) avoids the integer division and deque indexing of
+  /// \ref evaluate. Other queries, including going back in time, fall back to
+  /// a full lookup. Results are identical to \ref evaluate.
+  ///
+  /// The cursor keeps pointers to the knots of the spline and has to be
+  /// \ref reset after knots are added or removed.
+  class Cursor {
+   public:
+    /// @brief Create cursor for the spline. The spline has to outlive it.
+    explicit Cursor(const RdSpline& spline) : spline_(&spline) {}
+
+    /// @brief Drop cached segment, e.g. after the knots have changed.
+    inline void reset() { s_ = -1; }
+
+    /// @brief Evaluate value or derivative of the spline. See \ref
+    /// RdSpline::evaluate.
+    template <int Derivative = 0>
+    VecD evaluate(int64_t time_ns) {
+      const double u = seek(time_ns);
+
+      VecN coeff;
+      spline_->blendingCoeffs<Derivative>(coeff, u);
+
+      VecD res;
+      res.setZero();
+
+      for (int i = 0; i < N; i++) {
+        res += coeff[i] * *knots_[i];
+      }
+
+      return res;
+    }
+
+    /// @brief Alias for first derivative of spline. See \ref evaluate.
+    inline VecD velocity(int64_t time_ns) { return evaluate<1>(time_ns); }
+
+    /// @brief Alias for second derivative of spline. See \ref evaluate.
+    inline VecD acceleration(int64_t time_ns) { return evaluate<2>(time_ns); }
+
+    /// @brief Index of the first knot of the current segment, -1 if none.
+    inline int64_t segmentIndex() const { return s_; }
+
+   private:
+    /// @brief Move to the segment containing time_ns
+    ///
+    /// @return time since the start of the segment in units of the knot
+    /// interval
+    double seek(int64_t time_ns) {
+      const int64_t dt_ns = spline_->dt_ns_;
+      int64_t offset_ns = time_ns - seg_start_ns_;
+
+      if (s_ >= 0 && offset_ns >= dt_ns && offset_ns < 2 * dt_ns &&
+          size_t(s_ + 1 + N) <= spline_->knots_.size()) {
+        // next segment, shift the knots
+        s_++;
+        seg_start_ns_ += dt_ns;
+        offset_ns -= dt_ns;
+
+        for (int i = 0; i < N - 1; i++) knots_[i] = knots_[i + 1];
+        knots_[N - 1] = &spline_->knots_[s_ + N - 1];
+      } else if (s_ < 0 || offset_ns < 0 || offset_ns >= dt_ns) {
+        const int64_t st_ns = time_ns - spline_->start_t_ns_;
+
+        BASALT_ASSERT_STREAM(st_ns >= 0, "st_ns " << st_ns << " time_ns "
+                                                  << time_ns << " start_t_ns "
+                                                  << spline_->start_t_ns_);
+
+        s_ = st_ns / dt_ns;
+        seg_start_ns_ = spline_->start_t_ns_ + s_ * dt_ns;
+        offset_ns = st_ns - s_ * dt_ns;
+
+        BASALT_ASSERT_STREAM(size_t(s_ + N) <= spline_->knots_.size(),
+                             "s " << s_ << " N " << N << " knots.size() "
+                                  << spline_->knots_.size());
+
+        for (int i = 0; i < N; i++) knots_[i] = &spline_->knots_[s_ + i];
+      }
+
+      return double(offset_ns) / double(dt_ns);
+    }
+
+    const RdSpline* spline_;            ///< Evaluated spline
+    int64_t s_{-1};                     ///< Index of the first segment knot
+    int64_t seg_start_ns_{0};           ///< Start time of the segment
+    std::array<const VecD*, N> knots_;  ///< Knots of the segment
+  };
+
+  /// @brief Create a cursor for evaluation at increasing times. See \ref
+  /// Cursor.
+  inline Cursor cursor() const { return Cursor(*this); }
+
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
  protected:
@@ -335,7 +519,25 @@ class RdSpline {
     }
   }
 
-  template <int, int, typename>
+  /// @brief Blending coefficients of the knots at time u. See \ref
+  /// SplineBlending.
+  ///
+  /// @param Derivative derivative to evaluate
+  /// @param[out] res coefficients of the N knots
+  /// @param[in] u time since the start of the segment in units of the knot
+  /// interval
+  template <int Derivative, class Derived>
+  inline void blendingCoeffs(const Eigen::MatrixBase<Derived>& res,
+                             _Scalar u) const {
+    if constexpr (Derivative < N) {
+      SplineBlending<_N, _Scalar, false, Derivative>::evaluate(
+          res, u, pow_inv_dt_[Derivative]);
+    } else {
+      SplineBlending<_N, _Scalar, false, Derivative>::evaluate(res, u, 0);
+    }
+  }
+
+  template <int, int, typename, template <class> class>
   friend class RdSpline;
 
   static const MatN
@@ -344,20 +546,22 @@ class RdSpline {
   static const MatN BASE_COEFFICIENTS;  ///< Base coefficients matrix.
                                         ///< See \ref computeBaseCoefficients.
 
-  Eigen::aligned_deque<VecD> knots_;    ///< Knots
+  _KnotStorage<VecD> knots_;            ///< Knots
   int64_t dt_ns_{0};                    ///< Knot interval in nanoseconds
   int64_t start_t_ns_{0};               ///< Start time in nanoseconds
   std::array<_Scalar, _N> pow_inv_dt_;  ///< Array with inverse powers of dt
 };
 
-template <int _DIM, int _N, typename _Scalar>
-const typename RdSpline<_DIM, _N, _Scalar>::MatN
-    RdSpline<_DIM, _N, _Scalar>::BASE_COEFFICIENTS =
+template <int _DIM, int _N, typename _Scalar,
+          template <class> class _KnotStorage>
+const typename RdSpline<_DIM, _N, _Scalar, _KnotStorage>::MatN
+    RdSpline<_DIM, _N, _Scalar, _KnotStorage>::BASE_COEFFICIENTS =
         computeBaseCoefficients<_N, _Scalar>();
 
-template <int _DIM, int _N, typename _Scalar>
-const typename RdSpline<_DIM, _N, _Scalar>::MatN
-    RdSpline<_DIM, _N, _Scalar>::BLENDING_MATRIX =
+template <int _DIM, int _N, typename _Scalar,
+          template <class> class _KnotStorage>
+const typename RdSpline<_DIM, _N, _Scalar, _KnotStorage>::MatN
+    RdSpline<_DIM, _N, _Scalar, _KnotStorage>::BLENDING_MATRIX =
         computeBlendingMatrix<_N, _Scalar, false>();
 
 }  // namespace basalt
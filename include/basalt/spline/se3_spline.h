@@ -41,10 +41,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <basalt/spline/rd_spline.h>
 #include <basalt/spline/so3_spline.h>
 #include <basalt/utils/assert.h>
+#include <basalt/utils/instrumentation.h>
 
 #include <basalt/calibration/calib_bias.hpp>
 
 #include <array>
+#include <vector>
 
 namespace basalt {
 
@@ -52,8 +54,12 @@ namespace basalt {
 /// So3Spline) spline for rotation and 3D Euclidean spline (\ref RdSpline) for
 /// translation (split representaion).
 ///
+/// The knot storage of both splines is selected with _KnotStorage, see \ref
+/// RdSpline.
+///
 /// See [[arXiv:1911.08860]](https://arxiv.org/abs/1911.08860) for more details.
-template <int _N, typename _Scalar = double>
+template <int _N, typename _Scalar = double,
+          template <class> class _KnotStorage = Eigen::aligned_deque>
 class Se3Spline {
  public:
   static constexpr int N = _N;        ///< Order of the spline.
@@ -82,8 +88,13 @@ class Se3Spline {
   using SO3 = Sophus::SO3<_Scalar>;
   using SE3 = Sophus::SE3<_Scalar>;
 
-  using PosJacobianStruct = typename RdSpline<3, N, _Scalar>::JacobianStruct;
-  using SO3JacobianStruct = typename So3Spline<N, _Scalar>::JacobianStruct;
+  using PosSpline = RdSpline<3, _N, _Scalar, _KnotStorage>;
+  using RotSpline = So3Spline<_N, _Scalar, _KnotStorage>;
+
+  using PosJacobianStruct = typename PosSpline::JacobianStruct;
+  using SO3JacobianStruct = typename RotSpline::JacobianStruct;
+  using PosBatchJacobianStruct = typename PosSpline::BatchJacobianStruct;
+  using SO3BatchJacobianStruct = typename RotSpline::BatchJacobianStruct;
 
   /// @brief Struct to store the accelerometer residual Jacobian with
   /// respect to knots
@@ -98,6 +109,26 @@ class Se3Spline {
     std::array<Mat6, N> d_val_d_knot;
   };
 
+  /// @brief Struct to store the pose Jacobians of a batch evaluation grouped
+  /// by segment. For the queries k in [begin, end) of a segment the block
+  /// d_val_d_knot.block<6, 6>(0, 6 * (N * k + i)) holds the Jacobian with
+  /// respect to the knot start_idx + i of that segment.
+  struct PoseBatchJacobianStruct {
+    std::vector<SplineSegmentRange> segments;  ///< Queries grouped by segment
+    Eigen::Matrix<_Scalar, 6, Eigen::Dynamic>
+        d_val_d_knot;  ///< Nonzero Jacobians, 6N columns per query.
+  };
+
+  /// @brief Intermediate results of \ref poseBatch. Passing the same
+  /// workspace to every call reuses its storage.
+  struct PoseBatchWorkspace {
+    Eigen::aligned_vector<SO3> rot;    ///< Rotations, one per query
+    Eigen::aligned_vector<Vec3> trans;  ///< Translations, one per query
+    SO3BatchJacobianStruct J_rot;       ///< Jacobians of the rotations
+    PosBatchJacobianStruct J_trans;     ///< Jacobians of the translations
+    SplineBatchWorkspace<_N, _Scalar> spline_ws;  ///< Coefficients, segments
+  };
+
   /// @brief Constructor with knot interval and start time
   ///
   /// @param[in] time_interval_ns knot time interval in nanoseconds
@@ -143,7 +174,7 @@ class Se3Spline {
   /// @brief Reset spline to the knots from other spline
   ///
   /// @param[in] other spline to copy knots from
-  void setKnots(const Se3Spline<N, _Scalar> &other) {
+  void setKnots(const Se3Spline &other) {
     BASALT_ASSERT(other.dt_ns_ == dt_ns_);
     BASALT_ASSERT(other.pos_spline_.getKnots().size() ==
                   other.pos_spline_.getKnots().size());
@@ -177,15 +208,15 @@ class Se3Spline {
   ///
   /// @return first knot of the spline
   inline SE3 knotsFront() const {
-    SE3 res(so3_spline_.knots_front(), pos_spline_.knots_front());
+    SE3 res(so3_spline_.knotsFront(), pos_spline_.knotsFront());
 
     return res;
   }
 
   /// @brief Remove first knot of the spline and increase the start time
   inline void knotsPopFront() {
-    so3_spline_.knots_pop_front();
-    pos_spline_.knots_pop_front();
+    so3_spline_.knotsPopFront();
+    pos_spline_.knotsPopFront();
 
     BASALT_ASSERT(so3_spline_.minTimeNs() == pos_spline_.minTimeNs());
     BASALT_ASSERT(so3_spline_.getKnots().size() ==
@@ -241,6 +272,27 @@ class Se3Spline {
     return pos_spline_.getKnot(i);
   }
 
+  /// @brief Return const reference to the position spline
+  inline const PosSpline &getPosSpline() const { return pos_spline_; }
+
+  /// @brief Return const reference to the orientation spline
+  inline const RotSpline &getRotSpline() const { return so3_spline_; }
+
+  /// @brief Enable or disable the cache of the rotational knot deltas for
+  /// sliding-window use, see \ref So3Spline::setKnotDeltaCache.
+  ///
+  /// Pose, gyroscope and accelerometer residuals with Jacobians then reuse
+  /// the logarithms and inverse Jacobians between consecutive SO(3) knots.
+  /// Appending knots computes one new delta, \ref applyInc invalidates the
+  /// two deltas of the knot and \ref updateKnotDeltaCache recomputes them.
+  inline void setKnotDeltaCache(bool enable) {
+    so3_spline_.setKnotDeltaCache(enable);
+  }
+
+  /// @brief Recompute the cached knot deltas invalidated by \ref applyInc,
+  /// see \ref So3Spline::updateKnotDeltaCache.
+  inline void updateKnotDeltaCache() { so3_spline_.updateKnotDeltaCache(); }
+
   /// @brief Set start time for spline
   ///
   /// @param[in] start_time_ns start time of the spline in nanoseconds
@@ -338,8 +390,8 @@ class Se3Spline {
   Sophus::SE3d pose(int64_t time_ns, PosePosSO3JacobianStruct *J) const {
     Sophus::SE3d res;
 
-    typename So3Spline<_N, _Scalar>::JacobianStruct Jr;
-    typename RdSpline<3, N, _Scalar>::JacobianStruct Jp;
+    typename RotSpline::JacobianStruct Jr;
+    typename PosSpline::JacobianStruct Jp;
 
     res.so3() = so3_spline_.evaluate(time_ns, &Jr);
     res.translation() = pos_spline_.evaluate(time_ns, &Jp);
@@ -360,6 +412,92 @@ class Se3Spline {
     return res;
   }
 
+  /// @brief Evaluate pose at many timestamps.
+  ///
+  /// Batch version of \ref pose, see \ref RdSpline::evaluateBatch and \ref
+  /// So3Spline::evaluateBatch.
+  ///
+  /// @param[in] time_ns timestamps in nanoseconds sorted in non-decreasing
+  /// order
+  /// @param[out] res SE(3) poses, one per timestamp
+  /// @param[out] J if not nullptr, return the Jacobians of the poses with
+  /// respect to knots. The storage of J is reused between calls.
+  inline void poseBatch(const std::vector<int64_t> &time_ns,
+                        Eigen::aligned_vector<SE3> &res,
+                        PoseBatchJacobianStruct *J = nullptr) const {
+    PoseBatchWorkspace ws;
+    poseBatch(time_ns, res, J, ws);
+  }
+
+  /// @brief Evaluate pose at many timestamps, see overload above.
+  ///
+  /// @param[in,out] ws intermediate results, the storage is reused between
+  /// calls so that repeated evaluations of the same number of timestamps do
+  /// not allocate
+  void poseBatch(const std::vector<int64_t> &time_ns,
+                 Eigen::aligned_vector<SE3> &res, PoseBatchJacobianStruct *J,
+                 PoseBatchWorkspace &ws) const {
+    BASALT_INSTRUMENT_SCOPE("basalt::Se3Spline::poseBatch");
+    BASALT_INSTRUMENT_COUNT("basalt::Se3Spline::poseBatch queries",
+                            time_ns.size());
+
+    if (J) {
+      so3_spline_.evaluateBatch(time_ns, ws.rot, &ws.J_rot, &ws.spline_ws);
+      pos_spline_.evaluateBatch(time_ns, ws.trans, &ws.J_trans);
+
+      J->segments = ws.J_rot.segments;
+      J->d_val_d_knot.resize(6, 6 * N * time_ns.size());
+
+      for (size_t k = 0; k < time_ns.size(); k++) {
+        Mat3 RT = ws.rot[k].inverse().matrix();
+
+        for (int i = 0; i < N; i++) {
+          auto J_i = J->d_val_d_knot.template block<6, 6>(0, 6 * (N * k + i));
+          J_i.template topLeftCorner<3, 3>() =
+              RT * ws.J_trans.d_val_d_knot(i, k);
+          J_i.template topRightCorner<3, 3>().setZero();
+          J_i.template bottomLeftCorner<3, 3>().setZero();
+          J_i.template bottomRightCorner<3, 3>() =
+              RT * ws.J_rot.d_val_d_knot.template block<3, 3>(
+                       0, 3 * (N * k + i));
+        }
+      }
+    } else {
+      so3_spline_.evaluateBatch(time_ns, ws.rot, nullptr, &ws.spline_ws);
+      pos_spline_.evaluateBatch(time_ns, ws.trans, nullptr, &ws.spline_ws);
+    }
+
+    res.resize(time_ns.size());
+    for (size_t k = 0; k < time_ns.size(); k++) {
+      res[k].so3() = ws.rot[k];
+      res[k].translation() = ws.trans[k];
+    }
+  }
+
+  /// @brief Linear acceleration in the world frame at many timestamps. See
+  /// \ref RdSpline::evaluateBatch.
+  inline void transAccelWorldBatch(const std::vector<int64_t> &time_ns,
+                                   Eigen::aligned_vector<Vec3> &res,
+                                   PosBatchJacobianStruct *J = nullptr) const {
+    pos_spline_.accelerationBatch(time_ns, res, J);
+  }
+
+  /// @brief Linear velocity in the world frame at many timestamps. See \ref
+  /// RdSpline::evaluateBatch.
+  inline void transVelWorldBatch(const std::vector<int64_t> &time_ns,
+                                 Eigen::aligned_vector<Vec3> &res,
+                                 PosBatchJacobianStruct *J = nullptr) const {
+    pos_spline_.velocityBatch(time_ns, res, J);
+  }
+
+  /// @brief Rotational velocity in the body frame at many timestamps. See
+  /// \ref So3Spline::velocityBodyBatch.
+  inline void rotVelBodyBatch(const std::vector<int64_t> &time_ns,
+                              Eigen::aligned_vector<Vec3> &res,
+                              SO3BatchJacobianStruct *J = nullptr) const {
+    so3_spline_.velocityBodyBatch(time_ns, res, J);
+  }
+
   /// @brief Evaluate pose and compute time Jacobian.
   ///
   /// @param[in] time_ns time to evaluate pose in nanoseconds
@@ -437,8 +575,8 @@ class Se3Spline {
                      const CalibAccelBias<_Scalar> &accel_bias_full,
                      const Vec3 &g, AccelPosSO3JacobianStruct *J_knots,
                      Mat39 *J_bias = nullptr, Mat3 *J_g = nullptr) const {
-    typename So3Spline<_N, _Scalar>::JacobianStruct Jr;
-    typename RdSpline<3, N, _Scalar>::JacobianStruct Jp;
+    typename RotSpline::JacobianStruct Jr;
+    typename PosSpline::JacobianStruct Jp;
 
     Sophus::SO3d R = so3_spline_.evaluate(time_ns, &Jr);
     Eigen::Vector3d accel_world = pos_spline_.acceleration(time_ns, &Jp);
@@ -540,11 +678,67 @@ class Se3Spline {
   /// @brief Knot time interval in nanoseconds.
   inline int64_t getDtNs() const { return dt_ns_; }
 
+  /// @brief Cursor for repeated evaluation of the spline at increasing times
+  ///
+  /// Combines the cursors of the position (\ref RdSpline::Cursor) and
+  /// orientation (\ref So3Spline::Cursor) splines, e.g. for sampling the
+  /// trajectory at IMU rate. Results are identical to the corresponding
+  /// functions of \ref Se3Spline. Has to be \ref reset after knots are
+  /// modified, added or removed.
+  class Cursor {
+   public:
+    /// @brief Create cursor for the spline. The spline has to outlive it.
+    explicit Cursor(const Se3Spline &spline)
+        : pos_(spline.pos_spline_), so3_(spline.so3_spline_) {}
+
+    /// @brief Drop cached segments, e.g. after the knots have changed.
+    inline void reset() {
+      pos_.reset();
+      so3_.reset();
+    }
+
+    /// @brief Evaluate pose. See \ref Se3Spline::pose.
+    SE3 pose(int64_t time_ns) {
+      SE3 res;
+
+      res.so3() = so3_.evaluate(time_ns);
+      res.translation() = pos_.evaluate(time_ns);
+
+      return res;
+    }
+
+    /// @brief Linear acceleration in the world frame. See \ref
+    /// Se3Spline::transAccelWorld.
+    inline Vec3 transAccelWorld(int64_t time_ns) {
+      return pos_.acceleration(time_ns);
+    }
+
+    /// @brief Linear velocity in the world frame. See \ref
+    /// Se3Spline::transVelWorld.
+    inline Vec3 transVelWorld(int64_t time_ns) {
+      return pos_.velocity(time_ns);
+    }
+
+    /// @brief Rotational velocity in the body frame. See \ref
+    /// Se3Spline::rotVelBody.
+    inline Vec3 rotVelBody(int64_t time_ns) {
+      return so3_.velocityBody(time_ns);
+    }
+
+   private:
+    typename PosSpline::Cursor pos_;  ///< Position cursor
+    typename RotSpline::Cursor so3_;  ///< Orientation cursor
+  };
+
+  /// @brief Create a cursor for evaluation at increasing times. See \ref
+  /// Cursor.
+  inline Cursor cursor() const { return Cursor(*this); }
+
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
  private:
-  RdSpline<3, _N, _Scalar> pos_spline_;  ///< Position spline
-  So3Spline<_N, _Scalar> so3_spline_;    ///< Orientation spline
+  PosSpline pos_spline_;  ///< Position spline
+  RotSpline so3_spline_;  ///< Orientation spline
 
   int64_t dt_ns_;  ///< Knot interval in nanoseconds
 };
@@ -40,12 +40,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <basalt/spline/spline_common.h>
 #include <basalt/utils/assert.h>
+#include <basalt/utils/instrumentation.h>
+#include <basalt/utils/ring_buffer.h>
 #include <basalt/utils/sophus_utils.hpp>
 
 #include <Eigen/Dense>
 #include <sophus/so3.hpp>
 
 #include <array>
+#include <vector>
 
 namespace basalt {
 
@@ -73,8 +76,14 @@ namespace basalt {
 ///    & -8 & 3 \\ 1 & 4 & 6 & 4 & -3 \\ 0 & 0 & 0 & 0 & 1 \end{pmatrix}.
 /// \f}
 ///
+/// The knots are stored in an Eigen::aligned_deque by default. For
+/// sliding-window use \ref RingBuffer can be passed as _KnotStorage to keep
+/// all knots in one contiguous, cache line aligned allocation with O(1)
+/// \ref knotsPushBack and \ref knotsPopFront.
+///
 /// See [[arXiv:1911.08860]](https://arxiv.org/abs/1911.08860) for more details.
-template <int _N, typename _Scalar = double>
+template <int _N, typename _Scalar = double,
+          template <class> class _KnotStorage = Eigen::aligned_deque>
 class So3Spline {
  public:
   static constexpr int N = _N;        ///< Order of the spline.
@@ -101,6 +110,18 @@ class So3Spline {
     std::array<Mat3, _N> d_val_d_knot;
   };
 
+  /// @brief Struct to store the Jacobians of a batch evaluation
+  ///
+  /// Instead of one \ref JacobianStruct per query the Jacobians are stored
+  /// grouped by segment: for the queries k in [begin, end) of a segment the
+  /// block d_val_d_knot.block<3, 3>(0, 3 * (N * k + i)) holds the Jacobian
+  /// with respect to the knot start_idx + i of that segment.
+  struct BatchJacobianStruct {
+    std::vector<SplineSegmentRange> segments;  ///< Queries grouped by segment
+    Eigen::Matrix<_Scalar, 3, Eigen::Dynamic>
+        d_val_d_knot;  ///< Nonzero Jacobians, 3N columns per query.
+  };
+
   /// @brief Constructor with knot interval and start time
   ///
   /// @param[in] time_interval_ns knot time interval in nanoseconds
@@ -149,6 +170,8 @@ class So3Spline {
         knots_.push_back(knots_.back() * SO3::exp(Vec3::Random() * M_PI / 2));
       }
     }
+
+    if (knot_delta_cache_enabled_) setKnotDeltaCache(true);
   }
 
   /// @brief Set start time for spline
@@ -159,10 +182,23 @@ class So3Spline {
   /// @brief Add knot to the end of the spline
   ///
   /// @param[in] knot knot to add
-  inline void knotsPushBack(const SO3& knot) { knots_.push_back(knot); }
+  inline void knotsPushBack(const SO3& knot) {
+    knots_.push_back(knot);
+
+    if (knot_delta_cache_enabled_ && knots_.size() >= 2) {
+      KnotDelta d;
+      computeKnotDelta(knots_.size() - 2, d, true);
+      knot_deltas_.push_back(d);
+    }
+  }
 
   /// @brief Remove knot from the back of the spline
-  inline void knotsPopBack() { knots_.pop_back(); }
+  inline void knotsPopBack() {
+    knots_.pop_back();
+    if (knot_deltas_.size() >= knots_.size() && !knot_deltas_.empty()) {
+      knot_deltas_.pop_back();
+    }
+  }
 
   /// @brief Return the first knot of the spline
   ///
@@ -171,20 +207,33 @@ class So3Spline {
 
   /// @brief Remove first knot of the spline and increase the start time
   inline void knotsPopFront() {
+    // indices of invalid deltas are shifted, so update them first
+    updateKnotDeltaCache();
+
     start_t_ns_ += dt_ns_;
     knots_.pop_front();
+    if (!knot_deltas_.empty()) knot_deltas_.pop_front();
   }
 
   /// @brief Resize containter with knots
   ///
   /// @param[in] n number of knots
-  inline void resize(size_t n) { knots_.resize(n); }
+  inline void resize(size_t n) {
+    knots_.resize(n);
+    if (knot_delta_cache_enabled_) setKnotDeltaCache(true);
+  }
 
   /// @brief Return reference to the knot with index i
   ///
+  /// The knot is expected to be modified, so cached knot deltas that depend
+  /// on it are invalidated (see \ref setKnotDeltaCache).
+  ///
   /// @param i index of the knot
   /// @return reference to the knot
-  inline SO3& getKnot(int i) { return knots_[i]; }
+  inline SO3& getKnot(int i) {
+    invalidateKnotDeltas(i);
+    return knots_[i];
+  }
 
   /// @brief Return const reference to the knot with index i
   ///
@@ -192,16 +241,78 @@ class So3Spline {
   /// @return const reference to the knot
   inline const SO3& getKnot(int i) const { return knots_[i]; }
 
-  /// @brief Return const reference to deque with knots
+  /// @brief Return const reference to the container with knots
   ///
-  /// @return const reference to deque with knots
-  const Eigen::aligned_deque<SO3>& getKnots() const { return knots_; }
+  /// @return const reference to the container with knots
+  const _KnotStorage<SO3>& getKnots() const { return knots_; }
 
   /// @brief Return time interval in nanoseconds
   ///
   /// @return time interval in nanoseconds
   int64_t getTimeIntervalNs() const { return dt_ns_; }
 
+  /// @brief Quantities that only depend on the two consecutive knots j and
+  /// j + 1, see \ref setKnotDeltaCache.
+  struct KnotDelta {
+    Vec3 delta;          ///< \f$ \log(R_j^{-1}R_{j+1}) \f$
+    Mat3 Jl_inv_R0_inv;  ///< Left Jacobian inverse of delta times R_j^{-1}
+    Mat3 Jr_inv_R1_inv;  ///< Right Jacobian inverse of delta times R_{j+1}^{-1}
+    bool valid = false;  ///< False if one of the knots was modified
+  };
+
+  /// @brief Enable or disable the cache of knot deltas.
+  ///
+  /// Every evaluation computes the logarithm between the consecutive knots of
+  /// its segment and, for Jacobians, the inverse Jacobians of these
+  /// logarithms. With the cache enabled they are stored per pair of knots and
+  /// reused by \ref evaluate, \ref velocityBody, \ref accelerationBody with
+  /// Jacobians, \ref evaluateBatch and \ref velocityBodyBatch. This pays off
+  /// in sliding-window estimation where the residuals of the same segments
+  /// are evaluated repeatedly:
+  ///   - \ref knotsPushBack computes the delta of the new pair of knots,
+  ///   \ref knotsPopFront and \ref knotsPopBack drop one.
+  ///   - Non-const \ref getKnot (and thus Se3Spline::applyInc) invalidates
+  ///   the two deltas that depend on the knot. Evaluations compute invalid
+  ///   deltas on the fly, \ref updateKnotDeltaCache recomputes only them.
+  ///
+  /// Results are the same as without cache up to floating point rounding.
+  /// The cache is not thread-safe with respect to modifications of the
+  /// knots, but concurrent const evaluations are fine.
+  ///
+  /// @param[in] enable if true, (re)compute deltas for all knots
+  void setKnotDeltaCache(bool enable) {
+    knot_delta_cache_enabled_ = enable;
+    invalid_knot_deltas_.clear();
+    knot_deltas_.clear();
+
+    if (!enable || knots_.size() < 2) return;
+
+    knot_deltas_.resize(knots_.size() - 1);
+    for (size_t j = 0; j + 1 < knots_.size(); j++) {
+      computeKnotDelta(j, knot_deltas_[j], true);
+    }
+  }
+
+  /// @brief Return true if the knot delta cache is enabled.
+  inline bool hasKnotDeltaCache() const { return knot_delta_cache_enabled_; }
+
+  /// @brief Recompute the cached knot deltas that were invalidated since the
+  /// last update.
+  void updateKnotDeltaCache() {
+    for (size_t j : invalid_knot_deltas_) {
+      if (j < knot_deltas_.size() && !knot_deltas_[j].valid) {
+        computeKnotDelta(j, knot_deltas_[j], true);
+      }
+    }
+    invalid_knot_deltas_.clear();
+  }
+
+  /// @brief Return true if the delta of knots j and j + 1 is cached and
+  /// valid.
+  inline bool isKnotDeltaValid(size_t j) const {
+    return j < knot_deltas_.size() && knot_deltas_[j].valid;
+  }
+
   /// @brief Evaluate SO(3) B-spline
   ///
   /// @param[in] time_ns time for evaluating the value of the spline in
@@ -223,10 +334,8 @@ class So3Spline {
         size_t(s + N) <= knots_.size(),
         "s " << s << " N " << N << " knots.size() " << knots_.size());
 
-    VecN p;
-    baseCoeffsWithTime<0>(p, u);
-
-    VecN coeff = BLENDING_MATRIX * p;
+    VecN coeff;
+    blendingCoeffs<0>(coeff, u);
 
     SO3 res = knots_[s];
 
@@ -237,24 +346,20 @@ class So3Spline {
       J_helper.setIdentity();
     }
 
+    KnotDelta tmp;
     for (int i = 0; i < DEG; i++) {
-      const SO3& p0 = knots_[s + i];
-      const SO3& p1 = knots_[s + i + 1];
-
-      SO3 r01 = p0.inverse() * p1;
-      Vec3 delta = r01.log();
+      const KnotDelta& d = knotDelta(s + i, tmp, J != nullptr);
+      const Vec3& delta = d.delta;
       Vec3 kdelta = delta * coeff[i + 1];
 
       if (J) {
-        Mat3 Jl_inv_delta;
         Mat3 Jl_k_delta;
 
-        Sophus::leftJacobianInvSO3(delta, Jl_inv_delta);
         Sophus::leftJacobianSO3(kdelta, Jl_k_delta);
 
         J->d_val_d_knot[i] = J_helper;
-        J_helper = coeff[i + 1] * res.matrix() * Jl_k_delta * Jl_inv_delta *
-                   p0.inverse().matrix();
+        J_helper =
+            coeff[i + 1] * res.matrix() * Jl_k_delta * d.Jl_inv_R0_inv;
         J->d_val_d_knot[i] -= J_helper;
       }
       res *= SO3::exp(kdelta);
@@ -326,22 +431,18 @@ class So3Spline {
         size_t(s + N) <= knots_.size(),
         "s " << s << " N " << N << " knots.size() " << knots_.size());
 
-    VecN p;
-    baseCoeffsWithTime<0>(p, u);
-    VecN coeff = BLENDING_MATRIX * p;
+    VecN coeff;
+    blendingCoeffs<0>(coeff, u);
 
-    baseCoeffsWithTime<1>(p, u);
-    VecN dcoeff = pow_inv_dt_[1] * BLENDING_MATRIX * p;
+    VecN dcoeff;
+    blendingCoeffs<1>(dcoeff, u);
 
     Vec3 rot_vel;
     rot_vel.setZero();
 
+    KnotDelta tmp;
     for (int i = 0; i < DEG; i++) {
-      const SO3& p0 = knots_[s + i];
-      const SO3& p1 = knots_[s + i + 1];
-
-      SO3 r01 = p0.inverse() * p1;
-      Vec3 delta = r01.log();
+      const Vec3& delta = knotDelta(s + i, tmp, false).delta;
 
       rot_vel = SO3::exp(-delta * coeff[i + 1]) * rot_vel;
       rot_vel += delta * dcoeff[i + 1];
@@ -372,12 +473,11 @@ class So3Spline {
         size_t(s + N) <= knots_.size(),
         "s " << s << " N " << N << " knots.size() " << knots_.size());
 
-    VecN p;
-    baseCoeffsWithTime<0>(p, u);
-    VecN coeff = BLENDING_MATRIX * p;
+    VecN coeff;
+    blendingCoeffs<0>(coeff, u);
 
-    baseCoeffsWithTime<1>(p, u);
-    VecN dcoeff = pow_inv_dt_[1] * BLENDING_MATRIX * p;
+    VecN dcoeff;
+    blendingCoeffs<1>(dcoeff, u);
 
     Vec3 delta_vec[DEG];
 
@@ -389,20 +489,15 @@ class So3Spline {
     Mat3 Jr_kdelta[DEG];
 
     for (int i = DEG - 1; i >= 0; i--) {
-      const SO3& p0 = knots_[s + i];
-      const SO3& p1 = knots_[s + i + 1];
-
-      SO3 r01 = p0.inverse() * p1;
-      delta_vec[i] = r01.log();
-
-      Sophus::rightJacobianInvSO3(delta_vec[i], Jr_delta_inv[i]);
-      Jr_delta_inv[i] *= p1.inverse().matrix();
+      KnotDelta tmp;
+      const KnotDelta& d = knotDelta(s + i, tmp, true);
+      delta_vec[i] = d.delta;
+      Jr_delta_inv[i] = d.Jr_inv_R1_inv;
 
       Vec3 k_delta = coeff[i + 1] * delta_vec[i];
-      Sophus::rightJacobianSO3(-k_delta, Jr_kdelta[i]);
 
       R_tmp[i] = accum.matrix();
-      exp_k_delta[i] = Sophus::SO3d::exp(-k_delta);
+      exp_k_delta[i] = Sophus::expAndRightJacobianSO3(-k_delta, Jr_kdelta[i]);
       accum *= exp_k_delta[i];
     }
 
@@ -455,15 +550,14 @@ class So3Spline {
         size_t(s + N) <= knots_.size(),
         "s " << s << " N " << N << " knots.size() " << knots_.size());
 
-    VecN p;
-    baseCoeffsWithTime<0>(p, u);
-    VecN coeff = BLENDING_MATRIX * p;
+    VecN coeff;
+    blendingCoeffs<0>(coeff, u);
 
-    baseCoeffsWithTime<1>(p, u);
-    VecN dcoeff = pow_inv_dt_[1] * BLENDING_MATRIX * p;
+    VecN dcoeff;
+    blendingCoeffs<1>(dcoeff, u);
 
-    baseCoeffsWithTime<2>(p, u);
-    VecN ddcoeff = pow_inv_dt_[2] * BLENDING_MATRIX * p;
+    VecN ddcoeff;
+    blendingCoeffs<2>(ddcoeff, u);
 
     SO3 r_accum;
 
@@ -526,15 +620,14 @@ class So3Spline {
         size_t(s + N) <= knots_.size(),
         "s " << s << " N " << N << " knots.size() " << knots_.size());
 
-    VecN p;
-    baseCoeffsWithTime<0>(p, u);
-    VecN coeff = BLENDING_MATRIX * p;
+    VecN coeff;
+    blendingCoeffs<0>(coeff, u);
 
-    baseCoeffsWithTime<1>(p, u);
-    VecN dcoeff = pow_inv_dt_[1] * BLENDING_MATRIX * p;
+    VecN dcoeff;
+    blendingCoeffs<1>(dcoeff, u);
 
-    baseCoeffsWithTime<2>(p, u);
-    VecN ddcoeff = pow_inv_dt_[2] * BLENDING_MATRIX * p;
+    VecN ddcoeff;
+    blendingCoeffs<2>(ddcoeff, u);
 
     Vec3 delta_vec[DEG];
     Mat3 exp_k_delta[DEG];
@@ -551,19 +644,14 @@ class So3Spline {
     Vec3 rot_accel_arr[DEG];
 
     for (int i = 0; i < DEG; i++) {
-      const SO3& p0 = knots_[s + i];
-      const SO3& p1 = knots_[s + i + 1];
-
-      SO3 r01 = p0.inverse() * p1;
-      delta_vec[i] = r01.log();
-
-      Sophus::rightJacobianInvSO3(delta_vec[i], Jr_delta_inv[i]);
-      Jr_delta_inv[i] *= p1.inverse().matrix();
+      KnotDelta tmp;
+      const KnotDelta& d = knotDelta(s + i, tmp, true);
+      delta_vec[i] = d.delta;
+      Jr_delta_inv[i] = d.Jr_inv_R1_inv;
 
       Vec3 k_delta = coeff[i + 1] * delta_vec[i];
-      Sophus::rightJacobianSO3(-k_delta, Jr_kdelta[i]);
-
-      exp_k_delta[i] = Sophus::SO3d::exp(-k_delta).matrix();
+      exp_k_delta[i] =
+          Sophus::expAndRightJacobianSO3(-k_delta, Jr_kdelta[i]).matrix();
 
       rot_vel = exp_k_delta[i] * rot_vel;
       Vec3 vel_current = dcoeff[i + 1] * delta_vec[i];
@@ -678,18 +766,17 @@ class So3Spline {
         size_t(s + N) <= knots_.size(),
         "s " << s << " N " << N << " knots.size() " << knots_.size());
 
-    VecN p;
-    baseCoeffsWithTime<0>(p, u);
-    VecN coeff = BLENDING_MATRIX * p;
+    VecN coeff;
+    blendingCoeffs<0>(coeff, u);
 
-    baseCoeffsWithTime<1>(p, u);
-    VecN dcoeff = pow_inv_dt_[1] * BLENDING_MATRIX * p;
+    VecN dcoeff;
+    blendingCoeffs<1>(dcoeff, u);
 
-    baseCoeffsWithTime<2>(p, u);
-    VecN ddcoeff = pow_inv_dt_[2] * BLENDING_MATRIX * p;
+    VecN ddcoeff;
+    blendingCoeffs<2>(ddcoeff, u);
 
-    baseCoeffsWithTime<3>(p, u);
-    VecN dddcoeff = pow_inv_dt_[3] * BLENDING_MATRIX * p;
+    VecN dddcoeff;
+    blendingCoeffs<3>(dddcoeff, u);
 
     Vec3 rot_vel;
     rot_vel.setZero();
@@ -733,6 +820,430 @@ class So3Spline {
     return rot_jerk;
   }
 
+  /// @brief Evaluate SO(3) B-spline at many timestamps
+  ///
+  /// Groups the queries by segment, computes the blending coefficients of
+  /// every query with \ref splineBlendingCoeffsBatch and evaluates the queries
+  /// segment by segment. The logarithms between consecutive knots and, if
+  /// requested, the parts of the Jacobians that depend only on the knots are
+  /// computed once per segment. Results match \ref evaluate up to floating
+  /// point rounding.
+  ///
+  /// @param[in] time_ns timestamps in nanoseconds sorted in non-decreasing
+  /// order
+  /// @param[out] res values of the spline, one per timestamp
+  /// @param[out] J if not nullptr, return the Jacobians of the values with
+  /// respect to knots. The storage of J is reused between calls.
+  /// @param[in,out] ws if not nullptr, storage of the blending coefficients
+  /// (and of the segments if J is nullptr), see \ref SplineBatchWorkspace
+  void evaluateBatch(const std::vector<int64_t>& time_ns,
+                     Eigen::aligned_vector<SO3>& res,
+                     BatchJacobianStruct* J = nullptr,
+                     SplineBatchWorkspace<_N, _Scalar>* ws = nullptr) const {
+    BASALT_INSTRUMENT_SCOPE("basalt::So3Spline::evaluateBatch");
+    BASALT_INSTRUMENT_COUNT("basalt::So3Spline::evaluateBatch queries",
+                            time_ns.size());
+
+    SplineBatchWorkspace<_N, _Scalar> tmp;
+    if (!ws) ws = &tmp;
+    std::vector<SplineSegmentRange>& segments =
+        J ? J->segments : ws->segments;
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& coeff = ws->coeff;
+
+    splineSegmentsForTimes(time_ns, start_t_ns_, dt_ns_, knots_.size(), N,
+                           segments);
+
+    splineBlendingCoeffsBatch<_N, true, 0>(
+        time_ns, segments, start_t_ns_, dt_ns_, pow_inv_dt_[0], coeff);
+
+    res.resize(time_ns.size());
+    if (J) J->d_val_d_knot.resize(3, 3 * N * time_ns.size());
+
+    Vec3 delta[DEG];
+    Mat3 Jl_inv_delta_R0_inv[DEG];
+
+    for (const SplineSegmentRange& seg : segments) {
+      for (int i = 0; i < DEG; i++) {
+        KnotDelta tmp;
+        const KnotDelta& d = knotDelta(seg.start_idx + i, tmp, J != nullptr);
+        delta[i] = d.delta;
+        if (J) Jl_inv_delta_R0_inv[i] = d.Jl_inv_R0_inv;
+      }
+
+      for (size_t k = seg.begin; k < seg.end; k++) {
+        SO3 r = knots_[seg.start_idx];
+
+        Mat3 J_helper;
+        J_helper.setIdentity();
+
+        for (int i = 0; i < DEG; i++) {
+          Vec3 kdelta = delta[i] * coeff(i + 1, k);
+
+          if (J) {
+            Mat3 Jl_k_delta;
+            Sophus::leftJacobianSO3(kdelta, Jl_k_delta);
+
+            auto J_i = J->d_val_d_knot.template block<3, 3>(0, 3 * (N * k + i));
+            J_i = J_helper;
+            J_helper = coeff(i + 1, k) * r.matrix() * Jl_k_delta *
+                       Jl_inv_delta_R0_inv[i];
+            J_i -= J_helper;
+          }
+          r *= SO3::exp(kdelta);
+        }
+
+        if (J) {
+          J->d_val_d_knot.template block<3, 3>(0, 3 * (N * k + DEG)) =
+              J_helper;
+        }
+
+        res[k] = r;
+      }
+    }
+  }
+
+  /// @brief Evaluate rotational velocity in the body frame at many
+  /// timestamps
+  ///
+  /// Batch version of \ref velocityBody. The logarithms between consecutive
+  /// knots and, if requested, the parts of the Jacobians that depend only on
+  /// the knots are computed once per segment. Results match \ref
+  /// velocityBody up to floating point rounding.
+  ///
+  /// @param[in] time_ns timestamps in nanoseconds sorted in non-decreasing
+  /// order
+  /// @param[out] res rotational velocities, one per timestamp
+  /// @param[out] J if not nullptr, return the Jacobians of the rotational
+  /// velocities with respect to knots. The storage of J is reused between
+  /// calls.
+  /// @param[in,out] ws if not nullptr, storage of the blending coefficients
+  /// (and of the segments if J is nullptr), see \ref SplineBatchWorkspace
+  void velocityBodyBatch(
+      const std::vector<int64_t>& time_ns, Eigen::aligned_vector<Vec3>& res,
+      BatchJacobianStruct* J = nullptr,
+      SplineBatchWorkspace<_N, _Scalar>* ws = nullptr) const {
+    BASALT_INSTRUMENT_SCOPE("basalt::So3Spline::velocityBodyBatch");
+    BASALT_INSTRUMENT_COUNT("basalt::So3Spline::velocityBodyBatch queries",
+                            time_ns.size());
+
+    SplineBatchWorkspace<_N, _Scalar> tmp;
+    if (!ws) ws = &tmp;
+    std::vector<SplineSegmentRange>& segments =
+        J ? J->segments : ws->segments;
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& coeff = ws->coeff;
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& dcoeff = ws->dcoeff;
+
+    splineSegmentsForTimes(time_ns, start_t_ns_, dt_ns_, knots_.size(), N,
+                           segments);
+
+    splineBlendingCoeffsBatch<_N, true, 0>(
+        time_ns, segments, start_t_ns_, dt_ns_, pow_inv_dt_[0], coeff);
+    splineBlendingCoeffsBatch<_N, true, 1>(
+        time_ns, segments, start_t_ns_, dt_ns_, pow_inv_dt_[1], dcoeff);
+
+    res.resize(time_ns.size());
+    if (J) J->d_val_d_knot.resize(3, 3 * N * time_ns.size());
+
+    Vec3 delta_vec[DEG];
+    Mat3 Jr_delta_inv[DEG];
+
+    for (const SplineSegmentRange& seg : segments) {
+      for (int i = 0; i < DEG; i++) {
+        KnotDelta tmp;
+        const KnotDelta& d = knotDelta(seg.start_idx + i, tmp, J != nullptr);
+        delta_vec[i] = d.delta;
+        if (J) Jr_delta_inv[i] = d.Jr_inv_R1_inv;
+      }
+
+      for (size_t k = seg.begin; k < seg.end; k++) {
+        if (!J) {
+          Vec3 rot_vel;
+          rot_vel.setZero();
+
+          for (int i = 0; i < DEG; i++) {
+            rot_vel = SO3::exp(-delta_vec[i] * coeff(i + 1, k)) * rot_vel;
+            rot_vel += delta_vec[i] * dcoeff(i + 1, k);
+          }
+
+          res[k] = rot_vel;
+          continue;
+        }
+
+        Mat3 R_tmp[DEG];
+        SO3 accum;
+        SO3 exp_k_delta[DEG];
+        Mat3 Jr_kdelta[DEG];
+
+        for (int i = DEG - 1; i >= 0; i--) {
+          Vec3 k_delta = coeff(i + 1, k) * delta_vec[i];
+
+          R_tmp[i] = accum.matrix();
+          exp_k_delta[i] =
+              Sophus::expAndRightJacobianSO3(-k_delta, Jr_kdelta[i]);
+          accum *= exp_k_delta[i];
+        }
+
+        auto J_k = J->d_val_d_knot.template block<3, 3 * N>(0, 3 * N * k);
+        J_k.setZero();
+
+        Mat3 d_vel_d_knot = dcoeff(1, k) * R_tmp[0] * Jr_delta_inv[0];
+        J_k.template block<3, 3>(0, 0) -= d_vel_d_knot;
+        J_k.template block<3, 3>(0, 3) += d_vel_d_knot;
+
+        Vec3 rot_vel = delta_vec[0] * dcoeff(1, k);
+        for (int i = 1; i < DEG; i++) {
+          d_vel_d_knot = (R_tmp[i - 1] * SO3::hat(rot_vel) * Jr_kdelta[i] *
+                              coeff(i + 1, k) +
+                          R_tmp[i] * dcoeff(i + 1, k)) *
+                         Jr_delta_inv[i];
+          J_k.template block<3, 3>(0, 3 * i) -= d_vel_d_knot;
+          J_k.template block<3, 3>(0, 3 * (i + 1)) += d_vel_d_knot;
+
+          rot_vel = exp_k_delta[i] * rot_vel + delta_vec[i] * dcoeff(i + 1, k);
+        }
+
+        res[k] = rot_vel;
+      }
+    }
+  }
+
+  /// @brief Evaluate rotational acceleration in the body frame at many
+  /// timestamps
+  ///
+  /// Batch version of \ref accelerationBody. The logarithms between
+  /// consecutive knots are computed once per segment. Results match \ref
+  /// accelerationBody up to floating point rounding.
+  ///
+  /// @param[in] time_ns timestamps in nanoseconds sorted in non-decreasing
+  /// order
+  /// @param[out] res rotational accelerations, one per timestamp
+  /// @param[out] vel_body if not nullptr, return the rotational velocities in
+  /// the body frame (side computation)
+  /// @param[in,out] ws if not nullptr, storage of the segments and blending
+  /// coefficients, see \ref SplineBatchWorkspace
+  void accelerationBodyBatch(
+      const std::vector<int64_t>& time_ns, Eigen::aligned_vector<Vec3>& res,
+      Eigen::aligned_vector<Vec3>* vel_body = nullptr,
+      SplineBatchWorkspace<_N, _Scalar>* ws = nullptr) const {
+    BASALT_INSTRUMENT_SCOPE("basalt::So3Spline::accelerationBodyBatch");
+    BASALT_INSTRUMENT_COUNT("basalt::So3Spline::accelerationBodyBatch queries",
+                            time_ns.size());
+
+    SplineBatchWorkspace<_N, _Scalar> tmp;
+    if (!ws) ws = &tmp;
+    std::vector<SplineSegmentRange>& segments = ws->segments;
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& coeff = ws->coeff;
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& dcoeff = ws->dcoeff;
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& ddcoeff = ws->ddcoeff;
+
+    splineSegmentsForTimes(time_ns, start_t_ns_, dt_ns_, knots_.size(), N,
+                           segments);
+
+    splineBlendingCoeffsBatch<_N, true, 0>(
+        time_ns, segments, start_t_ns_, dt_ns_, pow_inv_dt_[0], coeff);
+    splineBlendingCoeffsBatch<_N, true, 1>(
+        time_ns, segments, start_t_ns_, dt_ns_, pow_inv_dt_[1], dcoeff);
+    splineBlendingCoeffsBatch<_N, true, 2>(
+        time_ns, segments, start_t_ns_, dt_ns_, pow_inv_dt_[2], ddcoeff);
+
+    res.resize(time_ns.size());
+    if (vel_body) vel_body->resize(time_ns.size());
+
+    Vec3 delta[DEG];
+
+    for (const SplineSegmentRange& seg : segments) {
+      for (int i = 0; i < DEG; i++) {
+        const SO3& p0 = knots_[seg.start_idx + i];
+        const SO3& p1 = knots_[seg.start_idx + i + 1];
+
+        delta[i] = (p0.inverse() * p1).log();
+      }
+
+      for (size_t k = seg.begin; k < seg.end; k++) {
+        Vec3 rot_vel;
+        rot_vel.setZero();
+
+        Vec3 rot_accel;
+        rot_accel.setZero();
+
+        for (int i = 0; i < DEG; i++) {
+          SO3 rot = SO3::exp(-delta[i] * coeff(i + 1, k));
+
+          rot_vel = rot * rot_vel;
+          Vec3 vel_current = dcoeff(i + 1, k) * delta[i];
+          rot_vel += vel_current;
+
+          rot_accel = rot * rot_accel;
+          rot_accel +=
+              ddcoeff(i + 1, k) * delta[i] + rot_vel.cross(vel_current);
+        }
+
+        res[k] = rot_accel;
+        if (vel_body) (*vel_body)[k] = rot_vel;
+      }
+    }
+  }
+
+  /// @brief Cursor for repeated evaluation of the spline at increasing times
+  ///
+  /// Caches the current segment, pointers to its knots and the logarithms
+  /// \f$ \log(R_{i+j-1}^{-1}R_{i+j}) \f$ between consecutive knots. Queries
+  /// within the same segment only evaluate the blending coefficients and the
+  /// exponentials, moving to the next segment computes a single new
+  /// logarithm. Other queries, including going back in time, fall back to a
+  /// full lookup. Results are identical to the corresponding functions of
+  /// \ref So3Spline.
+  ///
+  /// The cursor caches values computed from the knots and has to be \ref
+  /// reset after knots are modified, added or removed.
+  class Cursor {
+   public:
+    /// @brief Create cursor for the spline. The spline has to outlive it.
+    explicit Cursor(const So3Spline& spline) : spline_(&spline) {}
+
+    /// @brief Drop cached segment, e.g. after the knots have changed.
+    inline void reset() { s_ = -1; }
+
+    /// @brief Evaluate SO(3) B-spline. See \ref So3Spline::evaluate.
+    SO3 evaluate(int64_t time_ns) {
+      const double u = seek(time_ns);
+
+      VecN coeff;
+      spline_->blendingCoeffs<0>(coeff, u);
+
+      SO3 res = *knots_[0];
+
+      for (int i = 0; i < DEG; i++) {
+        Vec3 kdelta = deltas_[i] * coeff[i + 1];
+        res *= SO3::exp(kdelta);
+      }
+
+      return res;
+    }
+
+    /// @brief Evaluate rotational velocity in the body frame. See \ref
+    /// So3Spline::velocityBody.
+    Vec3 velocityBody(int64_t time_ns) {
+      const double u = seek(time_ns);
+
+      VecN coeff;
+      spline_->blendingCoeffs<0>(coeff, u);
+
+      VecN dcoeff;
+      spline_->blendingCoeffs<1>(dcoeff, u);
+
+      Vec3 rot_vel;
+      rot_vel.setZero();
+
+      for (int i = 0; i < DEG; i++) {
+        const Vec3& delta = deltas_[i];
+
+        rot_vel = SO3::exp(-delta * coeff[i + 1]) * rot_vel;
+        rot_vel += delta * dcoeff[i + 1];
+      }
+
+      return rot_vel;
+    }
+
+    /// @brief Evaluate rotational acceleration in the body frame. See \ref
+    /// So3Spline::accelerationBody.
+    Vec3 accelerationBody(int64_t time_ns, Vec3* vel_body = nullptr) {
+      const double u = seek(time_ns);
+
+      VecN coeff;
+      spline_->blendingCoeffs<0>(coeff, u);
+
+      VecN dcoeff;
+      spline_->blendingCoeffs<1>(dcoeff, u);
+
+      VecN ddcoeff;
+      spline_->blendingCoeffs<2>(ddcoeff, u);
+
+      Vec3 rot_vel;
+      rot_vel.setZero();
+
+      Vec3 rot_accel;
+      rot_accel.setZero();
+
+      for (int i = 0; i < DEG; i++) {
+        const Vec3& delta = deltas_[i];
+
+        SO3 rot = SO3::exp(-delta * coeff[i + 1]);
+
+        rot_vel = rot * rot_vel;
+        Vec3 vel_current = dcoeff[i + 1] * delta;
+        rot_vel += vel_current;
+
+        rot_accel = rot * rot_accel;
+        rot_accel += ddcoeff[i + 1] * delta + rot_vel.cross(vel_current);
+      }
+
+      if (vel_body) {
+        *vel_body = rot_vel;
+      }
+      return rot_accel;
+    }
+
+    /// @brief Index of the first knot of the current segment, -1 if none.
+    inline int64_t segmentIndex() const { return s_; }
+
+   private:
+    /// @brief Move to the segment containing time_ns
+    ///
+    /// @return time since the start of the segment in units of the knot
+    /// interval
+    double seek(int64_t time_ns) {
+      const int64_t dt_ns = spline_->dt_ns_;
+      int64_t offset_ns = time_ns - seg_start_ns_;
+
+      if (s_ >= 0 && offset_ns >= dt_ns && offset_ns < 2 * dt_ns &&
+          size_t(s_ + 1 + N) <= spline_->knots_.size()) {
+        // next segment, shift the knots and logarithms
+        s_++;
+        seg_start_ns_ += dt_ns;
+        offset_ns -= dt_ns;
+
+        for (int i = 0; i < N - 1; i++) knots_[i] = knots_[i + 1];
+        knots_[N - 1] = &spline_->knots_[s_ + N - 1];
+
+        for (int i = 0; i < DEG - 1; i++) deltas_[i] = deltas_[i + 1];
+        deltas_[DEG - 1] = (knots_[N - 2]->inverse() * *knots_[N - 1]).log();
+      } else if (s_ < 0 || offset_ns < 0 || offset_ns >= dt_ns) {
+        const int64_t st_ns = time_ns - spline_->start_t_ns_;
+
+        BASALT_ASSERT_STREAM(st_ns >= 0, "st_ns " << st_ns << " time_ns "
+                                                  << time_ns << " start_t_ns "
+                                                  << spline_->start_t_ns_);
+
+        s_ = st_ns / dt_ns;
+        seg_start_ns_ = spline_->start_t_ns_ + s_ * dt_ns;
+        offset_ns = st_ns - s_ * dt_ns;
+
+        BASALT_ASSERT_STREAM(size_t(s_ + N) <= spline_->knots_.size(),
+                             "s " << s_ << " N " << N << " knots.size() "
+                                  << spline_->knots_.size());
+
+        for (int i = 0; i < N; i++) knots_[i] = &spline_->knots_[s_ + i];
+
+        for (int i = 0; i < DEG; i++) {
+          deltas_[i] = (knots_[i]->inverse() * *knots_[i + 1]).log();
+        }
+      }
+
+      return double(offset_ns) / double(dt_ns);
+    }
+
+    const So3Spline* spline_;          ///< Evaluated spline
+    int64_t s_{-1};                    ///< Index of the first segment knot
+    int64_t seg_start_ns_{0};          ///< Start time of the segment
+    std::array<const SO3*, N> knots_;  ///< Knots of the segment
+    std::array<Vec3, DEG> deltas_;     ///< Logarithms between the knots
+  };
+
+  /// @brief Create a cursor for evaluation at increasing times. See \ref
+  /// Cursor.
+  inline Cursor cursor() const { return Cursor(*this); }
+
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
  protected:
@@ -765,26 +1276,95 @@ class So3Spline {
     }
   }
 
+  /// @brief Cumulative blending coefficients of the knots at time u. See
+  /// \ref SplineBlending.
+  ///
+  /// @param Derivative derivative to evaluate (up to 3 and less than N)
+  /// @param[out] res coefficients of the N knots
+  /// @param[in] u time since the start of the segment in units of the knot
+  /// interval
+  template <int Derivative, class Derived>
+  inline void blendingCoeffs(const Eigen::MatrixBase<Derived>& res,
+                             _Scalar u) const {
+    static_assert(Derivative < 4, "derivative not supported");
+    static_assert(Derivative < N, "derivative must be less than the order");
+    SplineBlending<_N, _Scalar, true, Derivative>::evaluate(
+        res, u, pow_inv_dt_[Derivative]);
+  }
+
+  /// @brief Compute the delta of knots j and j + 1.
+  ///
+  /// @param[in] j index of the first knot
+  /// @param[out] d result, marked as valid if the Jacobians are computed
+  /// @param[in] with_jacobians if false, only the logarithm is computed
+  inline void computeKnotDelta(size_t j, KnotDelta& d,
+                               bool with_jacobians) const {
+    const SO3& p0 = knots_[j];
+    const SO3& p1 = knots_[j + 1];
+
+    const SO3 r01 = p0.inverse() * p1;
+
+    if (!with_jacobians) {
+      d.delta = r01.log();
+      d.valid = false;
+      return;
+    }
+
+    Sophus::logAndRightJacobianInvSO3(r01, d.delta, d.Jr_inv_R1_inv);
+    d.Jr_inv_R1_inv *= p1.inverse().matrix();
+
+    Sophus::leftJacobianInvSO3(d.delta, d.Jl_inv_R0_inv);
+    d.Jl_inv_R0_inv *= p0.inverse().matrix();
+
+    d.valid = true;
+  }
+
+  /// @brief Return the delta of knots j and j + 1 from the cache if it is
+  /// valid, otherwise compute it in tmp.
+  inline const KnotDelta& knotDelta(size_t j, KnotDelta& tmp,
+                                    bool with_jacobians) const {
+    if (j < knot_deltas_.size() && knot_deltas_[j].valid) {
+      return knot_deltas_[j];
+    }
+    computeKnotDelta(j, tmp, with_jacobians);
+    return tmp;
+  }
+
+  /// @brief Invalidate the cached deltas that depend on knot i.
+  inline void invalidateKnotDeltas(int i) {
+    for (int j = i - 1; j <= i; j++) {
+      if (j >= 0 && size_t(j) < knot_deltas_.size() &&
+          knot_deltas_[j].valid) {
+        knot_deltas_[j].valid = false;
+        invalid_knot_deltas_.push_back(j);
+      }
+    }
+  }
+
   static const MatN
       BLENDING_MATRIX;  ///< Blending matrix. See \ref computeBlendingMatrix.
 
   static const MatN BASE_COEFFICIENTS;  ///< Base coefficients matrix.
   ///< See \ref computeBaseCoefficients.
 
-  Eigen::aligned_deque<SO3> knots_;    ///< Knots
+  _KnotStorage<SO3> knots_;            ///< Knots
   int64_t dt_ns_;                      ///< Knot interval in nanoseconds
   int64_t start_t_ns_;                 ///< Start time in nanoseconds
   std::array<_Scalar, 4> pow_inv_dt_;  ///< Array with inverse powers of dt
+
+  bool knot_delta_cache_enabled_ = false;  ///< See \ref setKnotDeltaCache
+  _KnotStorage<KnotDelta> knot_deltas_;    ///< Deltas of consecutive knots
+  std::vector<size_t> invalid_knot_deltas_;  ///< Deltas to update
 };                                     // namespace basalt
 
-template <int _N, typename _Scalar>
-const typename So3Spline<_N, _Scalar>::MatN
-    So3Spline<_N, _Scalar>::BASE_COEFFICIENTS =
+template <int _N, typename _Scalar, template <class> class _KnotStorage>
+const typename So3Spline<_N, _Scalar, _KnotStorage>::MatN
+    So3Spline<_N, _Scalar, _KnotStorage>::BASE_COEFFICIENTS =
         computeBaseCoefficients<_N, _Scalar>();
 
-template <int _N, typename _Scalar>
-const typename So3Spline<_N, _Scalar>::MatN
-    So3Spline<_N, _Scalar>::BLENDING_MATRIX =
+template <int _N, typename _Scalar, template <class> class _KnotStorage>
+const typename So3Spline<_N, _Scalar, _KnotStorage>::MatN
+    So3Spline<_N, _Scalar, _KnotStorage>::BLENDING_MATRIX =
         computeBlendingMatrix<_N, _Scalar, true>();
 
 }  // namespace basalt
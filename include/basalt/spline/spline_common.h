@@ -38,8 +38,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <basalt/utils/assert.h>
+
 #include <Eigen/Dense>
+
+#include <array>
 #include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace basalt {
 
@@ -61,32 +67,52 @@ constexpr inline uint64_t binomialCoefficient(uint64_t n, uint64_t k) {
   return r;
 }
 
-/// @brief Compute blending matrix for uniform B-spline evaluation.
+/// @brief Integer power of a floating point number usable in constant
+/// expressions.
+///
+/// @param[in] base
+/// @param[in] exp non-negative exponent
+/// @return base to the power of exp
+constexpr inline double integerPower(double base, int exp) {
+  double res = 1;
+  for (int i = 0; i < exp; i++) {
+    res *= base;
+  }
+  return res;
+}
+
+/// @brief Row-major square matrix of fixed size usable in constant
+/// expressions.
+template <int _N>
+using ConstexprMatrix = std::array<std::array<double, _N>, _N>;
+
+/// @brief Compute blending matrix for uniform B-spline evaluation at compile
+/// time. See \ref computeBlendingMatrix.
 ///
 /// @param _N order of the spline
-/// @param _Scalar scalar type to use
 /// @param _Cumulative if the spline should be cumulative
-template <int _N, typename _Scalar = double, bool _Cumulative = false>
-Eigen::Matrix<_Scalar, _N, _N> computeBlendingMatrix() {
-  Eigen::Matrix<double, _N, _N> m;
-  m.setZero();
+template <int _N, bool _Cumulative = false>
+constexpr ConstexprMatrix<_N> computeBlendingMatrixConstexpr() {
+  ConstexprMatrix<_N> m{};
 
   for (int i = 0; i < _N; ++i) {
     for (int j = 0; j < _N; ++j) {
       double sum = 0;
 
       for (int s = j; s < _N; ++s) {
-        sum += std::pow(-1.0, s - j) * binomialCoefficient(_N, s - j) *
-               std::pow(_N - s - 1.0, _N - 1.0 - i);
+        sum += integerPower(-1.0, s - j) * binomialCoefficient(_N, s - j) *
+               integerPower(_N - s - 1.0, _N - 1 - i);
       }
-      m(j, i) = binomialCoefficient(_N - 1, _N - 1 - i) * sum;
+      m[j][i] = binomialCoefficient(_N - 1, _N - 1 - i) * sum;
     }
   }
 
   if (_Cumulative) {
     for (int i = 0; i < _N; i++) {
       for (int j = i + 1; j < _N; j++) {
-        m.row(i) += m.row(j);
+        for (int k = 0; k < _N; k++) {
+          m[i][k] += m[j][k];
+        }
       }
     }
   }
@@ -96,7 +122,56 @@ Eigen::Matrix<_Scalar, _N, _N> computeBlendingMatrix() {
     factorial *= i;
   }
 
-  return (m / factorial).template cast<_Scalar>();
+  for (int i = 0; i < _N; i++) {
+    for (int j = 0; j < _N; j++) {
+      m[i][j] /= factorial;
+    }
+  }
+
+  return m;
+}
+
+/// @brief Compute blending matrix for uniform B-spline evaluation.
+///
+/// @param _N order of the spline
+/// @param _Scalar scalar type to use
+/// @param _Cumulative if the spline should be cumulative
+template <int _N, typename _Scalar = double, bool _Cumulative = false>
+Eigen::Matrix<_Scalar, _N, _N> computeBlendingMatrix() {
+  constexpr ConstexprMatrix<_N> m =
+      computeBlendingMatrixConstexpr<_N, _Cumulative>();
+
+  Eigen::Matrix<_Scalar, _N, _N> res;
+  for (int i = 0; i < _N; i++) {
+    for (int j = 0; j < _N; j++) {
+      res(i, j) = _Scalar(m[i][j]);
+    }
+  }
+  return res;
+}
+
+/// @brief Compute base coefficient matrix for polynomials of size N at
+/// compile time. See \ref computeBaseCoefficients.
+///
+/// @param _N order of the polynomial
+template <int _N>
+constexpr ConstexprMatrix<_N> computeBaseCoefficientsConstexpr() {
+  ConstexprMatrix<_N> base_coefficients{};
+
+  for (int i = 0; i < _N; i++) {
+    base_coefficients[0][i] = 1;
+  }
+
+  constexpr int DEG = _N - 1;
+  int order = DEG;
+  for (int n = 1; n < _N; n++) {
+    for (int i = DEG - order; i < _N; i++) {
+      base_coefficients[n][i] =
+          (order - DEG + i) * base_coefficients[n - 1][i];
+    }
+    order--;
+  }
+  return base_coefficients;
 }
 
 /// @brief Compute base coefficient matrix for polynomials of size N.
@@ -118,20 +193,218 @@ Eigen::Matrix<_Scalar, _N, _N> computeBlendingMatrix() {
 /// @param _Scalar scalar type to use
 template <int _N, typename _Scalar = double>
 Eigen::Matrix<_Scalar, _N, _N> computeBaseCoefficients() {
-  Eigen::Matrix<double, _N, _N> base_coefficients;
+  constexpr ConstexprMatrix<_N> m = computeBaseCoefficientsConstexpr<_N>();
 
-  base_coefficients.setZero();
-  base_coefficients.row(0).setOnes();
+  Eigen::Matrix<_Scalar, _N, _N> res;
+  for (int i = 0; i < _N; i++) {
+    for (int j = 0; j < _N; j++) {
+      res(i, j) = _Scalar(m[i][j]);
+    }
+  }
+  return res;
+}
 
-  constexpr int DEG = _N - 1;
-  int order = DEG;
-  for (int n = 1; n < _N; n++) {
-    for (int i = DEG - order; i < _N; i++) {
-      base_coefficients(n, i) = (order - DEG + i) * base_coefficients(n - 1, i);
+/// @brief Fold blending matrix and base coefficients into one polynomial in
+/// \f$ u \f$ per knot at compile time. Element [i][k] is the coefficient of
+/// \f$ u^k \f$ in the blending coefficient of knot i.
+///
+/// @param _N order of the spline
+/// @param _Cumulative if the spline is cumulative
+/// @param _Derivative time derivative of the blending coefficients
+template <int _N, bool _Cumulative, int _Derivative>
+constexpr ConstexprMatrix<_N> computeBlendingPolynomials() {
+  constexpr ConstexprMatrix<_N> blending =
+      computeBlendingMatrixConstexpr<_N, _Cumulative>();
+  constexpr ConstexprMatrix<_N> base = computeBaseCoefficientsConstexpr<_N>();
+
+  ConstexprMatrix<_N> res{};
+  for (int i = 0; i < _N; i++) {
+    for (int k = 0; k + _Derivative < _N; k++) {
+      res[i][k] =
+          blending[i][k + _Derivative] * base[_Derivative][k + _Derivative];
+    }
+  }
+  return res;
+}
+
+/// @brief Blending coefficients of a uniform B-spline as polynomials in time
+///
+/// The coefficients of the knots for derivative _Derivative are
+/// \f$ \frac{1}{\Delta t^{d}} M \frac{d^d}{du^d}
+/// \begin{pmatrix} 1 & u & \dots & u^{N-1} \end{pmatrix}^T \f$ (see
+/// \ref RdSpline). The product of the blending matrix and the base
+/// coefficients is folded into one polynomial per knot at compile time and
+/// \ref evaluate computes all of them in Horner form with fully unrolled
+/// loops, so evaluating a spline of order N costs about N * (N - 1 -
+/// _Derivative) multiply-adds.
+///
+/// @param _N order of the spline
+/// @param _Scalar scalar type to use
+/// @param _Cumulative if the spline is cumulative
+/// @param _Derivative time derivative of the coefficients
+template <int _N, typename _Scalar, bool _Cumulative, int _Derivative>
+struct SplineBlending {
+  /// Number of coefficients of each polynomial.
+  static constexpr int NUM_POLY_COEFFS =
+      _Derivative < _N ? _N - _Derivative : 0;
+
+  /// Polynomial coefficients, POLY[i][k] is the coefficient of \f$ u^k \f$
+  /// for knot i.
+  static constexpr ConstexprMatrix<_N> POLY =
+      computeBlendingPolynomials<_N, _Cumulative, _Derivative>();
+
+  /// @brief Evaluate the blending coefficients
+  ///
+  /// @param[out] res_const coefficients of the N knots
+  /// @param[in] u time since the start of the segment in units of the knot
+  /// interval
+  /// @param[in] scale factor applied to the coefficients, e.g. \f$
+  /// \frac{1}{\Delta t^{d}} \f$. Ignored for _Derivative = 0.
+  template <class Derived>
+  static inline void evaluate(const Eigen::MatrixBase<Derived>& res_const,
+                              _Scalar u, _Scalar scale) {
+    EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived, _N);
+    Eigen::MatrixBase<Derived>& res =
+        const_cast<Eigen::MatrixBase<Derived>&>(res_const);
+
+    evaluateImpl(res, u, scale, std::make_integer_sequence<int, _N>());
+  }
+
+ private:
+  template <class Derived, int... I>
+  static inline void evaluateImpl(Eigen::MatrixBase<Derived>& res, _Scalar u,
+                                  _Scalar scale,
+                                  std::integer_sequence<int, I...>) {
+    if constexpr (_Derivative == 0) {
+      UNUSED(scale);
+      ((res[I] = horner<I>(u)), ...);
+    } else {
+      ((res[I] = scale * horner<I>(u)), ...);
+    }
+  }
+
+  template <int I>
+  static inline _Scalar horner(_Scalar u) {
+    if constexpr (NUM_POLY_COEFFS == 0) {
+      UNUSED(u);
+      return _Scalar(0);
+    } else {
+      return hornerImpl<I>(
+          u, std::make_integer_sequence<int, NUM_POLY_COEFFS - 1>());
+    }
+  }
+
+  template <int I, int... K>
+  static inline _Scalar hornerImpl(_Scalar u,
+                                   std::integer_sequence<int, K...>) {
+    UNUSED(u);  // unused for constant polynomials
+    _Scalar res = _Scalar(POLY[I][NUM_POLY_COEFFS - 1]);
+    ((res = res * u + _Scalar(POLY[I][NUM_POLY_COEFFS - 2 - K])), ...);
+    return res;
+  }
+};
+
+/// @brief Range of queries of a batch evaluation that fall into the same
+/// spline segment.
+struct SplineSegmentRange {
+  int64_t start_idx;  ///< Index of the first knot of the segment
+  size_t begin;       ///< Index of the first query in the segment
+  size_t end;         ///< One past the index of the last query in the segment
+};
+
+/// @brief Group sorted timestamps by the spline segment they fall into.
+///
+/// Used by the batch evaluation functions of \ref RdSpline, \ref So3Spline
+/// and \ref Se3Spline.
+/// @param[in] time_ns timestamps in nanoseconds sorted in non-decreasing order
+/// @param[in] start_t_ns start time of the spline in nanoseconds
+/// @param[in] dt_ns knot interval in nanoseconds
+/// @param[in] num_knots number of knots in the spline
+/// @param[in] order order of the spline
+/// @param[out] segments segments covering all timestamps in order
+inline void splineSegmentsForTimes(const std::vector<int64_t>& time_ns,
+                                   int64_t start_t_ns, int64_t dt_ns,
+                                   size_t num_knots, int order,
+                                   std::vector<SplineSegmentRange>& segments) {
+  segments.clear();
+
+  int64_t seg_end_ns = 0;
+  for (size_t k = 0; k < time_ns.size(); k++) {
+    if (!segments.empty()) {
+      BASALT_ASSERT_STREAM(time_ns[k] >= time_ns[k - 1],
+                           "timestamps not sorted: " << time_ns[k - 1] << " "
+                                                     << time_ns[k]);
+      if (time_ns[k] < seg_end_ns) continue;
+      segments.back().end = k;
+    }
+
+    int64_t st_ns = time_ns[k] - start_t_ns;
+
+    BASALT_ASSERT_STREAM(st_ns >= 0, "st_ns " << st_ns << " time_ns "
+                                              << time_ns[k] << " start_t_ns "
+                                              << start_t_ns);
+
+    int64_t s = st_ns / dt_ns;
+
+    BASALT_ASSERT_STREAM(
+        size_t(s + order) <= num_knots,
+        "s " << s << " N " << order << " knots.size() " << num_knots);
+
+    segments.push_back({s, k, k});
+    seg_end_ns = start_t_ns + (s + 1) * dt_ns;
+  }
+
+  if (!segments.empty()) segments.back().end = time_ns.size();
+}
+
+/// @brief Storage of a batch evaluation that is reused between calls.
+///
+/// Can be passed to the batch evaluation functions of \ref RdSpline and \ref
+/// So3Spline, so that repeated evaluations of the same number of timestamps
+/// do not allocate.
+template <int _N, typename _Scalar>
+struct SplineBatchWorkspace {
+  std::vector<SplineSegmentRange> segments;  ///< Queries grouped by segment
+  Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>
+      coeff;  ///< Blending coefficients, one column per query
+  Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>
+      dcoeff;  ///< First derivative of coeff, if needed
+  Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>
+      ddcoeff;  ///< Second derivative of coeff, if needed
+};
+
+/// @brief Blending coefficients for all queries of a batch evaluation.
+///
+/// Used by the batch evaluation functions of \ref RdSpline and \ref
+/// So3Spline, see \ref SplineBlending.
+/// @param _N order of the spline
+/// @param _Cumulative if the spline is cumulative
+/// @param _Derivative time derivative of the coefficients
+/// @param[in] time_ns timestamps of the queries in nanoseconds
+/// @param[in] segments queries grouped by segment, see \ref
+/// splineSegmentsForTimes
+/// @param[in] start_t_ns start time of the spline in nanoseconds
+/// @param[in] dt_ns knot interval in nanoseconds
+/// @param[in] scale factor applied to the coefficients, e.g. \f$
+/// \frac{1}{\Delta t^{d}} \f$. Ignored for _Derivative = 0.
+/// @param[out] coeff coefficients of the knots, one column per query. The
+/// storage is reused if the number of queries does not change.
+template <int _N, bool _Cumulative, int _Derivative, typename _Scalar>
+inline void splineBlendingCoeffsBatch(
+    const std::vector<int64_t>& time_ns,
+    const std::vector<SplineSegmentRange>& segments, int64_t start_t_ns,
+    int64_t dt_ns, _Scalar scale,
+    Eigen::Matrix<_Scalar, _N, Eigen::Dynamic>& coeff) {
+  coeff.resize(_N, time_ns.size());
+
+  for (const SplineSegmentRange& seg : segments) {
+    const int64_t seg_start_ns = start_t_ns + seg.start_idx * dt_ns;
+    for (size_t k = seg.begin; k < seg.end; k++) {
+      const double u = double(time_ns[k] - seg_start_ns) / double(dt_ns);
+      SplineBlending<_N, _Scalar, _Cumulative, _Derivative>::evaluate(
+          coeff.col(k), _Scalar(u), scale);
     }
-    order--;
   }
-  return base_coefficients.template cast<_Scalar>();
 }
 
 }  // namespace basalt
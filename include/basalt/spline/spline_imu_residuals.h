@@ -0,0 +1,418 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Batch evaluation of IMU residuals on a Se3Spline into normal equations
+*/
+
+#pragma once
+
+#include <basalt/imu/imu_types.h>
+#include <basalt/spline/se3_spline.h>
+#include <basalt/spline/spline_common.h>
+#include <basalt/utils/assert.h>
+#include <basalt/utils/instrumentation.h>
+#include <basalt/utils/parallel.h>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace basalt {
+
+/// @brief Gauss-Newton normal equations of the IMU residuals of a
+/// \ref Se3Spline, see \ref accumulateImuResiduals.
+///
+/// The parameters are the spline knots, 6 per knot ordered as [position,
+/// rotation] like in Se3Spline::AccelPosSO3JacobianStruct, followed by the
+/// calibration parameters [gyro bias (12), accel bias (9), gravity (3)].
+/// Every residual depends on N consecutive knots only, so the knot part of H
+/// is block-banded and stored as the blocks H(k, k + d) for d < N. The
+/// system covers the knots [start_idx, start_idx + numKnots()) of the spline.
+template <int _N, typename _Scalar = double>
+struct SplineImuLinearSystem {
+  static constexpr int N = _N;  ///< Order of the spline.
+
+  static constexpr int KNOT_SIZE = 6;
+  static constexpr int GYRO_BIAS_OFFSET = 0;
+  static constexpr int ACCEL_BIAS_OFFSET = 12;
+  static constexpr int GRAVITY_OFFSET = 21;
+  static constexpr int CALIB_SIZE = 24;
+
+  using Scalar = _Scalar;
+
+  using Mat6 = Eigen::Matrix<Scalar, KNOT_SIZE, KNOT_SIZE>;
+  using MatCalib = Eigen::Matrix<Scalar, CALIB_SIZE, CALIB_SIZE>;
+  using MatKnotCalib = Eigen::Matrix<Scalar, Eigen::Dynamic, CALIB_SIZE>;
+  using VecCalib = Eigen::Matrix<Scalar, CALIB_SIZE, 1>;
+  using MatX = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+  using VecX = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+  int64_t start_idx = 0;  ///< Index of the first knot in the system
+
+  /// Band of the knot part, H(k, k + d) is stored at index k * N + d
+  Eigen::aligned_vector<Mat6> H_knots;
+  MatKnotCalib H_knots_calib;  ///< Off-diagonal knot-calibration part
+  MatCalib H_calib;            ///< Calibration part
+  VecX b_knots;                ///< Knot part of the gradient
+  VecCalib b_calib;            ///< Calibration part of the gradient
+
+  Scalar error = 0;          ///< Sum of the weighted squared residuals
+  size_t num_residuals = 0;  ///< Number of accumulated measurements
+
+  /// @brief Resize to the given knot range and set everything to zero.
+  ///
+  /// @param[in] num_knots number of knots in the system
+  /// @param[in] start_knot_idx index of the first knot in the spline
+  void setZero(size_t num_knots, int64_t start_knot_idx = 0) {
+    start_idx = start_knot_idx;
+    H_knots.assign(num_knots * N, Mat6::Zero());
+    H_knots_calib.setZero(num_knots * KNOT_SIZE, CALIB_SIZE);
+    H_calib.setZero();
+    b_knots.setZero(num_knots * KNOT_SIZE);
+    b_calib.setZero();
+    error = 0;
+    num_residuals = 0;
+  }
+
+  /// @brief Number of knots in the system.
+  inline size_t numKnots() const { return H_knots.size() / N; }
+
+  /// @brief Add another system whose knots are a subrange of this one.
+  void add(const SplineImuLinearSystem &other) {
+    const int64_t offset = other.start_idx - start_idx;
+
+    BASALT_ASSERT_STREAM(
+        offset >= 0 && size_t(offset) + other.numKnots() <= numKnots(),
+        "offset " << offset << " other.numKnots() " << other.numKnots()
+                  << " numKnots() " << numKnots());
+
+    for (size_t i = 0; i < other.H_knots.size(); i++) {
+      H_knots[offset * N + i] += other.H_knots[i];
+    }
+
+    H_knots_calib.middleRows(offset * KNOT_SIZE, other.H_knots_calib.rows()) +=
+        other.H_knots_calib;
+    H_calib += other.H_calib;
+    b_knots.segment(offset * KNOT_SIZE, other.b_knots.size()) += other.b_knots;
+    b_calib += other.b_calib;
+    error += other.error;
+    num_residuals += other.num_residuals;
+  }
+
+  /// @brief Convert to dense H and b, with the knots followed by the
+  /// calibration parameters.
+  ///
+  /// @param[out] H full symmetric Hessian approximation
+  /// @param[out] b gradient
+  void toDense(MatX &H, VecX &b) const {
+    const int knot_dim = numKnots() * KNOT_SIZE;
+
+    H.setZero(knot_dim + CALIB_SIZE, knot_dim + CALIB_SIZE);
+    b.resize(knot_dim + CALIB_SIZE);
+
+    for (size_t k = 0; k < numKnots(); k++) {
+      for (int d = 0; d < N && k + d < numKnots(); d++) {
+        const Mat6 &Hkd = H_knots[k * N + d];
+        H.template block<KNOT_SIZE, KNOT_SIZE>(k * KNOT_SIZE,
+                                               (k + d) * KNOT_SIZE) = Hkd;
+        if (d > 0) {
+          H.template block<KNOT_SIZE, KNOT_SIZE>((k + d) * KNOT_SIZE,
+                                                 k * KNOT_SIZE) =
+              Hkd.transpose();
+        }
+      }
+    }
+
+    H.topRightCorner(knot_dim, CALIB_SIZE) = H_knots_calib;
+    H.bottomLeftCorner(CALIB_SIZE, knot_dim) = H_knots_calib.transpose();
+    H.template bottomRightCorner<CALIB_SIZE, CALIB_SIZE>() = H_calib;
+
+    b.head(knot_dim) = b_knots;
+    b.template tail<CALIB_SIZE>() = b_calib;
+  }
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/// @brief Accumulate the IMU residuals of the measurements in the spline
+/// segments [seg_begin, seg_end) into a system covering just their knots.
+///
+/// Helper of \ref accumulateImuResiduals, which documents the parameters.
+template <int N, typename Scalar, template <class> class KnotStorage>
+void accumulateImuResidualsSegments(
+    const Se3Spline<N, Scalar, KnotStorage> &spline,
+    const ImuData<Scalar> *data,
+    const std::vector<SplineSegmentRange> &segments, size_t seg_begin,
+    size_t seg_end, const CalibGyroBias<Scalar> &gyro_bias,
+    const CalibAccelBias<Scalar> &accel_bias,
+    const Eigen::Matrix<Scalar, 3, 1> &g, Scalar gyro_weight,
+    Scalar accel_weight, SplineImuLinearSystem<N, Scalar> &ls) {
+  using LinearSystem = SplineImuLinearSystem<N, Scalar>;
+  using SplineT = Se3Spline<N, Scalar, KnotStorage>;
+
+  static constexpr int KNOT_SIZE = LinearSystem::KNOT_SIZE;
+  static constexpr int CALIB_SIZE = LinearSystem::CALIB_SIZE;
+  static constexpr int SEG_KNOT_DIM = N * KNOT_SIZE;
+  static constexpr int SEG_DIM = SEG_KNOT_DIM + CALIB_SIZE;
+
+  using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+  using MatSeg = Eigen::Matrix<Scalar, SEG_DIM, SEG_DIM>;
+  using VecSeg = Eigen::Matrix<Scalar, SEG_DIM, 1>;
+  using Mat3Seg = Eigen::Matrix<Scalar, 3, SEG_DIM>;
+
+  const int64_t first_knot = segments[seg_begin].start_idx;
+  const int64_t last_knot = segments[seg_end - 1].start_idx + N;
+  ls.setZero(last_knot - first_knot, first_knot);
+
+  // The residuals of one segment depend on the same N knots, so they are
+  // accumulated into a small dense system that is added to the band once
+  // per segment.
+  MatSeg H_seg;
+  VecSeg b_seg;
+  Mat3Seg J;
+
+  typename SplineT::SO3JacobianStruct J_gyro_knots;
+  typename SplineT::AccelPosSO3JacobianStruct J_accel_knots;
+  typename SplineT::Mat312 J_gyro_bias;
+  typename SplineT::Mat39 J_accel_bias;
+  typename SplineT::Mat3 J_g;
+
+  for (size_t si = seg_begin; si < seg_end; si++) {
+    const SplineSegmentRange &seg = segments[si];
+
+    H_seg.setZero();
+    b_seg.setZero();
+
+    for (size_t k = seg.begin; k < seg.end; k++) {
+      const ImuData<Scalar> &d = data[k];
+
+      Vec3 r_gyro = spline.gyroResidual(d.t_ns, d.gyro, gyro_bias,
+                                        &J_gyro_knots, &J_gyro_bias);
+      J.setZero();
+      for (int i = 0; i < N; i++) {
+        J.template block<3, 3>(0, i * KNOT_SIZE + 3) =
+            J_gyro_knots.d_val_d_knot[i];
+      }
+      J.template block<3, 12>(
+          0, SEG_KNOT_DIM + LinearSystem::GYRO_BIAS_OFFSET) = J_gyro_bias;
+
+      H_seg.template selfadjointView<Eigen::Upper>().rankUpdate(
+          J.transpose(), gyro_weight);
+      b_seg.noalias() += J.transpose() * (gyro_weight * r_gyro);
+      ls.error += gyro_weight * r_gyro.squaredNorm();
+
+      Vec3 r_accel =
+          spline.accelResidual(d.t_ns, d.accel, accel_bias, g, &J_accel_knots,
+                               &J_accel_bias, &J_g);
+      J.setZero();
+      for (int i = 0; i < N; i++) {
+        J.template block<3, KNOT_SIZE>(0, i * KNOT_SIZE) =
+            J_accel_knots.d_val_d_knot[i];
+      }
+      J.template block<3, 9>(
+          0, SEG_KNOT_DIM + LinearSystem::ACCEL_BIAS_OFFSET) = J_accel_bias;
+      J.template block<3, 3>(0, SEG_KNOT_DIM + LinearSystem::GRAVITY_OFFSET) =
+          J_g;
+
+      H_seg.template selfadjointView<Eigen::Upper>().rankUpdate(
+          J.transpose(), accel_weight);
+      b_seg.noalias() += J.transpose() * (accel_weight * r_accel);
+      ls.error += accel_weight * r_accel.squaredNorm();
+    }
+
+    ls.num_residuals += seg.end - seg.begin;
+
+    H_seg.template triangularView<Eigen::StrictlyLower>() = H_seg.transpose();
+
+    const int64_t local_idx = seg.start_idx - first_knot;
+    for (int i = 0; i < N; i++) {
+      const int64_t row = (local_idx + i) * KNOT_SIZE;
+      for (int j = i; j < N; j++) {
+        ls.H_knots[(local_idx + i) * N + (j - i)] +=
+            H_seg.template block<KNOT_SIZE, KNOT_SIZE>(i * KNOT_SIZE,
+                                                       j * KNOT_SIZE);
+      }
+      ls.H_knots_calib.template middleRows<KNOT_SIZE>(row) +=
+          H_seg.template block<KNOT_SIZE, CALIB_SIZE>(i * KNOT_SIZE,
+                                                      SEG_KNOT_DIM);
+      ls.b_knots.template segment<KNOT_SIZE>(row) +=
+          b_seg.template segment<KNOT_SIZE>(i * KNOT_SIZE);
+    }
+    ls.H_calib += H_seg.template bottomRightCorner<CALIB_SIZE, CALIB_SIZE>();
+    ls.b_calib += b_seg.template tail<CALIB_SIZE>();
+  }
+}
+
+/// @brief Accumulate gyroscope and accelerometer residuals of a sequence of
+/// IMU measurements into the normal equations of the spline.
+///
+/// Evaluates \ref Se3Spline::gyroResidual and \ref Se3Spline::accelResidual
+/// with Jacobians for every measurement and adds
+/// \f$ w J^T J \f$ and \f$ w J^T r \f$ to H and b without materializing the
+/// Jacobian of all measurements. The measurements are grouped by spline
+/// segment, and the residuals of a segment are accumulated into a small dense
+/// system that is added to ls once per segment.
+///
+/// @param[in] spline spline to evaluate, with any knot storage
+/// @param[in] data measurements sorted by timestamp, all inside the time
+/// interval of the spline
+/// @param[in] num_data number of measurements
+/// @param[in] gyro_bias gyroscope calibration
+/// @param[in] accel_bias accelerometer calibration
+/// @param[in] g gravity in the world frame
+/// @param[in] gyro_weight weight (inverse variance) of the gyroscope residuals
+/// @param[in] accel_weight weight (inverse variance) of the accelerometer
+/// residuals
+/// @param[in,out] ls system covering all knots of the spline (see \ref
+/// SplineImuLinearSystem::setZero), the residuals are added to it
+template <int N, typename Scalar, template <class> class KnotStorage>
+void accumulateImuResiduals(const Se3Spline<N, Scalar, KnotStorage> &spline,
+                            const ImuData<Scalar> *data, size_t num_data,
+                            const CalibGyroBias<Scalar> &gyro_bias,
+                            const CalibAccelBias<Scalar> &accel_bias,
+                            const Eigen::Matrix<Scalar, 3, 1> &g,
+                            Scalar gyro_weight, Scalar accel_weight,
+                            SplineImuLinearSystem<N, Scalar> &ls) {
+  // without workers all chunks run on the calling thread
+  accumulateImuResiduals(
+      spline, data, num_data, gyro_bias, accel_bias, g, gyro_weight,
+      accel_weight, ls, [](std::function<void()> task) { task(); }, 0);
+}
+
+/// @brief Accumulate IMU residuals into the normal equations of the spline
+/// using a caller-supplied executor for parallelization.
+///
+/// The segments are split into num_workers + 1 contiguous chunks of about the
+/// same number of measurements, which are processed with \ref parallelFor by
+/// the calling thread and \p num_workers worker tasks passed to \p executor
+/// (see there for the requirements on the executor). Each chunk accumulates
+/// into a system covering only its knots, which are added to ls at the end,
+/// so the result does not depend on the number of workers (up to floating
+/// point summation order).
+///
+/// @param executor callable taking a std::function<void()> to run, e.g.
+/// submitting it to a thread pool
+/// @param num_workers number of tasks passed to the executor
+///
+/// See the overload without executor for the other parameters.
+template <int N, typename Scalar, template <class> class KnotStorage,
+          class Executor>
+void accumulateImuResiduals(const Se3Spline<N, Scalar, KnotStorage> &spline,
+                            const ImuData<Scalar> *data, size_t num_data,
+                            const CalibGyroBias<Scalar> &gyro_bias,
+                            const CalibAccelBias<Scalar> &accel_bias,
+                            const Eigen::Matrix<Scalar, 3, 1> &g,
+                            Scalar gyro_weight, Scalar accel_weight,
+                            SplineImuLinearSystem<N, Scalar> &ls,
+                            Executor &&executor, size_t num_workers) {
+  BASALT_INSTRUMENT_SCOPE("basalt::accumulateImuResiduals");
+  BASALT_INSTRUMENT_COUNT("basalt::accumulateImuResiduals measurements",
+                          num_data);
+
+  BASALT_ASSERT_STREAM(ls.start_idx == 0 && ls.numKnots() == spline.numKnots(),
+                       "ls.start_idx " << ls.start_idx << " ls.numKnots() "
+                                       << ls.numKnots() << " numKnots() "
+                                       << spline.numKnots());
+
+  if (num_data == 0) return;
+
+  std::vector<int64_t> time_ns(num_data);
+  for (size_t k = 0; k < num_data; k++) time_ns[k] = data[k].t_ns;
+
+  std::vector<SplineSegmentRange> segments;
+  splineSegmentsForTimes(time_ns, spline.minTimeNs(), spline.getDtNs(),
+                         spline.numKnots(), N, segments);
+
+  // Split the segments into chunks of about num_data / num_chunks
+  // measurements.
+  const size_t num_chunks = std::min(num_workers + 1, segments.size());
+  std::vector<size_t> chunk_begin{0};
+  for (size_t si = 0; si < segments.size(); si++) {
+    const size_t target = num_data * chunk_begin.size() / num_chunks;
+    if (chunk_begin.size() < num_chunks && segments[si].begin >= target &&
+        si > chunk_begin.back()) {
+      chunk_begin.push_back(si);
+    }
+  }
+  chunk_begin.push_back(segments.size());
+
+  const size_t num_used_chunks = chunk_begin.size() - 1;
+  Eigen::aligned_vector<SplineImuLinearSystem<N, Scalar>> chunk_ls(
+      num_used_chunks);
+
+  parallelFor(num_used_chunks, std::forward<Executor>(executor),
+              num_used_chunks - 1, [&](size_t c) {
+                accumulateImuResidualsSegments(
+                    spline, data, segments, chunk_begin[c], chunk_begin[c + 1],
+                    gyro_bias, accel_bias, g, gyro_weight, accel_weight,
+                    chunk_ls[c]);
+              });
+
+  for (const auto &cls : chunk_ls) ls.add(cls);
+}
+
+/// @brief Overload of \ref accumulateImuResiduals for a vector of
+/// measurements.
+template <int N, typename Scalar, template <class> class KnotStorage>
+inline void accumulateImuResiduals(
+    const Se3Spline<N, Scalar, KnotStorage> &spline,
+    const std::vector<ImuData<Scalar>> &data,
+    const CalibGyroBias<Scalar> &gyro_bias,
+    const CalibAccelBias<Scalar> &accel_bias,
+    const Eigen::Matrix<Scalar, 3, 1> &g, Scalar gyro_weight,
+    Scalar accel_weight, SplineImuLinearSystem<N, Scalar> &ls) {
+  accumulateImuResiduals(spline, data.data(), data.size(), gyro_bias,
+                         accel_bias, g, gyro_weight, accel_weight, ls);
+}
+
+/// @brief Overload of \ref accumulateImuResiduals with executor for a vector
+/// of measurements.
+template <int N, typename Scalar, template <class> class KnotStorage,
+          class Executor>
+inline void accumulateImuResiduals(
+    const Se3Spline<N, Scalar, KnotStorage> &spline,
+    const std::vector<ImuData<Scalar>> &data,
+    const CalibGyroBias<Scalar> &gyro_bias,
+    const CalibAccelBias<Scalar> &accel_bias,
+    const Eigen::Matrix<Scalar, 3, 1> &g, Scalar gyro_weight,
+    Scalar accel_weight, SplineImuLinearSystem<N, Scalar> &ls,
+    Executor &&executor, size_t num_workers) {
+  accumulateImuResiduals(spline, data.data(), data.size(), gyro_bias,
+                         accel_bias, g, gyro_weight, accel_weight, ls,
+                         std::forward<Executor>(executor), num_workers);
+}
+
+}  // namespace basalt
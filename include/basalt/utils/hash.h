@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <type_traits>
+
+#include <Eigen/Core>
 
 namespace basalt {
 
@@ -23,4 +27,33 @@ inline void hash_combine(std::size_t& seed, const T& value) {
   }
 }
 
+// hash of all coefficients of a fixed size integer vector
+template <class Derived>
+inline std::size_t hash_coeffs(const Eigen::DenseBase<Derived>& v) {
+  static_assert(std::is_integral_v<typename Derived::Scalar>,
+                "hash_coeffs is meant for integer keys");
+  std::size_t seed = 0;
+  for (Eigen::Index i = 0; i < v.size(); i++) hash_combine(seed, v[i]);
+  return seed;
+}
+
 }  // namespace basalt
+
+namespace std {
+
+// Hashes for grid cells and voxels, e.g. as keys of std::unordered_map.
+template <>
+struct hash<Eigen::Vector2i> {
+  std::size_t operator()(const Eigen::Vector2i& v) const {
+    return basalt::hash_coeffs(v);
+  }
+};
+
+template <>
+struct hash<Eigen::Vector3i> {
+  std::size_t operator()(const Eigen::Vector3i& v) const {
+    return basalt::hash_coeffs(v);
+  }
+};
+
+}  // namespace std
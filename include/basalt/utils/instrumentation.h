@@ -0,0 +1,308 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+@file
+@brief Optional instrumentation of hot paths with scoped timers and counters
+*/
+
+#pragma once
+
+// Without BASALT_ENABLE_INSTRUMENTATION only no-op macros are defined, so
+// instrumented headers do not depend on the machinery below.
+#if defined(BASALT_ENABLE_INSTRUMENTATION)
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace basalt::instrumentation {
+
+/// @brief Receiver of instrumentation events
+///
+/// Events are keyed by a name with static storage duration (a string
+/// literal), so sinks can use the pointer as key. Functions are called from
+/// any thread that runs instrumented code and have to be thread safe.
+class Sink {
+ public:
+  virtual ~Sink() = default;
+
+  /// @brief Called at the end of an instrumented scope
+  ///
+  /// @param[in] name name of the scope
+  /// @param[in] duration_ns time spent in the scope in nanoseconds
+  virtual void recordTime(const char* name, int64_t duration_ns) = 0;
+
+  /// @brief Called for a counter event
+  ///
+  /// @param[in] name name of the counter
+  /// @param[in] value value added to the counter, e.g. number of points
+  virtual void recordCount(const char* name, int64_t value) = 0;
+};
+
+/// @brief Storage of the registered sink
+inline std::atomic<Sink*>& sinkStorage() {
+  static std::atomic<Sink*> sink{nullptr};
+  return sink;
+}
+
+/// @brief Register the sink that receives all events, nullptr to disable
+///
+/// The sink has to stay valid until it is unregistered and all instrumented
+/// scopes that started before have ended.
+inline void setSink(Sink* sink) {
+  sinkStorage().store(sink, std::memory_order_release);
+}
+
+/// @brief Currently registered sink or nullptr
+inline Sink* getSink() {
+  return sinkStorage().load(std::memory_order_acquire);
+}
+
+/// @brief Measures the time between construction and destruction and reports
+/// it to the sink registered at construction
+class ScopedTimer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// @param[in] name name of the scope, has to have static storage duration
+  explicit ScopedTimer(const char* name) : name_(name), sink_(getSink()) {
+    if (sink_) start_ = Clock::now();
+  }
+
+  ~ScopedTimer() {
+    if (sink_) {
+      const auto duration = Clock::now() - start_;
+      sink_->recordTime(
+          name_,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+              .count());
+    }
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  const char* name_;
+  Sink* sink_;
+  Clock::time_point start_;
+};
+
+/// @brief Report a counter event to the registered sink
+///
+/// @param[in] name name of the counter, has to have static storage duration
+/// @param[in] value value added to the counter
+inline void count(const char* name, int64_t value) {
+  if (Sink* sink = getSink()) sink->recordCount(name, value);
+}
+
+/// @brief Sink that accumulates events in per-thread lock-free tables
+///
+/// Every thread writes only to its own table, so recording an event is a
+/// lookup of the name pointer and a few relaxed atomic stores without locks
+/// or contention. A mutex is only taken the first time a thread reports to
+/// the sink and by @ref snapshot. Per-frame budgets are the difference of two
+/// snapshots taken at the frame boundaries.
+///
+/// Each thread can record up to MAX_NAMES distinct names, further names are
+/// dropped and counted in @ref numDropped.
+class CounterSink : public Sink {
+ public:
+  /// Capacity of the table of each thread
+  static constexpr size_t MAX_NAMES = 128;
+
+  /// @brief Accumulated events of one name over all threads
+  struct Stats {
+    std::string name;      ///< Name of the scope or counter
+    uint64_t calls = 0;    ///< Number of finished scopes
+    int64_t total_ns = 0;  ///< Total time spent in the scopes
+    int64_t count = 0;     ///< Sum of the counter values
+  };
+
+  CounterSink() : id_(nextId()) {}
+
+  void recordTime(const char* name, int64_t duration_ns) override {
+    if (Slot* slot = findSlot(name)) {
+      add(slot->calls, uint64_t(1));
+      add(slot->total_ns, duration_ns);
+    }
+  }
+
+  void recordCount(const char* name, int64_t value) override {
+    if (Slot* slot = findSlot(name)) add(slot->count, value);
+  }
+
+  /// @brief Accumulate the tables of all threads, sorted by name
+  ///
+  /// Can be called while other threads record events. Values of different
+  /// names are not taken at exactly the same time in this case.
+  std::vector<Stats> snapshot() const {
+    std::map<std::string, Stats> res;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& table : tables_) {
+      for (const Slot& slot : table->slots) {
+        const char* name = slot.name.load(std::memory_order_acquire);
+        if (!name) continue;
+
+        Stats& s = res[name];
+        s.name = name;
+        s.calls += slot.calls.load(std::memory_order_relaxed);
+        s.total_ns += slot.total_ns.load(std::memory_order_relaxed);
+        s.count += slot.count.load(std::memory_order_relaxed);
+      }
+    }
+
+    std::vector<Stats> stats;
+    for (auto& [name, s] : res) stats.emplace_back(std::move(s));
+    return stats;
+  }
+
+  /// @brief Number of events dropped because a table was full
+  uint64_t numDropped() const {
+    return num_dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<int64_t> total_ns{0};
+    std::atomic<int64_t> count{0};
+  };
+
+  struct Table {
+    std::thread::id thread_id;
+    std::array<Slot, MAX_NAMES> slots;
+  };
+
+  /// Values are only written by the owning thread, so no read-modify-write
+  /// instructions are needed.
+  template <typename T>
+  static void add(std::atomic<T>& value, T inc) {
+    value.store(value.load(std::memory_order_relaxed) + inc,
+                std::memory_order_relaxed);
+  }
+
+  static uint64_t nextId() {
+    static std::atomic<uint64_t> id{0};
+    return ++id;
+  }
+
+  /// @brief Table of the calling thread, created on first use
+  Table& threadTable() {
+    // Cache of the last sink used by this thread. Sinks are identified by a
+    // unique id, so a new sink at the address of a destroyed one does not
+    // hit the cache.
+    thread_local uint64_t cached_id = 0;
+    thread_local Table* cached_table = nullptr;
+
+    if (cached_id != id_) {
+      const std::thread::id thread_id = std::this_thread::get_id();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      cached_table = nullptr;
+      for (const auto& table : tables_) {
+        if (table->thread_id == thread_id) cached_table = table.get();
+      }
+      if (!cached_table) {
+        tables_.emplace_back(std::make_unique<Table>());
+        tables_.back()->thread_id = thread_id;
+        cached_table = tables_.back().get();
+      }
+      cached_id = id_;
+    }
+
+    return *cached_table;
+  }
+
+  /// @brief Slot of name in the table of the calling thread, inserted if
+  /// needed. nullptr if the table is full.
+  Slot* findSlot(const char* name) {
+    Table& table = threadTable();
+
+    size_t idx = (reinterpret_cast<uintptr_t>(name) >> 3) % MAX_NAMES;
+    for (size_t i = 0; i < MAX_NAMES; i++) {
+      Slot& slot = table.slots[idx];
+      const char* slot_name = slot.name.load(std::memory_order_relaxed);
+      if (slot_name == name) return &slot;
+      if (!slot_name) {
+        slot.name.store(name, std::memory_order_release);
+        return &slot;
+      }
+      idx = (idx + 1) % MAX_NAMES;
+    }
+
+    num_dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  const uint64_t id_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Table>> tables_;
+
+  std::atomic<uint64_t> num_dropped_{0};
+};
+
+}  // namespace basalt::instrumentation
+
+#define BASALT_INSTRUMENT_CONCAT_IMPL(a, b) a##b
+#define BASALT_INSTRUMENT_CONCAT(a, b) BASALT_INSTRUMENT_CONCAT_IMPL(a, b)
+
+/// @brief Time the enclosing scope, name has to be a string literal
+#define BASALT_INSTRUMENT_SCOPE(name)                          \
+  const ::basalt::instrumentation::ScopedTimer                 \
+  BASALT_INSTRUMENT_CONCAT(basalt_instrument_timer_, __LINE__)( \
+      name)
+
+/// @brief Add value to a counter, name has to be a string literal
+#define BASALT_INSTRUMENT_COUNT(name, value) \
+  ::basalt::instrumentation::count(name, int64_t(value))
+
+#else
+
+#define BASALT_INSTRUMENT_SCOPE(name) ((void)0)
+
+#define BASALT_INSTRUMENT_COUNT(name, value) ((void)0)
+
+#endif
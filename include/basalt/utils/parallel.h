@@ -0,0 +1,253 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Parallel loops over caller-supplied executors
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace basalt {
+
+/// @brief State shared by a parallel loop and the worker tasks it passes to
+/// an executor, see \ref runParallelWork.
+///
+/// Worker tasks only capture a pointer to the state, which fits into the
+/// small buffer of std::function, so passing them to the executor does not
+/// allocate. The state is reference counted and deleted by whoever releases it
+/// last, so the executor may start workers after the loop returned. Such late
+/// workers find no tasks left and only release their reference.
+struct ParallelWorkState {
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  size_t num_tasks = 0;      ///< Tasks that may be started
+  size_t num_started = 0;    ///< Tasks started so far
+  size_t num_completed = 0;  ///< Started tasks that returned or threw
+
+  /// First exception thrown by a task or the executor
+  std::exception_ptr error;
+
+  std::atomic<size_t> refs{0};
+
+  virtual ~ParallelWorkState() = default;
+
+  /// @brief Run tasks until no task can be started any more.
+  ///
+  /// Tasks may only access data of the loop while num_started < num_tasks.
+  /// Has to catch all exceptions of the tasks, see \ref runUnlocked.
+  ///
+  /// @param worker index of the worker in [0, num_workers], the calling
+  /// thread has index num_workers
+  virtual void work(size_t worker) = 0;
+
+  /// @brief Run a started task with the mutex unlocked.
+  ///
+  /// @return exception thrown by the task, if any
+  template <class F>
+  static std::exception_ptr runUnlocked(std::unique_lock<std::mutex>& lock,
+                                        F&& f) noexcept {
+    std::exception_ptr e;
+    lock.unlock();
+    try {
+      f();
+    } catch (...) {
+      e = std::current_exception();
+    }
+    lock.lock();
+    return e;
+  }
+
+  /// @brief Count a started task as completed, with the mutex locked. If it
+  /// failed, keep the first exception and start no further tasks.
+  inline void completeTask(std::exception_ptr e) {
+    if (e) fail(std::move(e));
+    num_completed++;
+    cv.notify_all();
+  }
+
+  /// @brief Keep the first exception and start no further tasks, with the
+  /// mutex locked.
+  inline void fail(std::exception_ptr e) {
+    if (!error) error = std::move(e);
+    num_tasks = num_started;
+  }
+
+  /// @brief Release one reference, deleting the state with the last one.
+  inline void release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+};
+
+/// @brief Run \p state on the calling thread and in \p num_workers worker
+/// tasks passed to \p executor.
+///
+/// Returns when all started tasks completed. If a task or the executor
+/// throws, no further tasks are started and the first exception is rethrown
+/// once the started tasks completed. An executor that throws is assumed to
+/// not have taken the task. Every task it takes has to be run exactly once.
+///
+/// @param state state with the tasks, the reference counting is handled here
+/// @param executor callable taking a std::function<void()> to run
+/// @param num_workers number of worker tasks passed to the executor
+template <class Executor>
+inline void runParallelWork(std::unique_ptr<ParallelWorkState> state_ptr,
+                            Executor&& executor, size_t num_workers) {
+  ParallelWorkState* state = state_ptr.release();
+
+  // one reference for the calling thread and for each worker
+  state->refs = num_workers + 1;
+
+  size_t num_passed = 0;
+  try {
+    for (; num_passed < num_workers; num_passed++) {
+      executor(std::function<void()>([state, worker = num_passed]() {
+        state->work(worker);
+        state->release();
+      }));
+    }
+  } catch (...) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->fail(std::current_exception());
+    state->refs -= num_workers - num_passed;
+  }
+
+  state->work(num_workers);
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(
+        lock, [&]() { return state->num_completed == state->num_started; });
+    error = state->error;
+  }
+  state->release();
+
+  if (error) std::rethrow_exception(error);
+}
+
+/// @brief State of \ref parallelFor
+template <class Func>
+struct ParallelForState : ParallelWorkState {
+  Func* func = nullptr;
+
+  inline void work(size_t) override {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (num_started < num_tasks) {
+      const size_t task = num_started++;
+      completeTask(runUnlocked(lock, [&]() { (*func)(task); }));
+    }
+  }
+};
+
+/// @brief Call func(i) for all i in [0, num_tasks) using a caller-supplied
+/// executor for parallelization.
+///
+/// Besides the calling thread, which also runs tasks, \p num_workers worker
+/// tasks are passed to \p executor, which is the same interface as in
+/// ManagedImagePyr::setFromImage. No threads are created here. The function
+/// returns when all tasks are done. Workers that start later return
+/// immediately, so the executor may run them at any time, including
+/// immediately in the calling thread. Tasks are handed out in increasing
+/// order, but may run concurrently and finish in any order.
+///
+/// If \p func or the executor throws, no further tasks are started and the
+/// first exception is rethrown after all started tasks returned. Without
+/// workers the tasks run directly on the calling thread, and a parallel call
+/// allocates only the shared state of \ref runParallelWork.
+///
+/// @param num_tasks number of tasks
+/// @param executor callable taking a std::function<void()> to run, e.g.
+/// submitting it to a thread pool
+/// @param num_workers number of worker tasks passed to the executor
+/// @param func callable taking the task index
+template <class Executor, class Func>
+inline void parallelFor(size_t num_tasks, Executor&& executor,
+                        size_t num_workers, Func&& func) {
+  if (num_tasks == 0) return;
+
+  // more workers than tasks would only return immediately
+  num_workers = std::min(num_workers, num_tasks - 1);
+  if (num_workers == 0) {
+    for (size_t i = 0; i < num_tasks; i++) func(i);
+    return;
+  }
+
+  auto state =
+      std::make_unique<ParallelForState<std::remove_reference_t<Func>>>();
+  state->num_tasks = num_tasks;
+  state->func = &func;
+  runParallelWork(std::move(state), std::forward<Executor>(executor),
+                  num_workers);
+}
+
+/// @brief Executor that runs every task on a new thread, for callers
+/// without a thread pool. The threads are joined by \ref join or the
+/// destructor.
+class ThreadSpawnExecutor {
+ public:
+  ThreadSpawnExecutor() = default;
+  ThreadSpawnExecutor(const ThreadSpawnExecutor&) = delete;
+  ThreadSpawnExecutor& operator=(const ThreadSpawnExecutor&) = delete;
+
+  inline ~ThreadSpawnExecutor() { join(); }
+
+  inline void operator()(std::function<void()> task) {
+    threads_.emplace_back(std::move(task));
+  }
+
+  /// @brief Wait for all started threads.
+  inline void join() {
+    for (std::thread& t : threads_) t.join();
+    threads_.clear();
+  }
+
+ private:
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace basalt
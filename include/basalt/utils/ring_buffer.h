@@ -0,0 +1,266 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Contiguous ring buffer used as knot storage of the splines
+*/
+
+#pragma once
+
+#include <basalt/utils/assert.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace basalt {
+
+/// @brief Contiguous buffer with O(1) push_back and pop_front
+///
+/// Drop-in replacement for Eigen::aligned_deque in sliding-window use, e.g. as
+/// knot storage of \ref RdSpline and \ref So3Spline. The elements are kept in
+/// one cache line aligned allocation of twice the capacity and the live
+/// elements always form a single contiguous range, so any number of
+/// consecutive elements can be accessed through a plain pointer (see \ref
+/// data). pop_front only advances the head. When push_back reaches the end of
+/// the allocation the live elements are moved back to the front, which happens
+/// at most once every capacity() pushes, so push_back is amortized O(1). The
+/// capacity is doubled only when the buffer is full, i.e. a sliding window of
+/// bounded size never reallocates once the capacity is reached (or set with
+/// \ref reserve).
+///
+/// Pushing elements may move the stored elements, references and pointers to
+/// elements are therefore invalidated by push_back, emplace_back, resize and
+/// reserve.
+template <typename T>
+class RingBuffer {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  /// Alignment of the storage, at least one cache line.
+  static constexpr size_t ALIGNMENT = alignof(T) > 64 ? alignof(T) : 64;
+
+  /// @brief Default constructor, no storage is allocated.
+  RingBuffer() = default;
+
+  /// @brief Construct empty buffer with storage for capacity elements.
+  explicit RingBuffer(size_t capacity) { reserve(capacity); }
+
+  RingBuffer(const RingBuffer& other) { *this = other; }
+
+  RingBuffer(RingBuffer&& other) noexcept { swap(other); }
+
+  ~RingBuffer() { deallocate(); }
+
+  RingBuffer& operator=(const RingBuffer& other) {
+    if (this != &other) {
+      clear();
+      reserve(other.capacity_);
+      std::copy(other.begin(), other.end(), data_);
+      size_ = other.size_;
+    }
+    return *this;
+  }
+
+  RingBuffer& operator=(RingBuffer&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  /// @brief Swap contents with other buffer.
+  void swap(RingBuffer& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+  }
+
+  /// @brief Make sure the buffer can hold at least capacity elements without
+  /// reallocating.
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_) return;
+
+    T* new_data = allocate(2 * capacity);
+    std::move(begin(), end(), new_data);
+
+    deallocate();
+    data_ = new_data;
+    capacity_ = capacity;
+    head_ = 0;
+  }
+
+  /// @brief Add element to the back of the buffer.
+  inline void push_back(const T& val) {
+    makeRoomAtBack(1);
+    data_[head_ + size_] = val;
+    size_++;
+  }
+
+  /// @brief Construct element at the back of the buffer.
+  ///
+  /// The storage slot already holds a default constructed element. A single
+  /// argument that T is assignable from is assigned to it directly (e.g. an
+  /// Eigen expression is evaluated into the slot). Otherwise the element is
+  /// destroyed and constructed in place if that cannot throw, or else assigned
+  /// from a temporary, so the slot always holds a live object.
+  template <typename... Args>
+  inline T& emplace_back(Args&&... args) {
+    makeRoomAtBack(1);
+    T* slot = data_ + head_ + size_;
+    if constexpr (sizeof...(Args) == 1 &&
+                  (std::is_assignable_v<T&, Args&&> && ...)) {
+      ((*slot = std::forward<Args>(args)), ...);
+    } else if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+      std::destroy_at(slot);
+      ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+    } else {
+      *slot = T(std::forward<Args>(args)...);
+    }
+    size_++;
+    return *slot;
+  }
+
+  /// @brief Remove the last element.
+  inline void pop_back() {
+    BASALT_ASSERT(size_ > 0);
+    size_--;
+  }
+
+  /// @brief Remove the first element.
+  inline void pop_front() {
+    BASALT_ASSERT(size_ > 0);
+    head_++;
+    size_--;
+    if (size_ == 0) head_ = 0;
+  }
+
+  /// @brief Resize the buffer to n elements. New elements are default
+  /// constructed.
+  void resize(size_t n) {
+    if (n > size_) {
+      makeRoomAtBack(n - size_);
+      // replace stale slots in place instead of copying a temporary
+      std::destroy(end(), data_ + head_ + n);
+      std::uninitialized_default_construct(end(), data_ + head_ + n);
+    }
+    size_ = n;
+  }
+
+  /// @brief Remove all elements, keeps the storage.
+  inline void clear() {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  inline T& operator[](size_t i) {
+    checkIndex(i);
+    return data_[head_ + i];
+  }
+
+  inline const T& operator[](size_t i) const {
+    checkIndex(i);
+    return data_[head_ + i];
+  }
+
+  inline T& front() { return (*this)[0]; }
+  inline const T& front() const { return (*this)[0]; }
+  inline T& back() { return (*this)[size_ - 1]; }
+  inline const T& back() const { return (*this)[size_ - 1]; }
+
+  /// @brief Pointer to the first element. All elements are stored
+  /// contiguously.
+  inline T* data() { return data_ + head_; }
+  inline const T* data() const { return data_ + head_; }
+
+  inline iterator begin() { return data(); }
+  inline iterator end() { return data() + size_; }
+  inline const_iterator begin() const { return data(); }
+  inline const_iterator end() const { return data() + size_; }
+
+  inline size_t size() const { return size_; }
+  inline bool empty() const { return size_ == 0; }
+
+  /// @brief Number of elements the buffer can hold without reallocating.
+  inline size_t capacity() const { return capacity_; }
+
+ private:
+  /// @brief Make sure num more elements fit after the last element, moving
+  /// the elements to the front or growing the storage if needed.
+  inline void makeRoomAtBack(size_t num) {
+    if (size_ + num > capacity_) {
+      reserve(std::max(size_ + num, std::max<size_t>(2 * capacity_, 16)));
+    } else if (head_ + size_ + num > 2 * capacity_) {
+      // head_ >= capacity_ >= size_, so the ranges do not overlap
+      std::move(begin(), end(), data_);
+      head_ = 0;
+    }
+  }
+
+  inline void checkIndex(size_t i) const {
+#ifdef BASALT_ENABLE_BOUNDS_CHECKS
+    BASALT_ASSERT_STREAM(i < size_, "i " << i << " size " << size_);
+#else
+    UNUSED(i);
+#endif
+  }
+
+  static T* allocate(size_t n) {
+    T* res = static_cast<T*>(
+        ::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+    std::uninitialized_default_construct_n(res, n);
+    return res;
+  }
+
+  void deallocate() {
+    if (!data_) return;
+    std::destroy_n(data_, 2 * capacity_);
+    ::operator delete(data_, std::align_val_t(ALIGNMENT));
+    data_ = nullptr;
+  }
+
+  T* data_{nullptr};     ///< Storage for 2 * capacity_ elements
+  size_t capacity_{0};   ///< Maximum number of elements
+  size_t head_{0};       ///< Index of the first element in the storage
+  size_t size_{0};       ///< Number of elements
+};
+
+}  // namespace basalt
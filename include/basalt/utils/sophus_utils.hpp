@@ -321,6 +321,170 @@ inline void rightJacobianInvSO3(const Eigen::MatrixBase<Derived1> &phi,
 }
 */
 
+/// @brief Expmap for SO(3) fused with the right Jacobian
+///
+/// Computes \f$ \exp(\phi) \f$ and the right Jacobian of SO(3) (see
+/// rightJacobianSO3) from a single evaluation of the rotation angle and of
+/// \f$ \sin(\theta/2), \cos(\theta/2) \f$. Below the threshold
+/// \f$ \theta^2 \leq \sqrt{\epsilon} \f$ both are evaluated with Taylor
+/// expansions. Above it the multiplier of phi_hat2 still suffers from the
+/// cancellation in \f$ \theta - \sin(\theta) \f$, with a relative error
+/// of about \f$ \epsilon / \theta^2 \f$. Since phi_hat2 has magnitude
+/// \f$ \theta^2 \f$, the absolute error of J_phi stays of order
+/// \f$ \epsilon \f$.
+/// @param[in] phi (3x1 vector)
+/// @param[out] J_phi (3x3 matrix)
+/// @return \f$ \exp(\phi) \f$
+template <typename Derived1, typename Derived2>
+inline Sophus::SO3<typename Derived1::Scalar> expAndRightJacobianSO3(
+    const Eigen::MatrixBase<Derived1> &phi,
+    const Eigen::MatrixBase<Derived2> &J_phi) {
+  EIGEN_STATIC_ASSERT_FIXED_SIZE(Derived1);
+  EIGEN_STATIC_ASSERT_FIXED_SIZE(Derived2);
+  EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived1, 3);
+  EIGEN_STATIC_ASSERT_MATRIX_SPECIFIC_SIZE(Derived2, 3, 3);
+
+  using Scalar = typename Derived1::Scalar;
+
+  Eigen::MatrixBase<Derived2> &J =
+      const_cast<Eigen::MatrixBase<Derived2> &>(J_phi);
+
+  Scalar phi_norm2 = phi.squaredNorm();
+  Eigen::Matrix<Scalar, 3, 3> phi_hat = Sophus::SO3<Scalar>::hat(phi);
+  Eigen::Matrix<Scalar, 3, 3> phi_hat2 = phi_hat * phi_hat;
+
+  // real and imaginary (divided by angle) part of the quaternion, scalar
+  // multipliers of phi_hat and phi_hat2 in the Jacobian
+  Scalar real, imag, a, b;
+
+  if (phi_norm2 > Sophus::Constants<Scalar>::epsilonSqrt()) {
+    Scalar phi_norm = std::sqrt(phi_norm2);
+    Scalar s = std::sin(phi_norm / 2);
+    Scalar c = std::cos(phi_norm / 2);
+
+    real = c;
+    imag = s / phi_norm;
+
+    // 1 - cos(phi_norm) = 2 s^2, sin(phi_norm) = 2 s c
+    a = 2 * s * s / phi_norm2;
+    b = (phi_norm - 2 * s * c) / (phi_norm2 * phi_norm);
+  } else {
+    // Taylor expansion around 0
+    Scalar phi_norm4 = phi_norm2 * phi_norm2;
+    real = 1 - phi_norm2 / 8 + phi_norm4 / 384;
+    imag = Scalar(0.5) - phi_norm2 / 48 + phi_norm4 / 3840;
+    a = Scalar(0.5) - phi_norm2 / 24 + phi_norm4 / 720;
+    b = Scalar(1) / 6 - phi_norm2 / 120 + phi_norm4 / 5040;
+  }
+
+  J.setIdentity();
+  J -= a * phi_hat;
+  J += b * phi_hat2;
+
+  return Sophus::SO3<Scalar>(Eigen::Quaternion<Scalar>(
+      real, imag * phi[0], imag * phi[1], imag * phi[2]));
+}
+
+/// @brief Logmap for SO(3) fused with the right inverse Jacobian
+///
+/// Computes \f$ \phi = \log(R) \f$ and the right inverse Jacobian of SO(3)
+/// (see rightJacobianInvSO3) at \f$ \phi \f$ directly from the unit
+/// quaternion of R. The angle is always in range [0, pi], and the multiplier
+/// of phi_hat2 is expressed in terms of the half angle, so no special
+/// treatment is needed close to pi. Below the threshold
+/// \f$ \theta^2 \leq \sqrt{\epsilon} \f$ a Taylor expansion is used.
+/// Above it the multiplier of phi_hat2 is a difference of two terms of
+/// magnitude \f$ 1 / \theta^2 \f$ and has a relative error of about
+/// \f$ \epsilon / \theta^2 \f$, i.e. the absolute error of J_phi stays
+/// of order \f$ \epsilon \f$.
+/// @param[in] R SO(3) member
+/// @param[out] phi (3x1 vector)
+/// @param[out] J_phi (3x3 matrix)
+template <typename Scalar, typename Derived1, typename Derived2>
+inline void logAndRightJacobianInvSO3(
+    const Sophus::SO3<Scalar> &R, const Eigen::MatrixBase<Derived1> &phi,
+    const Eigen::MatrixBase<Derived2> &J_phi) {
+  EIGEN_STATIC_ASSERT_FIXED_SIZE(Derived1);
+  EIGEN_STATIC_ASSERT_FIXED_SIZE(Derived2);
+  EIGEN_STATIC_ASSERT_VECTOR_SPECIFIC_SIZE(Derived1, 3);
+  EIGEN_STATIC_ASSERT_MATRIX_SPECIFIC_SIZE(Derived2, 3, 3);
+
+  Eigen::MatrixBase<Derived1> &res =
+      const_cast<Eigen::MatrixBase<Derived1> &>(phi);
+  Eigen::MatrixBase<Derived2> &J =
+      const_cast<Eigen::MatrixBase<Derived2> &>(J_phi);
+
+  // q and -q represent the same rotation. Choose w >= 0 such that the angle is
+  // in range [0, pi].
+  const Eigen::Quaternion<Scalar> &q = R.unit_quaternion();
+  Scalar w = q.w();
+  Eigen::Matrix<Scalar, 3, 1> vec = q.vec();
+  if (w < 0) {
+    w = -w;
+    vec = -vec;
+  }
+
+  Scalar n2 = vec.squaredNorm();
+  Scalar n = std::sqrt(n2);
+  Scalar phi_norm;
+
+  if (n2 > Sophus::Constants<Scalar>::epsilon()) {
+    phi_norm = 2 * std::atan2(n, w);
+    res = (phi_norm / n) * vec;
+  } else {
+    // Taylor expansion around 0
+    Scalar two_atan_nbyw_by_n = 2 / w - Scalar(2.0 / 3.0) * n2 / (w * w * w);
+    res = two_atan_nbyw_by_n * vec;
+    phi_norm = two_atan_nbyw_by_n * n;
+  }
+
+  Scalar phi_norm2 = phi_norm * phi_norm;
+  Eigen::Matrix<Scalar, 3, 3> phi_hat = Sophus::SO3<Scalar>::hat(res);
+  Eigen::Matrix<Scalar, 3, 3> phi_hat2 = phi_hat * phi_hat;
+
+  J.setIdentity();
+  J += phi_hat / 2;
+
+  if (phi_norm2 > Sophus::Constants<Scalar>::epsilonSqrt()) {
+    // (1 + cos(phi_norm)) / (2 phi_norm sin(phi_norm)) = w / (2 phi_norm n)
+    J += phi_hat2 * (1 / phi_norm2 - w / (2 * phi_norm * n));
+  } else {
+    // Taylor expansion around 0
+    J += phi_hat2 * (Scalar(1) / 12 + phi_norm2 / 720 +
+                     phi_norm2 * phi_norm2 / 30240);
+  }
+}
+
+/// @brief Batch version of expAndRightJacobianSO3
+///
+/// @param[in] phi array of num tangent vectors
+/// @param[in] num number of tangent vectors
+/// @param[out] R array of num SO(3) members
+/// @param[out] J_phi array of num right Jacobians
+template <typename Scalar>
+inline void expAndRightJacobianSO3Batch(
+    const Eigen::Matrix<Scalar, 3, 1> *phi, size_t num,
+    Sophus::SO3<Scalar> *R, Eigen::Matrix<Scalar, 3, 3> *J_phi) {
+  for (size_t i = 0; i < num; i++) {
+    R[i] = expAndRightJacobianSO3(phi[i], J_phi[i]);
+  }
+}
+
+/// @brief Batch version of logAndRightJacobianInvSO3
+///
+/// @param[in] R array of num SO(3) members
+/// @param[in] num number of SO(3) members
+/// @param[out] phi array of num tangent vectors
+/// @param[out] J_phi array of num right inverse Jacobians
+template <typename Scalar>
+inline void logAndRightJacobianInvSO3Batch(
+    const Sophus::SO3<Scalar> *R, size_t num,
+    Eigen::Matrix<Scalar, 3, 1> *phi, Eigen::Matrix<Scalar, 3, 3> *J_phi) {
+  for (size_t i = 0; i < num; i++) {
+    logAndRightJacobianInvSO3(R[i], phi[i], J_phi[i]);
+  }
+}
+
 /// @brief Left Jacobian for SO(3)
 ///
 /// For \f$ \exp(x) \in SO(3) \f$ provides a Jacobian that approximates the sum
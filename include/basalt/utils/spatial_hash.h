@@ -0,0 +1,543 @@
+/**
+BSD 3-Clause License
+
+This file is part of the Basalt project.
+https://gitlab.com/VladyslavUsenko/basalt-headers.git
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+@file
+@brief Open-addressing hash containers and grids for integer cell keys
+*/
+
+#pragma once
+
+#include <basalt/utils/assert.h>
+#include <basalt/utils/eigen_utils.hpp>
+#include <basalt/utils/hash.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace basalt {
+
+/// @brief Scramble the bits of a hash value
+///
+/// hash_combine of small integers (std::hash<int> is the identity) leaves
+/// most of the entropy in the low bits of only a few positions. The
+/// finalizer of MurmurHash3 spreads it over all bits, so the table index can
+/// be taken with a mask.
+inline std::size_t mixHash(std::size_t h) {
+  if constexpr (sizeof(std::size_t) == 8) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdLLU;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53LLU;
+    h ^= h >> 33;
+  } else {
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+  }
+  return h;
+}
+
+/// @brief Grid cell of a point for square cells of cell_size
+///
+/// Rounds towards negative infinity, so cells have the same size on both
+/// sides of the origin, for integer and floating point coordinates.
+template <class Derived>
+inline Eigen::Matrix<int, Derived::RowsAtCompileTime, 1> gridCell(
+    const Eigen::MatrixBase<Derived>& pos, int cell_size) {
+  EIGEN_STATIC_ASSERT_FIXED_SIZE(Derived);
+  EIGEN_STATIC_ASSERT_VECTOR_ONLY(Derived);
+  BASALT_ASSERT(cell_size > 0);
+
+  using Scalar = typename Derived::Scalar;
+
+  Eigen::Matrix<int, Derived::RowsAtCompileTime, 1> res;
+  for (int i = 0; i < Derived::RowsAtCompileTime; i++) {
+    if constexpr (std::is_integral_v<Scalar>) {
+      const int v = int(pos[i]);
+      res[i] = (v >= 0 ? v : v - (cell_size - 1)) / cell_size;
+    } else {
+      res[i] = int(std::floor(pos[i] / Scalar(cell_size)));
+    }
+  }
+  return res;
+}
+
+/// @brief Hash map for small fixed size integer vectors, e.g. grid cells
+///
+/// Replacement for std::unordered_map<Eigen::Vector2i, Value> in hot loops.
+/// Keys, values and occupancy flags are stored in flat arrays with a power
+/// of two number of slots and collisions are resolved with linear probing,
+/// so lookups touch one or a few neighbouring slots instead of following
+/// node pointers. The load factor is kept below 3/4. \ref clear keeps the
+/// storage, so a map that is refilled every frame stops allocating once it
+/// has grown to its working size (or was sized with \ref reserve).
+///
+/// Pointers to values are invalidated by insertions that grow the table and
+/// by \ref erase, which moves later entries of a probe sequence back.
+/// Value has to be default constructible.
+template <class Key, class Value>
+class CellHashMap {
+ public:
+  static_assert(Key::SizeAtCompileTime != Eigen::Dynamic &&
+                    std::is_integral_v<typename Key::Scalar>,
+                "Key has to be a fixed size integer vector");
+
+  /// @brief Default constructor, no storage is allocated.
+  CellHashMap() = default;
+
+  /// @brief Construct empty map with storage for num_elements entries.
+  explicit CellHashMap(size_t num_elements) { reserve(num_elements); }
+
+  /// @brief Number of entries.
+  inline size_t size() const { return size_; }
+
+  /// @brief If the map has no entries.
+  inline bool empty() const { return size_ == 0; }
+
+  /// @brief Number of slots of the table.
+  inline size_t numSlots() const { return used_.size(); }
+
+  /// @brief Make sure the map can hold num_elements entries without
+  /// reallocating.
+  void reserve(size_t num_elements) {
+    size_t num_slots = MIN_SLOTS;
+    while (4 * num_elements > 3 * num_slots) num_slots *= 2;
+    if (num_slots > numSlots()) rehash(num_slots);
+  }
+
+  /// @brief Remove all entries, keeping the storage.
+  void clear() {
+    std::fill(used_.begin(), used_.end(), 0);
+    size_ = 0;
+  }
+
+  /// @brief Value of key or nullptr if key is not in the map.
+  inline Value* find(const Key& key) {
+    const size_t i = findSlot(key);
+    return i == NOT_FOUND ? nullptr : &values_[i];
+  }
+
+  /// @brief Value of key or nullptr if key is not in the map.
+  inline const Value* find(const Key& key) const {
+    const size_t i = findSlot(key);
+    return i == NOT_FOUND ? nullptr : &values_[i];
+  }
+
+  /// @brief If key is in the map.
+  inline bool contains(const Key& key) const {
+    return findSlot(key) != NOT_FOUND;
+  }
+
+  /// @brief Insert key with value if key is not in the map yet.
+  ///
+  /// @return pointer to the value stored for key and true if the key was
+  /// inserted, false if it was already in the map (the value is not changed)
+  std::pair<Value*, bool> insert(const Key& key, const Value& value) {
+    if (4 * (size_ + 1) > 3 * numSlots()) {
+      rehash(std::max(MIN_SLOTS, 2 * numSlots()));
+    }
+
+    size_t i = homeSlot(key);
+    while (used_[i]) {
+      if (keys_[i] == key) return {&values_[i], false};
+      i = (i + 1) & mask_;
+    }
+
+    used_[i] = 1;
+    keys_[i] = key;
+    values_[i] = value;
+    size_++;
+    return {&values_[i], true};
+  }
+
+  /// @brief Value of key, inserting a default constructed value if key is not
+  /// in the map.
+  inline Value& operator[](const Key& key) {
+    const size_t i = findSlot(key);
+    if (i != NOT_FOUND) return values_[i];
+    return *insert(key, Value()).first;
+  }
+
+  /// @brief Remove key from the map.
+  ///
+  /// Uses backward shift deletion, so there are no tombstones and lookups do
+  /// not get slower after many erases.
+  /// @return true if the key was in the map
+  bool erase(const Key& key) {
+    size_t i = findSlot(key);
+    if (i == NOT_FOUND) return false;
+
+    // Move entries of the probe sequence after i into the hole if their home
+    // slot is not between the hole and their current slot.
+    for (size_t j = (i + 1) & mask_; used_[j]; j = (j + 1) & mask_) {
+      const size_t home = homeSlot(keys_[j]);
+      if (((j - home) & mask_) >= ((j - i) & mask_)) {
+        keys_[i] = keys_[j];
+        values_[i] = std::move(values_[j]);
+        i = j;
+      }
+    }
+
+    used_[i] = 0;
+    size_--;
+    return true;
+  }
+
+  /// @brief Call f(key, value) for all entries in unspecified order.
+  template <class F>
+  void forEach(F&& f) const {
+    for (size_t i = 0; i < used_.size(); i++) {
+      if (used_[i]) f(keys_[i], values_[i]);
+    }
+  }
+
+  /// @brief Call f(key, value) for all entries in unspecified order, f may
+  /// modify the values.
+  template <class F>
+  void forEach(F&& f) {
+    for (size_t i = 0; i < used_.size(); i++) {
+      if (used_[i]) f(static_cast<const Key&>(keys_[i]), values_[i]);
+    }
+  }
+
+ private:
+  static constexpr size_t MIN_SLOTS = 16;
+  static constexpr size_t NOT_FOUND = size_t(-1);
+
+  inline size_t homeSlot(const Key& key) const {
+    return mixHash(hash_coeffs(key)) & mask_;
+  }
+
+  inline size_t findSlot(const Key& key) const {
+    if (size_ == 0) return NOT_FOUND;
+
+    for (size_t i = homeSlot(key); used_[i]; i = (i + 1) & mask_) {
+      if (keys_[i] == key) return i;
+    }
+    return NOT_FOUND;
+  }
+
+  void rehash(size_t num_slots) {
+    Eigen::aligned_vector<Key> old_keys(num_slots);
+    std::vector<Value> old_values(num_slots);
+    std::vector<uint8_t> old_used(num_slots, 0);
+    old_keys.swap(keys_);
+    old_values.swap(values_);
+    old_used.swap(used_);
+
+    mask_ = num_slots - 1;
+    size_ = 0;
+
+    for (size_t i = 0; i < old_used.size(); i++) {
+      if (!old_used[i]) continue;
+
+      size_t j = homeSlot(old_keys[i]);
+      while (used_[j]) j = (j + 1) & mask_;
+
+      used_[j] = 1;
+      keys_[j] = old_keys[i];
+      values_[j] = std::move(old_values[i]);
+      size_++;
+    }
+  }
+
+  Eigen::aligned_vector<Key> keys_;
+  std::vector<Value> values_;
+  std::vector<uint8_t> used_;
+  size_t mask_ = 0;
+  size_t size_ = 0;
+};
+
+/// @brief Hash set for small fixed size integer vectors, see \ref
+/// CellHashMap.
+template <class Key>
+class CellHashSet {
+ public:
+  /// @brief Default constructor, no storage is allocated.
+  CellHashSet() = default;
+
+  /// @brief Construct empty set with storage for num_elements keys.
+  explicit CellHashSet(size_t num_elements) : map_(num_elements) {}
+
+  /// @brief Number of keys.
+  inline size_t size() const { return map_.size(); }
+
+  /// @brief If the set has no keys.
+  inline bool empty() const { return map_.empty(); }
+
+  /// @brief Make sure the set can hold num_elements keys without
+  /// reallocating.
+  inline void reserve(size_t num_elements) { map_.reserve(num_elements); }
+
+  /// @brief Remove all keys, keeping the storage.
+  inline void clear() { map_.clear(); }
+
+  /// @brief Insert key. Returns true if it was not in the set before.
+  inline bool insert(const Key& key) { return map_.insert(key, {}).second; }
+
+  /// @brief If key is in the set.
+  inline bool contains(const Key& key) const { return map_.contains(key); }
+
+  /// @brief Remove key. Returns true if it was in the set.
+  inline bool erase(const Key& key) { return map_.erase(key); }
+
+  /// @brief Call f(key) for all keys in unspecified order.
+  template <class F>
+  void forEach(F&& f) const {
+    map_.forEach([&](const Key& key, const Empty&) { f(key); });
+  }
+
+ private:
+  struct Empty {};
+
+  CellHashMap<Key, Empty> map_;
+};
+
+/// @brief Items bucketed by the cell of a sparse 2D grid
+///
+/// Every item is stored once in a flat array and chained to the previous
+/// item of the same cell, the map only stores the index of the last item of
+/// every occupied cell. Useful when the grid is large compared to the number
+/// of occupied cells, e.g. for landmark deduplication by projected position.
+/// Items of a cell are visited in reverse insertion order.
+template <class T>
+class GridBuckets {
+ public:
+  using Cell = Eigen::Vector2i;
+
+  /// @brief Construct empty grid with square cells of cell_size.
+  explicit GridBuckets(int cell_size = 1) : cell_size_(cell_size) {
+    BASALT_ASSERT(cell_size > 0);
+  }
+
+  /// @brief Size of the cells.
+  inline int cellSize() const { return cell_size_; }
+
+  /// @brief Total number of items.
+  inline size_t size() const { return items_.size(); }
+
+  /// @brief Number of cells with at least one item.
+  inline size_t numCells() const { return heads_.size(); }
+
+  /// @brief Make sure num_items items in up to num_items cells can be
+  /// inserted without reallocating.
+  void reserve(size_t num_items) {
+    heads_.reserve(num_items);
+    items_.reserve(num_items);
+    next_.reserve(num_items);
+  }
+
+  /// @brief Remove all items, keeping the storage.
+  void clear() {
+    heads_.clear();
+    items_.clear();
+    next_.clear();
+  }
+
+  /// @brief Cell of a position, see \ref gridCell.
+  template <class Derived>
+  inline Cell cellOf(const Eigen::MatrixBase<Derived>& pos) const {
+    return gridCell(pos, cell_size_);
+  }
+
+  /// @brief Add item to cell.
+  void insert(const Cell& cell, const T& item) {
+    const int idx = int(items_.size());
+    int& head = *heads_.insert(cell, -1).first;
+
+    items_.push_back(item);
+    next_.push_back(head);
+    head = idx;
+  }
+
+  /// @brief Add item to the cell containing pos.
+  template <class Derived>
+  inline void insertAt(const Eigen::MatrixBase<Derived>& pos, const T& item) {
+    insert(cellOf(pos), item);
+  }
+
+  /// @brief Number of items in cell.
+  size_t count(const Cell& cell) const {
+    size_t res = 0;
+    forEachInCell(cell, [&](const T&) { res++; });
+    return res;
+  }
+
+  /// @brief Call f(item) for all items of cell.
+  template <class F>
+  void forEachInCell(const Cell& cell, F&& f) const {
+    const int* head = heads_.find(cell);
+    for (int i = head ? *head : -1; i >= 0; i = next_[i]) f(items_[i]);
+  }
+
+  /// @brief Call f(item) for all items in the (2 radius + 1)^2 cells around
+  /// cell.
+  template <class F>
+  void forEachInNeighborhood(const Cell& cell, int radius, F&& f) const {
+    for (int y = cell.y() - radius; y <= cell.y() + radius; y++) {
+      for (int x = cell.x() - radius; x <= cell.x() + radius; x++) {
+        forEachInCell(Cell(x, y), f);
+      }
+    }
+  }
+
+  /// @brief Call f(cell, item) for all items.
+  template <class F>
+  void forEach(F&& f) const {
+    heads_.forEach([&](const Cell& cell, const int& head) {
+      for (int i = head; i >= 0; i = next_[i]) f(cell, items_[i]);
+    });
+  }
+
+ private:
+  int cell_size_;
+  CellHashMap<Cell, int> heads_;
+  Eigen::aligned_vector<T> items_;
+  std::vector<int> next_;
+};
+
+/// @brief Dense 2D grid of cells covering an image
+///
+/// Cache-friendly and allocation-free alternative to the hash containers
+/// when the grid is bounded and a good part of the cells is used, e.g. for
+/// keypoint occupancy in the tracker: every cell is one element of a
+/// row-major array, \ref fill resets it for the next frame without
+/// allocating. Use uint8_t instead of bool, std::vector<bool> is not
+/// addressable per element.
+template <class T>
+class DenseCellGrid {
+ public:
+  static_assert(!std::is_same_v<T, bool>, "use uint8_t instead of bool");
+
+  using Cell = Eigen::Vector2i;
+
+  /// @brief Default constructor, no storage is allocated.
+  DenseCellGrid() = default;
+
+  /// @brief Grid of cells of cell_size covering a width x height image, all
+  /// set to value.
+  DenseCellGrid(int width, int height, int cell_size, const T& value = T()) {
+    reset(width, height, cell_size, value);
+  }
+
+  /// @brief Resize for a width x height image and set all cells to value.
+  /// Only allocates if the number of cells grows.
+  void reset(int width, int height, int cell_size, const T& value = T()) {
+    BASALT_ASSERT(width >= 0 && height >= 0 && cell_size > 0);
+
+    cell_size_ = cell_size;
+    cols_ = (width + cell_size - 1) / cell_size;
+    rows_ = (height + cell_size - 1) / cell_size;
+    cells_.assign(size_t(cols_) * rows_, value);
+  }
+
+  /// @brief Set all cells to value.
+  inline void fill(const T& value) {
+    std::fill(cells_.begin(), cells_.end(), value);
+  }
+
+  /// @brief Number of cells in horizontal direction.
+  inline int cols() const { return cols_; }
+
+  /// @brief Number of cells in vertical direction.
+  inline int rows() const { return rows_; }
+
+  /// @brief Size of the cells.
+  inline int cellSize() const { return cell_size_; }
+
+  /// @brief Cell of a position, see \ref gridCell.
+  template <class Derived>
+  inline Cell cellOf(const Eigen::MatrixBase<Derived>& pos) const {
+    return gridCell(pos, cell_size_);
+  }
+
+  /// @brief If cell is part of the grid.
+  inline bool inBounds(const Cell& cell) const {
+    return cell.x() >= 0 && cell.x() < cols_ && cell.y() >= 0 &&
+           cell.y() < rows_;
+  }
+
+  /// @brief Value of cell (x, y). There is no bounds check (unless
+  /// BASALT_ENABLE_BOUNDS_CHECKS is defined).
+  inline T& operator()(int x, int y) {
+    checkBounds(x, y);
+    return cells_[size_t(y) * cols_ + x];
+  }
+
+  /// @brief Value of cell (x, y). There is no bounds check (unless
+  /// BASALT_ENABLE_BOUNDS_CHECKS is defined).
+  inline const T& operator()(int x, int y) const {
+    checkBounds(x, y);
+    return cells_[size_t(y) * cols_ + x];
+  }
+
+  /// @brief Value of cell.
+  inline T& operator()(const Cell& cell) { return (*this)(cell.x(), cell.y()); }
+
+  /// @brief Value of cell.
+  inline const T& operator()(const Cell& cell) const {
+    return (*this)(cell.x(), cell.y());
+  }
+
+  /// @brief Row-major storage of all cells.
+  inline T* data() { return cells_.data(); }
+
+  /// @brief Row-major storage of all cells.
+  inline const T* data() const { return cells_.data(); }
+
+ private:
+  inline void checkBounds(int x, int y) const {
+#ifdef BASALT_ENABLE_BOUNDS_CHECKS
+    BASALT_ASSERT_STREAM(inBounds(Cell(x, y)), "cell " << x << " " << y
+                                                       << " grid " << cols_
+                                                       << "x" << rows_);
+#else
+    UNUSED(x);
+    UNUSED(y);
+#endif
+  }
+
+  int cell_size_ = 1;
+  int cols_ = 0;
+  int rows_ = 0;
+  std::vector<T> cells_;
+};
+
+}  // namespace basalt
@@ -121,6 +121,50 @@ void bmUnprojectJacobians(benchmark::State &state) {
   }
 }
 
+template <class CamT>
+void bmUnprojectBatch(benchmark::State &state) {
+  static constexpr int SIZE = 50;
+
+  using Scalar = typename CamT::Scalar;
+
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  // Same points as in bmUnproject, stored as 2xN matrix per camera.
+  const int num_points = (2 * SIZE + 1) * (2 * SIZE + 1);
+  std::vector<basalt::CameraBatchPoints2<Scalar>> proj(test_cams.size());
+  for (size_t i = 0; i < test_cams.size(); i++) {
+    proj[i].resize(2, num_points);
+    int k = 0;
+    for (int x = -SIZE; x <= SIZE; x++) {
+      for (int y = -SIZE; y <= SIZE; y++) {
+        proj[i].col(k++) << test_cams[i].getParam()(2) + x,
+            test_cams[i].getParam()(3) + y;
+      }
+    }
+  }
+
+  Eigen::Matrix<Scalar, 4, Eigen::Dynamic> p3d(4, num_points);
+  basalt::CameraBatchValid valid(num_points);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < test_cams.size(); i++) {
+      test_cams[i].unprojectBatch(proj[i], p3d, valid);
+      benchmark::DoNotOptimize(p3d.data());
+    }
+  }
+}
+
+template <class CamT>
+void bmComputeRpmax(benchmark::State &state) {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  for (auto _ : state) {
+    for (CamT &cam : test_cams) {
+      benchmark::DoNotOptimize(cam.computeRpmax());
+    }
+  }
+}
+
 BENCHMARK_TEMPLATE(bmProject, basalt::PinholeCamera<double>);
 BENCHMARK_TEMPLATE(bmProject, basalt::PinholeRadtan8Camera<double>);
 BENCHMARK_TEMPLATE(bmProject, basalt::ExtendedUnifiedCamera<double>);
@@ -146,11 +190,61 @@ BENCHMARK_TEMPLATE(bmUnproject, basalt::DoubleSphereCamera<double>);
 BENCHMARK_TEMPLATE(bmUnproject, basalt::FovCamera<double>);
 
 BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::PinholeCamera<double>);
-// BENCHMARK_TEMPL(bmUnprojectJacobians, basalt::PinholeRadtan8Camera<double>);
+// Unprojection Jacobians are not implemented for PinholeRadtan8Camera
 BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::ExtendedUnifiedCamera<double>);
 BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::UnifiedCamera<double>);
 BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::KannalaBrandtCamera4<double>);
 BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::DoubleSphereCamera<double>);
 BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::FovCamera<double>);
 
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::PinholeCamera<double>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::PinholeRadtan8Camera<double>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::ExtendedUnifiedCamera<double>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::UnifiedCamera<double>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::KannalaBrandtCamera4<double>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::DoubleSphereCamera<double>);
+
+BENCHMARK_TEMPLATE(bmComputeRpmax, basalt::PinholeRadtan8Camera<double>);
+BENCHMARK_TEMPLATE(bmComputeRpmax, basalt::PinholeRadtan8Camera<float>);
+
+// Single precision versions used in the tracking front-end
+BENCHMARK_TEMPLATE(bmProject, basalt::PinholeCamera<float>);
+BENCHMARK_TEMPLATE(bmProject, basalt::PinholeRadtan8Camera<float>);
+BENCHMARK_TEMPLATE(bmProject, basalt::ExtendedUnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmProject, basalt::UnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmProject, basalt::KannalaBrandtCamera4<float>);
+BENCHMARK_TEMPLATE(bmProject, basalt::DoubleSphereCamera<float>);
+BENCHMARK_TEMPLATE(bmProject, basalt::FovCamera<float>);
+
+BENCHMARK_TEMPLATE(bmProjectJacobians, basalt::PinholeCamera<float>);
+BENCHMARK_TEMPLATE(bmProjectJacobians, basalt::PinholeRadtan8Camera<float>);
+BENCHMARK_TEMPLATE(bmProjectJacobians, basalt::ExtendedUnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmProjectJacobians, basalt::UnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmProjectJacobians, basalt::KannalaBrandtCamera4<float>);
+BENCHMARK_TEMPLATE(bmProjectJacobians, basalt::DoubleSphereCamera<float>);
+BENCHMARK_TEMPLATE(bmProjectJacobians, basalt::FovCamera<float>);
+
+BENCHMARK_TEMPLATE(bmUnproject, basalt::PinholeCamera<float>);
+BENCHMARK_TEMPLATE(bmUnproject, basalt::PinholeRadtan8Camera<float>);
+BENCHMARK_TEMPLATE(bmUnproject, basalt::ExtendedUnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmUnproject, basalt::UnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmUnproject, basalt::KannalaBrandtCamera4<float>);
+BENCHMARK_TEMPLATE(bmUnproject, basalt::DoubleSphereCamera<float>);
+BENCHMARK_TEMPLATE(bmUnproject, basalt::FovCamera<float>);
+
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::PinholeCamera<float>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::PinholeRadtan8Camera<float>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::ExtendedUnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::UnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::KannalaBrandtCamera4<float>);
+BENCHMARK_TEMPLATE(bmUnprojectBatch, basalt::DoubleSphereCamera<float>);
+
+BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::PinholeCamera<float>);
+// Unprojection Jacobians are not implemented for PinholeRadtan8Camera
+BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::ExtendedUnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::UnifiedCamera<float>);
+BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::KannalaBrandtCamera4<float>);
+BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::DoubleSphereCamera<float>);
+BENCHMARK_TEMPLATE(bmUnprojectJacobians, basalt::FovCamera<float>);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,274 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include <basalt/image/cubic_spline_image.h>
+#include <basalt/image/gradient_image.h>
+#include <basalt/image/image.h>
+#include <basalt/image/image_pyr.h>
+#include <basalt/image/lazy_image_pyr.h>
+
+// Image sizes from VGA to 2 MP
+static void imageSizes(benchmark::internal::Benchmark *b) {
+  b->Args({640, 480})->Args({1280, 720})->Args({1920, 1080});
+}
+
+template <typename T>
+void setRandomImageData(basalt::ManagedImage<T> &img) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(0, std::numeric_limits<T>::max());
+
+  for (size_t y = 0; y < img.h; y++) {
+    for (size_t x = 0; x < img.w; x++) {
+      img(x, y) = T(dist(gen));
+    }
+  }
+}
+
+template <typename T>
+void bmPyrSetFromImage(benchmark::State &state) {
+  static constexpr int NUM_LEVELS = 3;
+
+  basalt::ManagedImage<T> img(state.range(0), state.range(1));
+  setRandomImageData(img);
+
+  basalt::ManagedImagePyr<T> pyr;
+
+  for (auto _ : state) {
+    pyr.setFromImage(img, NUM_LEVELS);
+    benchmark::DoNotOptimize(pyr.lvl(NUM_LEVELS).ptr);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * img.size() * sizeof(T));
+}
+
+// A frame of a tracker that only accesses the first levels of a deeper
+// pyramid. Compare with bmPyrSetFromImage, which computes every level.
+template <typename T, basalt::PyrLayout LAYOUT>
+void bmLazyPyr(benchmark::State &state) {
+  static constexpr int NUM_LEVELS = 3;
+  static constexpr int USED_LEVELS = 2;
+
+  basalt::ManagedImage<T> img(state.range(0), state.range(1));
+  setRandomImageData(img);
+
+  basalt::LazyImagePyr<T> pyr(LAYOUT);
+
+  for (auto _ : state) {
+    pyr.setFromImage(img, NUM_LEVELS);
+    benchmark::DoNotOptimize(pyr.lvl(USED_LEVELS).ptr);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * img.size() * sizeof(T));
+}
+
+template <typename T>
+void bmPyrSubsample(benchmark::State &state) {
+  basalt::ManagedImage<T> img(state.range(0), state.range(1));
+  setRandomImageData(img);
+
+  basalt::ManagedImage<T> res(img.w / 2, img.h / 2);
+  basalt::Image<T> res_img = res;
+  const basalt::Image<const T> src = std::as_const(img).SubImage(0, 0, img.w,
+                                                                 img.h);
+  std::vector<int> tmp;
+
+  for (auto _ : state) {
+    basalt::ManagedImagePyr<T>::subsample(src, res_img, tmp);
+    benchmark::DoNotOptimize(res.ptr);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * img.size() * sizeof(T));
+}
+
+// Random points in the interior of the image, as tracked by patch alignment
+static Eigen::Matrix<double, 2, Eigen::Dynamic> randomPoints(size_t w,
+                                                             size_t h) {
+  static constexpr int NUM_POINTS = 10000;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> dist_x(2, w - 3);
+  std::uniform_real_distribution<double> dist_y(2, h - 3);
+
+  Eigen::Matrix<double, 2, Eigen::Dynamic> points(2, NUM_POINTS);
+  for (int i = 0; i < NUM_POINTS; i++) {
+    points.col(i) << dist_x(gen), dist_y(gen);
+  }
+  return points;
+}
+
+template <typename T>
+void bmInterpGrad(benchmark::State &state) {
+  basalt::ManagedImage<T> img(640, 480);
+  setRandomImageData(img);
+
+  const Eigen::Matrix<double, 2, Eigen::Dynamic> points =
+      randomPoints(img.w, img.h);
+
+  for (auto _ : state) {
+    for (int i = 0; i < points.cols(); i++) {
+      const Eigen::Vector2d p = points.col(i);
+      benchmark::DoNotOptimize(img.template interpGrad<double>(p));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+template <typename T>
+void bmInterpGradBatch(benchmark::State &state) {
+  basalt::ManagedImage<T> img(640, 480);
+  setRandomImageData(img);
+
+  const Eigen::Matrix<double, 2, Eigen::Dynamic> points =
+      randomPoints(img.w, img.h);
+  Eigen::Matrix<double, 3, Eigen::Dynamic> res(3, points.cols());
+
+  for (auto _ : state) {
+    img.interpGradBatch(points, res);
+    benchmark::DoNotOptimize(res.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+template <typename T>
+void bmGradientImageSet(benchmark::State &state) {
+  basalt::ManagedImage<T> img(state.range(0), state.range(1));
+  setRandomImageData(img);
+
+  const basalt::Image<const T> src = std::as_const(img).SubImage(0, 0, img.w,
+                                                                 img.h);
+  basalt::GradientImage<T> grad_img;
+
+  for (auto _ : state) {
+    grad_img.setFromImage(src);
+    benchmark::DoNotOptimize(grad_img.texels().ptr);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * img.size() * sizeof(T));
+}
+
+template <typename T>
+void bmGradientImageInterpGradBatch(benchmark::State &state) {
+  basalt::ManagedImage<T> img(640, 480);
+  setRandomImageData(img);
+
+  const basalt::GradientImage<T> grad_img(
+      std::as_const(img).SubImage(0, 0, img.w, img.h));
+
+  const Eigen::Matrix<double, 2, Eigen::Dynamic> points =
+      randomPoints(img.w, img.h);
+  Eigen::Matrix<double, 3, Eigen::Dynamic> res(3, points.cols());
+
+  for (auto _ : state) {
+    grad_img.interpGradBatch(points, res);
+    benchmark::DoNotOptimize(res.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+template <typename T>
+void bmInterpGradCubicSplines(benchmark::State &state) {
+  basalt::ManagedImage<T> img(640, 480);
+  setRandomImageData(img);
+
+  const Eigen::Matrix<double, 2, Eigen::Dynamic> points =
+      randomPoints(img.w, img.h);
+  Eigen::Matrix<double, 3, Eigen::Dynamic> res(3, points.cols());
+
+  for (auto _ : state) {
+    for (int i = 0; i < points.cols(); i++) {
+      res.col(i) = img.template interpGradCubicSplines<double>(
+          points(0, i), points(1, i));
+    }
+    benchmark::DoNotOptimize(res.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+template <typename T>
+void bmCubicSplineImageSet(benchmark::State &state) {
+  basalt::ManagedImage<T> img(state.range(0), state.range(1));
+  setRandomImageData(img);
+
+  const basalt::Image<const T> src = std::as_const(img).SubImage(0, 0, img.w,
+                                                                 img.h);
+  basalt::CubicSplineImage<T> spline_img;
+
+  for (auto _ : state) {
+    spline_img.setFromImage(src);
+    benchmark::DoNotOptimize(spline_img.texels().ptr);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * img.size() * sizeof(T));
+}
+
+template <typename T>
+void bmCubicSplineImageInterpGradBatch(benchmark::State &state) {
+  basalt::ManagedImage<T> img(640, 480);
+  setRandomImageData(img);
+
+  const basalt::CubicSplineImage<T> spline_img(
+      std::as_const(img).SubImage(0, 0, img.w, img.h));
+
+  const Eigen::Matrix<double, 2, Eigen::Dynamic> points =
+      randomPoints(img.w, img.h);
+  Eigen::Matrix<double, 3, Eigen::Dynamic> res(3, points.cols());
+
+  for (auto _ : state) {
+    spline_img.interpGradCubicSplinesBatch(points, res);
+    benchmark::DoNotOptimize(res.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+BENCHMARK_TEMPLATE(bmPyrSetFromImage, uint8_t)->Apply(imageSizes);
+BENCHMARK_TEMPLATE(bmPyrSetFromImage, uint16_t)->Apply(imageSizes);
+
+BENCHMARK_TEMPLATE(bmLazyPyr, uint8_t, basalt::PyrLayout::Mipmap)
+    ->Apply(imageSizes);
+BENCHMARK_TEMPLATE(bmLazyPyr, uint8_t, basalt::PyrLayout::PerLevel)
+    ->Apply(imageSizes);
+BENCHMARK_TEMPLATE(bmLazyPyr, uint16_t, basalt::PyrLayout::Mipmap)
+    ->Apply(imageSizes);
+BENCHMARK_TEMPLATE(bmLazyPyr, uint16_t, basalt::PyrLayout::PerLevel)
+    ->Apply(imageSizes);
+
+BENCHMARK_TEMPLATE(bmPyrSubsample, uint8_t)->Apply(imageSizes);
+BENCHMARK_TEMPLATE(bmPyrSubsample, uint16_t)->Apply(imageSizes);
+
+BENCHMARK_TEMPLATE(bmInterpGrad, uint8_t);
+BENCHMARK_TEMPLATE(bmInterpGrad, uint16_t);
+
+BENCHMARK_TEMPLATE(bmInterpGradBatch, uint8_t);
+BENCHMARK_TEMPLATE(bmInterpGradBatch, uint16_t);
+
+BENCHMARK_TEMPLATE(bmGradientImageSet, uint8_t)->Apply(imageSizes);
+BENCHMARK_TEMPLATE(bmGradientImageSet, uint16_t)->Apply(imageSizes);
+
+BENCHMARK_TEMPLATE(bmGradientImageInterpGradBatch, uint8_t);
+BENCHMARK_TEMPLATE(bmGradientImageInterpGradBatch, uint16_t);
+
+BENCHMARK_TEMPLATE(bmInterpGradCubicSplines, uint8_t);
+BENCHMARK_TEMPLATE(bmInterpGradCubicSplines, uint16_t);
+
+BENCHMARK_TEMPLATE(bmCubicSplineImageSet, uint8_t)->Apply(imageSizes);
+BENCHMARK_TEMPLATE(bmCubicSplineImageSet, uint16_t)->Apply(imageSizes);
+
+BENCHMARK_TEMPLATE(bmCubicSplineImageInterpGradBatch, uint8_t);
+BENCHMARK_TEMPLATE(bmCubicSplineImageInterpGradBatch, uint16_t);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include <basalt/imu/pose_vel_bias_state_array.h>
+#include <basalt/imu/preintegration.h>
+#include <basalt/spline/se3_spline.h>
+
+// 1 s of IMU measurements at 200 Hz, the typical segment between two
+// keyframes
+static constexpr int NUM_SAMPLES = 200;
+static constexpr int64_t DT_NS = 5e6;
+
+static const Eigen::Vector3d G(0, 0, -9.81);
+
+template <typename Scalar>
+Eigen::aligned_vector<basalt::ImuData<Scalar>> imuSegment() {
+  basalt::Se3Spline<5> gt_spline(int64_t(1e8));
+  gt_spline.genRandomTrajectory(20);
+
+  Eigen::aligned_vector<basalt::ImuData<Scalar>> res;
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    const int64_t t_ns = i * DT_NS + DT_NS / 2;
+
+    const Sophus::SE3d pose = gt_spline.pose(t_ns);
+
+    basalt::ImuData<Scalar> data;
+    data.t_ns = t_ns;
+    data.accel = (pose.so3().inverse() *
+                  (gt_spline.transAccelWorld(t_ns) - G))
+                     .template cast<Scalar>();
+    data.gyro = gt_spline.rotVelBody(t_ns).template cast<Scalar>();
+    res.push_back(data);
+  }
+  return res;
+}
+
+template <typename Scalar>
+void bmIntegrate(benchmark::State &state) {
+  using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+
+  const Eigen::aligned_vector<basalt::ImuData<Scalar>> data =
+      imuSegment<Scalar>();
+
+  for (auto _ : state) {
+    basalt::IntegratedImuMeasurement<Scalar> imu_meas(0, Vec3::Zero(),
+                                                      Vec3::Zero());
+    for (const auto &d : data) {
+      imu_meas.integrate(d, Vec3::Ones(), Vec3::Ones());
+    }
+    benchmark::DoNotOptimize(imu_meas.getDeltaState());
+  }
+
+  state.SetItemsProcessed(state.iterations() * data.size());
+}
+
+template <typename Scalar>
+void bmIntegrateBatch(benchmark::State &state) {
+  using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+
+  const Eigen::aligned_vector<basalt::ImuData<Scalar>> data =
+      imuSegment<Scalar>();
+
+  for (auto _ : state) {
+    basalt::IntegratedImuMeasurement<Scalar> imu_meas(0, Vec3::Zero(),
+                                                      Vec3::Zero());
+    imu_meas.integrateBatch(data, Vec3::Ones(), Vec3::Ones());
+    benchmark::DoNotOptimize(imu_meas.getDeltaState());
+  }
+
+  state.SetItemsProcessed(state.iterations() * data.size());
+}
+
+template <typename Scalar>
+void bmStateApplyInc(benchmark::State &state) {
+  using States = Eigen::aligned_vector<basalt::PoseVelBiasState<Scalar>>;
+  using VecX = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+  States states(state.range(0));
+  const VecX inc =
+      VecX::Random(basalt::POSE_VEL_BIAS_SIZE * states.size()) * Scalar(1e-3);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < states.size(); i++) {
+      states[i].applyInc(inc.template segment<basalt::POSE_VEL_BIAS_SIZE>(
+          basalt::POSE_VEL_BIAS_SIZE * i));
+    }
+    benchmark::DoNotOptimize(states.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * states.size());
+}
+
+template <typename Scalar>
+void bmStateArrayApplyInc(benchmark::State &state) {
+  using VecX = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+  basalt::PoseVelBiasStateArray<Scalar> states(state.range(0));
+  const VecX inc =
+      VecX::Random(basalt::POSE_VEL_BIAS_SIZE * states.size()) * Scalar(1e-3);
+
+  for (auto _ : state) {
+    states.applyInc(inc);
+    benchmark::DoNotOptimize(states.poses().data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * states.size());
+}
+
+BENCHMARK_TEMPLATE(bmIntegrate, double);
+BENCHMARK_TEMPLATE(bmIntegrate, float);
+
+BENCHMARK_TEMPLATE(bmIntegrateBatch, double);
+BENCHMARK_TEMPLATE(bmIntegrateBatch, float);
+
+BENCHMARK_TEMPLATE(bmStateApplyInc, double)->Arg(2000);
+BENCHMARK_TEMPLATE(bmStateArrayApplyInc, double)->Arg(2000);
+
+BENCHMARK_MAIN();
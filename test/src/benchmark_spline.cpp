@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+
+#include <basalt/spline/se3_spline.h>
+#include <basalt/spline/so3_spline.h>
+#include <basalt/spline/spline_imu_residuals.h>
+#include <basalt/utils/parallel.h>
+
+// Knots at 10 Hz over 10 s, queried at sorted random times as by a
+// measurement loop
+static constexpr int NUM_KNOTS = 100;
+static constexpr int64_t DT_NS = 1e8;
+static constexpr int NUM_QUERIES = 1000;
+
+static std::vector<int64_t> queryTimes(int64_t min_t_ns, int64_t max_t_ns) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int64_t> dist(min_t_ns, max_t_ns);
+
+  std::vector<int64_t> res(NUM_QUERIES);
+  for (auto &t_ns : res) t_ns = dist(gen);
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+template <int N>
+void bmSo3SplineEvaluate(benchmark::State &state) {
+  basalt::So3Spline<N> spline(DT_NS);
+  spline.genRandomTrajectory(NUM_KNOTS);
+
+  const std::vector<int64_t> times =
+      queryTimes(spline.minTimeNs(), spline.maxTimeNs());
+
+  for (auto _ : state) {
+    for (int64_t t_ns : times) {
+      benchmark::DoNotOptimize(spline.evaluate(t_ns));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+template <int N>
+void bmSo3SplineVelocityBody(benchmark::State &state) {
+  basalt::So3Spline<N> spline(DT_NS);
+  spline.genRandomTrajectory(NUM_KNOTS);
+
+  const std::vector<int64_t> times =
+      queryTimes(spline.minTimeNs(), spline.maxTimeNs());
+
+  for (auto _ : state) {
+    for (int64_t t_ns : times) {
+      benchmark::DoNotOptimize(spline.velocityBody(t_ns));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+template <int N>
+void bmSe3SplinePose(benchmark::State &state) {
+  basalt::Se3Spline<N> spline(DT_NS);
+  spline.genRandomTrajectory(NUM_KNOTS);
+
+  const std::vector<int64_t> times =
+      queryTimes(spline.minTimeNs(), spline.maxTimeNs());
+
+  for (auto _ : state) {
+    for (int64_t t_ns : times) {
+      benchmark::DoNotOptimize(spline.pose(t_ns));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+template <int N, bool CACHE>
+void bmSe3SplineGyroResidualJacobian(benchmark::State &state) {
+  basalt::Se3Spline<N> spline(DT_NS);
+  spline.genRandomTrajectory(NUM_KNOTS);
+  spline.setKnotDeltaCache(CACHE);
+
+  const std::vector<int64_t> times =
+      queryTimes(spline.minTimeNs(), spline.maxTimeNs());
+
+  basalt::CalibGyroBias<double> gyro_bias;
+  const Eigen::Vector3d meas(0.1, -0.2, 0.3);
+  typename basalt::Se3Spline<N>::SO3JacobianStruct J;
+
+  for (auto _ : state) {
+    for (int64_t t_ns : times) {
+      benchmark::DoNotOptimize(spline.gyroResidual(t_ns, meas, gyro_bias, &J));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+void bmSe3SplineAccumulateImuResiduals(benchmark::State &state) {
+  static constexpr int N = 5;
+
+  basalt::Se3Spline<N> spline(DT_NS);
+  spline.genRandomTrajectory(NUM_KNOTS);
+
+  // 200 Hz IMU
+  std::vector<basalt::ImuData<double>> data;
+  for (int64_t t_ns = spline.minTimeNs(); t_ns < spline.maxTimeNs();
+       t_ns += 5e6) {
+    basalt::ImuData<double> d;
+    d.t_ns = t_ns;
+    d.gyro.setRandom();
+    d.accel.setRandom();
+    data.emplace_back(d);
+  }
+
+  basalt::CalibGyroBias<double> gyro_bias;
+  basalt::CalibAccelBias<double> accel_bias;
+  const Eigen::Vector3d g(0, 0, -9.81);
+
+  basalt::SplineImuLinearSystem<N> ls;
+
+  for (auto _ : state) {
+    ls.setZero(spline.numKnots());
+    basalt::ThreadSpawnExecutor executor;
+    basalt::accumulateImuResiduals(spline, data, gyro_bias, accel_bias, g,
+                                   1.0, 1.0, ls, executor, state.range(0));
+    executor.join();
+    benchmark::DoNotOptimize(ls.b_calib);
+  }
+
+  state.SetItemsProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK_TEMPLATE(bmSo3SplineEvaluate, 4);
+BENCHMARK_TEMPLATE(bmSo3SplineEvaluate, 5);
+BENCHMARK_TEMPLATE(bmSo3SplineEvaluate, 6);
+
+BENCHMARK_TEMPLATE(bmSo3SplineVelocityBody, 4);
+BENCHMARK_TEMPLATE(bmSo3SplineVelocityBody, 5);
+BENCHMARK_TEMPLATE(bmSo3SplineVelocityBody, 6);
+
+BENCHMARK_TEMPLATE(bmSe3SplinePose, 4);
+BENCHMARK_TEMPLATE(bmSe3SplinePose, 5);
+BENCHMARK_TEMPLATE(bmSe3SplinePose, 6);
+
+BENCHMARK_TEMPLATE(bmSe3SplineGyroResidualJacobian, 5, false);
+BENCHMARK_TEMPLATE(bmSe3SplineGyroResidualJacobian, 5, true);
+
+BENCHMARK(bmSe3SplineAccumulateImuResiduals)->Arg(0)->Arg(3);
+
+BENCHMARK_MAIN();
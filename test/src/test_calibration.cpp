@@ -0,0 +1,398 @@
+/**
+BSD 3-Clause License
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <basalt/serialization/calibration_binary.h>
+#include <basalt/serialization/headers_serialization.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+basalt::Calibration<double> makeTestCalibration() {
+  basalt::Calibration<double> calib;
+
+  using VariantT = decltype(basalt::GenericCamera<double>::variant);
+  constexpr size_t NUM_MODELS = std::variant_size_v<VariantT>;
+
+  for (size_t i = 0; i < NUM_MODELS; i++) {
+    calib.T_i_c.emplace_back(Sophus::SE3d::exp(Sophus::Vector6d::Random()));
+
+    // the binary model ids are 1, ..., NUM_MODELS
+    basalt::GenericCamera<double> cam;
+    EXPECT_TRUE(basalt::calibBinaryCameraFromType(uint32_t(i + 1), cam));
+    std::visit(
+        [&](auto& model) {
+          using CamT = std::decay_t<decltype(model)>;
+          model = CamT::getTestProjections().back();
+        },
+        cam.variant);
+    calib.intrinsics.emplace_back(cam);
+
+    calib.resolution.emplace_back(640 + i, 480 + 2 * i);
+  }
+
+  for (size_t i = 0; i < 2; i++) {
+    basalt::RdSpline<1, 4, double> vignette(10e9, -int64_t(i) * 1000);
+    for (size_t j = 0; j < 5 + i; j++) {
+      vignette.knotsPushBack(Eigen::Matrix<double, 1, 1>::Random());
+    }
+    calib.vignette.emplace_back(vignette);
+  }
+
+  calib.cam_time_offset_ns = -12345;
+  calib.calib_accel_bias.setRandom();
+  calib.calib_gyro_bias.setRandom();
+  calib.imu_update_rate = 400;
+  calib.gyro_noise_std.setRandom();
+  calib.accel_noise_std.setRandom();
+  calib.gyro_bias_std.setRandom();
+  calib.accel_bias_std.setRandom();
+
+  return calib;
+}
+
+// Values that went through JSON are compared up to rounding in the last
+// digit, since exact decimal round trips depend on the precision of the
+// parser. The binary format itself is always exact.
+template <class Derived1, class Derived2>
+void expectMatrixEq(const Eigen::MatrixBase<Derived1>& a,
+                    const Eigen::MatrixBase<Derived2>& b, bool exact) {
+  if (exact) {
+    EXPECT_EQ(a.eval(), b.eval());
+  } else {
+    EXPECT_TRUE(a.isApprox(b, 4 * std::numeric_limits<double>::epsilon()))
+        << "a:\n"
+        << a << "\nb:\n"
+        << b;
+  }
+}
+
+void expectCalibrationEq(const basalt::Calibration<double>& a,
+                         const basalt::Calibration<double>& b,
+                         bool exact = true) {
+  ASSERT_EQ(a.intrinsics.size(), b.intrinsics.size());
+  for (size_t i = 0; i < a.intrinsics.size(); i++) {
+    EXPECT_TRUE(a.T_i_c[i].matrix().isApprox(b.T_i_c[i].matrix(), 1e-15));
+    EXPECT_EQ(a.intrinsics[i].variant.index(),
+              b.intrinsics[i].variant.index());
+    EXPECT_EQ(a.intrinsics[i].getName(), b.intrinsics[i].getName());
+    expectMatrixEq(a.intrinsics[i].getParam(), b.intrinsics[i].getParam(),
+                   exact);
+    EXPECT_EQ(a.resolution[i], b.resolution[i]);
+  }
+
+  ASSERT_EQ(a.vignette.size(), b.vignette.size());
+  for (size_t i = 0; i < a.vignette.size(); i++) {
+    EXPECT_EQ(a.vignette[i].minTimeNs(), b.vignette[i].minTimeNs());
+    EXPECT_EQ(a.vignette[i].getTimeIntervalNs(),
+              b.vignette[i].getTimeIntervalNs());
+    ASSERT_EQ(a.vignette[i].getKnots().size(), b.vignette[i].getKnots().size());
+    for (size_t j = 0; j < a.vignette[i].getKnots().size(); j++) {
+      expectMatrixEq(a.vignette[i].getKnots()[j], b.vignette[i].getKnots()[j],
+                     exact);
+    }
+  }
+
+  EXPECT_EQ(a.cam_time_offset_ns, b.cam_time_offset_ns);
+  expectMatrixEq(a.calib_accel_bias.getParam(), b.calib_accel_bias.getParam(),
+                 exact);
+  expectMatrixEq(a.calib_gyro_bias.getParam(), b.calib_gyro_bias.getParam(),
+                 exact);
+  EXPECT_EQ(a.imu_update_rate, b.imu_update_rate);
+  expectMatrixEq(a.gyro_noise_std, b.gyro_noise_std, exact);
+  expectMatrixEq(a.accel_noise_std, b.accel_noise_std, exact);
+  expectMatrixEq(a.gyro_bias_std, b.gyro_bias_std, exact);
+  expectMatrixEq(a.accel_bias_std, b.accel_bias_std, exact);
+}
+
+}  // namespace
+
+TEST(CalibrationBinaryTest, RoundTrip) {
+  const basalt::Calibration<double> calib = makeTestCalibration();
+
+  std::vector<uint8_t> buf;
+  basalt::calibToBinary(calib, buf);
+
+  basalt::CalibBinaryView view;
+  ASSERT_TRUE(view.init(buf.data(), buf.size()));
+  EXPECT_EQ(view.numCameras(), calib.intrinsics.size());
+  EXPECT_EQ(view.numVignettes(), calib.vignette.size());
+
+  // records can be used in place
+  for (size_t i = 0; i < view.numCameras(); i++) {
+    EXPECT_EQ(view.camera(i).camera_type,
+              uint32_t(basalt::calibBinaryCameraType(calib.intrinsics[i])));
+    EXPECT_EQ(view.camera(i).resolution[0], calib.resolution[i][0]);
+    EXPECT_EQ(view.camera(i).intrinsics[0], calib.intrinsics[i].getParam()[0]);
+  }
+  EXPECT_EQ(view.vignetteKnots(1)[2], calib.vignette[1].getKnots()[2][0]);
+
+  basalt::Calibration<double> calib_loaded;
+  view.toCalibration(calib_loaded);
+  expectCalibrationEq(calib, calib_loaded);
+
+  // radtan8 keeps the stored rpmax
+  for (size_t i = 0; i < calib.intrinsics.size(); i++) {
+    const auto* a = std::get_if<basalt::PinholeRadtan8Camera<double>>(
+        &calib.intrinsics[i].variant);
+    const auto* b = std::get_if<basalt::PinholeRadtan8Camera<double>>(
+        &calib_loaded.intrinsics[i].variant);
+    ASSERT_EQ(a == nullptr, b == nullptr);
+    if (a) {
+      EXPECT_EQ(a->getRpmax(), b->getRpmax());
+    }
+  }
+
+  basalt::Calibration<float> calib_float;
+  view.toCalibration(calib_float);
+  EXPECT_EQ(calib_float.intrinsics.size(), calib.intrinsics.size());
+  EXPECT_TRUE(calib_float.intrinsics[0].getParam().isApprox(
+      calib.intrinsics[0].getParam().cast<float>()));
+}
+
+TEST(CalibrationBinaryTest, CameraTypes) {
+  using basalt::CalibBinaryCameraType;
+
+  // the ids are part of the file format and must not change
+  const std::vector<std::pair<std::string, CalibBinaryCameraType>> ids = {
+      {"eucm", CalibBinaryCameraType::EUCM},
+      {"ds", CalibBinaryCameraType::DS},
+      {"kb4", CalibBinaryCameraType::KB4},
+      {"ucm", CalibBinaryCameraType::UCM},
+      {"pinhole", CalibBinaryCameraType::PINHOLE},
+      {"pinhole-radtan8", CalibBinaryCameraType::PINHOLE_RADTAN8}};
+
+  using VariantT = decltype(basalt::GenericCamera<double>::variant);
+  ASSERT_EQ(ids.size(), std::variant_size_v<VariantT>);
+
+  for (const auto& [name, id] : ids) {
+    const basalt::GenericCamera<double> cam =
+        basalt::GenericCamera<double>::fromString(name);
+    ASSERT_EQ(cam.getName(), name);
+    EXPECT_EQ(basalt::calibBinaryCameraType(cam), id) << name;
+
+    basalt::GenericCamera<double> cam_from_id;
+    ASSERT_TRUE(basalt::calibBinaryCameraFromType(uint32_t(id), cam_from_id));
+    EXPECT_EQ(cam_from_id.getName(), name);
+    EXPECT_EQ(basalt::calibBinaryNumIntrinsics(uint32_t(id)),
+              int(cam.getParam().size()) + (name == "pinhole-radtan8"));
+  }
+
+  basalt::GenericCamera<double> cam;
+  EXPECT_FALSE(basalt::calibBinaryCameraFromType(0, cam));
+  EXPECT_FALSE(basalt::calibBinaryCameraFromType(100, cam));
+  EXPECT_EQ(basalt::calibBinaryNumIntrinsics(0), -1);
+}
+
+TEST(CalibrationBinaryTest, ConvertJson) {
+  const basalt::Calibration<double> calib = makeTestCalibration();
+
+  std::stringstream json;
+  {
+    cereal::JSONOutputArchive ar(json);
+    ar(calib);
+  }
+  const std::string json_str = json.str();
+
+  std::vector<uint8_t> buf;
+  basalt::convertCalibToBinary(json, buf);
+
+  basalt::CalibBinaryView view;
+  ASSERT_TRUE(view.init(buf.data(), buf.size()));
+
+  basalt::Calibration<double> calib_binary;
+  view.toCalibration(calib_binary);
+  expectCalibrationEq(calib, calib_binary, false);
+
+  // the conversion adds no error to the values loaded from JSON
+  basalt::Calibration<double> calib_json;
+  {
+    std::stringstream is(json_str);
+    cereal::JSONInputArchive ar(is);
+    ar(calib_json);
+  }
+  expectCalibrationEq(calib_json, calib_binary);
+
+  // JSON -> binary -> JSON gives the same calibration
+  std::stringstream json_binary;
+  {
+    cereal::JSONOutputArchive ar(json_binary);
+    ar(calib_binary);
+  }
+
+  basalt::Calibration<double> calib_json_binary;
+  {
+    cereal::JSONInputArchive ar(json_binary);
+    ar(calib_json_binary);
+  }
+  expectCalibrationEq(calib_json, calib_json_binary, false);
+}
+
+TEST(CalibrationBinaryTest, File) {
+  const basalt::Calibration<double> calib = makeTestCalibration();
+
+  const std::string path = testing::TempDir() + "calib_binary_test.bin";
+  ASSERT_TRUE(basalt::saveCalibBinary(path, calib));
+
+  basalt::Calibration<double> calib_loaded;
+  ASSERT_TRUE(basalt::loadCalibBinary(path, calib_loaded));
+  expectCalibrationEq(calib, calib_loaded);
+
+  std::remove(path.c_str());
+  EXPECT_FALSE(basalt::loadCalibBinary(path, calib_loaded));
+}
+
+TEST(CalibrationBinaryTest, Invalid) {
+  const basalt::Calibration<double> calib = makeTestCalibration();
+
+  std::vector<uint8_t> buf;
+  basalt::calibToBinary(calib, buf);
+
+  basalt::CalibBinaryView view;
+  EXPECT_TRUE(view.init(buf.data(), buf.size()));
+  EXPECT_FALSE(view.init(buf.data(), buf.size() - 8));
+  EXPECT_FALSE(view.valid());
+  EXPECT_FALSE(view.init(nullptr, buf.size()));
+
+  auto modified = [&](size_t offset, uint8_t value) {
+    std::vector<uint8_t> res = buf;
+    res[offset] = value;
+    return res;
+  };
+
+  // magic
+  std::vector<uint8_t> b = modified(0, 'X');
+  EXPECT_FALSE(view.init(b.data(), b.size()));
+
+  // version
+  b = modified(offsetof(basalt::CalibBinaryHeader, version),
+               basalt::CalibBinaryHeader::VERSION + 1);
+  EXPECT_FALSE(view.init(b.data(), b.size()));
+
+  // camera type of the first camera
+  b = modified(sizeof(basalt::CalibBinaryHeader) +
+                   sizeof(basalt::CalibBinaryImu) +
+                   offsetof(basalt::CalibBinaryCamera, camera_type),
+               100);
+  EXPECT_FALSE(view.init(b.data(), b.size()));
+
+  // knot count that wraps around in the size computation: 2^61 extra knots
+  // are 2^64 extra bytes, so the 64 bit size would still match
+  b = buf;
+  {
+    basalt::CalibBinaryHeader header;
+    std::memcpy(&header, b.data(), sizeof(header));
+    header.num_vignette_knots += uint64_t(1) << 61;
+    std::memcpy(b.data(), &header, sizeof(header));
+  }
+  EXPECT_FALSE(view.init(b.data(), b.size()));
+
+  // truncated to the header
+  EXPECT_FALSE(view.init(buf.data(), sizeof(basalt::CalibBinaryHeader)));
+
+  // knot offset of the first vignette
+  b = modified(sizeof(basalt::CalibBinaryHeader) +
+                   sizeof(basalt::CalibBinaryImu) +
+                   calib.intrinsics.size() * sizeof(basalt::CalibBinaryCamera) +
+                   offsetof(basalt::CalibBinaryVignette, knot_offset),
+               100);
+  EXPECT_FALSE(view.init(b.data(), b.size()));
+}
+
+TEST(CalibrationTest, ProjectBatch) {
+  const basalt::Calibration<double> calib = makeTestCalibration();
+  const size_t num_cams = calib.intrinsics.size();
+
+  // More than one block, not a multiple of the block size.
+  const int num_points =
+      2 * basalt::Calibration<double>::PROJECT_BATCH_BLOCK_SIZE + 123;
+  const basalt::CameraBatchPoints3<double> p3d_i =
+      basalt::CameraBatchPoints3<double>::Random(3, num_points) * 5.0;
+
+  const double border = 2;
+
+  std::vector<basalt::CameraBatchPoints2<double>> proj;
+  std::vector<basalt::CameraBatchValid> valid, in_image;
+  calib.projectBatch(p3d_i, proj, valid, in_image, border);
+
+  std::vector<basalt::CameraBatchPoints2<double>> proj_mt;
+  std::vector<basalt::CameraBatchValid> valid_mt, in_image_mt;
+  std::vector<std::thread> threads;
+  const auto executor = [&](std::function<void()> task) {
+    threads.emplace_back(std::move(task));
+  };
+  calib.projectBatch(p3d_i, proj_mt, valid_mt, in_image_mt, executor, 2,
+                     border);
+  for (auto& t : threads) t.join();
+
+  ASSERT_EQ(proj.size(), num_cams);
+  ASSERT_EQ(valid.size(), num_cams);
+  ASSERT_EQ(in_image.size(), num_cams);
+
+  int num_in_image = 0;
+  for (size_t c = 0; c < num_cams; c++) {
+    const Eigen::Matrix4d T_c_i = calib.T_i_c[c].inverse().matrix();
+    const Eigen::Vector2d res(calib.resolution[c].cast<double>());
+
+    for (int i = 0; i < num_points; i++) {
+      Eigen::Vector2d p;
+      const bool success = calib.intrinsics[c].project(
+          Eigen::Vector4d(T_c_i * p3d_i.col(i).homogeneous()), p);
+      const bool inside = success && p.x() >= border &&
+                          p.x() < res.x() - border && p.y() >= border &&
+                          p.y() < res.y() - border;
+      num_in_image += inside;
+
+      ASSERT_EQ(success, valid[c][i] != 0) << "c " << c << " i " << i;
+      ASSERT_EQ(inside, in_image[c][i] != 0) << "c " << c << " i " << i;
+      if (success) {
+        EXPECT_LE((p - proj[c].col(i)).norm(), 1e-6 * std::max(1.0, p.norm()));
+        EXPECT_EQ(proj[c].col(i), proj_mt[c].col(i));
+      }
+
+      EXPECT_EQ(valid[c][i], valid_mt[c][i]);
+      EXPECT_EQ(in_image[c][i], in_image_mt[c][i]);
+    }
+  }
+
+  // Make sure the in-image check is exercised.
+  EXPECT_GT(num_in_image, 0);
+}
@@ -33,6 +33,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <basalt/camera/generic_camera.hpp>
 #include <basalt/camera/stereographic_param.hpp>
 
+#include <limits>
+#include <random>
+
 #include "gtest/gtest.h"
 #include "test_utils.h"
 
@@ -568,6 +571,776 @@ TEST(CameraTestCase, FovUnprojectJacobiansFloat3) {
 
 ////////////////////////////////////////////////////////////////
 
+template <typename CamT>
+void testProjectBatch() {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  using Scalar = typename CamT::Scalar;
+  using Vec2 = typename CamT::Vec2;
+  using Vec4 = typename CamT::Vec4;
+
+  // Number of points is not a multiple of the batch size to test the tail.
+  const int num_points = 21 * 21 * 7;
+  basalt::CameraBatchPoints3<Scalar> p3d(3, num_points);
+  int i = 0;
+  for (int x = -10; x <= 10; x++) {
+    for (int y = -10; y <= 10; y++) {
+      for (int z = -1; z <= 5; z++) {
+        p3d.col(i++) << x, y, z;
+      }
+    }
+  }
+
+  // Column-major 4xN input goes through the strided load path.
+  const Eigen::Matrix<Scalar, 4, Eigen::Dynamic> p4d =
+      p3d.colwise().homogeneous();
+
+  const Scalar tol = Sophus::Constants<Scalar>::epsilonSqrt();
+
+  for (const CamT &cam : test_cams) {
+    basalt::CameraBatchPoints2<Scalar> proj3(2, num_points);
+    basalt::CameraBatchPoints2<Scalar> proj4(2, num_points);
+    basalt::CameraBatchValid valid3(num_points);
+    basalt::CameraBatchValid valid4(num_points);
+
+    cam.projectBatch(p3d, proj3, valid3);
+    cam.projectBatch(p4d, proj4, valid4);
+
+    for (int j = 0; j < num_points; j++) {
+      Vec2 res;
+      const bool success = cam.project(Vec4(p4d.col(j)), res);
+
+      ASSERT_EQ(success, valid3[j] != 0) << "p3d " << p3d.col(j).transpose();
+      ASSERT_EQ(success, valid4[j] != 0) << "p3d " << p3d.col(j).transpose();
+
+      if (success) {
+        const Scalar scale = std::max(Scalar(1), res.norm());
+        EXPECT_LE((res - proj3.col(j)).norm(), tol * scale)
+            << "res " << res.transpose() << " proj3 "
+            << proj3.col(j).transpose();
+        EXPECT_LE((res - proj4.col(j)).norm(), tol * scale)
+            << "res " << res.transpose() << " proj4 "
+            << proj4.col(j).transpose();
+      }
+    }
+  }
+}
+
+template <typename CamT>
+void testProjectBatchJacobians() {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  constexpr int N = CamT::N;
+
+  using Scalar = typename CamT::Scalar;
+  using Vec2 = typename CamT::Vec2;
+  using Vec4 = typename CamT::Vec4;
+  using Mat24 = typename CamT::Mat24;
+  using Mat2N = typename CamT::Mat2N;
+
+  using Mat23 = Eigen::Matrix<Scalar, 2, 3>;
+  using Mat2NRowMajor = Eigen::Matrix<Scalar, 2, N, Eigen::RowMajor>;
+
+  const int num_points = 21 * 21 * 7;
+  basalt::CameraBatchPoints3<Scalar> p3d(3, num_points);
+  int i = 0;
+  for (int x = -10; x <= 10; x++) {
+    for (int y = -10; y <= 10; y++) {
+      for (int z = -1; z <= 5; z++) {
+        p3d.col(i++) << x, y, z;
+      }
+    }
+  }
+
+  const Eigen::Matrix<Scalar, 4, Eigen::Dynamic, Eigen::RowMajor> p4d =
+      p3d.colwise().homogeneous();
+
+  const Scalar tol = Sophus::Constants<Scalar>::epsilonSqrt();
+
+  for (const CamT &cam : test_cams) {
+    basalt::CameraBatchPoints2<Scalar> proj3(2, num_points);
+    basalt::CameraBatchPoints2<Scalar> proj4(2, num_points);
+    basalt::CameraBatchValid valid3(num_points);
+    basalt::CameraBatchValid valid4(num_points);
+
+    Eigen::aligned_vector<Mat23> J_p3(num_points);
+    Eigen::aligned_vector<Mat2NRowMajor> J_param3(num_points);
+    Eigen::aligned_vector<Mat24> J_p4(num_points);
+    Eigen::aligned_vector<Mat2N> J_param4(num_points);
+
+    cam.projectBatch(p3d, proj3, valid3, J_p3.data(), J_param3.data());
+    cam.projectBatch(p4d, proj4, valid4, J_p4.data(), J_param4.data());
+
+    for (int j = 0; j < num_points; j++) {
+      Vec2 res;
+      Mat24 J_p;
+      Mat2N J_param;
+      const bool success =
+          cam.project(Vec4(p4d.col(j)), res, &J_p, &J_param);
+
+      ASSERT_EQ(success, valid3[j] != 0) << "p3d " << p3d.col(j).transpose();
+      ASSERT_EQ(success, valid4[j] != 0) << "p3d " << p3d.col(j).transpose();
+
+      if (success) {
+        const Scalar scale = std::max(Scalar(1), res.norm());
+        EXPECT_LE((res - proj3.col(j)).norm(), tol * scale);
+        EXPECT_LE((res - proj4.col(j)).norm(), tol * scale);
+
+        const Scalar scale_p = std::max(Scalar(1), J_p.norm());
+        EXPECT_LE((J_p.template leftCols<3>() - J_p3[j]).norm(), tol * scale_p)
+            << "J_p\n"
+            << J_p << "\nJ_p3\n"
+            << J_p3[j];
+        EXPECT_LE((J_p - J_p4[j]).norm(), tol * scale_p) << "J_p\n"
+                                                          << J_p << "\nJ_p4\n"
+                                                          << J_p4[j];
+
+        const Scalar scale_param = std::max(Scalar(1), J_param.norm());
+        EXPECT_LE((J_param - J_param3[j]).norm(), tol * scale_param)
+            << "J_param\n"
+            << J_param << "\nJ_param3\n"
+            << J_param3[j];
+        EXPECT_LE((J_param - J_param4[j]).norm(), tol * scale_param)
+            << "J_param\n"
+            << J_param << "\nJ_param4\n"
+            << J_param4[j];
+      }
+    }
+  }
+}
+
+template <typename CamT>
+void testGenericProjectBatch() {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  using Scalar = typename CamT::Scalar;
+  using Vec3 = Eigen::Matrix<Scalar, 3, 1>;
+  using Vec4 = typename CamT::Vec4;
+  using Mat4 = Eigen::Matrix<Scalar, 4, 4>;
+
+  const int num_points = 1000;
+  const basalt::CameraBatchPoints3<Scalar> p3d =
+      basalt::CameraBatchPoints3<Scalar>::Random(3, num_points) * Scalar(10);
+
+  Eigen::aligned_vector<Vec4> p3d_vec(num_points);
+  for (int i = 0; i < num_points; i++) {
+    p3d_vec[i] = p3d.col(i).homogeneous();
+  }
+
+  // Column-major 4xN view of the same points.
+  const Eigen::Map<const Eigen::Matrix<Scalar, 4, Eigen::Dynamic>>
+      p3d_vec_mat(p3d_vec[0].data(), 4, num_points);
+
+  Mat4 T_c_w = Mat4::Identity();
+  T_c_w.template topLeftCorner<3, 3>() =
+      Eigen::AngleAxis<Scalar>(Scalar(0.3), Vec3(1, 2, 3).normalized())
+          .toRotationMatrix();
+  T_c_w.template topRightCorner<3, 1>() = Vec3(0.1, -0.2, 0.3);
+
+  const Scalar tol = Sophus::Constants<Scalar>::epsilonSqrt();
+
+  for (const CamT &cam : test_cams) {
+    basalt::GenericCamera<Scalar> gcam;
+    gcam.variant = cam;
+
+    basalt::CameraBatchPoints2<Scalar> proj;
+    basalt::CameraBatchValid valid;
+    gcam.projectBatch(p3d, T_c_w, proj, valid);
+
+    Eigen::aligned_vector<typename CamT::Mat24> J_p(num_points);
+    std::vector<Scalar> J_param(num_points * 2 * CamT::N);
+    basalt::CameraBatchPoints2<Scalar> proj_j;
+    basalt::CameraBatchValid valid_j;
+    gcam.projectBatch(p3d_vec_mat, T_c_w, proj_j, valid_j, J_p.data(),
+                      J_param.data());
+
+    Eigen::aligned_vector<typename CamT::Vec2> proj_vec;
+    std::vector<bool> success_vec;
+    gcam.project(p3d_vec, T_c_w, proj_vec, success_vec);
+
+    ASSERT_EQ(proj.cols(), num_points);
+    ASSERT_EQ(valid.size(), num_points);
+
+    for (int i = 0; i < num_points; i++) {
+      ASSERT_EQ(success_vec[i], valid[i] != 0);
+      ASSERT_EQ(success_vec[i], valid_j[i] != 0);
+      if (success_vec[i]) {
+        const Scalar scale = std::max(Scalar(1), proj_vec[i].norm());
+        EXPECT_LE((proj_vec[i] - proj.col(i)).norm(), tol * scale);
+        EXPECT_LE((proj_vec[i] - proj_j.col(i)).norm(), tol * scale);
+
+        typename CamT::Vec2 res;
+        typename CamT::Mat24 J_p_ref;
+        typename CamT::Mat2N J_param_ref;
+        cam.project(T_c_w * p3d_vec[i], res, &J_p_ref, &J_param_ref);
+
+        const Eigen::Map<const typename CamT::Mat2N> J_param_i(
+            J_param.data() + i * 2 * CamT::N);
+
+        EXPECT_LE((J_p_ref - J_p[i]).norm(),
+                  tol * std::max(Scalar(1), J_p_ref.norm()));
+        EXPECT_LE((J_param_ref - J_param_i).norm(),
+                  tol * std::max(Scalar(1), J_param_ref.norm()));
+      }
+    }
+  }
+}
+
+TEST(CameraTestCase, PinholeProjectBatch) {
+  testProjectBatch<basalt::PinholeCamera<double>>();
+}
+TEST(CameraTestCase, PinholeProjectBatchFloat) {
+  testProjectBatch<basalt::PinholeCamera<float>>();
+}
+
+TEST(CameraTestCase, PinholeRadtan8ProjectBatch) {
+  testProjectBatch<basalt::PinholeRadtan8Camera<double>>();
+}
+TEST(CameraTestCase, PinholeRadtan8ProjectBatchFloat) {
+  testProjectBatch<basalt::PinholeRadtan8Camera<float>>();
+}
+
+TEST(CameraTestCase, UnifiedProjectBatch) {
+  testProjectBatch<basalt::UnifiedCamera<double>>();
+}
+TEST(CameraTestCase, UnifiedProjectBatchFloat) {
+  testProjectBatch<basalt::UnifiedCamera<float>>();
+}
+
+TEST(CameraTestCase, ExtendedUnifiedProjectBatch) {
+  testProjectBatch<basalt::ExtendedUnifiedCamera<double>>();
+}
+TEST(CameraTestCase, ExtendedUnifiedProjectBatchFloat) {
+  testProjectBatch<basalt::ExtendedUnifiedCamera<float>>();
+}
+
+TEST(CameraTestCase, KannalaBrandtProjectBatch) {
+  testProjectBatch<basalt::KannalaBrandtCamera4<double>>();
+}
+TEST(CameraTestCase, KannalaBrandtProjectBatchFloat) {
+  testProjectBatch<basalt::KannalaBrandtCamera4<float>>();
+}
+
+TEST(CameraTestCase, DoubleSphereProjectBatch) {
+  testProjectBatch<basalt::DoubleSphereCamera<double>>();
+}
+TEST(CameraTestCase, DoubleSphereProjectBatchFloat) {
+  testProjectBatch<basalt::DoubleSphereCamera<float>>();
+}
+
+TEST(CameraTestCase, FovProjectBatch) {
+  testProjectBatch<basalt::FovCamera<double>>();
+}
+TEST(CameraTestCase, FovProjectBatchFloat) {
+  testProjectBatch<basalt::FovCamera<float>>();
+}
+
+TEST(CameraTestCase, BalProjectBatch) {
+  testProjectBatch<basalt::BalCamera<double>>();
+}
+TEST(CameraTestCase, BalProjectBatchFloat) {
+  testProjectBatch<basalt::BalCamera<float>>();
+}
+
+TEST(CameraTestCase, PinholeProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::PinholeCamera<double>>();
+}
+TEST(CameraTestCase, PinholeProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::PinholeCamera<float>>();
+}
+
+TEST(CameraTestCase, PinholeRadtan8ProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::PinholeRadtan8Camera<double>>();
+}
+TEST(CameraTestCase, PinholeRadtan8ProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::PinholeRadtan8Camera<float>>();
+}
+
+TEST(CameraTestCase, UnifiedProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::UnifiedCamera<double>>();
+}
+TEST(CameraTestCase, UnifiedProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::UnifiedCamera<float>>();
+}
+
+TEST(CameraTestCase, ExtendedUnifiedProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::ExtendedUnifiedCamera<double>>();
+}
+TEST(CameraTestCase, ExtendedUnifiedProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::ExtendedUnifiedCamera<float>>();
+}
+
+TEST(CameraTestCase, KannalaBrandtProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::KannalaBrandtCamera4<double>>();
+}
+TEST(CameraTestCase, KannalaBrandtProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::KannalaBrandtCamera4<float>>();
+}
+
+TEST(CameraTestCase, DoubleSphereProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::DoubleSphereCamera<double>>();
+}
+TEST(CameraTestCase, DoubleSphereProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::DoubleSphereCamera<float>>();
+}
+
+TEST(CameraTestCase, FovProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::FovCamera<double>>();
+}
+TEST(CameraTestCase, FovProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::FovCamera<float>>();
+}
+
+TEST(CameraTestCase, BalProjectBatchJacobians) {
+  testProjectBatchJacobians<basalt::BalCamera<double>>();
+}
+TEST(CameraTestCase, BalProjectBatchJacobiansFloat) {
+  testProjectBatchJacobians<basalt::BalCamera<float>>();
+}
+
+TEST(CameraTestCase, GenericProjectBatch) {
+  testGenericProjectBatch<basalt::PinholeCamera<double>>();
+  testGenericProjectBatch<basalt::PinholeRadtan8Camera<double>>();
+  testGenericProjectBatch<basalt::UnifiedCamera<double>>();
+  testGenericProjectBatch<basalt::ExtendedUnifiedCamera<double>>();
+  testGenericProjectBatch<basalt::KannalaBrandtCamera4<double>>();
+  testGenericProjectBatch<basalt::DoubleSphereCamera<double>>();
+}
+
+template <typename CamT>
+void testUnprojectBatch() {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  using Scalar = typename CamT::Scalar;
+  using Vec2 = typename CamT::Vec2;
+  using Vec4 = typename CamT::Vec4;
+
+  // Number of points is not a multiple of the batch size to test the tail.
+  const int num_points = 94 * 60;
+  basalt::CameraBatchPoints2<Scalar> proj(2, num_points);
+  int i = 0;
+  for (int x = 0; x < 94; x++) {
+    for (int y = 0; y < 60; y++) {
+      proj.col(i++) << Scalar(8 * x), Scalar(8 * y);
+    }
+  }
+
+  const Scalar tol = Sophus::Constants<Scalar>::epsilonSqrt();
+
+  for (const CamT &cam : test_cams) {
+    basalt::CameraBatchPoints3<Scalar> p3d(3, num_points);
+    Eigen::Matrix<Scalar, 4, Eigen::Dynamic> p4d(4, num_points);
+    basalt::CameraBatchValid valid3(num_points);
+    basalt::CameraBatchValid valid4(num_points);
+
+    cam.unprojectBatch(proj, p3d, valid3);
+    cam.unprojectBatch(proj, p4d, valid4);
+
+    for (int j = 0; j < num_points; j++) {
+      Vec4 res;
+      const bool success = cam.unproject(Vec2(proj.col(j)), res);
+
+      ASSERT_EQ(success, valid3[j] != 0) << "proj " << proj.col(j).transpose();
+      ASSERT_EQ(success, valid4[j] != 0) << "proj " << proj.col(j).transpose();
+
+      // Far outside of the image some models produce NaNs for valid points
+      // in both implementations.
+      if (success && res.allFinite()) {
+        EXPECT_LE((res.template head<3>() - p3d.col(j)).norm(), tol)
+            << "res " << res.transpose() << " p3d " << p3d.col(j).transpose();
+        EXPECT_LE((res - p4d.col(j)).norm(), tol)
+            << "res " << res.transpose() << " p4d " << p4d.col(j).transpose();
+      }
+    }
+  }
+}
+
+template <typename CamT>
+void testGenericUnprojectBatch() {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  using Scalar = typename CamT::Scalar;
+  using Vec2 = typename CamT::Vec2;
+  using Vec4 = typename CamT::Vec4;
+
+  const int num_points = 1000;
+  Eigen::aligned_vector<Vec2> proj(num_points);
+  for (int i = 0; i < num_points; i++) {
+    proj[i] = (Vec2::Random() + Vec2::Ones()) * Scalar(400);
+  }
+
+  const Scalar tol = Sophus::Constants<Scalar>::epsilonSqrt();
+
+  for (const CamT &cam : test_cams) {
+    basalt::GenericCamera<Scalar> gcam;
+    gcam.variant = cam;
+
+    Eigen::aligned_vector<Vec4> p3d_vec;
+    std::vector<bool> success_vec;
+    gcam.unproject(proj, p3d_vec, success_vec);
+
+    // Caller-owned buffers, e.g. reused across frames.
+    Eigen::aligned_vector<Vec4> p3d(num_points);
+    std::vector<uint8_t> valid(num_points);
+    gcam.unproject(proj.data(), proj.size(), p3d.data(), valid.data());
+
+    for (int i = 0; i < num_points; i++) {
+      ASSERT_EQ(success_vec[i], valid[i] != 0);
+      // Far outside of the image some models produce NaNs for valid points
+      // in both implementations.
+      if (success_vec[i] && p3d_vec[i].allFinite()) {
+        EXPECT_LE((p3d_vec[i] - p3d[i]).norm(), tol)
+            << "p3d_vec " << p3d_vec[i].transpose() << " p3d "
+            << p3d[i].transpose();
+      }
+    }
+  }
+}
+
+TEST(CameraTestCase, PinholeUnprojectBatch) {
+  testUnprojectBatch<basalt::PinholeCamera<double>>();
+}
+TEST(CameraTestCase, PinholeUnprojectBatchFloat) {
+  testUnprojectBatch<basalt::PinholeCamera<float>>();
+}
+
+TEST(CameraTestCase, PinholeRadtan8UnprojectBatch) {
+  testUnprojectBatch<basalt::PinholeRadtan8Camera<double>>();
+}
+TEST(CameraTestCase, PinholeRadtan8UnprojectBatchFloat) {
+  testUnprojectBatch<basalt::PinholeRadtan8Camera<float>>();
+}
+
+TEST(CameraTestCase, UnifiedUnprojectBatch) {
+  testUnprojectBatch<basalt::UnifiedCamera<double>>();
+}
+TEST(CameraTestCase, UnifiedUnprojectBatchFloat) {
+  testUnprojectBatch<basalt::UnifiedCamera<float>>();
+}
+
+TEST(CameraTestCase, ExtendedUnifiedUnprojectBatch) {
+  testUnprojectBatch<basalt::ExtendedUnifiedCamera<double>>();
+}
+TEST(CameraTestCase, ExtendedUnifiedUnprojectBatchFloat) {
+  testUnprojectBatch<basalt::ExtendedUnifiedCamera<float>>();
+}
+
+TEST(CameraTestCase, KannalaBrandtUnprojectBatch) {
+  testUnprojectBatch<basalt::KannalaBrandtCamera4<double>>();
+}
+TEST(CameraTestCase, KannalaBrandtUnprojectBatchFloat) {
+  testUnprojectBatch<basalt::KannalaBrandtCamera4<float>>();
+}
+
+TEST(CameraTestCase, DoubleSphereUnprojectBatch) {
+  testUnprojectBatch<basalt::DoubleSphereCamera<double>>();
+}
+TEST(CameraTestCase, DoubleSphereUnprojectBatchFloat) {
+  testUnprojectBatch<basalt::DoubleSphereCamera<float>>();
+}
+
+TEST(CameraTestCase, GenericUnprojectBatch) {
+  testGenericUnprojectBatch<basalt::PinholeCamera<double>>();
+  testGenericUnprojectBatch<basalt::PinholeRadtan8Camera<double>>();
+  testGenericUnprojectBatch<basalt::UnifiedCamera<double>>();
+  testGenericUnprojectBatch<basalt::ExtendedUnifiedCamera<double>>();
+  testGenericUnprojectBatch<basalt::KannalaBrandtCamera4<double>>();
+  testGenericUnprojectBatch<basalt::DoubleSphereCamera<double>>();
+}
+
+template <typename CamT>
+void testGenericVisitBatch() {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  using Scalar = typename CamT::Scalar;
+  using Vec2 = typename CamT::Vec2;
+  using Vec4 = typename CamT::Vec4;
+
+  Eigen::aligned_vector<Vec4> p3d;
+  for (int x = -10; x <= 10; x++) {
+    for (int y = -10; y <= 10; y++) {
+      p3d.emplace_back(x, y, 5, 0.23424);
+    }
+  }
+
+  for (const CamT &cam : test_cams) {
+    basalt::GenericCamera<Scalar> gcam;
+    gcam.variant = cam;
+
+    // the kernel runs on the concrete type
+    const std::string name = gcam.visitBatch([&](const auto &c) {
+      using C = std::decay_t<decltype(c)>;
+      EXPECT_TRUE((std::is_same_v<C, CamT>));
+      return c.getName();
+    });
+    EXPECT_EQ(name, CamT::getName());
+
+    Eigen::aligned_vector<Vec2> proj(p3d.size());
+    std::vector<bool> valid(p3d.size());
+    gcam.visitBatch([&](const auto &c) {
+      for (size_t i = 0; i < p3d.size(); i++) {
+        valid[i] = c.project(p3d[i], proj[i]);
+      }
+    });
+
+    // concrete models are passed through directly
+    const int n = basalt::visitCameraModel(cam, [](const auto &c) {
+      using C = std::decay_t<decltype(c)>;
+      EXPECT_TRUE((std::is_same_v<C, CamT>));
+      return c.N;
+    });
+    EXPECT_EQ(n, CamT::N);
+
+    for (size_t i = 0; i < p3d.size(); i++) {
+      Vec2 proj_ref;
+      EXPECT_EQ(valid[i], gcam.project(p3d[i], proj_ref));
+      if (valid[i]) {
+        EXPECT_EQ(proj[i], proj_ref);
+      }
+    }
+
+    // non-const access to the stored model
+    gcam.visitBatch([](auto &c) { c.setFromInit(Vec4(400, 410, 320, 240)); });
+    EXPECT_EQ(gcam.getParam().template head<4>(), Vec4(400, 410, 320, 240));
+  }
+}
+
+TEST(CameraTestCase, GenericVisitBatch) {
+  testGenericVisitBatch<basalt::PinholeCamera<double>>();
+  testGenericVisitBatch<basalt::PinholeRadtan8Camera<double>>();
+  testGenericVisitBatch<basalt::UnifiedCamera<double>>();
+  testGenericVisitBatch<basalt::ExtendedUnifiedCamera<double>>();
+  testGenericVisitBatch<basalt::KannalaBrandtCamera4<double>>();
+  testGenericVisitBatch<basalt::DoubleSphereCamera<double>>();
+}
+
+////////////////////////////////////////////////////////////////
+
+template <typename CamT>
+void testUnprojectLut() {
+  Eigen::aligned_vector<CamT> test_cams = CamT::getTestProjections();
+
+  using Scalar = typename CamT::Scalar;
+  using Vec2 = typename CamT::Vec2;
+  using Vec4 = typename CamT::Vec4;
+
+  const Scalar tol = Sophus::Constants<Scalar>::epsilonSqrt();
+
+  std::mt19937 gen(0);
+
+  for (const CamT &cam : test_cams) {
+    // Image size such that the principal point is in the center
+    const int width = int(2 * cam.getParam()[2]);
+    const int height = int(2 * cam.getParam()[3]);
+
+    std::uniform_real_distribution<Scalar> dist_x(0, Scalar(width - 1));
+    std::uniform_real_distribution<Scalar> dist_y(0, Scalar(height - 1));
+
+    for (int step : {1, 4, 16}) {
+      basalt::UnprojectLut<Scalar> lut;
+      lut.build(cam, width, height, step);
+
+      // Check every cell; the default only samples a subset of them
+      const Scalar max_error =
+          lut.estimateMaxError(cam, std::numeric_limits<int>::max());
+      EXPECT_LT(max_error, Scalar(1e-2) * step * step);
+      EXPECT_LE(lut.estimateMaxError(cam), max_error);
+
+      // Grid nodes are exact
+      for (int y = 0; y < height; y += 7 * step) {
+        for (int x = 0; x < width; x += 7 * step) {
+          const Vec2 p(x, y);
+          Vec4 res_exact, res_lut;
+          const bool success_exact = cam.unproject(p, res_exact);
+          const bool success_lut = lut.unproject(p, res_lut);
+
+          if (success_exact && success_lut) {
+            EXPECT_LE((res_exact - res_lut).norm(), tol) << "p " << p;
+          }
+        }
+      }
+
+      // Error in between grid nodes is bounded by the measured error
+      for (int i = 0; i < 1000; i++) {
+        const Vec2 p(dist_x(gen), dist_y(gen));
+        Vec4 res_exact, res_lut;
+        const bool success_exact = cam.unproject(p, res_exact);
+        const bool success_lut = lut.unproject(p, res_lut);
+
+        if (success_exact && success_lut) {
+          EXPECT_LE((res_exact - res_lut).norm(),
+                    Scalar(2) * max_error + tol)
+              << "p " << p.transpose();
+        }
+      }
+
+      Vec4 res;
+      EXPECT_FALSE(lut.unproject(Vec2(-1, 0), res));
+      EXPECT_FALSE(lut.unproject(Vec2(0, Scalar(height + step)), res));
+    }
+
+    basalt::GenericCamera<Scalar> gcam;
+    gcam.variant = cam;
+    const basalt::UnprojectLut<Scalar> lut_generic =
+        gcam.makeUnprojectLut(width, height, 4);
+    EXPECT_FALSE(lut_generic.empty());
+    EXPECT_EQ(lut_generic.getStep(), 4);
+
+    // building from the generic camera gives the same table
+    basalt::UnprojectLut<Scalar> lut_ref;
+    lut_ref.build(cam, width, height, 4);
+    EXPECT_EQ(lut_generic.estimateMaxError(gcam),
+              lut_ref.estimateMaxError(cam));
+  }
+}
+
+TEST(CameraTestCase, KannalaBrandtUnprojectLut) {
+  testUnprojectLut<basalt::KannalaBrandtCamera4<double>>();
+}
+
+TEST(CameraTestCase, PinholeRadtan8UnprojectLut) {
+  testUnprojectLut<basalt::PinholeRadtan8Camera<double>>();
+}
+
+TEST(CameraTestCase, DoubleSphereUnprojectLut) {
+  testUnprojectLut<basalt::DoubleSphereCamera<double>>();
+}
+
+////////////////////////////////////////////////////////////////
+
+// Compares the float instantiation of a model against double on a grid of
+// pixels covering the image. Errors are in pixels, for unprojection the
+// angular error is scaled by the focal length. Only pixels where the double
+// model round-trips exactly are used, so the bounds measure the precision of
+// float and not the convergence of the solvers at the border of the domain.
+template <template <class> class CamT>
+void testFloatPrecision(double max_unproject_err, double max_project_err) {
+  const Eigen::aligned_vector<CamT<double>> test_cams =
+      CamT<double>::getTestProjections();
+
+  for (const CamT<double> &cam : test_cams) {
+    const CamT<float> cam_f = cam.template cast<float>();
+
+    const double w = 2 * cam.getParam()[2];
+    const double h = 2 * cam.getParam()[3];
+
+    int num_tested = 0;
+    for (double v = 0; v <= h; v += h / 50) {
+      for (double u = 0; u <= w; u += w / 50) {
+        const Eigen::Vector2d p(u, v);
+
+        Eigen::Vector4d p3d;
+        Eigen::Vector2d p_back;
+        if (!cam.unproject(p, p3d) || !cam.project(p3d, p_back) ||
+            (p_back - p).norm() > 1e-6) {
+          continue;
+        }
+
+        Eigen::Vector4f p3d_f;
+        ASSERT_TRUE(cam_f.unproject(p.cast<float>(), p3d_f)) << "p " << p;
+        const Eigen::Vector3d dir_f = p3d_f.head<3>().cast<double>();
+        const double cos_angle =
+            dir_f.normalized().dot(p3d.head<3>().normalized());
+        EXPECT_LE(std::acos(std::min(1.0, cos_angle)) * cam.getParam()[0],
+                  max_unproject_err)
+            << "p " << p.transpose();
+
+        Eigen::Vector2f proj_f;
+        ASSERT_TRUE(cam_f.project(p3d.cast<float>(), proj_f)) << "p " << p;
+        EXPECT_LE((proj_f.cast<double>() - p).norm(), max_project_err)
+            << "p " << p.transpose();
+
+        num_tested++;
+      }
+    }
+
+    EXPECT_GT(num_tested, 51 * 51 / 2);
+  }
+}
+
+TEST(CameraTestCase, PinholeFloatPrecision) {
+  testFloatPrecision<basalt::PinholeCamera>(1e-3, 1e-3);
+}
+
+TEST(CameraTestCase, PinholeRadtan8FloatPrecision) {
+  testFloatPrecision<basalt::PinholeRadtan8Camera>(1e-3, 1e-3);
+}
+
+TEST(CameraTestCase, UnifiedFloatPrecision) {
+  testFloatPrecision<basalt::UnifiedCamera>(1e-3, 1e-3);
+}
+
+TEST(CameraTestCase, ExtendedUnifiedFloatPrecision) {
+  testFloatPrecision<basalt::ExtendedUnifiedCamera>(1e-3, 1e-3);
+}
+
+TEST(CameraTestCase, KannalaBrandtFloatPrecision) {
+  testFloatPrecision<basalt::KannalaBrandtCamera4>(1e-3, 1e-3);
+}
+
+TEST(CameraTestCase, DoubleSphereFloatPrecision) {
+  testFloatPrecision<basalt::DoubleSphereCamera>(5e-3, 1e-3);
+}
+
+TEST(CameraTestCase, FovFloatPrecision) {
+  testFloatPrecision<basalt::FovCamera>(1e-3, 1e-2);
+}
+
+TEST(CameraTestCase, PinholeRadtan8FloatRpmax) {
+  for (const auto &cam :
+       basalt::PinholeRadtan8Camera<double>::getTestProjections()) {
+    const basalt::PinholeRadtan8Camera<float> cam_f(
+        cam.getParam().cast<float>());
+    EXPECT_GT(cam_f.getRpmax(), 0);
+    EXPECT_NEAR(cam_f.getRpmax(), cam.getRpmax(), 1e-2 * cam.getRpmax());
+  }
+}
+
+TEST(CameraTestCase, PinholeRadtan8Rpmax) {
+  // Must match RPMAX_SCALE in PinholeRadtan8Camera::computeRpmax
+  const double rpmax_scale = 0.85;
+
+  for (const auto &cam :
+       basalt::PinholeRadtan8Camera<double>::getTestProjections()) {
+    const double rpmax = cam.getRpmax();
+    ASSERT_GT(rpmax, 0);
+
+    // The cached value is kept by copies and casts
+    EXPECT_EQ(cam.cast<double>().getRpmax(), rpmax);
+    EXPECT_EQ(cam.cast<float>().getRpmax(), float(rpmax));
+
+    auto rpp = [&cam](const Eigen::Vector2d &xy) {
+      Eigen::Vector2d xypp;
+      cam.distort(xy, xypp);
+      return xypp.norm();
+    };
+
+    // Distortion is injective inside rpmax on every ray, and the unscaled
+    // radius is a maximum of the distorted radius on at least one of them.
+    bool found_max = false;
+    const double r_max = rpmax / rpmax_scale;
+    for (int i = 0; i < 32; i++) {
+      const double angle = 2 * M_PI * i / 32;
+      const Eigen::Vector2d dir(std::cos(angle), std::sin(angle));
+
+      double last_rpp = 0;
+      for (int j = 1; j <= 100; j++) {
+        const double cur_rpp = rpp(rpmax * j / 100 * dir);
+        EXPECT_GT(cur_rpp, last_rpp) << "ray " << i << " step " << j;
+        last_rpp = cur_rpp;
+      }
+
+      if (rpp(1.01 * r_max * dir) < rpp(r_max * dir) &&
+          rpp(0.99 * r_max * dir) < rpp(r_max * dir)) {
+        found_max = true;
+      }
+    }
+    EXPECT_TRUE(found_max);
+  }
+}
+
+////////////////////////////////////////////////////////////////
+
 template <typename CamT>
 void testStereographicProjectJacobian() {
   using Vec2 = typename CamT::Vec2;
@@ -1,5 +1,6 @@
 
 
+#include <algorithm>
 #include <iostream>
 
 #include "gtest/gtest.h"
@@ -494,3 +495,85 @@ TEST(CeresSplineTestSuite, CeresSplineHelperSim3jerk5) {
 TEST(CeresSplineTestSuite, CeresSplineHelperSim3jerk6) {
   test_ceres_spline_helper_jerk_sim3<6>();
 }
+
+template <int N>
+void test_ceres_spline_helper_batch() {
+  static const int64_t dt_ns = 2e9;
+  static const int64_t start_t_ns = 1e9;
+
+  basalt::So3Spline<N> so3_spline(dt_ns, start_t_ns);
+  so3_spline.genRandomTrajectory(3 * N);
+
+  basalt::RdSpline<3, N> pos_spline(dt_ns, start_t_ns);
+  pos_spline.genRandomTrajectory(3 * N);
+
+  // unsorted residual times
+  std::vector<int64_t> time_ns;
+  for (int64_t t_ns = start_t_ns; t_ns < so3_spline.maxTimeNs(); t_ns += 3e8) {
+    time_ns.emplace_back(t_ns);
+  }
+  std::reverse(time_ns.begin(), time_ns.begin() + time_ns.size() / 2);
+  time_ns.emplace_back(so3_spline.maxTimeNs());
+
+  std::vector<basalt::CeresSplineResidualGroup> groups;
+  basalt::CeresSplineHelper<N>::groupByKnotWindow(
+      time_ns, start_t_ns, dt_ns, so3_spline.getKnots().size(), groups);
+
+  ASSERT_EQ(groups.size(), so3_spline.getKnots().size() - N + 1);
+
+  const double pow_inv_dt = 1e9 / dt_ns;
+
+  size_t num_residuals = 0;
+  for (size_t j = 0; j < groups.size(); j++) {
+    const basalt::CeresSplineResidualGroup &g = groups[j];
+    ASSERT_EQ(g.indices.size(), g.u.size());
+    EXPECT_EQ(g.start_idx, int64_t(j));
+    num_residuals += g.indices.size();
+
+    std::vector<const double *> so3_knots, pos_knots;
+    for (int i = 0; i < N; i++) {
+      so3_knots.emplace_back(so3_spline.getKnots()[g.start_idx + i].data());
+      pos_knots.emplace_back(pos_spline.getKnots()[g.start_idx + i].data());
+    }
+
+    const size_t num = g.u.size();
+    Eigen::aligned_vector<Sophus::SO3d> rot(num);
+    Eigen::aligned_vector<Eigen::Vector3d> vel(num), accel(num), jerk(num),
+        pos(num), pos_accel(num);
+
+    basalt::CeresSplineHelper<N>::template evaluate_lie_batch<double,
+                                                              Sophus::SO3>(
+        &so3_knots[0], g.u.data(), num, pow_inv_dt, rot.data(), vel.data(),
+        accel.data(), jerk.data());
+    basalt::CeresSplineHelper<N>::template evaluate_batch<double, 3, 0>(
+        &pos_knots[0], g.u.data(), num, pow_inv_dt, pos.data());
+    basalt::CeresSplineHelper<N>::template evaluate_batch<double, 3, 2>(
+        &pos_knots[0], g.u.data(), num, pow_inv_dt, pos_accel.data());
+
+    for (size_t k = 0; k < num; k++) {
+      const int64_t t_ns = time_ns[g.indices[k]];
+
+      EXPECT_TRUE(rot[k].matrix().isApprox(so3_spline.evaluate(t_ns).matrix()))
+          << "t_ns " << t_ns;
+      EXPECT_TRUE(vel[k].isApprox(so3_spline.velocityBody(t_ns)));
+      EXPECT_TRUE(accel[k].isApprox(so3_spline.accelerationBody(t_ns)));
+      EXPECT_TRUE(jerk[k].isApprox(so3_spline.jerkBody(t_ns)));
+      EXPECT_TRUE(pos[k].isApprox(pos_spline.template evaluate<0>(t_ns)));
+      EXPECT_TRUE(pos_accel[k].isApprox(pos_spline.template evaluate<2>(t_ns)));
+    }
+  }
+
+  EXPECT_EQ(num_residuals, time_ns.size());
+}
+
+TEST(CeresSplineTestSuite, CeresSplineHelperBatch4) {
+  test_ceres_spline_helper_batch<4>();
+}
+
+TEST(CeresSplineTestSuite, CeresSplineHelperBatch5) {
+  test_ceres_spline_helper_batch<5>();
+}
+
+TEST(CeresSplineTestSuite, CeresSplineHelperBatch6) {
+  test_ceres_spline_helper_batch<6>();
+}
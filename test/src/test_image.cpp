@@ -1,9 +1,22 @@
 
+#include <functional>
+#include <thread>
+
 #include <Eigen/Dense>
 
+#include <basalt/image/cubic_spline_image.h>
+#include <basalt/image/gradient_image.h>
 #include <basalt/image/image.h>
+#include <basalt/image/image_allocator.h>
+#include <basalt/image/image_pyr.h>
+#include <basalt/image/image_remap.h>
+#include <basalt/image/lazy_image_pyr.h>
+#include <basalt/image/vignette_correction.h>
+
+#include <basalt/camera/generic_camera.hpp>
 
 #include "gtest/gtest.h"
+#include "heap_allocation_counter.h"
 #include "test_utils.h"
 
 void setImageData(uint16_t* image_array, int size) {
@@ -15,6 +28,372 @@ void setImageData(uint16_t* image_array, int size) {
   }
 }
 
+template <typename T>
+void testSubsampleExact() {
+  const std::vector<std::pair<int, int>> sizes = {
+      {4, 4}, {5, 7}, {17, 9}, {37, 21}, {64, 48}, {641, 481}};
+
+  std::vector<int> tmp;
+
+  for (const auto& [w, h] : sizes) {
+    basalt::ManagedImage<T> img(w, h);
+    for (size_t i = 0; i < img.size(); i++) {
+      img.ptr[i] = T(rand());
+    }
+
+    const basalt::Image<const T> src = std::as_const(img).SubImage(0, 0, w, h);
+
+    basalt::ManagedImage<T> res(w / 2, h / 2), res_ref(w / 2, h / 2);
+    basalt::Image<T> res_img = res, res_ref_img = res_ref;
+
+    basalt::ManagedImagePyr<T>::subsample(src, res_img, tmp);
+    basalt::ManagedImagePyr<T>::subsampleReference(src, res_ref_img);
+
+    for (size_t y = 0; y < res.h; y++) {
+      for (size_t x = 0; x < res.w; x++) {
+        ASSERT_EQ(res(x, y), res_ref(x, y))
+            << "size " << w << "x" << h << " at " << x << " " << y;
+      }
+    }
+  }
+}
+
+TEST(Image, ImagePyrSubsampleExact8) { testSubsampleExact<uint8_t>(); }
+
+TEST(Image, ImagePyrSubsampleExact16) { testSubsampleExact<uint16_t>(); }
+
+template <typename T, typename A1, typename A2>
+void expectEqualMipmaps(const basalt::ManagedImagePyr<T, A1>& pyr1,
+                        const basalt::ManagedImagePyr<T, A2>& pyr2) {
+  ASSERT_EQ(pyr1.mipmap().w, pyr2.mipmap().w);
+  ASSERT_EQ(pyr1.mipmap().h, pyr2.mipmap().h);
+
+  for (size_t y = 0; y < pyr1.mipmap().h; y++) {
+    for (size_t x = 0; x < pyr1.mipmap().w; x++) {
+      ASSERT_EQ(pyr1.mipmap()(x, y), pyr2.mipmap()(x, y))
+          << "at " << x << " " << y;
+    }
+  }
+}
+
+TEST(Image, ImagePyrPooledAllocator) {
+  using Allocator = basalt::PooledImageAllocator<uint16_t>;
+
+  basalt::ManagedImage<uint16_t> img(640, 480);
+  setImageData(img.ptr, img.size());
+
+  const uint16_t* mipmap_ptr = nullptr;
+  {
+    basalt::ManagedImagePyr<uint16_t, Allocator> pyr(img, 3);
+    mipmap_ptr = pyr.mipmap().ptr;
+  }
+
+  EXPECT_GE(basalt::ImageMemoryPool::instance().cachedBytes(),
+            960 * 480 * sizeof(uint16_t));
+
+  basalt::ManagedImagePyr<uint16_t, Allocator> pyr(img, 3);
+  basalt::ManagedImagePyr<uint16_t> pyr_ref(img, 3);
+
+  // memory of the destroyed pyramid is recycled
+  EXPECT_EQ(pyr.mipmap().ptr, mipmap_ptr);
+
+  expectEqualMipmaps(pyr, pyr_ref);
+}
+
+TEST(Image, ImagePyrPooledSteadyState) {
+  using Allocator = basalt::PooledImageAllocator<uint16_t>;
+
+  basalt::ManagedImagePyr<uint16_t, Allocator> pyr;
+
+  // A new camera image per frame and a reused pyramid: after the first frame
+  // all memory comes from the pool or is kept by the pyramid.
+  for (int frame = 0; frame < 4; frame++) {
+    const size_t allocations_before = numHeapAllocations();
+    {
+      basalt::ManagedImage<uint16_t, Allocator> img(640, 480);
+      setImageData(img.ptr, img.size());
+      pyr.setFromImage(img, 3);
+    }
+    const size_t allocations = numHeapAllocations() - allocations_before;
+
+    if (frame > 0) {
+      EXPECT_EQ(allocations, 0u) << "frame " << frame;
+    }
+  }
+}
+
+TEST(Image, ImageMemoryPoolBuckets) {
+  basalt::ImageMemoryPool pool;
+
+  // 3 x 3 uint8_t pixels are 9 bytes, reinterpreted as uint16_t the image
+  // would be returned as 10 bytes
+  void* p = pool.allocate(9);
+  pool.deallocate(p, 10);
+  EXPECT_EQ(pool.cachedBytes(), 9u);
+
+  void* p10 = pool.allocate(10);
+  EXPECT_NE(p10, p);
+  EXPECT_EQ(pool.allocate(9), p);
+  pool.deallocate(p, 9);
+  pool.deallocate(p10, 10);
+  EXPECT_EQ(pool.cachedBytes(), 19u);
+
+  pool.trim(9);
+  EXPECT_EQ(pool.cachedBytes(), 9u);
+  EXPECT_EQ(pool.allocate(9), p);
+  pool.deallocate(p, 9);
+
+  // blocks beyond the limit are freed instead of cached
+  pool.setCacheLimit(16);
+  EXPECT_EQ(pool.cacheLimit(), 16u);
+  void* p16 = pool.allocate(16);
+  pool.deallocate(p16, 16);
+  EXPECT_EQ(pool.cachedBytes(), 9u);
+
+  pool.release();
+  EXPECT_EQ(pool.cachedBytes(), 0u);
+}
+
+TEST(Image, ImagePooledOwnAndReinterpret) {
+  using Allocator8 = basalt::PooledImageAllocator<uint8_t>;
+  using Allocator16 = basalt::PooledImageAllocator<uint16_t>;
+
+  basalt::ImageMemoryPool::instance().release();
+
+  {
+    basalt::ManagedImage<uint8_t, Allocator8> img8(3, 3);
+    basalt::ManagedImage<uint16_t, Allocator16> img16;
+    img16.OwnAndReinterpret(std::move(img8));
+  }
+  EXPECT_EQ(basalt::ImageMemoryPool::instance().cachedBytes(), 9u);
+
+  // the 9 byte block is not handed out for 10 bytes
+  basalt::ManagedImage<uint16_t, Allocator16> img(5, 1);
+  EXPECT_EQ(basalt::ImageMemoryPool::instance().cachedBytes(), 9u);
+}
+
+TEST(Image, ImagePyrNoCopy) {
+  basalt::ManagedImage<uint16_t> img(640, 481);
+  setImageData(img.ptr, img.size());
+
+  basalt::ManagedImage<uint16_t> img2(640, 481);
+  setImageData(img2.ptr, img2.size());
+
+  basalt::ManagedImagePyr<uint16_t> pyr_ref(img, 3);
+
+  // parts of the mipmap that were used for more levels are cleared
+  basalt::ManagedImagePyr<uint16_t> pyr(img2, 6);
+  pyr.setFromImage(img, 3);
+  expectEqualMipmaps(pyr, pyr_ref);
+  EXPECT_EQ(pyr.mipmap()(640, 470), 0);
+
+  // write level 0 directly
+  pyr.setFromImage(img2, 6);
+  basalt::Image<uint16_t> l0 = pyr.prepareLevel0(img.w, img.h);
+  l0.CopyFrom(img);
+  pyr.computeLevels(3);
+  expectEqualMipmaps(pyr, pyr_ref);
+
+  // keep external level 0
+  const basalt::Image<const uint16_t> view =
+      std::as_const(img).SubImage(0, 0, img.w, img.h);
+  pyr.setFromExternalImage(view, 3);
+  EXPECT_EQ(pyr.lvl(0).ptr, img.ptr);
+
+  for (size_t l = 1; l <= 3; l++) {
+    const basalt::Image<const uint16_t> lvl = pyr.lvl(l);
+    const basalt::Image<const uint16_t> lvl_ref = pyr_ref.lvl(l);
+    for (size_t y = 0; y < lvl_ref.h; y++) {
+      for (size_t x = 0; x < lvl_ref.w; x++) {
+        ASSERT_EQ(lvl(x, y), lvl_ref(x, y));
+      }
+    }
+  }
+}
+
+TEST(Image, ImagePyrParallel) {
+  basalt::ManagedImage<uint16_t> img(641, 479);
+  setImageData(img.ptr, img.size());
+
+  basalt::ManagedImagePyr<uint16_t> pyr_ref(img, 8);
+  basalt::ManagedImagePyr<uint16_t> pyr;
+
+  {
+    // start a thread for every task
+    std::vector<std::thread> threads;
+    const auto executor = [&](std::function<void()> task) {
+      threads.emplace_back(std::move(task));
+    };
+
+    pyr.setFromImage(img, 8, executor, 3, 16);
+    for (auto& t : threads) t.join();
+
+    expectEqualMipmaps(pyr, pyr_ref);
+  }
+
+  {
+    // run tasks immediately
+    const auto executor = [](std::function<void()> task) { task(); };
+
+    pyr.setFromImage(img, 8, executor, 2, 7);
+    expectEqualMipmaps(pyr, pyr_ref);
+  }
+
+  {
+    // run tasks after the pyramid is done
+    std::vector<std::function<void()>> tasks;
+    const auto executor = [&](std::function<void()> task) {
+      tasks.emplace_back(std::move(task));
+    };
+
+    pyr.setFromImage(img, 8, executor, 4);
+    expectEqualMipmaps(pyr, pyr_ref);
+
+    for (auto& t : tasks) t();
+  }
+
+  {
+    // run tasks after the pyramid is destroyed
+    std::vector<std::function<void()>> tasks;
+    const auto executor = [&](std::function<void()> task) {
+      tasks.emplace_back(std::move(task));
+    };
+
+    {
+      basalt::ManagedImagePyr<uint16_t> pyr_tmp;
+      pyr_tmp.setFromImage(img, 8, executor, 2);
+      expectEqualMipmaps(pyr_tmp, pyr_ref);
+    }
+
+    for (auto& t : tasks) t();
+  }
+}
+
+TEST(Image, ImagePyrParallelSteadyState) {
+  using Allocator = basalt::PooledImageAllocator<uint16_t>;
+
+  basalt::ManagedImagePyr<uint16_t, Allocator> pyr;
+  basalt::ManagedImagePyr<uint16_t> pyr_ref;
+
+  const auto executor = [](std::function<void()> task) { task(); };
+
+  // After the first frame the only allocation is the state shared with the
+  // workers. Passing the workers to the executor does not allocate.
+  for (int frame = 0; frame < 4; frame++) {
+    const size_t allocations_before = numHeapAllocations();
+    basalt::ManagedImage<uint16_t, Allocator> img(640, 480);
+    setImageData(img.ptr, img.size());
+    pyr.setFromImage(img, 3, executor, 3, 16);
+    const size_t allocations = numHeapAllocations() - allocations_before;
+
+    if (frame > 0) {
+      EXPECT_EQ(allocations, 1u) << "frame " << frame;
+    }
+
+    pyr_ref.setFromImage(img, 3);
+    expectEqualMipmaps(pyr, pyr_ref);
+  }
+}
+
+template <typename T>
+void expectEqualLevel(const basalt::Image<const T>& lvl,
+                      const basalt::Image<const T>& lvl_ref) {
+  ASSERT_EQ(lvl.w, lvl_ref.w);
+  ASSERT_EQ(lvl.h, lvl_ref.h);
+
+  for (size_t y = 0; y < lvl_ref.h; y++) {
+    for (size_t x = 0; x < lvl_ref.w; x++) {
+      ASSERT_EQ(lvl(x, y), lvl_ref(x, y)) << "at " << x << " " << y;
+    }
+  }
+}
+
+TEST(Image, LazyImagePyr) {
+  basalt::ManagedImage<uint16_t> img(641, 479);
+  setImageData(img.ptr, img.size());
+
+  basalt::ManagedImage<uint16_t> img2(641, 479);
+  setImageData(img2.ptr, img2.size());
+
+  basalt::ManagedImagePyr<uint16_t> pyr_ref(img, 6);
+  basalt::ManagedImagePyr<uint16_t> pyr_ref2(img2, 6);
+
+  for (const auto layout :
+       {basalt::PyrLayout::Mipmap, basalt::PyrLayout::PerLevel}) {
+    basalt::LazyImagePyr<uint16_t> pyr(layout);
+    EXPECT_EQ(pyr.layout(), layout);
+
+    pyr.setFromImage(img, 6);
+    EXPECT_EQ(pyr.numLevels(), 6u);
+    EXPECT_TRUE(pyr.isComputed(0));
+    EXPECT_FALSE(pyr.isComputed(1));
+
+    // only the requested and lower levels are computed
+    expectEqualLevel(pyr.lvl(2), pyr_ref.lvl(2));
+    EXPECT_TRUE(pyr.isComputed(1));
+    EXPECT_TRUE(pyr.isComputed(2));
+    EXPECT_FALSE(pyr.isComputed(3));
+
+    for (size_t l = 0; l <= 6; l++) {
+      expectEqualLevel(pyr.lvl(l), pyr_ref.lvl(l));
+    }
+
+    // the next frame invalidates the levels and keeps the memory
+    const uint16_t* lvl1_ptr = pyr.lvl(1).ptr;
+    pyr.setFromImage(img2, 6);
+    EXPECT_FALSE(pyr.isComputed(1));
+    EXPECT_EQ(pyr.lvl(1).ptr, lvl1_ptr);
+    for (size_t l = 0; l <= 6; l++) {
+      expectEqualLevel(pyr.lvl(l), pyr_ref2.lvl(l));
+    }
+
+    // keep external level 0
+    const basalt::Image<const uint16_t> view =
+        std::as_const(img).SubImage(0, 0, img.w, img.h);
+    pyr.setFromExternalImage(view, 3);
+    EXPECT_EQ(pyr.lvl(0).ptr, img.ptr);
+    pyr.computeLevels();
+    EXPECT_TRUE(pyr.isComputed(3));
+    for (size_t l = 0; l <= 3; l++) {
+      expectEqualLevel(pyr.lvl(l), pyr_ref.lvl(l));
+    }
+  }
+}
+
+TEST(Image, ImageAlignedPitch) {
+  using Allocator = basalt::AlignedImageAllocator<uint16_t, 64>;
+
+  basalt::ManagedImage<uint16_t> img(37, 11);
+  setImageData(img.ptr, img.size());
+
+  basalt::ManagedImage<uint16_t, Allocator> img_aligned(37, 11);
+  EXPECT_EQ(img_aligned.pitch, 128u);
+  for (size_t y = 0; y < img_aligned.h; y++) {
+    EXPECT_EQ(size_t(img_aligned.RowPtr(y)) % 64, 0u);
+  }
+
+  img_aligned.CopyFrom(img);
+
+  basalt::ManagedImage<uint16_t> img_copy(37, 11);
+  img_copy.CopyFrom(img_aligned);
+
+  for (size_t y = 0; y < img.h; y++) {
+    for (size_t x = 0; x < img.w; x++) {
+      ASSERT_EQ(img_aligned(x, y), img(x, y));
+      ASSERT_EQ(img_copy(x, y), img(x, y));
+    }
+  }
+
+  // Memset of a sub-image should not touch pixels outside of it
+  img_aligned.SubImage(1, 1, 5, 5).Memset(0);
+  for (size_t y = 0; y < img.h; y++) {
+    for (size_t x = 0; x < img.w; x++) {
+      const bool inside = x >= 1 && x < 6 && y >= 1 && y < 6;
+      ASSERT_EQ(img_aligned(x, y), inside ? 0 : img(x, y));
+    }
+  }
+}
+
 TEST(Image, ImageInterpolate) {
   Eigen::Vector2i offset(231, 123);
 
@@ -143,3 +522,389 @@ TEST(Image, ImageInterpolateGradCubicSplines) {
       },
       Eigen::Vector2d::Zero(), 1e-4);
 }
+
+template <typename T, typename S>
+void testInterpBatch() {
+  basalt::ManagedImage<T> img(640, 480);
+  for (size_t i = 0; i < img.size(); i++) {
+    img.ptr[i] = T(rand());
+  }
+
+  // not a multiple of the batch size
+  const int num_points = 52;
+
+  Eigen::Matrix<S, 2, Eigen::Dynamic> points(2, num_points);
+  for (int i = 0; i < num_points; i++) {
+    points(0, i) = 1 + (img.w - 4) * S(rand()) / RAND_MAX;
+    points(1, i) = 1 + (img.h - 4) * S(rand()) / RAND_MAX;
+  }
+
+  Eigen::Matrix<S, 1, Eigen::Dynamic> val(1, num_points);
+  Eigen::Matrix<S, 3, Eigen::Dynamic> grad(3, num_points);
+  Eigen::Matrix<S, 3, Eigen::Dynamic> grad_exact(3, num_points);
+
+  img.interpBatch(points, val);
+  img.interpGradBatch(points, grad);
+  img.interpGradBilinearExactBatch(points, grad_exact);
+
+  // Same arithmetic as the single point versions, but the compiler may
+  // contract it to FMA differently in the vectorized loop. The rounding error
+  // scales with the pixel values.
+  const S threshold = 4 * std::numeric_limits<S>::epsilon() *
+                      std::numeric_limits<T>::max();
+
+  for (int i = 0; i < num_points; i++) {
+    const Eigen::Matrix<S, 2, 1> p = points.col(i);
+
+    EXPECT_NEAR(val[i], img.interp(p), threshold);
+    EXPECT_LE((grad.col(i) - img.interpGrad(p))
+                  .template lpNorm<Eigen::Infinity>(),
+              threshold);
+    EXPECT_LE((grad_exact.col(i) - img.interpGradBilinearExact(p))
+                  .template lpNorm<Eigen::Infinity>(),
+              threshold);
+  }
+}
+
+TEST(Image, ImageInterpolateBatchDouble) {
+  testInterpBatch<uint8_t, double>();
+  testInterpBatch<uint16_t, double>();
+}
+
+TEST(Image, ImageInterpolateBatchFloat) {
+  testInterpBatch<uint8_t, float>();
+  testInterpBatch<uint16_t, float>();
+}
+
+template <typename T, typename S>
+void testGradientImage() {
+  basalt::ManagedImage<T> img(97, 61);
+  for (size_t i = 0; i < img.size(); i++) {
+    img.ptr[i] = T(rand());
+  }
+
+  const basalt::Image<const T> view =
+      std::as_const(img).SubImage(0, 0, img.w, img.h);
+  const basalt::GradientImage<T> grad_img(view);
+  EXPECT_EQ(grad_img.width(), img.w);
+  EXPECT_EQ(grad_img.height(), img.h);
+
+  const int num_points = 200;
+  Eigen::Matrix<S, 2, Eigen::Dynamic> points(2, num_points);
+  for (int i = 0; i < num_points; i++) {
+    points(0, i) = 1 + (img.w - 3.001) * S(rand()) / RAND_MAX;
+    points(1, i) = 1 + (img.h - 3.001) * S(rand()) / RAND_MAX;
+  }
+  // integer coordinates at the first and last valid pixel
+  points.col(0) << 1, 1;
+  points.col(1) << img.w - 3, img.h - 3;
+
+  Eigen::Matrix<S, 3, Eigen::Dynamic> res(3, num_points);
+  grad_img.interpGradBatch(points, res);
+
+  // the differences are summed before they are interpolated
+  const S threshold = 8 * std::numeric_limits<S>::epsilon() *
+                      std::numeric_limits<T>::max();
+
+  for (int i = 0; i < num_points; i++) {
+    const Eigen::Matrix<S, 2, 1> p = points.col(i);
+    ASSERT_TRUE(grad_img.InBounds(p[0], p[1], 1));
+
+    const Eigen::Matrix<S, 3, 1> ref = img.interpGrad(p);
+    EXPECT_LE((grad_img.interpGrad(p) - ref).template lpNorm<Eigen::Infinity>(),
+              threshold)
+        << "p " << p.transpose();
+    EXPECT_EQ(res.col(i), grad_img.interpGrad(p));
+  }
+}
+
+TEST(Image, GradientImage8) {
+  testGradientImage<uint8_t, float>();
+  testGradientImage<uint8_t, double>();
+}
+
+TEST(Image, GradientImage16) {
+  testGradientImage<uint16_t, float>();
+  testGradientImage<uint16_t, double>();
+}
+
+template <typename T, typename S>
+void testCubicSplineImage() {
+  basalt::ManagedImage<T> img(97, 61);
+  for (size_t i = 0; i < img.size(); i++) {
+    img.ptr[i] = T(rand());
+  }
+
+  const basalt::CubicSplineImage<T> spline_img(
+      std::as_const(img).SubImage(0, 0, img.w, img.h));
+  EXPECT_EQ(spline_img.width(), img.w);
+  EXPECT_EQ(spline_img.height(), img.h);
+
+  const int num_points = 200;
+  Eigen::Matrix<S, 2, Eigen::Dynamic> points(2, num_points);
+  for (int i = 0; i < num_points; i++) {
+    points(0, i) = (img.w - 1.001) * S(rand()) / RAND_MAX;
+    points(1, i) = (img.h - 1.001) * S(rand()) / RAND_MAX;
+  }
+  // points at the borders where the neighbourhood is clamped
+  points.col(0) << 0, 0;
+  points.col(1) << 0.5, img.h - 1.5;
+  points.col(2) << img.w - 1.5, 0.25;
+
+  Eigen::Matrix<S, 3, Eigen::Dynamic> res(3, num_points);
+  spline_img.interpGradCubicSplinesBatch(points, res);
+
+  // the spline weights sum up to 4 in magnitude per direction
+  const S threshold = 64 * std::numeric_limits<S>::epsilon() *
+                      std::numeric_limits<T>::max();
+
+  for (int i = 0; i < num_points; i++) {
+    const Eigen::Matrix<S, 2, 1> p = points.col(i);
+    ASSERT_TRUE(spline_img.InBounds(p[0], p[1], 0));
+
+    // the Image methods are only implemented for double
+    const Eigen::Vector2d pd = p.template cast<double>();
+    const Eigen::Matrix<S, 3, 1> ref =
+        img.interpGradCubicSplines(pd).template cast<S>();
+    EXPECT_LE((spline_img.interpGradCubicSplines(p) - ref)
+                  .template lpNorm<Eigen::Infinity>(),
+              threshold)
+        << "p " << p.transpose();
+    EXPECT_NEAR(spline_img.interpCubicSplines(p), img.interpCubicSplines(pd),
+                threshold)
+        << "p " << p.transpose();
+    EXPECT_EQ(res.col(i), spline_img.interpGradCubicSplines(p));
+  }
+}
+
+TEST(Image, CubicSplineImage8) {
+  testCubicSplineImage<uint8_t, float>();
+  testCubicSplineImage<uint8_t, double>();
+}
+
+TEST(Image, CubicSplineImage16) {
+  testCubicSplineImage<uint16_t, float>();
+  testCubicSplineImage<uint16_t, double>();
+}
+
+template <typename T>
+void setSmoothImageData(basalt::ManagedImage<T>& img, double offset,
+                        double amplitude) {
+  for (size_t y = 0; y < img.h; y++) {
+    for (size_t x = 0; x < img.w; x++) {
+      img(x, y) = T(offset + amplitude * std::sin(x * 0.05) *
+                                 std::cos(y * 0.04 + 0.3));
+    }
+  }
+}
+
+TEST(Image, ImageRemapIdentity) {
+  basalt::GenericCamera<double> cam;
+  cam.variant = basalt::PinholeCamera<double>(
+      basalt::PinholeCamera<double>::VecN(300, 310, 320.5, 239.5));
+
+  basalt::ManagedImage<uint16_t> img(641, 479);
+  setImageData(img.ptr, img.size());
+
+  basalt::ImageRemap remap;
+  remap.build(cam, img.w, img.h, cam, img.w, img.h);
+
+  basalt::ManagedImage<uint16_t> res(img.w, img.h);
+  remap.apply(img, res);
+
+  for (size_t y = 0; y < img.h; y++) {
+    for (size_t x = 0; x < img.w; x++) {
+      ASSERT_EQ(res(x, y), img(x, y)) << "x " << x << " y " << y;
+    }
+  }
+}
+
+template <typename T>
+void testRemapFisheyeToPinhole(double offset, double amplitude,
+                               double threshold) {
+  basalt::GenericCamera<double> src_cam;
+  src_cam.variant = basalt::KannalaBrandtCamera4<double>(
+      basalt::KannalaBrandtCamera4<double>::VecN(190, 191, 256.5, 250.5, 0.007,
+                                                 -0.0014, -0.0003, -0.0004));
+
+  // wide virtual pinhole camera that also covers pixels outside the source
+  basalt::GenericCamera<double> dst_cam;
+  dst_cam.variant = basalt::PinholeCamera<double>(
+      basalt::PinholeCamera<double>::VecN(60, 60, 200, 150));
+
+  const Eigen::Matrix3d R_src_dst =
+      Eigen::AngleAxisd(0.2, Eigen::Vector3d(0.3, -1, 0.2).normalized())
+          .toRotationMatrix();
+
+  basalt::ManagedImage<T> img(512, 500);
+  setSmoothImageData(img, offset, amplitude);
+
+  basalt::ImageRemap remap;
+  remap.build(src_cam, img.w, img.h, dst_cam, 400, 300, R_src_dst);
+
+  const T border = 7;
+  basalt::ManagedImage<T> res(400, 300);
+  remap.apply(img, res, border);
+
+  size_t num_valid = 0;
+  for (size_t y = 0; y < res.h; y++) {
+    for (size_t x = 0; x < res.w; x++) {
+      if (remap.getMap()(x, y).x < 0) {
+        ASSERT_EQ(res(x, y), border);
+        continue;
+      }
+
+      Eigen::Vector4d p3d;
+      ASSERT_TRUE(dst_cam.unproject(Eigen::Vector2d(x, y), p3d));
+      p3d.head<3>() = R_src_dst * p3d.head<3>();
+
+      Eigen::Vector2d proj;
+      ASSERT_TRUE(src_cam.project(p3d, proj));
+
+      // reference interpolation needs the 2x2 neighborhood within the image
+      proj[0] = std::clamp(proj[0], 0.0, img.w - 1.0 - 1e-9);
+      proj[1] = std::clamp(proj[1], 0.0, img.h - 1.0 - 1e-9);
+
+      ASSERT_NEAR(res(x, y), img.interp(proj), threshold)
+          << "x " << x << " y " << y;
+      num_valid++;
+    }
+  }
+
+  EXPECT_GT(num_valid, res.size() / 2);
+  EXPECT_LT(num_valid, res.size());
+}
+
+TEST(Image, ImageRemapFisheyeToPinhole8) {
+  testRemapFisheyeToPinhole<uint8_t>(128, 100, 1);
+}
+
+TEST(Image, ImageRemapFisheyeToPinhole16) {
+  testRemapFisheyeToPinhole<uint16_t>(30000, 20000, 20000 * 0.05 / 64 + 1);
+}
+
+TEST(Image, ImageRemapParallel) {
+  basalt::GenericCamera<double> src_cam;
+  src_cam.variant = basalt::KannalaBrandtCamera4<double>(
+      basalt::KannalaBrandtCamera4<double>::VecN(190, 191, 256.5, 250.5, 0.007,
+                                                 -0.0014, -0.0003, -0.0004));
+
+  basalt::GenericCamera<double> dst_cam;
+  dst_cam.variant = basalt::PinholeCamera<double>(
+      basalt::PinholeCamera<double>::VecN(150, 150, 251, 200));
+
+  basalt::ManagedImage<uint8_t> img(512, 500);
+  setSmoothImageData(img, 128, 100);
+
+  basalt::ImageRemap remap;
+  remap.build(src_cam, img.w, img.h, dst_cam, 503, 397);
+
+  basalt::ManagedImage<uint8_t> res_ref(503, 397);
+  remap.apply(img, res_ref);
+
+  basalt::ManagedImage<uint8_t> res(503, 397);
+  res.Fill(0);
+
+  std::vector<std::thread> threads;
+  const auto executor = [&](std::function<void()> task) {
+    threads.emplace_back(std::move(task));
+  };
+
+  remap.apply(img, res, executor, 3, 13);
+  for (auto& t : threads) t.join();
+
+  for (size_t y = 0; y < res.h; y++) {
+    for (size_t x = 0; x < res.w; x++) {
+      ASSERT_EQ(res(x, y), res_ref(x, y)) << "x " << x << " y " << y;
+    }
+  }
+}
+
+basalt::RdSpline<1, 4> makeVignetteSpline() {
+  // attenuation 1 - 0.5 (r / 400)^2 with knots every 10 pixels of radius
+  basalt::RdSpline<1, 4> vignette(int64_t(1e10), 0);
+  for (int i = 0; i < 45; i++) {
+    const double r = (i - 1) * 10.0;
+    vignette.knotsPushBack(
+        Eigen::Matrix<double, 1, 1>(1 - 0.5 * r * r / (400.0 * 400.0)));
+  }
+  return vignette;
+}
+
+template <typename T>
+void testVignetteCorrection(double offset, double amplitude) {
+  const basalt::RdSpline<1, 4> vignette = makeVignetteSpline();
+
+  basalt::ManagedImage<T> img(640, 480);
+  setSmoothImageData(img, offset, amplitude);
+
+  basalt::VignetteCorrection correction;
+  correction.build(vignette, Eigen::Vector2i(img.w, img.h));
+
+  basalt::ManagedImage<T> res(img.w, img.h);
+  correction.apply(img, res);
+
+  // bound on the error of the gain from the radius lookup table, see
+  // VignetteCorrection
+  const auto gain = [&](double r) {
+    return 1 / vignette.evaluate(int64_t(std::max(r, 0.0) * 1e9))[0];
+  };
+  const double radius_err = 0.5 / basalt::VignetteCorrection::RADIUS_STEPS;
+  const double quant_err = 0.5 / basalt::VignetteCorrection::GAIN_SCALE;
+
+  const Eigen::Vector2d center = correction.getCenter();
+  for (size_t y = 0; y < img.h; y++) {
+    for (size_t x = 0; x < img.w; x++) {
+      const double r = (Eigen::Vector2d(x, y) - center).norm();
+      const double g = gain(r);
+      const double ref =
+          std::min<double>(img(x, y) * g, std::numeric_limits<T>::max());
+      const double lut_err = std::max(std::abs(gain(r - radius_err) - g),
+                                      std::abs(gain(r + radius_err) - g));
+
+      ASSERT_NEAR(res(x, y), ref, 1 + img(x, y) * (quant_err + lut_err))
+          << "x " << x << " y " << y;
+    }
+  }
+
+  // in place
+  correction.apply(img);
+  for (size_t y = 0; y < img.h; y++) {
+    for (size_t x = 0; x < img.w; x++) {
+      ASSERT_EQ(img(x, y), res(x, y)) << "x " << x << " y " << y;
+    }
+  }
+}
+
+TEST(Image, VignetteCorrection8) { testVignetteCorrection<uint8_t>(128, 100); }
+
+TEST(Image, VignetteCorrection16) {
+  testVignetteCorrection<uint16_t>(30000, 20000);
+}
+
+TEST(Image, VignetteCorrectionPyr) {
+  basalt::ManagedImage<uint8_t> img(641, 479);
+  setSmoothImageData(img, 128, 100);
+
+  basalt::VignetteCorrection correction;
+  correction.build(makeVignetteSpline(), Eigen::Vector2i(img.w, img.h));
+
+  basalt::ManagedImage<uint8_t> corrected(img.w, img.h);
+  correction.apply(img, corrected);
+
+  basalt::ManagedImagePyr<uint8_t> pyr_ref, pyr;
+  pyr_ref.setFromImage(corrected, 3);
+  basalt::setFromImage(pyr, img, 3, correction);
+
+  for (size_t i = 0; i <= 3; i++) {
+    const basalt::Image<const uint8_t> l = pyr.lvl(i);
+    const basalt::Image<const uint8_t> l_ref = pyr_ref.lvl(i);
+    ASSERT_EQ(l.w, l_ref.w);
+    ASSERT_EQ(l.h, l_ref.h);
+    for (size_t y = 0; y < l.h; y++) {
+      for (size_t x = 0; x < l.w; x++) {
+        ASSERT_EQ(l(x, y), l_ref(x, y)) << "lvl " << i << " x " << x;
+      }
+    }
+  }
+}
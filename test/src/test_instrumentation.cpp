@@ -0,0 +1,183 @@
+/**
+BSD 3-Clause License
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <basalt/utils/instrumentation.h>
+
+#include <basalt/camera/pinhole_camera.hpp>
+#include <basalt/image/image_pyr.h>
+#include <basalt/imu/preintegration.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#ifndef BASALT_ENABLE_INSTRUMENTATION
+#error "test_instrumentation has to be compiled with instrumentation enabled"
+#endif
+
+namespace {
+
+const basalt::instrumentation::CounterSink::Stats* findStats(
+    const std::vector<basalt::instrumentation::CounterSink::Stats>& stats,
+    const std::string& name) {
+  for (const auto& s : stats) {
+    if (s.name == name) return &s;
+  }
+  return nullptr;
+}
+
+/// Registers a sink for the lifetime of the object
+struct SinkGuard {
+  explicit SinkGuard(basalt::instrumentation::Sink* sink) {
+    basalt::instrumentation::setSink(sink);
+  }
+  ~SinkGuard() { basalt::instrumentation::setSink(nullptr); }
+};
+
+}  // namespace
+
+TEST(Instrumentation, NoSink) {
+  basalt::instrumentation::CounterSink sink;
+
+  // events without registered sink are ignored
+  {
+    BASALT_INSTRUMENT_SCOPE("test scope");
+    BASALT_INSTRUMENT_COUNT("test counter", 3);
+  }
+
+  EXPECT_TRUE(sink.snapshot().empty());
+}
+
+TEST(Instrumentation, CounterSinkThreads) {
+  static constexpr int NUM_THREADS = 4;
+  static constexpr int NUM_ITER = 1000;
+
+  basalt::instrumentation::CounterSink sink;
+  SinkGuard guard(&sink);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; i++) {
+    threads.emplace_back([]() {
+      for (int k = 0; k < NUM_ITER; k++) {
+        BASALT_INSTRUMENT_SCOPE("test scope");
+        BASALT_INSTRUMENT_COUNT("test counter", 2);
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  {
+    BASALT_INSTRUMENT_SCOPE("test scope");
+  }
+
+  const auto stats = sink.snapshot();
+  ASSERT_EQ(stats.size(), 2u);
+
+  const auto* scope = findStats(stats, "test scope");
+  ASSERT_TRUE(scope);
+  EXPECT_EQ(scope->calls, uint64_t(NUM_THREADS * NUM_ITER + 1));
+  EXPECT_GE(scope->total_ns, 0);
+  EXPECT_EQ(scope->count, 0);
+
+  const auto* counter = findStats(stats, "test counter");
+  ASSERT_TRUE(counter);
+  EXPECT_EQ(counter->calls, 0u);
+  EXPECT_EQ(counter->count, 2 * NUM_THREADS * NUM_ITER);
+
+  EXPECT_EQ(sink.numDropped(), 0u);
+}
+
+TEST(Instrumentation, CounterSinkFull) {
+  basalt::instrumentation::CounterSink sink;
+
+  static std::array<char, basalt::instrumentation::CounterSink::MAX_NAMES + 1>
+      names{};
+
+  // names are keyed by pointer, so distinct addresses are distinct names
+  for (size_t i = 0; i < names.size(); i++) {
+    sink.recordCount(&names[i], 1);
+  }
+
+  // all names are empty strings, which are merged in the snapshot
+  const auto stats = sink.snapshot();
+  ASSERT_EQ(stats.size(), 1u);
+  EXPECT_EQ(stats[0].count, int64_t(names.size()) - 1);
+  EXPECT_EQ(sink.numDropped(), 1u);
+}
+
+TEST(Instrumentation, Hooks) {
+  basalt::instrumentation::CounterSink sink;
+  SinkGuard guard(&sink);
+
+  basalt::ManagedImage<uint8_t> img(64, 48);
+  img.Fill(10);
+  basalt::ManagedImagePyr<uint8_t> pyr;
+  pyr.setFromImage(img, 2);
+
+  basalt::PinholeCamera<double> cam(
+      basalt::PinholeCamera<double>::VecN(100, 100, 32, 24));
+  basalt::CameraBatchPoints3<double> p3d(3, 20);
+  p3d.setRandom();
+  p3d.row(2).setConstant(5);
+  basalt::CameraBatchPoints2<double> proj(2, 20);
+  basalt::CameraBatchValid valid(20);
+  cam.projectBatch(p3d, proj, valid);
+
+  basalt::IntegratedImuMeasurement<double> imu_meas(
+      0, Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero());
+  std::vector<basalt::ImuData<double>> data(10);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i].t_ns = (i + 1) * 5000000;
+    data[i].accel << 0, 0, 9.81;
+    data[i].gyro.setZero();
+  }
+  imu_meas.integrateBatch(data, Eigen::Vector3d::Ones(),
+                          Eigen::Vector3d::Ones());
+
+  const auto stats = sink.snapshot();
+
+  const auto* pyr_stats =
+      findStats(stats, "basalt::ManagedImagePyr::setFromImage");
+  ASSERT_TRUE(pyr_stats);
+  EXPECT_EQ(pyr_stats->calls, 1u);
+
+  const auto* proj_stats = findStats(stats, "basalt::projectBatch points");
+  ASSERT_TRUE(proj_stats);
+  EXPECT_EQ(proj_stats->count, 20);
+
+  const auto* imu_stats = findStats(
+      stats, "basalt::IntegratedImuMeasurement::integrateBatch samples");
+  ASSERT_TRUE(imu_stats);
+  EXPECT_EQ(imu_stats->count, 10);
+}
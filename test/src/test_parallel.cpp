@@ -0,0 +1,164 @@
+/**
+BSD 3-Clause License
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <basalt/utils/parallel.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(ParallelTest, ParallelFor) {
+  const size_t num_tasks = 1000;
+
+  {
+    // start a thread for every worker
+    std::vector<int> count(num_tasks, 0);
+    basalt::ThreadSpawnExecutor executor;
+    basalt::parallelFor(num_tasks, executor, 3,
+                        [&](size_t i) { count[i]++; });
+    executor.join();
+    EXPECT_EQ(count, std::vector<int>(num_tasks, 1));
+  }
+
+  {
+    // run workers immediately
+    std::vector<int> count(num_tasks, 0);
+    size_t num_workers = 0;
+    const auto executor = [&](std::function<void()> task) {
+      num_workers++;
+      task();
+    };
+    basalt::parallelFor(num_tasks, executor, 2, [&](size_t i) { count[i]++; });
+    EXPECT_EQ(count, std::vector<int>(num_tasks, 1));
+    EXPECT_EQ(num_workers, 2u);
+  }
+
+  {
+    // run workers after all tasks are done, they return immediately
+    std::vector<std::function<void()>> workers;
+    const auto executor = [&](std::function<void()> task) {
+      workers.emplace_back(std::move(task));
+    };
+    std::vector<int> count(num_tasks, 0);
+    basalt::parallelFor(num_tasks, executor, 4, [&](size_t i) { count[i]++; });
+    EXPECT_EQ(count, std::vector<int>(num_tasks, 1));
+    EXPECT_EQ(workers.size(), 4u);
+    for (auto& w : workers) w();
+  }
+
+  {
+    // no more workers than tasks
+    size_t num_workers = 0;
+    const auto executor = [&](std::function<void()> task) {
+      num_workers++;
+      task();
+    };
+    basalt::parallelFor(3, executor, 8, [](size_t) {});
+    EXPECT_EQ(num_workers, 2u);
+    basalt::parallelFor(0, executor, 8, [](size_t) { FAIL(); });
+    EXPECT_EQ(num_workers, 2u);
+  }
+}
+
+TEST(ParallelTest, ParallelForExceptions) {
+  const size_t num_tasks = 1000;
+
+  {
+    // a task throws in a worker thread or the calling thread
+    std::vector<int> count(num_tasks, 0);
+    basalt::ThreadSpawnExecutor executor;
+    EXPECT_THROW(basalt::parallelFor(num_tasks, executor, 3,
+                                     [&](size_t i) {
+                                       count[i]++;
+                                       if (i == 100) {
+                                         throw std::runtime_error("task");
+                                       }
+                                     }),
+                 std::runtime_error);
+    executor.join();
+    for (size_t i = 0; i < num_tasks; i++) EXPECT_LE(count[i], 1);
+    EXPECT_EQ(count[100], 1);
+  }
+
+  {
+    // all tasks run on the calling thread, the workers start afterwards
+    std::vector<std::function<void()>> workers;
+    const auto executor = [&](std::function<void()> task) {
+      workers.emplace_back(std::move(task));
+    };
+    std::vector<int> count(num_tasks, 0);
+    EXPECT_THROW(basalt::parallelFor(num_tasks, executor, 2,
+                                     [&](size_t i) {
+                                       count[i]++;
+                                       if (i == 5) {
+                                         throw std::runtime_error("task");
+                                       }
+                                     }),
+                 std::runtime_error);
+    EXPECT_EQ(std::count(count.begin(), count.end(), 1), 6);
+    EXPECT_EQ(count[5], 1);
+
+    // the late workers do not start any task
+    for (auto& w : workers) w();
+    EXPECT_EQ(std::count(count.begin(), count.end(), 1), 6);
+  }
+
+  {
+    // the executor fails to start the second worker
+    std::vector<std::function<void()>> workers;
+    const auto executor = [&](std::function<void()> task) {
+      if (!workers.empty()) throw std::runtime_error("executor");
+      workers.emplace_back(std::move(task));
+    };
+    std::vector<int> count(num_tasks, 0);
+    EXPECT_THROW(basalt::parallelFor(num_tasks, executor, 3,
+                                     [&](size_t i) { count[i]++; }),
+                 std::runtime_error);
+    EXPECT_EQ(count, std::vector<int>(num_tasks, 0));
+
+    ASSERT_EQ(workers.size(), 1u);
+    workers[0]();
+    EXPECT_EQ(count, std::vector<int>(num_tasks, 0));
+  }
+
+  {
+    // without workers exceptions propagate directly
+    const auto executor = [](std::function<void()>) { FAIL(); };
+    EXPECT_THROW(basalt::parallelFor(num_tasks, executor, 0,
+                                     [](size_t) {
+                                       throw std::runtime_error("task");
+                                     }),
+                 std::runtime_error);
+  }
+}
@@ -30,6 +30,7 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <basalt/imu/pose_vel_bias_state_array.h>
 #include <basalt/imu/preintegration.h>
 #include <basalt/spline/se3_spline.h>
 
@@ -648,6 +649,360 @@ TEST(ImuPreintegrationTestCase, CovarianceTest) {
   EXPECT_LE(std::abs(std::sqrt(var) - ACCEL_STD_DEV), 0.03);
 }
 
+TEST(ImuPreintegrationTestCase, IntegrateBatchTest) {
+  int num_knots = 15;
+
+  basalt::Se3Spline<5> gt_spline(int64_t(10e9));
+  gt_spline.genRandomTrajectory(num_knots);
+
+  const Eigen::Vector3d bg(0.01, -0.02, 0.005);
+  const Eigen::Vector3d ba(-0.1, 0.05, 0.2);
+
+  std::vector<basalt::ImuData<double>> data_vec;
+
+  int64_t start_t_ns = 12345;
+  int64_t dt_ns = 2.5e6;
+  for (int64_t t_ns = start_t_ns + dt_ns; t_ns < int64_t(1e9); t_ns += dt_ns) {
+    Sophus::SE3d pose = gt_spline.pose(t_ns);
+
+    basalt::ImuData<double> data;
+    data.accel = pose.so3().inverse() *
+                 (gt_spline.transAccelWorld(t_ns) - basalt::constants::G);
+    data.gyro = gt_spline.rotVelBody(t_ns);
+    data.t_ns = t_ns;
+
+    for (int j = 0; j < 3; j++) {
+      data.accel[j] += accel_noise_dist(gen) + ba[j];
+      data.gyro[j] += gyro_noise_dist(gen) + bg[j];
+    }
+
+    data_vec.emplace_back(data);
+  }
+
+  Eigen::Vector3d accel_cov(0.1, 0.2, 0.3);
+  Eigen::Vector3d gyro_cov(0.01, 0.02, 0.03);
+
+  basalt::IntegratedImuMeasurement<double> imu_meas(start_t_ns, bg, ba);
+  for (const auto& data : data_vec) {
+    imu_meas.integrate(data, accel_cov, gyro_cov);
+  }
+
+  // integrate in two batches of different size
+  basalt::IntegratedImuMeasurement<double> imu_meas_batch(start_t_ns, bg, ba);
+  const size_t num_first = data_vec.size() / 3;
+  imu_meas_batch.integrateBatch(data_vec.data(), num_first, accel_cov,
+                                gyro_cov);
+  imu_meas_batch.integrateBatch(data_vec.data() + num_first,
+                                data_vec.size() - num_first, accel_cov,
+                                gyro_cov);
+
+  const auto& state = imu_meas.getDeltaState();
+  const auto& state_batch = imu_meas_batch.getDeltaState();
+
+  EXPECT_EQ(imu_meas.get_dt_ns(), imu_meas_batch.get_dt_ns());
+  EXPECT_TRUE(state.T_w_i.translation().isApprox(
+      state_batch.T_w_i.translation(), 1e-12));
+  EXPECT_TRUE(state.T_w_i.so3().matrix().isApprox(
+      state_batch.T_w_i.so3().matrix(), 1e-12));
+  EXPECT_TRUE(state.vel_w_i.isApprox(state_batch.vel_w_i, 1e-12));
+
+  EXPECT_TRUE(imu_meas.get_cov().isApprox(imu_meas_batch.get_cov(), 1e-10))
+      << "cov\n"
+      << imu_meas.get_cov() << "\ncov_batch\n"
+      << imu_meas_batch.get_cov();
+  EXPECT_TRUE(imu_meas.get_d_state_d_ba().isApprox(
+      imu_meas_batch.get_d_state_d_ba(), 1e-10))
+      << "d_state_d_ba\n"
+      << imu_meas.get_d_state_d_ba() << "\nd_state_d_ba_batch\n"
+      << imu_meas_batch.get_d_state_d_ba();
+  EXPECT_TRUE(imu_meas.get_d_state_d_bg().isApprox(
+      imu_meas_batch.get_d_state_d_bg(), 1e-10))
+      << "d_state_d_bg\n"
+      << imu_meas.get_d_state_d_bg() << "\nd_state_d_bg_batch\n"
+      << imu_meas_batch.get_d_state_d_bg();
+
+  EXPECT_TRUE(
+      imu_meas.get_cov_inv().isApprox(imu_meas_batch.get_cov_inv(), 1e-6));
+
+  // the std::vector overload and empty batches
+  basalt::IntegratedImuMeasurement<double> imu_meas_vec(start_t_ns, bg, ba);
+  imu_meas_vec.integrateBatch(data_vec.data(), 0, accel_cov, gyro_cov);
+  imu_meas_vec.integrateBatch(data_vec, accel_cov, gyro_cov);
+  EXPECT_TRUE(imu_meas_vec.get_cov().isApprox(imu_meas_batch.get_cov(), 1e-10));
+}
+
+TEST(ImuPreintegrationTestCase, UpdateBiasLinTest) {
+  basalt::Se3Spline<5> gt_spline(int64_t(10e9));
+  gt_spline.genRandomTrajectory(15);
+
+  std::vector<basalt::ImuData<double>> data_vec;
+
+  int64_t dt_ns = 5e6;
+  for (int64_t t_ns = dt_ns; t_ns < int64_t(5e8); t_ns += dt_ns) {
+    Sophus::SE3d pose = gt_spline.pose(t_ns);
+
+    basalt::ImuData<double> data;
+    data.accel = pose.so3().inverse() *
+                 (gt_spline.transAccelWorld(t_ns) - basalt::constants::G);
+    data.gyro = gt_spline.rotVelBody(t_ns);
+    data.t_ns = t_ns;
+    data_vec.emplace_back(data);
+  }
+
+  const Eigen::Vector3d accel_cov = Eigen::Vector3d::Constant(0.1);
+  const Eigen::Vector3d gyro_cov = Eigen::Vector3d::Constant(0.01);
+
+  const Eigen::Vector3d bg0(0.01, -0.02, 0.005);
+  const Eigen::Vector3d ba0(-0.1, 0.05, 0.2);
+  const Eigen::Vector3d bg1 = bg0 + Eigen::Vector3d(0.05, 0.02, -0.03);
+  const Eigen::Vector3d ba1 = ba0 + Eigen::Vector3d(0.3, -0.2, 0.1);
+
+  basalt::IntegratedImuMeasurement<double> imu_meas_ref(0, bg1, ba1);
+  imu_meas_ref.integrateBatch(data_vec, accel_cov, gyro_cov);
+
+  basalt::PoseVelState<double> state0(0, Sophus::SE3d(),
+                                      Eigen::Vector3d::Zero());
+  basalt::PoseVelState<double> state1;
+  imu_meas_ref.predictState(state0, basalt::constants::G, state1);
+
+  {
+    // re-integration from stored data
+    basalt::IntegratedImuMeasurement<double> imu_meas(0, bg0, ba0);
+    imu_meas.setKeepData(true);
+    imu_meas.integrateBatch(data_vec.data(), 10, accel_cov, gyro_cov);
+    for (size_t i = 10; i < data_vec.size(); i++) {
+      imu_meas.integrate(data_vec[i], accel_cov, gyro_cov);
+    }
+
+    // small change is handled by the first order correction
+    const Eigen::VectorXd cov_before = imu_meas.get_cov().reshaped();
+    EXPECT_FALSE(imu_meas.updateBiasLin(bg1, ba1, 1, 1));
+    EXPECT_TRUE(imu_meas.get_bias_gyro_lin().isApprox(bg0));
+    EXPECT_TRUE(imu_meas.get_bias_accel_lin().isApprox(ba0));
+    EXPECT_TRUE(imu_meas.get_cov().reshaped().isApprox(cov_before));
+
+    EXPECT_TRUE(imu_meas.updateBiasLin(bg1, ba1, 0.01, 1));
+    EXPECT_TRUE(imu_meas.get_bias_gyro_lin().isApprox(bg1));
+    EXPECT_TRUE(imu_meas.get_bias_accel_lin().isApprox(ba1));
+
+    const auto& state = imu_meas.getDeltaState();
+    const auto& state_ref = imu_meas_ref.getDeltaState();
+    EXPECT_EQ(imu_meas.get_dt_ns(), imu_meas_ref.get_dt_ns());
+    EXPECT_TRUE(state.T_w_i.translation().isApprox(
+        state_ref.T_w_i.translation(), 1e-12));
+    EXPECT_TRUE(state.T_w_i.so3().matrix().isApprox(
+        state_ref.T_w_i.so3().matrix(), 1e-12));
+    EXPECT_TRUE(state.vel_w_i.isApprox(state_ref.vel_w_i, 1e-12));
+    EXPECT_TRUE(imu_meas.get_cov().isApprox(imu_meas_ref.get_cov(), 1e-12));
+    EXPECT_TRUE(imu_meas.get_d_state_d_ba().isApprox(
+        imu_meas_ref.get_d_state_d_ba(), 1e-12));
+    EXPECT_TRUE(imu_meas.get_d_state_d_bg().isApprox(
+        imu_meas_ref.get_d_state_d_bg(), 1e-12));
+  }
+
+  {
+    // without stored data the first order correction moves into the delta
+    // state and the residual at the new biases does not change
+    basalt::IntegratedImuMeasurement<double> imu_meas(0, bg0, ba0);
+    imu_meas.integrateBatch(data_vec, accel_cov, gyro_cov);
+
+    const basalt::PoseVelState<double>::VecN res_before = imu_meas.residual(
+        state0, basalt::constants::G, state1, bg1, ba1);
+
+    EXPECT_FALSE(imu_meas.updateBiasLin(bg1, ba1, 0.01, 0.01));
+    EXPECT_TRUE(imu_meas.get_bias_gyro_lin().isApprox(bg1));
+    EXPECT_TRUE(imu_meas.get_bias_accel_lin().isApprox(ba1));
+
+    const basalt::PoseVelState<double>::VecN res_after = imu_meas.residual(
+        state0, basalt::constants::G, state1, bg1, ba1);
+
+    EXPECT_TRUE(res_before.isApprox(res_after, 1e-8))
+        << "res_before " << res_before.transpose() << "\nres_after "
+        << res_after.transpose();
+  }
+}
+
+TEST(ImuPreintegrationTestCase, AppendTest) {
+  basalt::Se3Spline<5> gt_spline(int64_t(10e9));
+  gt_spline.genRandomTrajectory(15);
+
+  std::vector<basalt::ImuData<double>> data_vec;
+
+  int64_t start_t_ns = 1000;
+  int64_t dt_ns = 2e6;
+  for (int64_t t_ns = start_t_ns + dt_ns; t_ns < int64_t(1e9); t_ns += dt_ns) {
+    Sophus::SE3d pose = gt_spline.pose(t_ns);
+
+    basalt::ImuData<double> data;
+    data.accel = pose.so3().inverse() *
+                 (gt_spline.transAccelWorld(t_ns) - basalt::constants::G);
+    data.gyro = gt_spline.rotVelBody(t_ns);
+    data.t_ns = t_ns;
+    data_vec.emplace_back(data);
+  }
+
+  const Eigen::Vector3d accel_cov(0.1, 0.2, 0.3);
+  const Eigen::Vector3d gyro_cov(0.01, 0.02, 0.03);
+  const Eigen::Vector3d bg(0.01, -0.02, 0.005);
+  const Eigen::Vector3d ba(-0.1, 0.05, 0.2);
+
+  basalt::IntegratedImuMeasurement<double> imu_meas_ref(start_t_ns, bg, ba);
+  imu_meas_ref.setKeepData(true);
+  imu_meas_ref.integrateBatch(data_vec, accel_cov, gyro_cov);
+
+  // integrate three segments independently and append them
+  const size_t split[] = {0, 100, 317, data_vec.size()};
+  std::vector<basalt::IntegratedImuMeasurement<double>> segments;
+  for (int i = 0; i < 3; i++) {
+    int64_t segment_start_t_ns =
+        split[i] == 0 ? start_t_ns : data_vec[split[i] - 1].t_ns;
+    segments.emplace_back(segment_start_t_ns, bg, ba);
+    segments.back().setKeepData(true);
+    segments.back().integrateBatch(data_vec.data() + split[i],
+                                   split[i + 1] - split[i], accel_cov,
+                                   gyro_cov);
+  }
+
+  basalt::IntegratedImuMeasurement<double> imu_meas = segments[0];
+  imu_meas.append(segments[1]);
+  imu_meas.append(segments[2]);
+
+  const auto& state = imu_meas.getDeltaState();
+  const auto& state_ref = imu_meas_ref.getDeltaState();
+
+  EXPECT_EQ(imu_meas.get_start_t_ns(), imu_meas_ref.get_start_t_ns());
+  EXPECT_EQ(imu_meas.get_dt_ns(), imu_meas_ref.get_dt_ns());
+  EXPECT_TRUE(state.T_w_i.translation().isApprox(
+      state_ref.T_w_i.translation(), 1e-10));
+  EXPECT_TRUE(state.T_w_i.so3().matrix().isApprox(
+      state_ref.T_w_i.so3().matrix(), 1e-10));
+  EXPECT_TRUE(state.vel_w_i.isApprox(state_ref.vel_w_i, 1e-10));
+
+  EXPECT_TRUE(imu_meas.get_cov().isApprox(imu_meas_ref.get_cov(), 1e-10))
+      << "cov\n"
+      << imu_meas.get_cov() << "\ncov_ref\n"
+      << imu_meas_ref.get_cov();
+  EXPECT_TRUE(imu_meas.get_d_state_d_ba().isApprox(
+      imu_meas_ref.get_d_state_d_ba(), 1e-10));
+  EXPECT_TRUE(imu_meas.get_d_state_d_bg().isApprox(
+      imu_meas_ref.get_d_state_d_bg(), 1e-10));
+
+  // the stored data is appended as well
+  const Eigen::Vector3d bg1(0.03, 0.01, -0.02);
+  const Eigen::Vector3d ba1(0.1, 0.2, -0.1);
+  imu_meas.reintegrate(bg1, ba1);
+  imu_meas_ref.reintegrate(bg1, ba1);
+  EXPECT_TRUE(imu_meas.get_cov().isApprox(imu_meas_ref.get_cov(), 1e-12));
+  EXPECT_TRUE(imu_meas.getDeltaState().vel_w_i.isApprox(
+      imu_meas_ref.getDeltaState().vel_w_i, 1e-12));
+}
+
+template <class MeasT>
+void expectPreintegrationNear(
+    const MeasT& imu_meas,
+    const basalt::IntegratedImuMeasurement<double>& imu_meas_ref,
+    double max_pos_err, double max_rot_err, double max_vel_err,
+    double max_rel_cov_err, double max_rel_cov_inv_err) {
+  const auto state = imu_meas.getDeltaState().template cast<double>();
+  const auto& state_ref = imu_meas_ref.getDeltaState();
+
+  const auto rel_err = [](const auto& a, const auto& b) {
+    return (a.template cast<double>() - b).norm() / b.norm();
+  };
+
+  EXPECT_EQ(state.t_ns, state_ref.t_ns);
+  EXPECT_LE((state.T_w_i.translation() - state_ref.T_w_i.translation()).norm(),
+            max_pos_err);
+  EXPECT_LE((state.T_w_i.so3() * state_ref.T_w_i.so3().inverse()).log().norm(),
+            max_rot_err);
+  EXPECT_LE((state.vel_w_i - state_ref.vel_w_i).norm(), max_vel_err);
+
+  EXPECT_LE(rel_err(imu_meas.get_cov(), imu_meas_ref.get_cov()),
+            max_rel_cov_err);
+  EXPECT_LE(
+      rel_err(imu_meas.get_d_state_d_ba(), imu_meas_ref.get_d_state_d_ba()),
+      max_rel_cov_err);
+  EXPECT_LE(
+      rel_err(imu_meas.get_d_state_d_bg(), imu_meas_ref.get_d_state_d_bg()),
+      max_rel_cov_err);
+  // The square root is not unique, compare the inverse instead.
+  EXPECT_LE(rel_err(imu_meas.get_cov_inv(), imu_meas_ref.get_cov_inv()),
+            max_rel_cov_inv_err);
+}
+
+TEST(ImuPreintegrationTestCase, MixedPrecisionTest) {
+  basalt::Se3Spline<5> gt_spline(int64_t(2e9));
+  gt_spline.genRandomTrajectory(15);
+
+  // 20 seconds at 1 kHz
+  std::vector<basalt::ImuData<double>> data_vec;
+  std::vector<basalt::ImuData<float>> data_vec_float;
+
+  int64_t dt_ns = 1e6;
+  for (int64_t t_ns = dt_ns; t_ns <= int64_t(20e9); t_ns += dt_ns) {
+    Sophus::SE3d pose = gt_spline.pose(t_ns);
+
+    basalt::ImuData<double> data;
+    data.accel = pose.so3().inverse() *
+                     (gt_spline.transAccelWorld(t_ns) - basalt::constants::G);
+    data.gyro = gt_spline.rotVelBody(t_ns);
+    data.t_ns = t_ns;
+
+    // round to float, so that all versions integrate the same data
+    data_vec_float.emplace_back(data.cast<float>());
+    data_vec.emplace_back(data_vec_float.back().cast<double>());
+  }
+
+  const Eigen::Vector3d accel_cov =
+      Eigen::Vector3d::Constant(ACCEL_STD_DEV * ACCEL_STD_DEV);
+  const Eigen::Vector3d gyro_cov =
+      Eigen::Vector3d::Constant(GYRO_STD_DEV * GYRO_STD_DEV);
+  const Eigen::Vector3f bg(0.001, -0.002, 0.0005);
+  const Eigen::Vector3f ba(-0.01, 0.005, 0.02);
+
+  basalt::IntegratedImuMeasurement<double> imu_meas_ref(
+      0, bg.cast<double>(), ba.cast<double>());
+  imu_meas_ref.integrateBatch(data_vec, accel_cov, gyro_cov);
+
+  basalt::IntegratedImuMeasurement<float> imu_meas_float(0, bg, ba);
+  basalt::IntegratedImuMeasurement<float, double> imu_meas_mixed(0, bg, ba);
+  basalt::IntegratedImuMeasurement<float, double> imu_meas_mixed_seq(0, bg,
+                                                                     ba);
+
+  imu_meas_float.integrateBatch(data_vec_float, accel_cov.cast<float>(),
+                                gyro_cov.cast<float>());
+  imu_meas_mixed.integrateBatch(data_vec_float, accel_cov.cast<float>(),
+                                gyro_cov.cast<float>());
+  for (const auto& data : data_vec_float) {
+    imu_meas_mixed_seq.integrate(data, accel_cov.cast<float>(),
+                                 gyro_cov.cast<float>());
+  }
+
+  // Single precision accumulates rounding errors over the long interval.
+  expectPreintegrationNear(imu_meas_float, imu_meas_ref, 0.5, 1e-3, 1e-2,
+                           1e-3, 1e-2);
+
+  // Mixed precision is only limited by the single precision increments.
+  expectPreintegrationNear(imu_meas_mixed, imu_meas_ref, 1e-3, 1e-6, 1e-4,
+                           1e-6, 1e-6);
+
+  // Sequential integration uses the same code path
+  EXPECT_EQ(imu_meas_mixed_seq.get_cov(), imu_meas_mixed.get_cov());
+  EXPECT_EQ(imu_meas_mixed_seq.getDeltaState().vel_w_i,
+            imu_meas_mixed.getDeltaState().vel_w_i);
+
+  // Residual of the reference end state is small in single precision
+  basalt::PoseVelState<double> state0(0, Sophus::SE3d(),
+                                      Eigen::Vector3d::Zero());
+  basalt::PoseVelState<double> state1;
+  imu_meas_ref.predictState(state0, basalt::constants::G, state1);
+
+  const Eigen::Matrix<float, 9, 1> res = imu_meas_mixed.residual(
+      state0.cast<float>(), basalt::constants::G.cast<float>(),
+      state1.cast<float>(), bg, ba);
+  EXPECT_LE(res.norm(), 1e-2);
+}
+
 TEST(ImuPreintegrationTestCase, RandomWalkTest) {
   double dt = 0.005;
 
@@ -753,3 +1108,66 @@ TEST(ImuPreintegrationTestCase, ComputeSqrtCovInv) {
       << cov_inv_computed << "\ncov_inv_gt\n"
       << cov_inv_gt;
 }
+
+TEST(ImuPreintegrationTestCase, StateArrayTest) {
+  using State = basalt::PoseVelBiasState<double>;
+  using StateArray = basalt::PoseVelBiasStateArray<double>;
+
+  const size_t num_states = 50;
+
+  Eigen::aligned_vector<State> states(num_states);
+  for (size_t i = 0; i < num_states; i++) {
+    states[i] = State(i * 1000, Sophus::se3_expd(Sophus::Vector6d::Random()),
+                      Eigen::Vector3d::Random(), Eigen::Vector3d::Random(),
+                      Eigen::Vector3d::Random());
+  }
+
+  StateArray array(states);
+  ASSERT_EQ(array.size(), num_states);
+
+  Eigen::VectorXd inc =
+      Eigen::VectorXd::Random(basalt::POSE_VEL_BIAS_SIZE * num_states);
+  // Cover the small angle branch of the exponential map.
+  inc.segment<3>(3).setZero();
+  inc.segment<3>(basalt::POSE_VEL_BIAS_SIZE + 3).setConstant(1e-12);
+
+  StateArray array_inc = array;
+  array_inc.applyInc(inc);
+
+  for (size_t i = 0; i < num_states; i++) {
+    State s = states[i];
+    s.applyInc(inc.segment<basalt::POSE_VEL_BIAS_SIZE>(
+        basalt::POSE_VEL_BIAS_SIZE * i));
+
+    const State s_array = array_inc.getState(i);
+    EXPECT_EQ(s.t_ns, s_array.t_ns);
+    EXPECT_TRUE(s.T_w_i.matrix().isApprox(s_array.T_w_i.matrix()))
+        << "i " << i;
+    EXPECT_TRUE(s.vel_w_i.isApprox(s_array.vel_w_i));
+    EXPECT_TRUE(s.bias_gyro.isApprox(s_array.bias_gyro));
+    EXPECT_TRUE(s.bias_accel.isApprox(s_array.bias_accel));
+
+    Eigen::VectorXd d = states[i].diff(s);
+    Eigen::VectorXd d_array = array.diff(array_inc).segment<15>(15 * i);
+    EXPECT_TRUE(d.isApprox(d_array, 1e-10)) << "d " << d.transpose()
+                                            << "\nd_array "
+                                            << d_array.transpose();
+  }
+
+  const Eigen::VectorXd d = array.diff(array_inc);
+  EXPECT_TRUE(d.isApprox(inc, 1e-10));
+
+  // Per-state access maps the array storage.
+  array_inc.T_w_i(3) = states[3].T_w_i;
+  array_inc.vel_w_i(3) = states[3].vel_w_i;
+  array_inc.bias_gyro(3) = states[3].bias_gyro;
+  array_inc.bias_accel(3) = states[3].bias_accel;
+  EXPECT_TRUE(array.diff(array_inc).segment<15>(15 * 3).isZero(1e-12));
+
+  array_inc.resize(num_states + 2);
+  EXPECT_TRUE(array_inc.getState(num_states + 1)
+                  .T_w_i.matrix()
+                  .isApprox(Eigen::Matrix4d::Identity()));
+  EXPECT_TRUE(array_inc.getState(num_states).vel_w_i.isZero());
+  EXPECT_EQ(array_inc.getStates().size(), num_states + 2);
+}
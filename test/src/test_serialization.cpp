@@ -0,0 +1,355 @@
+/**
+BSD 3-Clause License
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <basalt/serialization/headers_serialization.h>
+#include <basalt/utils/ring_buffer.h>
+
+#include <cereal/archives/portable_binary.hpp>
+
+#include <deque>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// More than two chunks, not a multiple of the chunk size.
+constexpr size_t NUM_ELEMENTS =
+    2 * cereal::basalt_detail::BLOB_CHUNK_SIZE + 123;
+
+template <class OutputArchive, class T>
+std::string saveToString(const T& val) {
+  std::ostringstream os;
+  {
+    OutputArchive ar(os);
+    ar(val);
+  }
+  return os.str();
+}
+
+template <class InputArchive, class T>
+void loadFromString(const std::string& str, T& val) {
+  std::istringstream is(str);
+  InputArchive ar(is);
+  ar(val);
+}
+
+// Reference serialization of a container element by element, without blobs.
+template <class OutputArchive, class Container>
+std::string saveElementwise(const Container& c) {
+  std::ostringstream os;
+  {
+    OutputArchive ar(os);
+    ar(cereal::make_size_tag(static_cast<cereal::size_type>(c.size())));
+    for (const auto& v : c) {
+      ar(v);
+    }
+  }
+  return os.str();
+}
+
+template <class Derived>
+const Derived& params(const Eigen::MatrixBase<Derived>& m) {
+  return m.derived();
+}
+
+template <class Scalar>
+Eigen::Matrix<Scalar, 4, 1> params(const Sophus::SO3<Scalar>& p) {
+  return p.params();
+}
+
+template <class Scalar>
+Eigen::Matrix<Scalar, 7, 1> params(const Sophus::SE3<Scalar>& p) {
+  return p.params();
+}
+
+template <class Scalar>
+Eigen::Matrix<Scalar, 7, 1> params(const Sophus::Sim3<Scalar>& p) {
+  return p.params();
+}
+
+// Binary archives store the exact bits. Text archives store decimal numbers,
+// which only load back bit-exact if the parser uses full precision, so they
+// are compared up to rounding in the last digit.
+template <class Archive>
+constexpr bool isExact() {
+  return !cereal::traits::is_text_archive<Archive>::value;
+}
+
+template <class A, class B>
+void expectParamsEq(const A& a, const B& b, bool exact = true) {
+  const auto pa = params(a);
+  const auto pb = params(b);
+  ASSERT_EQ(pa.rows(), pb.rows());
+  ASSERT_EQ(pa.cols(), pb.cols());
+  if (exact) {
+    EXPECT_EQ(pa, pb);
+  } else {
+    using Scalar = typename std::decay_t<decltype(pa)>::Scalar;
+    EXPECT_TRUE(pa.isApprox(pb, 4 * std::numeric_limits<Scalar>::epsilon()))
+        << "a:\n"
+        << pa << "\nb:\n"
+        << pb;
+  }
+}
+
+template <class OutputArchive, class InputArchive, class T>
+void testRoundTrip(const T& val) {
+  const std::string str = saveToString<OutputArchive>(val);
+
+  T loaded;
+  loadFromString<InputArchive>(str, loaded);
+
+  expectParamsEq(loaded, val, isExact<InputArchive>());
+}
+
+template <class OutputArchive, class InputArchive, class Container>
+void testContainerRoundTrip(const Container& c) {
+  const std::string str = saveToString<OutputArchive>(c);
+
+  Container loaded;
+  loadFromString<InputArchive>(str, loaded);
+
+  ASSERT_EQ(loaded.size(), c.size());
+  auto it = c.begin();
+  for (const auto& v : loaded) {
+    expectParamsEq(v, *it, isExact<InputArchive>());
+    ++it;
+  }
+}
+
+template <class OutputArchive, class InputArchive>
+void testMatrices() {
+  using namespace Eigen;
+
+  testRoundTrip<OutputArchive, InputArchive>(Vector3d(Vector3d::Random()));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<double, 3, 4>(Matrix<double, 3, 4>::Random()));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<double, 3, 4, RowMajor>(Matrix<double, 3, 4, RowMajor>::Random()));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<float, 2, 5>(Matrix<float, 2, 5>::Random()));
+
+  testRoundTrip<OutputArchive, InputArchive>(VectorXd(VectorXd::Random(10)));
+  testRoundTrip<OutputArchive, InputArchive>(MatrixXd(MatrixXd::Random(3, 4)));
+  testRoundTrip<OutputArchive, InputArchive>(MatrixXd(0, 0));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<double, Dynamic, Dynamic, RowMajor>(
+          Matrix<double, Dynamic, Dynamic, RowMajor>::Random(3, 4)));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<double, 3, Dynamic>(Matrix<double, 3, Dynamic>::Random(3, 5)));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<double, 3, Dynamic, RowMajor>(
+          Matrix<double, 3, Dynamic, RowMajor>::Random(3, 5)));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<double, Dynamic, 2>(Matrix<double, Dynamic, 2>::Random(4, 2)));
+  testRoundTrip<OutputArchive, InputArchive>(
+      Matrix<double, Dynamic, 2, RowMajor>(
+          Matrix<double, Dynamic, 2, RowMajor>::Random(4, 2)));
+}
+
+template <class Container>
+Container randomContainer(size_t size) {
+  using T = typename Container::value_type;
+
+  Container c;
+  for (size_t i = 0; i < size; i++) {
+    if constexpr (std::is_same_v<T, Eigen::Vector3d>) {
+      c.push_back(Eigen::Vector3d::Random());
+    } else {
+      c.push_back(T::exp(T::Tangent::Random()));
+    }
+  }
+  return c;
+}
+
+template <class OutputArchive, class InputArchive, class T>
+void testContainers() {
+  for (size_t size : {size_t(0), size_t(5), NUM_ELEMENTS}) {
+    testContainerRoundTrip<OutputArchive, InputArchive>(
+        randomContainer<Eigen::aligned_vector<T>>(size));
+    testContainerRoundTrip<OutputArchive, InputArchive>(
+        randomContainer<Eigen::aligned_deque<T>>(size));
+  }
+}
+
+template <class OutputArchive, class InputArchive>
+void testAllContainers() {
+  testContainers<OutputArchive, InputArchive, Eigen::Vector3d>();
+  testContainers<OutputArchive, InputArchive, Sophus::SO3d>();
+  testContainers<OutputArchive, InputArchive, Sophus::SE3d>();
+  testContainers<OutputArchive, InputArchive, Sophus::Sim3d>();
+}
+
+template <class OutputArchive, class T>
+void testBlobLayout() {
+  const auto v = randomContainer<Eigen::aligned_vector<T>>(NUM_ELEMENTS);
+  const auto d = randomContainer<Eigen::aligned_deque<T>>(NUM_ELEMENTS);
+
+  EXPECT_EQ(saveToString<OutputArchive>(v), saveElementwise<OutputArchive>(v));
+  EXPECT_EQ(saveToString<OutputArchive>(d), saveElementwise<OutputArchive>(d));
+}
+
+template <class OutputArchive>
+void testAllBlobLayouts() {
+  testBlobLayout<OutputArchive, Eigen::Vector3d>();
+  testBlobLayout<OutputArchive, Sophus::SO3d>();
+  testBlobLayout<OutputArchive, Sophus::SE3d>();
+  testBlobLayout<OutputArchive, Sophus::Sim3d>();
+
+  // column-major matrices are stored in row-major order
+  const Eigen::Matrix<double, 3, 4> m = Eigen::Matrix<double, 3, 4>::Random();
+  std::ostringstream os;
+  {
+    OutputArchive ar(os);
+    for (int i = 0; i < m.rows(); i++) {
+      for (int j = 0; j < m.cols(); j++) {
+        ar(m(i, j));
+      }
+    }
+  }
+  EXPECT_EQ(saveToString<OutputArchive>(m), os.str());
+}
+
+template <class Spline1, class Spline2>
+void expectSplineEq(const Spline1& a, const Spline2& b, bool exact) {
+  ASSERT_EQ(a.numKnots(), b.numKnots());
+  EXPECT_EQ(a.minTimeNs(), b.minTimeNs());
+  EXPECT_EQ(a.getDtNs(), b.getDtNs());
+  for (size_t i = 0; i < a.numKnots(); i++) {
+    expectParamsEq(a.getKnotPos(i), b.getKnotPos(i), exact);
+    expectParamsEq(a.getKnotSO3(i), b.getKnotSO3(i), exact);
+  }
+}
+
+template <class OutputArchive, class InputArchive>
+void testSe3Spline() {
+  static constexpr int N = 5;
+
+  basalt::Se3Spline<N> spline(int64_t(2e8), 12345);
+  spline.genRandomTrajectory(3 * N);
+
+  const std::string str = saveToString<OutputArchive>(spline);
+
+  constexpr bool exact = isExact<InputArchive>();
+
+  basalt::Se3Spline<N> loaded(1);
+  loadFromString<InputArchive>(str, loaded);
+  expectSplineEq(spline, loaded, exact);
+
+  // the format does not depend on the knot storage
+  basalt::Se3Spline<N, double, basalt::RingBuffer> loaded_rb(1);
+  loadFromString<InputArchive>(str, loaded_rb);
+  expectSplineEq(spline, loaded_rb, exact);
+  EXPECT_EQ(saveToString<OutputArchive>(loaded_rb),
+            saveToString<OutputArchive>(loaded));
+
+  basalt::Se3Spline<N, float> spline_float(int64_t(2e8), -12345);
+  spline_float.genRandomTrajectory(3 * N);
+
+  basalt::Se3Spline<N, float> loaded_float(1);
+  loadFromString<InputArchive>(saveToString<OutputArchive>(spline_float),
+                               loaded_float);
+  expectSplineEq(spline_float, loaded_float, exact);
+}
+
+}  // namespace
+
+TEST(SerializationTest, MatricesBinary) {
+  testMatrices<cereal::BinaryOutputArchive, cereal::BinaryInputArchive>();
+}
+
+TEST(SerializationTest, MatricesPortableBinary) {
+  testMatrices<cereal::PortableBinaryOutputArchive,
+               cereal::PortableBinaryInputArchive>();
+}
+
+TEST(SerializationTest, MatricesJson) {
+  testMatrices<cereal::JSONOutputArchive, cereal::JSONInputArchive>();
+}
+
+TEST(SerializationTest, MatricesJsonLegacyLayout) {
+  // dynamic matrices written as a plain array of coefficients load as before
+  Eigen::MatrixXd m;
+  loadFromString<cereal::JSONInputArchive>("{\"value0\": [2.5]}", m);
+  ASSERT_EQ(m.rows(), 1);
+  ASSERT_EQ(m.cols(), 1);
+  EXPECT_EQ(m(0, 0), 2.5);
+
+  loadFromString<cereal::JSONInputArchive>("{\"value0\": []}", m);
+  EXPECT_EQ(m.size(), 0);
+
+  // the current layout stores the shape
+  const Eigen::MatrixXd m23 = Eigen::MatrixXd::Random(2, 3);
+  const std::string str = saveToString<cereal::JSONOutputArchive>(m23);
+  EXPECT_NE(str.find("\"rows\": 2"), std::string::npos);
+  loadFromString<cereal::JSONInputArchive>(str, m);
+  expectParamsEq(m, m23, false);
+}
+
+TEST(SerializationTest, ContainersBinary) {
+  testAllContainers<cereal::BinaryOutputArchive, cereal::BinaryInputArchive>();
+}
+
+TEST(SerializationTest, ContainersPortableBinary) {
+  testAllContainers<cereal::PortableBinaryOutputArchive,
+                    cereal::PortableBinaryInputArchive>();
+}
+
+TEST(SerializationTest, ContainersJson) {
+  testAllContainers<cereal::JSONOutputArchive, cereal::JSONInputArchive>();
+}
+
+TEST(SerializationTest, BlobLayoutBinary) {
+  testAllBlobLayouts<cereal::BinaryOutputArchive>();
+}
+
+TEST(SerializationTest, BlobLayoutPortableBinary) {
+  testAllBlobLayouts<cereal::PortableBinaryOutputArchive>();
+}
+
+TEST(SerializationTest, Se3SplineBinary) {
+  testSe3Spline<cereal::BinaryOutputArchive, cereal::BinaryInputArchive>();
+}
+
+TEST(SerializationTest, Se3SplinePortableBinary) {
+  testSe3Spline<cereal::PortableBinaryOutputArchive,
+                cereal::PortableBinaryInputArchive>();
+}
+
+TEST(SerializationTest, Se3SplineJson) {
+  testSe3Spline<cereal::JSONOutputArchive, cereal::JSONInputArchive>();
+}
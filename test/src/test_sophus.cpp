@@ -112,6 +112,103 @@ TEST(SophusUtilsCase, LeftJacobianInvSO3) {
       x0);
 }
 
+TEST(SophusUtilsCase, ExpAndRightJacobianSO3) {
+  const double scales[] = {M_PI / 2, 1e-2, 1e-4, 1e-6, 1e-9, 0};
+
+  for (double scale : scales) {
+    Eigen::Vector3d phi;
+    phi.setRandom();
+    phi *= scale;
+
+    Eigen::Matrix3d J_a;
+    Sophus::SO3d R = Sophus::expAndRightJacobianSO3(phi, J_a);
+
+    Eigen::Matrix3d J_ref;
+    Sophus::rightJacobianSO3(phi, J_ref);
+
+    EXPECT_TRUE(R.matrix().isApprox(Sophus::SO3d::exp(phi).matrix(), 1e-14))
+        << "scale " << scale;
+    EXPECT_TRUE(J_a.isApprox(J_ref, 1e-10)) << "scale " << scale;
+
+    Eigen::Vector3d x0;
+    x0.setZero();
+
+    test_jacobian(
+        "expAndRightJacobianSO3", J_a,
+        [&](const Eigen::Vector3d &x) {
+          return (R.inverse() * Sophus::SO3d::exp(phi + x)).log();
+        },
+        x0);
+  }
+}
+
+TEST(SophusUtilsCase, LogAndRightJacobianInvSO3) {
+  const double scales[] = {M_PI - 1e-3, M_PI / 2, 1e-2, 1e-4, 1e-6, 1e-9, 0};
+
+  for (double scale : scales) {
+    Eigen::Vector3d phi_gt;
+    phi_gt.setRandom();
+    if (scale > 0) phi_gt *= scale / phi_gt.norm();
+
+    // Negate the quaternion to check that the angle is still in [0, pi].
+    Eigen::Quaterniond q = Sophus::SO3d::exp(phi_gt).unit_quaternion();
+    q.coeffs() = -q.coeffs();
+    Sophus::SO3d R(q);
+
+    Eigen::Vector3d phi;
+    Eigen::Matrix3d J_a;
+    Sophus::logAndRightJacobianInvSO3(R, phi, J_a);
+
+    EXPECT_TRUE(phi.isApprox(phi_gt, 1e-12) || phi.norm() < 1e-12)
+        << "scale " << scale;
+    EXPECT_LE(phi.norm(), M_PI + 1e-12);
+
+    Eigen::Matrix3d J_ref;
+    Sophus::rightJacobianInvSO3(phi, J_ref);
+    EXPECT_TRUE(J_a.isApprox(J_ref, 1e-8)) << "scale " << scale;
+
+    Eigen::Vector3d x0;
+    x0.setZero();
+
+    test_jacobian(
+        "logAndRightJacobianInvSO3", J_a,
+        [&](const Eigen::Vector3d &x) {
+          return (R * Sophus::SO3d::exp(x)).log();
+        },
+        x0);
+  }
+}
+
+TEST(SophusUtilsCase, ExpLogRightJacobianSO3Batch) {
+  constexpr size_t NUM = 17;
+
+  Eigen::aligned_vector<Eigen::Vector3d> phi(NUM);
+  for (size_t i = 0; i < NUM; i++) {
+    phi[i].setRandom();
+    phi[i] *= std::pow(10.0, -double(i % 8));
+  }
+
+  Eigen::aligned_vector<Sophus::SO3d> R(NUM);
+  Eigen::aligned_vector<Eigen::Matrix3d> J(NUM);
+  Sophus::expAndRightJacobianSO3Batch(phi.data(), NUM, R.data(), J.data());
+
+  Eigen::aligned_vector<Eigen::Vector3d> phi_log(NUM);
+  Eigen::aligned_vector<Eigen::Matrix3d> J_inv(NUM);
+  Sophus::logAndRightJacobianInvSO3Batch(R.data(), NUM, phi_log.data(),
+                                         J_inv.data());
+
+  for (size_t i = 0; i < NUM; i++) {
+    Eigen::Matrix3d J_ref;
+    Sophus::SO3d R_ref = Sophus::expAndRightJacobianSO3(phi[i], J_ref);
+    EXPECT_TRUE(R[i].matrix() == R_ref.matrix());
+    EXPECT_TRUE(J[i] == J_ref);
+
+    EXPECT_TRUE(phi_log[i].isApprox(phi[i], 1e-12));
+    EXPECT_TRUE((J[i] * J_inv[i]).isApprox(Eigen::Matrix3d::Identity(), 1e-12))
+        << "i " << i;
+  }
+}
+
 TEST(SophusUtilsCase, RightJacobianSE3Decoupled) {
   Sophus::Vector6d phi;
   phi.setRandom();
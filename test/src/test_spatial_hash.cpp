@@ -0,0 +1,201 @@
+/**
+BSD 3-Clause License
+
+Copyright (c) 2019, Vladyslav Usenko and Nikolaus Demmel.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <basalt/utils/spatial_hash.h>
+
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "gtest/gtest.h"
+
+TEST(SpatialHashTest, StdHash) {
+  std::unordered_set<Eigen::Vector2i> cells;
+  for (int x = -10; x < 10; x++) {
+    for (int y = -10; y < 10; y++) cells.emplace(x, y);
+  }
+  EXPECT_EQ(cells.size(), 400u);
+  EXPECT_EQ(cells.count(Eigen::Vector2i(-10, 9)), 1u);
+  EXPECT_EQ(cells.count(Eigen::Vector2i(10, 0)), 0u);
+
+  std::hash<Eigen::Vector3i> h;
+  EXPECT_EQ(h(Eigen::Vector3i(1, 2, 3)), h(Eigen::Vector3i(1, 2, 3)));
+  EXPECT_NE(h(Eigen::Vector3i(1, 2, 3)), h(Eigen::Vector3i(3, 2, 1)));
+}
+
+TEST(SpatialHashTest, GridCell) {
+  EXPECT_EQ(basalt::gridCell(Eigen::Vector2i(0, 15), 16),
+            Eigen::Vector2i(0, 0));
+  EXPECT_EQ(basalt::gridCell(Eigen::Vector2i(-1, 16), 16),
+            Eigen::Vector2i(-1, 1));
+  EXPECT_EQ(basalt::gridCell(Eigen::Vector2i(-16, -17), 16),
+            Eigen::Vector2i(-1, -2));
+  EXPECT_EQ(basalt::gridCell(Eigen::Vector2f(-0.5f, 31.9f), 16),
+            Eigen::Vector2i(-1, 1));
+  EXPECT_EQ(basalt::gridCell(Eigen::Vector3d(-16.0, 0.0, 47.5), 16),
+            Eigen::Vector3i(-1, 0, 2));
+}
+
+TEST(SpatialHashTest, CellHashMapRandomOps) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> coord(-20, 20);
+  std::uniform_int_distribution<int> op(0, 3);
+
+  basalt::CellHashMap<Eigen::Vector2i, int> map;
+  std::unordered_map<Eigen::Vector2i, int> ref;
+
+  EXPECT_FALSE(map.contains(Eigen::Vector2i(0, 0)));
+  EXPECT_EQ(map.find(Eigen::Vector2i(0, 0)), nullptr);
+
+  for (int i = 0; i < 20000; i++) {
+    const Eigen::Vector2i key(coord(gen), coord(gen));
+    switch (op(gen)) {
+      case 0: {
+        const auto res = map.insert(key, i);
+        const auto res_ref = ref.emplace(key, i);
+        ASSERT_EQ(res.second, res_ref.second);
+        ASSERT_EQ(*res.first, res_ref.first->second);
+        break;
+      }
+      case 1:
+        map[key] += 1;
+        ref[key] += 1;
+        break;
+      case 2:
+        ASSERT_EQ(map.erase(key), ref.erase(key) == 1);
+        break;
+      default: {
+        const int* val = map.find(key);
+        const auto it = ref.find(key);
+        ASSERT_EQ(val != nullptr, it != ref.end());
+        if (val) {
+          ASSERT_EQ(*val, it->second);
+        }
+      }
+    }
+    ASSERT_EQ(map.size(), ref.size());
+  }
+
+  // All remaining keys are found after the erases.
+  size_t num_visited = 0;
+  map.forEach([&](const Eigen::Vector2i& key, const int& val) {
+    num_visited++;
+    ASSERT_EQ(ref.at(key), val);
+  });
+  EXPECT_EQ(num_visited, ref.size());
+
+  const size_t num_slots = map.numSlots();
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.numSlots(), num_slots);
+  for (const auto& kv : ref) EXPECT_FALSE(map.contains(kv.first));
+}
+
+TEST(SpatialHashTest, CellHashSet) {
+  basalt::CellHashSet<Eigen::Vector3i> set(100);
+
+  for (int i = 0; i < 50; i++) {
+    EXPECT_TRUE(set.insert(Eigen::Vector3i(i, -i, 2 * i)));
+    EXPECT_FALSE(set.insert(Eigen::Vector3i(i, -i, 2 * i)));
+  }
+  EXPECT_EQ(set.size(), 50u);
+  EXPECT_TRUE(set.contains(Eigen::Vector3i(7, -7, 14)));
+  EXPECT_FALSE(set.contains(Eigen::Vector3i(7, 7, 14)));
+
+  EXPECT_TRUE(set.erase(Eigen::Vector3i(7, -7, 14)));
+  EXPECT_FALSE(set.erase(Eigen::Vector3i(7, -7, 14)));
+  EXPECT_FALSE(set.contains(Eigen::Vector3i(7, -7, 14)));
+
+  int sum = 0;
+  set.forEach([&](const Eigen::Vector3i& key) { sum += key.x(); });
+  EXPECT_EQ(sum, 49 * 50 / 2 - 7);
+
+  set.clear();
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(SpatialHashTest, GridBuckets) {
+  basalt::GridBuckets<int> grid(10);
+
+  for (int i = 0; i < 100; i++) {
+    grid.insertAt(Eigen::Vector2f(i * 1.5f - 20, 3.0f), i);
+  }
+  EXPECT_EQ(grid.size(), 100u);
+
+  // Cell (-2, 0) covers x in [-20, -10).
+  std::vector<int> items;
+  grid.forEachInCell(Eigen::Vector2i(-2, 0),
+                     [&](const int& i) { items.push_back(i); });
+  EXPECT_EQ(items, std::vector<int>({6, 5, 4, 3, 2, 1, 0}));
+  EXPECT_EQ(grid.count(Eigen::Vector2i(-2, 1)), 0u);
+
+  size_t num_neighborhood = 0;
+  grid.forEachInNeighborhood(Eigen::Vector2i(-1, 0), 1,
+                             [&](const int&) { num_neighborhood++; });
+  // x in [-20, 10)
+  EXPECT_EQ(num_neighborhood, 20u);
+
+  size_t num_all = 0;
+  grid.forEach([&](const Eigen::Vector2i& cell, const int& i) {
+    num_all++;
+    EXPECT_EQ(cell, grid.cellOf(Eigen::Vector2f(i * 1.5f - 20, 3.0f)));
+  });
+  EXPECT_EQ(num_all, 100u);
+  EXPECT_EQ(grid.numCells(), 15u);
+
+  grid.clear();
+  EXPECT_EQ(grid.size(), 0u);
+  EXPECT_EQ(grid.count(Eigen::Vector2i(-2, 0)), 0u);
+}
+
+TEST(SpatialHashTest, DenseCellGrid) {
+  basalt::DenseCellGrid<uint8_t> grid(640, 481, 32);
+  EXPECT_EQ(grid.cols(), 20);
+  EXPECT_EQ(grid.rows(), 16);
+
+  const Eigen::Vector2f p(639.5f, 480.5f);
+  const Eigen::Vector2i cell = grid.cellOf(p);
+  EXPECT_EQ(cell, Eigen::Vector2i(19, 15));
+  ASSERT_TRUE(grid.inBounds(cell));
+  EXPECT_FALSE(grid.inBounds(grid.cellOf(Eigen::Vector2f(-0.5f, 0.0f))));
+  EXPECT_FALSE(grid.inBounds(Eigen::Vector2i(20, 0)));
+
+  grid(cell) = 1;
+  EXPECT_EQ(grid(19, 15), 1);
+  EXPECT_EQ(grid.data()[15 * 20 + 19], 1);
+  EXPECT_EQ(grid(18, 15), 0);
+
+  const uint8_t* data = grid.data();
+  grid.fill(0);
+  EXPECT_EQ(grid(cell), 0);
+  EXPECT_EQ(grid.data(), data);
+}
@@ -30,12 +30,18 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+// Lets the batch test check that Eigen does not allocate. Must come before the
+// first Eigen include.
+#define EIGEN_RUNTIME_NO_MALLOC
+
 #include <basalt/spline/rd_spline.h>
 #include <basalt/spline/so3_spline.h>
 
 #include <iostream>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "heap_allocation_counter.h"
 #include "test_utils.h"
 
 template <int DIM, int N, int DERIV>
@@ -716,6 +722,378 @@ TEST(SplineTest, UBSplineBounds) {
   // std::cerr << "res4\n" << res2.matrix() << std::endl;
 }
 
+// Query times: small steps within and across segments, jumps over several
+// segments, a step back in time and the first and last valid time.
+std::vector<int64_t> cursorTestTimes(int64_t min_time_ns,
+                                     int64_t max_time_ns) {
+  std::vector<int64_t> times;
+  times.emplace_back(min_time_ns);
+  for (int64_t t_ns = min_time_ns + 1234; t_ns < max_time_ns; t_ns += 3e7) {
+    times.emplace_back(t_ns);
+  }
+  times.emplace_back(max_time_ns);
+  times.emplace_back(min_time_ns + 4e9 + 17);
+  times.emplace_back(min_time_ns + 4e9 + 18);
+  times.emplace_back(min_time_ns + 11e9);
+  times.emplace_back(min_time_ns + 3e9);
+  times.emplace_back(max_time_ns);
+  return times;
+}
+
+template <int N>
+void testRdSplineCursor() {
+  basalt::RdSpline<3, N> spline(int64_t(2e9), int64_t(1e9));
+  spline.genRandomTrajectory(3 * N);
+
+  auto cursor = spline.cursor();
+  for (int64_t t_ns : cursorTestTimes(spline.minTimeNs(), spline.maxTimeNs())) {
+    EXPECT_EQ(cursor.evaluate(t_ns), spline.evaluate(t_ns)) << "t_ns " << t_ns;
+    EXPECT_EQ(cursor.velocity(t_ns), spline.velocity(t_ns)) << "t_ns " << t_ns;
+    EXPECT_EQ(cursor.acceleration(t_ns), spline.acceleration(t_ns))
+        << "t_ns " << t_ns;
+    EXPECT_EQ(cursor.segmentIndex(),
+              (t_ns - spline.minTimeNs()) / spline.getTimeIntervalNs());
+  }
+
+  // changed knots are picked up after reset
+  spline.getKnot(N) *= 2;
+  cursor.reset();
+  const int64_t t_ns = spline.minTimeNs() + 3e9;
+  EXPECT_EQ(cursor.evaluate(t_ns), spline.evaluate(t_ns));
+}
+
+template <int N>
+void testSo3SplineCursor() {
+  basalt::So3Spline<N> spline(int64_t(2e9), int64_t(1e9));
+  spline.genRandomTrajectory(3 * N);
+
+  auto cursor = spline.cursor();
+  for (int64_t t_ns : cursorTestTimes(spline.minTimeNs(), spline.maxTimeNs())) {
+    EXPECT_EQ(cursor.evaluate(t_ns).matrix(), spline.evaluate(t_ns).matrix())
+        << "t_ns " << t_ns;
+    EXPECT_EQ(cursor.velocityBody(t_ns), spline.velocityBody(t_ns))
+        << "t_ns " << t_ns;
+
+    Eigen::Vector3d vel, vel_ref;
+    EXPECT_EQ(cursor.accelerationBody(t_ns, &vel),
+              spline.accelerationBody(t_ns, &vel_ref))
+        << "t_ns " << t_ns;
+    EXPECT_EQ(vel, vel_ref);
+  }
+
+  // changed knots are picked up after reset
+  spline.getKnot(N) = Sophus::SO3d::exp(Eigen::Vector3d(0.1, 0.2, 0.3));
+  cursor.reset();
+  const int64_t t_ns = spline.minTimeNs() + 3e9;
+  EXPECT_EQ(cursor.evaluate(t_ns).matrix(), spline.evaluate(t_ns).matrix());
+}
+
+TEST(SplineTest, UBSplineCursor4) { testRdSplineCursor<4>(); }
+
+TEST(SplineTest, UBSplineCursor5) { testRdSplineCursor<5>(); }
+
+TEST(SplineTest, UBSplineCursor6) { testRdSplineCursor<6>(); }
+
+TEST(SplineTest, SO3CUBSplineCursor4) { testSo3SplineCursor<4>(); }
+
+TEST(SplineTest, SO3CUBSplineCursor5) { testSo3SplineCursor<5>(); }
+
+TEST(SplineTest, SO3CUBSplineCursor6) { testSo3SplineCursor<6>(); }
+
+// Sorted query times: several queries per segment, repeated timestamps,
+// skipped segments and the first and last valid time.
+std::vector<int64_t> batchTestTimes(int64_t min_time_ns, int64_t max_time_ns) {
+  std::vector<int64_t> times;
+  times.emplace_back(min_time_ns);
+  for (int64_t t_ns = min_time_ns + 1234; t_ns < min_time_ns + 5e9;
+       t_ns += 3e8) {
+    times.emplace_back(t_ns);
+  }
+  times.emplace_back(times.back());
+  for (int64_t t_ns = min_time_ns + 9e9; t_ns < max_time_ns; t_ns += 7e8) {
+    times.emplace_back(t_ns);
+  }
+  times.emplace_back(max_time_ns);
+  return times;
+}
+
+template <int N>
+void testRdSplineBatch() {
+  basalt::RdSpline<3, N> spline(int64_t(2e9), int64_t(1e9));
+  spline.genRandomTrajectory(3 * N);
+
+  const std::vector<int64_t> times =
+      batchTestTimes(spline.minTimeNs(), spline.maxTimeNs());
+
+  Eigen::aligned_vector<Eigen::Vector3d> res, vel, accel;
+  typename basalt::RdSpline<3, N>::BatchJacobianStruct J_batch;
+
+  spline.evaluateBatch(times, res, &J_batch);
+  spline.velocityBatch(times, vel);
+  spline.accelerationBatch(times, accel);
+
+  ASSERT_EQ(res.size(), times.size());
+  ASSERT_EQ(size_t(J_batch.d_val_d_knot.cols()), times.size());
+  ASSERT_FALSE(J_batch.segments.empty());
+  EXPECT_EQ(J_batch.segments.front().begin, 0u);
+  EXPECT_EQ(J_batch.segments.back().end, times.size());
+
+  for (size_t j = 0; j < J_batch.segments.size(); j++) {
+    const basalt::SplineSegmentRange &seg = J_batch.segments[j];
+    if (j > 0) {
+      EXPECT_EQ(seg.begin, J_batch.segments[j - 1].end);
+      EXPECT_GT(seg.start_idx, J_batch.segments[j - 1].start_idx);
+    }
+
+    for (size_t k = seg.begin; k < seg.end; k++) {
+      typename basalt::RdSpline<3, N>::JacobianStruct J;
+      Eigen::Vector3d res_ref = spline.evaluate(times[k], &J);
+
+      EXPECT_TRUE(res[k].isApprox(res_ref, 1e-12)) << "t_ns " << times[k];
+      EXPECT_TRUE(vel[k].isApprox(spline.velocity(times[k]), 1e-12));
+      EXPECT_TRUE(accel[k].isApprox(spline.acceleration(times[k]), 1e-12));
+
+      EXPECT_EQ(size_t(seg.start_idx), J.start_idx);
+      for (int i = 0; i < N; i++) {
+        EXPECT_NEAR(J_batch.d_val_d_knot(i, k), J.d_val_d_knot[i], 1e-12);
+      }
+    }
+  }
+}
+
+template <int N>
+void testSo3SplineBatch() {
+  basalt::So3Spline<N> spline(int64_t(2e9), int64_t(1e9));
+  spline.genRandomTrajectory(3 * N);
+
+  const std::vector<int64_t> times =
+      batchTestTimes(spline.minTimeNs(), spline.maxTimeNs());
+
+  Eigen::aligned_vector<Sophus::SO3d> res;
+  Eigen::aligned_vector<Eigen::Vector3d> vel, vel_no_J, accel, accel_vel;
+  typename basalt::So3Spline<N>::BatchJacobianStruct J_res, J_vel;
+
+  spline.evaluateBatch(times, res, &J_res);
+  spline.velocityBodyBatch(times, vel, &J_vel);
+  spline.velocityBodyBatch(times, vel_no_J);
+  spline.accelerationBodyBatch(times, accel, &accel_vel);
+
+  ASSERT_EQ(res.size(), times.size());
+  ASSERT_EQ(size_t(J_res.d_val_d_knot.cols()), 3 * N * times.size());
+  ASSERT_EQ(J_res.segments.size(), J_vel.segments.size());
+
+  for (const basalt::SplineSegmentRange &seg : J_res.segments) {
+    for (size_t k = seg.begin; k < seg.end; k++) {
+      typename basalt::So3Spline<N>::JacobianStruct J, J_v;
+      Sophus::SO3d res_ref = spline.evaluate(times[k], &J);
+      Eigen::Vector3d vel_ref = spline.velocityBody(times[k], &J_v);
+      Eigen::Vector3d accel_vel_ref;
+      Eigen::Vector3d accel_ref =
+          spline.accelerationBody(times[k], &accel_vel_ref);
+
+      EXPECT_TRUE(res[k].matrix().isApprox(res_ref.matrix(), 1e-12))
+          << "t_ns " << times[k];
+      EXPECT_TRUE(vel[k].isApprox(vel_ref, 1e-12)) << "t_ns " << times[k];
+      EXPECT_TRUE(vel_no_J[k].isApprox(vel_ref, 1e-12));
+      EXPECT_TRUE(accel[k].isApprox(accel_ref, 1e-12));
+      EXPECT_TRUE(accel_vel[k].isApprox(accel_vel_ref, 1e-12));
+
+      EXPECT_EQ(size_t(seg.start_idx), J.start_idx);
+      for (int i = 0; i < N; i++) {
+        const int col = 3 * (N * k + i);
+        EXPECT_LE((J_res.d_val_d_knot.template block<3, 3>(0, col) -
+                   J.d_val_d_knot[i])
+                      .norm(),
+                  1e-10);
+        EXPECT_LE((J_vel.d_val_d_knot.template block<3, 3>(0, col) -
+                   J_v.d_val_d_knot[i])
+                      .norm(),
+                  1e-10);
+      }
+    }
+  }
+
+  // reusing a workspace must give the same result
+  basalt::SplineBatchWorkspace<N, double> ws;
+  Eigen::aligned_vector<Eigen::Vector3d> vel_ws, vel_no_J_ws, accel_ws,
+      accel_vel_ws;
+  spline.velocityBodyBatch(times, vel_ws, &J_vel, &ws);
+  spline.velocityBodyBatch(times, vel_no_J_ws, nullptr, &ws);
+  spline.accelerationBodyBatch(times, accel_ws, &accel_vel_ws, &ws);
+
+  // with the same number of timestamps all storage is reused
+  const size_t allocations_before = numHeapAllocations();
+  Eigen::internal::set_is_malloc_allowed(false);
+  spline.velocityBodyBatch(times, vel_ws, &J_vel, &ws);
+  spline.velocityBodyBatch(times, vel_no_J_ws, nullptr, &ws);
+  spline.accelerationBodyBatch(times, accel_ws, &accel_vel_ws, &ws);
+  Eigen::internal::set_is_malloc_allowed(true);
+  EXPECT_EQ(numHeapAllocations(), allocations_before);
+
+  for (size_t k = 0; k < times.size(); k++) {
+    EXPECT_TRUE(vel_ws[k].isApprox(vel[k], 1e-12));
+    EXPECT_TRUE(vel_no_J_ws[k].isApprox(vel[k], 1e-12));
+    EXPECT_TRUE(accel_ws[k].isApprox(accel[k], 1e-12));
+    EXPECT_TRUE(accel_vel_ws[k].isApprox(accel_vel[k], 1e-12));
+  }
+}
+
+TEST(SplineTest, UBSplineBatch4) { testRdSplineBatch<4>(); }
+
+TEST(SplineTest, UBSplineBatch5) { testRdSplineBatch<5>(); }
+
+TEST(SplineTest, UBSplineBatch6) { testRdSplineBatch<6>(); }
+
+TEST(SplineTest, SO3CUBSplineBatch4) { testSo3SplineBatch<4>(); }
+
+TEST(SplineTest, SO3CUBSplineBatch5) { testSo3SplineBatch<5>(); }
+
+TEST(SplineTest, SO3CUBSplineBatch6) { testSo3SplineBatch<6>(); }
+
+TEST(SplineTest, RingBufferTest) {
+  basalt::RingBuffer<Eigen::Vector3d> buffer(8);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.capacity(), 8u);
+
+  // sliding window of 5 elements, storage is never reallocated
+  for (int i = 0; i < 100; i++) {
+    buffer.push_back(Eigen::Vector3d::Constant(i));
+    if (buffer.size() > 5) buffer.pop_front();
+
+    ASSERT_EQ(buffer.size(), std::min(i + 1, 5));
+    EXPECT_EQ(buffer.capacity(), 8u);
+    if (i == 0) {
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) %
+                    basalt::RingBuffer<Eigen::Vector3d>::ALIGNMENT,
+                0u);
+    }
+
+    const Eigen::Vector3d* data = buffer.data();
+    for (size_t j = 0; j < buffer.size(); j++) {
+      EXPECT_EQ(&buffer[j], data + j);
+      EXPECT_EQ(buffer[j][0], i + 1 - int(buffer.size()) + int(j));
+    }
+    EXPECT_EQ(buffer.back()[0], i);
+  }
+
+  // growing keeps the elements
+  basalt::RingBuffer<Eigen::Vector3d> copy = buffer;
+  for (int i = 0; i < 20; i++) copy.emplace_back(-i, 0, 0);
+  ASSERT_EQ(copy.size(), 25u);
+  EXPECT_GE(copy.capacity(), 25u);
+  for (size_t j = 0; j < 5; j++) EXPECT_EQ(copy[j], buffer[j]);
+  EXPECT_EQ(copy.back()[0], -19);
+
+  // an expression is evaluated into the storage slot
+  copy.emplace_back(2 * Eigen::Vector3d::UnitY());
+  EXPECT_EQ(copy.back(), Eigen::Vector3d(0, 2, 0));
+  copy.pop_back();
+
+  copy.pop_back();
+  copy.resize(3);
+  EXPECT_EQ(copy.size(), 3u);
+  EXPECT_EQ(copy.front(), buffer.front());
+}
+
+TEST(SplineTest, RingBufferSplineTest) {
+  static constexpr int N = 5;
+  static constexpr int64_t dt_ns = 1e8;
+
+  basalt::RdSpline<3, N> spline(dt_ns);
+  basalt::RdSpline<3, N, double, basalt::RingBuffer> spline_rb(dt_ns);
+  basalt::So3Spline<N> so3_spline(dt_ns);
+  basalt::So3Spline<N, double, basalt::RingBuffer> so3_spline_rb(dt_ns);
+
+  // sliding window with 2 * N knots
+  for (int i = 0; i < 10 * N; i++) {
+    Eigen::Vector3d knot = Eigen::Vector3d::Random();
+    Sophus::SO3d so3_knot = Sophus::SO3d::exp(Eigen::Vector3d::Random());
+
+    spline.knotsPushBack(knot);
+    spline_rb.knotsPushBack(knot);
+    so3_spline.knotsPushBack(so3_knot);
+    so3_spline_rb.knotsPushBack(so3_knot);
+
+    if (spline.getKnots().size() > 2 * N) {
+      spline.knotsPopFront();
+      spline_rb.knotsPopFront();
+      so3_spline.knotsPopFront();
+      so3_spline_rb.knotsPopFront();
+    }
+
+    if (spline.getKnots().size() < N) continue;
+
+    ASSERT_EQ(spline_rb.minTimeNs(), spline.minTimeNs());
+    ASSERT_EQ(spline_rb.maxTimeNs(), spline.maxTimeNs());
+
+    for (int64_t t_ns = spline.minTimeNs(); t_ns < spline.maxTimeNs();
+         t_ns += dt_ns / 3) {
+      EXPECT_EQ(spline_rb.evaluate(t_ns), spline.evaluate(t_ns));
+      EXPECT_EQ(spline_rb.velocity(t_ns), spline.velocity(t_ns));
+      EXPECT_EQ(so3_spline_rb.evaluate(t_ns).matrix(),
+                so3_spline.evaluate(t_ns).matrix());
+      EXPECT_EQ(so3_spline_rb.velocityBody(t_ns),
+                so3_spline.velocityBody(t_ns));
+    }
+  }
+
+  EXPECT_LE(spline_rb.getKnots().capacity(), 4u * N);
+
+  basalt::RdSpline<3, N, float, basalt::RingBuffer> spline_f =
+      spline_rb.cast<float>();
+  EXPECT_TRUE(spline_f.evaluate(spline.minTimeNs())
+                  .isApprox(spline.evaluate(spline.minTimeNs()).cast<float>()));
+}
+
+template <int N, bool CUMULATIVE, int DERIV>
+void testSplineBlending() {
+  using VecN = Eigen::Matrix<double, N, 1>;
+
+  const Eigen::Matrix<double, N, N> blending =
+      basalt::computeBlendingMatrix<N, double, CUMULATIVE>();
+  const Eigen::Matrix<double, N, N> base =
+      basalt::computeBaseCoefficients<N, double>();
+
+  // time scaling only applies to derivatives
+  const double scale = DERIV > 0 ? 3.5 : 1.0;
+
+  for (double u : {0.0, 0.1, 0.5, 0.77, 0.999}) {
+    VecN p;
+    p.setZero();
+    double ui = 1;
+    for (int j = DERIV; j < N; j++) {
+      p[j] = base(DERIV, j) * ui;
+      ui *= u;
+    }
+    VecN coeff_ref = scale * (blending * p);
+
+    VecN coeff;
+    basalt::SplineBlending<N, double, CUMULATIVE, DERIV>::evaluate(coeff, u,
+                                                                   scale);
+    EXPECT_LE((coeff - coeff_ref).norm(), 1e-12)
+        << "u " << u << " coeff " << coeff.transpose() << " coeff_ref "
+        << coeff_ref.transpose();
+  }
+}
+
+TEST(SplineTest, SplineBlendingTest) {
+  // cubic B-spline, p(u=0) = (p_0 + 4 p_1 + p_2) / 6
+  constexpr auto blending4 = basalt::computeBlendingMatrixConstexpr<4>();
+  static_assert(blending4[0][0] == 1.0 / 6);
+  static_assert(blending4[1][0] == 4.0 / 6);
+  static_assert(blending4[3][0] == 0);
+
+  testSplineBlending<4, false, 0>();
+  testSplineBlending<4, false, 2>();
+  testSplineBlending<4, true, 0>();
+  testSplineBlending<4, true, 1>();
+  testSplineBlending<5, false, 1>();
+  testSplineBlending<5, true, 2>();
+  testSplineBlending<6, false, 3>();
+  testSplineBlending<6, true, 0>();
+  testSplineBlending<6, true, 5>();
+}
+
 TEST(SplineTest, CrossProductTest) {
   Eigen::Matrix3d J_1;
   Eigen::Matrix3d J_2;
@@ -30,11 +30,21 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+// Lets the batch test check that Eigen does not allocate. Must come before the
+// first Eigen include.
+#define EIGEN_RUNTIME_NO_MALLOC
+
+#include <basalt/serialization/spline_log.h>
 #include <basalt/spline/se3_spline.h>
+#include <basalt/spline/spline_imu_residuals.h>
 
+#include <cstdio>
+#include <functional>
 #include <iostream>
+#include <thread>
 
 #include "gtest/gtest.h"
+#include "heap_allocation_counter.h"
 #include "test_utils.h"
 
 template <int N>
@@ -366,3 +376,396 @@ TEST(SplineSE3, PoseTest) {
     testPose<N>(s, t_ns);
   }
 }
+
+TEST(SplineSE3, CursorTest) {
+  static constexpr int N = 5;
+
+  basalt::Se3Spline<N> s(int64_t(2e9));
+  s.genRandomTrajectory(3 * N);
+
+  auto cursor = s.cursor();
+
+  // sample at 200 Hz, including a restart
+  for (int pass = 0; pass < 2; pass++) {
+    for (int64_t t_ns = 0; t_ns < s.maxTimeNs(); t_ns += 5e6) {
+      EXPECT_EQ(cursor.pose(t_ns).matrix(), s.pose(t_ns).matrix());
+      EXPECT_EQ(cursor.transVelWorld(t_ns), s.transVelWorld(t_ns));
+      EXPECT_EQ(cursor.transAccelWorld(t_ns), s.transAccelWorld(t_ns));
+      EXPECT_EQ(cursor.rotVelBody(t_ns), s.rotVelBody(t_ns));
+    }
+  }
+}
+
+TEST(SplineSE3, BatchTest) {
+  static constexpr int N = 5;
+
+  basalt::Se3Spline<N> s(int64_t(2e9));
+  s.genRandomTrajectory(3 * N);
+
+  std::vector<int64_t> times;
+  for (int64_t t_ns = 0; t_ns < s.maxTimeNs(); t_ns += 1e8 + 7) {
+    times.emplace_back(t_ns);
+  }
+
+  Eigen::aligned_vector<Sophus::SE3d> poses;
+  Eigen::aligned_vector<Eigen::Vector3d> vel, accel, rot_vel;
+  basalt::Se3Spline<N>::PoseBatchJacobianStruct J_batch;
+
+  s.poseBatch(times, poses, &J_batch);
+  s.transVelWorldBatch(times, vel);
+  s.transAccelWorldBatch(times, accel);
+  s.rotVelBodyBatch(times, rot_vel);
+
+  ASSERT_EQ(poses.size(), times.size());
+
+  for (const basalt::SplineSegmentRange &seg : J_batch.segments) {
+    for (size_t k = seg.begin; k < seg.end; k++) {
+      basalt::Se3Spline<N>::PosePosSO3JacobianStruct J;
+      Sophus::SE3d pose_ref = s.pose(times[k], &J);
+
+      EXPECT_TRUE(poses[k].matrix().isApprox(pose_ref.matrix(), 1e-12));
+      EXPECT_TRUE(vel[k].isApprox(s.transVelWorld(times[k]), 1e-12));
+      EXPECT_TRUE(accel[k].isApprox(s.transAccelWorld(times[k]), 1e-12));
+      EXPECT_TRUE(rot_vel[k].isApprox(s.rotVelBody(times[k]), 1e-12));
+
+      EXPECT_EQ(size_t(seg.start_idx), J.start_idx);
+      for (int i = 0; i < N; i++) {
+        EXPECT_LE((J_batch.d_val_d_knot.block<6, 6>(0, 6 * (N * k + i)) -
+                   J.d_val_d_knot[i])
+                      .norm(),
+                  1e-10);
+      }
+    }
+  }
+
+  // reusing a workspace and a stale Jacobian must give the same result
+  basalt::Se3Spline<N>::PoseBatchWorkspace ws;
+  basalt::Se3Spline<N>::PoseBatchJacobianStruct J_reused;
+  Eigen::aligned_vector<Sophus::SE3d> poses_reused;
+
+  std::vector<int64_t> times_short(times.begin(), times.begin() + 5);
+  s.poseBatch(times_short, poses_reused, &J_reused, ws);
+  s.poseBatch(times, poses_reused, &J_reused, ws);
+  J_reused.d_val_d_knot.setConstant(1e9);
+
+  Eigen::aligned_vector<Sophus::SE3d> poses_no_J = poses_reused;
+  s.poseBatch(times, poses_no_J, nullptr, ws);
+
+  // with the same number of timestamps all storage is reused
+  const size_t allocations_before = numHeapAllocations();
+  Eigen::internal::set_is_malloc_allowed(false);
+  s.poseBatch(times, poses_reused, &J_reused, ws);
+  s.poseBatch(times, poses_no_J, nullptr, ws);
+  Eigen::internal::set_is_malloc_allowed(true);
+  EXPECT_EQ(numHeapAllocations(), allocations_before);
+
+  ASSERT_EQ(poses_reused.size(), times.size());
+  ASSERT_EQ(J_reused.segments.size(), J_batch.segments.size());
+  for (size_t k = 0; k < times.size(); k++) {
+    EXPECT_TRUE(poses_reused[k].matrix().isApprox(poses[k].matrix(), 1e-12));
+  }
+  EXPECT_TRUE(J_reused.d_val_d_knot.isApprox(J_batch.d_val_d_knot, 1e-12));
+}
+
+TEST(SplineSE3, KnotDeltaCacheTest) {
+  static constexpr int N = 5;
+
+  basalt::Se3Spline<N> s(int64_t(2e9));
+  s.genRandomTrajectory(3 * N);
+
+  basalt::Se3Spline<N> s_cached = s;
+  s_cached.setKnotDeltaCache(true);
+
+  const Eigen::Vector3d g(0, 0, -9.81);
+  const Eigen::Vector3d meas(0.1, -0.2, 9.7);
+  basalt::CalibGyroBias<double> gyro_bias;
+  basalt::CalibAccelBias<double> accel_bias;
+  gyro_bias.setRandom();
+  accel_bias.setRandom();
+
+  auto compare = [&]() {
+    for (int64_t t_ns = s.minTimeNs(); t_ns < s.maxTimeNs(); t_ns += 1e8 + 7) {
+      basalt::Se3Spline<N>::PosePosSO3JacobianStruct J_pose, J_pose_c;
+      Sophus::SE3d pose = s.pose(t_ns, &J_pose);
+      Sophus::SE3d pose_c = s_cached.pose(t_ns, &J_pose_c);
+      EXPECT_TRUE(pose.matrix().isApprox(pose_c.matrix(), 1e-12));
+
+      basalt::Se3Spline<N>::SO3JacobianStruct J_gyro, J_gyro_c;
+      Eigen::Vector3d res_gyro =
+          s.gyroResidual(t_ns, meas, gyro_bias, &J_gyro);
+      Eigen::Vector3d res_gyro_c =
+          s_cached.gyroResidual(t_ns, meas, gyro_bias, &J_gyro_c);
+      EXPECT_TRUE(res_gyro.isApprox(res_gyro_c, 1e-12));
+
+      basalt::Se3Spline<N>::AccelPosSO3JacobianStruct J_accel, J_accel_c;
+      Eigen::Vector3d res_accel =
+          s.accelResidual(t_ns, meas, accel_bias, g, &J_accel);
+      Eigen::Vector3d res_accel_c =
+          s_cached.accelResidual(t_ns, meas, accel_bias, g, &J_accel_c);
+      EXPECT_TRUE(res_accel.isApprox(res_accel_c, 1e-12));
+
+      ASSERT_EQ(J_pose.start_idx, J_pose_c.start_idx);
+      ASSERT_EQ(J_gyro.start_idx, J_gyro_c.start_idx);
+      ASSERT_EQ(J_accel.start_idx, J_accel_c.start_idx);
+      for (int i = 0; i < N; i++) {
+        EXPECT_LE((J_pose.d_val_d_knot[i] - J_pose_c.d_val_d_knot[i]).norm(),
+                  1e-10);
+        EXPECT_LE((J_gyro.d_val_d_knot[i] - J_gyro_c.d_val_d_knot[i]).norm(),
+                  1e-10);
+        EXPECT_LE(
+            (J_accel.d_val_d_knot[i] - J_accel_c.d_val_d_knot[i]).norm(),
+            1e-10);
+      }
+    }
+
+    std::vector<int64_t> times;
+    for (int64_t t_ns = s.minTimeNs(); t_ns < s.maxTimeNs(); t_ns += 3e7 + 1) {
+      times.emplace_back(t_ns);
+    }
+
+    Eigen::aligned_vector<Sophus::SE3d> poses, poses_c;
+    Eigen::aligned_vector<Eigen::Vector3d> rot_vel, rot_vel_c;
+    s.poseBatch(times, poses);
+    s_cached.poseBatch(times, poses_c);
+    s.rotVelBodyBatch(times, rot_vel);
+    s_cached.rotVelBodyBatch(times, rot_vel_c);
+
+    for (size_t k = 0; k < times.size(); k++) {
+      EXPECT_TRUE(poses[k].matrix().isApprox(poses_c[k].matrix(), 1e-12));
+      EXPECT_TRUE(rot_vel[k].isApprox(rot_vel_c[k], 1e-12));
+    }
+  };
+
+  compare();
+
+  // slide the window: append a knot, drop the oldest one and update a knot
+  // in the middle like an optimizer step would
+  Sophus::SE3d new_knot = Sophus::SE3d::exp(Sophus::Vector6d::Random());
+  s.knotsPushBack(new_knot);
+  s_cached.knotsPushBack(new_knot);
+  s.knotsPopFront();
+  s_cached.knotsPopFront();
+
+  ASSERT_EQ(s.minTimeNs(), s_cached.minTimeNs());
+  EXPECT_TRUE(
+      s.knotsFront().matrix().isApprox(s_cached.knotsFront().matrix()));
+
+  Sophus::Vector6d inc = Sophus::Vector6d::Random() * 0.1;
+  const int inc_idx = N;
+  s.applyInc(inc_idx, inc);
+  s_cached.applyInc(inc_idx, inc);
+
+  const basalt::So3Spline<N> &rot_spline = s_cached.getRotSpline();
+  EXPECT_TRUE(rot_spline.hasKnotDeltaCache());
+  EXPECT_FALSE(rot_spline.isKnotDeltaValid(inc_idx - 1));
+  EXPECT_FALSE(rot_spline.isKnotDeltaValid(inc_idx));
+  EXPECT_TRUE(rot_spline.isKnotDeltaValid(inc_idx + 1));
+
+  // stale deltas fall back to the uncached path
+  compare();
+
+  s_cached.updateKnotDeltaCache();
+  for (size_t j = 0; j + 1 < rot_spline.getKnots().size(); j++) {
+    EXPECT_TRUE(rot_spline.isKnotDeltaValid(j));
+  }
+
+  compare();
+}
+
+TEST(SplineSE3, ImuResidualBatchTest) {
+  static constexpr int N = 5;
+  using LinearSystem = basalt::SplineImuLinearSystem<N>;
+
+  basalt::Se3Spline<N> s(int64_t(2e8));
+  s.genRandomTrajectory(4 * N);
+
+  basalt::CalibGyroBias<double> gyro_bias;
+  basalt::CalibAccelBias<double> accel_bias;
+  gyro_bias.setRandom();
+  accel_bias.setRandom();
+  const Eigen::Vector3d g(0.1, -0.2, -9.81);
+  const double gyro_weight = 2.0;
+  const double accel_weight = 0.5;
+
+  // irregular 200 Hz samples with random measurements
+  std::vector<basalt::ImuData<double>> imu_data;
+  for (int64_t t_ns = s.minTimeNs(); t_ns < s.maxTimeNs(); t_ns += 5e6 + 13) {
+    basalt::ImuData<double> d;
+    d.t_ns = t_ns;
+    d.gyro.setRandom();
+    d.accel = Eigen::Vector3d::Random() + Eigen::Vector3d(0, 0, 9.81);
+    imu_data.emplace_back(d);
+  }
+
+  // reference with explicit dense Jacobians
+  const int knot_dim = s.numKnots() * LinearSystem::KNOT_SIZE;
+  const int dim = knot_dim + LinearSystem::CALIB_SIZE;
+  Eigen::MatrixXd H_ref = Eigen::MatrixXd::Zero(dim, dim);
+  Eigen::VectorXd b_ref = Eigen::VectorXd::Zero(dim);
+  double error_ref = 0;
+
+  for (const auto &d : imu_data) {
+    basalt::Se3Spline<N>::SO3JacobianStruct J_gyro;
+    basalt::Se3Spline<N>::AccelPosSO3JacobianStruct J_accel;
+    Eigen::Matrix<double, 3, 12> J_gyro_bias;
+    Eigen::Matrix<double, 3, 9> J_accel_bias;
+    Eigen::Matrix3d J_g;
+
+    Eigen::Vector3d r_gyro =
+        s.gyroResidual(d.t_ns, d.gyro, gyro_bias, &J_gyro, &J_gyro_bias);
+    Eigen::Vector3d r_accel = s.accelResidual(
+        d.t_ns, d.accel, accel_bias, g, &J_accel, &J_accel_bias, &J_g);
+
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(3, dim);
+    for (int i = 0; i < N; i++) {
+      J.block<3, 3>(0, 6 * (J_gyro.start_idx + i) + 3) =
+          J_gyro.d_val_d_knot[i];
+    }
+    J.block<3, 12>(0, knot_dim + LinearSystem::GYRO_BIAS_OFFSET) = J_gyro_bias;
+    H_ref += gyro_weight * J.transpose() * J;
+    b_ref += gyro_weight * J.transpose() * r_gyro;
+    error_ref += gyro_weight * r_gyro.squaredNorm();
+
+    J.setZero();
+    for (int i = 0; i < N; i++) {
+      J.block<3, 6>(0, 6 * (J_accel.start_idx + i)) = J_accel.d_val_d_knot[i];
+    }
+    J.block<3, 9>(0, knot_dim + LinearSystem::ACCEL_BIAS_OFFSET) =
+        J_accel_bias;
+    J.block<3, 3>(0, knot_dim + LinearSystem::GRAVITY_OFFSET) = J_g;
+    H_ref += accel_weight * J.transpose() * J;
+    b_ref += accel_weight * J.transpose() * r_accel;
+    error_ref += accel_weight * r_accel.squaredNorm();
+  }
+
+  const auto expect_equal_ref = [&](const LinearSystem &ls) {
+    Eigen::MatrixXd H;
+    Eigen::VectorXd b;
+    ls.toDense(H, b);
+
+    EXPECT_EQ(ls.num_residuals, imu_data.size());
+    EXPECT_NEAR(ls.error, error_ref, 1e-8 * error_ref);
+    EXPECT_LE((H - H_ref).norm(), 1e-9 * H_ref.norm());
+    EXPECT_LE((b - b_ref).norm(), 1e-9 * b_ref.norm());
+  };
+
+  {
+    LinearSystem ls;
+    ls.setZero(s.numKnots());
+    basalt::accumulateImuResiduals(s, imu_data, gyro_bias, accel_bias, g,
+                                   gyro_weight, accel_weight, ls);
+    expect_equal_ref(ls);
+  }
+
+  {
+    // start a thread for every task
+    std::vector<std::thread> threads;
+    const auto executor = [&](std::function<void()> task) {
+      threads.emplace_back(std::move(task));
+    };
+
+    LinearSystem ls;
+    ls.setZero(s.numKnots());
+    basalt::accumulateImuResiduals(s, imu_data, gyro_bias, accel_bias, g,
+                                   gyro_weight, accel_weight, ls, executor, 2);
+    for (auto &t : threads) t.join();
+    expect_equal_ref(ls);
+  }
+
+  // same knots in a ring buffer
+  basalt::Se3Spline<N, double, basalt::RingBuffer> s_rb(s.getDtNs(),
+                                                        s.minTimeNs());
+  for (size_t i = 0; i < s.numKnots(); i++) {
+    s_rb.knotsPushBack(Sophus::SE3d(s.getKnotSO3(i), s.getKnotPos(i)));
+  }
+
+  // run tasks immediately
+  const auto executor = [](std::function<void()> task) { task(); };
+
+  LinearSystem ls;
+  ls.setZero(s_rb.numKnots());
+  basalt::accumulateImuResiduals(s_rb, imu_data, gyro_bias, accel_bias, g,
+                                 gyro_weight, accel_weight, ls, executor, 2);
+  expect_equal_ref(ls);
+}
+
+TEST(SplineSE3, LogTest) {
+  static constexpr int N = 5;
+
+  basalt::Se3Spline<N> s(int64_t(2e8), int64_t(1e9));
+  s.genRandomTrajectory(100);
+
+  const std::string path = testing::TempDir() + "se3_spline_log_test.bin";
+
+  {
+    basalt::Se3SplineLogWriter<N> writer(path, s.getDtNs(), s.minTimeNs(), 16);
+    writer.knotsPushBack(s);
+    EXPECT_EQ(writer.numKnots(), s.numKnots());
+  }
+
+  basalt::Se3SplineLogReader<N> reader;
+  ASSERT_TRUE(reader.open(path));
+  EXPECT_EQ(reader.numKnots(), s.numKnots());
+  EXPECT_EQ(reader.minTimeNs(), s.minTimeNs());
+  EXPECT_EQ(reader.maxTimeNs(), s.maxTimeNs());
+
+  // windows only hold a chunk of knots
+  EXPECT_LE(reader.window(s.minTimeNs()).numKnots(), size_t(16 + N - 1));
+
+  // Knot quaternions are renormalized on load, so results match up to
+  // roundoff. Forward, across chunk borders and random access:
+  for (int64_t t_ns = s.minTimeNs(); t_ns <= s.maxTimeNs(); t_ns += 1e7 + 3) {
+    EXPECT_TRUE(
+        reader.pose(t_ns).matrix().isApprox(s.pose(t_ns).matrix(), 1e-12));
+  }
+  EXPECT_TRUE(reader.pose(s.maxTimeNs())
+                  .matrix()
+                  .isApprox(s.pose(s.maxTimeNs()).matrix(), 1e-12));
+  for (int i = 0; i < 100; i++) {
+    int64_t t_ns =
+        s.minTimeNs() + std::rand() % (s.maxTimeNs() - s.minTimeNs());
+    EXPECT_TRUE(
+        reader.pose(t_ns).matrix().isApprox(s.pose(t_ns).matrix(), 1e-12));
+  }
+
+  // a different order is rejected
+  basalt::Se3SplineLogReader<N - 1> reader_wrong_order;
+  EXPECT_FALSE(reader_wrong_order.open(path));
+
+  std::remove(path.c_str());
+}
+
+TEST(SplineSE3, LogAppendTest) {
+  static constexpr int N = 4;
+
+  basalt::Se3Spline<N> s(int64_t(1e8));
+  s.genRandomTrajectory(50);
+
+  const std::string path = testing::TempDir() + "se3_spline_log_append.bin";
+
+  basalt::Se3SplineLogWriter<N> writer(path, s.getDtNs(), s.minTimeNs(), 8);
+  for (size_t i = 0; i < 20; i++) writer.knotsPushBack(s.getKnot(i));
+  writer.flush();
+
+  basalt::Se3SplineLogReader<N> reader;
+  ASSERT_TRUE(reader.open(path));
+  EXPECT_EQ(reader.numKnots(), 20u);
+
+  // append the remaining knots as a spline that starts at the end of the log
+  basalt::Se3Spline<N> s_tail(s.getDtNs(), s.minTimeNs() + 20 * s.getDtNs());
+  for (size_t i = 20; i < s.numKnots(); i++) s_tail.knotsPushBack(s.getKnot(i));
+  writer.knotsPushBack(s_tail);
+  writer.flush();
+
+  // the reader sees appended knots after refresh
+  EXPECT_EQ(reader.numKnots(), 20u);
+  reader.refresh();
+  EXPECT_EQ(reader.numKnots(), s.numKnots());
+
+  for (int64_t t_ns = s.minTimeNs(); t_ns <= s.maxTimeNs(); t_ns += 1e7 + 3) {
+    EXPECT_TRUE(
+        reader.pose(t_ns).matrix().isApprox(s.pose(t_ns).matrix(), 1e-12));
+  }
+
+  std::remove(path.c_str());
+}